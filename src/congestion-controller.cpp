@@ -0,0 +1,162 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+* Copyright (c) 2016 Regents of the University of California.
+*
+* This file is part of the nTorrent codebase.
+*
+* nTorrent is free software: you can redistribute it and/or modify it under the
+* terms of the GNU Lesser General Public License as published by the Free Software
+* Foundation, either version 3 of the License, or (at your option) any later version.
+*
+* nTorrent is distributed in the hope that it will be useful, but WITHOUT ANY
+* WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+* PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+*
+* You should have received copies of the GNU General Public License and GNU Lesser
+* General Public License along with nTorrent, e.g., in COPYING.md file. If not, see
+* <http://www.gnu.org/licenses/>.
+*
+* See AUTHORS for complete list of nTorrent authors and contributors.
+*/
+
+#include "congestion-controller.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace ndn {
+namespace ntorrent {
+
+static double
+toSeconds(const time::nanoseconds& duration)
+{
+  return time::duration_cast<time::microseconds>(duration).count() / 1e6;
+}
+
+const char* CongestionController::DEFAULT_ALGORITHM = "cubic";
+
+std::unique_ptr<CongestionController>
+CongestionController::create(const std::string& algorithm, size_t maxWindow)
+{
+  if ("aimd" == algorithm) {
+    return std::unique_ptr<CongestionController>(new AimdCongestionController(maxWindow));
+  }
+  if ("cubic" == algorithm) {
+    return std::unique_ptr<CongestionController>(new CubicCongestionController(maxWindow));
+  }
+  BOOST_THROW_EXCEPTION(Error("Unsupported congestion control: " + algorithm));
+}
+
+CongestionController::CongestionController(size_t maxWindow)
+  : m_cwnd(std::min<double>(INITIAL_WINDOW, maxWindow))
+  , m_ssthresh(maxWindow)
+  , m_maxWindow(maxWindow)
+  , m_srtt(0)
+  , m_hasDecreased(false)
+{
+}
+
+void
+CongestionController::onData(const time::nanoseconds& rtt)
+{
+  // exponentially weighted moving average with a gain of 1/8 as in RFC 6298
+  m_srtt = (m_srtt == time::nanoseconds::zero()) ? rtt : (m_srtt * 7 + rtt) / 8;
+  if (m_cwnd < m_ssthresh) {
+    // slow start
+    m_cwnd += 1;
+  }
+  else {
+    increaseWindow();
+  }
+  m_cwnd = std::min(m_cwnd, m_maxWindow);
+}
+
+void
+CongestionController::onLoss()
+{
+  auto now = time::steady_clock::now();
+  if (m_hasDecreased && now - m_lastDecrease < m_srtt) {
+    return;
+  }
+  m_hasDecreased = true;
+  m_lastDecrease = now;
+  decreaseWindow();
+  m_cwnd = std::max(m_cwnd, 1.0);
+  m_ssthresh = m_cwnd;
+}
+
+const double AimdCongestionController::BETA = 0.5;
+
+AimdCongestionController::AimdCongestionController(size_t maxWindow)
+  : CongestionController(maxWindow)
+{
+}
+
+void
+AimdCongestionController::increaseWindow()
+{
+  m_cwnd += 1 / m_cwnd;
+}
+
+void
+AimdCongestionController::decreaseWindow()
+{
+  m_cwnd *= BETA;
+}
+
+const double CubicCongestionController::C = 0.4;
+const double CubicCongestionController::BETA = 0.7;
+
+CubicCongestionController::CubicCongestionController(size_t maxWindow)
+  : CongestionController(maxWindow)
+  , m_wMax(0)
+  , m_k(0)
+  , m_wEst(0)
+  , m_inEpoch(false)
+{
+}
+
+void
+CubicCongestionController::increaseWindow()
+{
+  auto now = time::steady_clock::now();
+  if (!m_inEpoch) {
+    m_inEpoch = true;
+    m_epochStart = now;
+    if (m_cwnd < m_wMax) {
+      m_k = std::cbrt((m_wMax - m_cwnd) / C);
+    }
+    else {
+      // we left slow start, or grew past the last congestion event, without a loss
+      m_k = 0;
+      m_wMax = m_cwnd;
+    }
+    m_wEst = m_cwnd;
+  }
+  // the window the cubic function reaches one round-trip time from now
+  double t = toSeconds(now - m_epochStart + m_srtt) - m_k;
+  double target = C * t * t * t + m_wMax;
+  // do not grow by more than half the window per round-trip time
+  target = std::min(target, 1.5 * m_cwnd);
+  if (target > m_cwnd) {
+    m_cwnd += (target - m_cwnd) / m_cwnd;
+  }
+  else {
+    m_cwnd += 0.01 / m_cwnd;
+  }
+  // the AIMD window with the same decrease factor (RFC 8312, section 4.2)
+  m_wEst += 3 * (1 - BETA) / (1 + BETA) / m_cwnd;
+  m_cwnd = std::max(m_cwnd, m_wEst);
+}
+
+void
+CubicCongestionController::decreaseWindow()
+{
+  m_inEpoch = false;
+  // fast convergence: release bandwidth to new flows if the window has not grown back
+  m_wMax = m_cwnd < m_wMax ? m_cwnd * (1 + BETA) / 2 : m_cwnd;
+  m_cwnd *= BETA;
+}
+
+} // namespace ntorrent
+} // namespace ndn
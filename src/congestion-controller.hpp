@@ -0,0 +1,245 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+* Copyright (c) 2016 Regents of the University of California.
+*
+* This file is part of the nTorrent codebase.
+*
+* nTorrent is free software: you can redistribute it and/or modify it under the
+* terms of the GNU Lesser General Public License as published by the Free Software
+* Foundation, either version 3 of the License, or (at your option) any later version.
+*
+* nTorrent is distributed in the hope that it will be useful, but WITHOUT ANY
+* WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+* PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+*
+* You should have received copies of the GNU General Public License and GNU Lesser
+* General Public License along with nTorrent, e.g., in COPYING.md file. If not, see
+* <http://www.gnu.org/licenses/>.
+*
+* See AUTHORS for complete list of nTorrent authors and contributors.
+*/
+
+#ifndef INCLUDED_CONGESTION_CONTROLLER_HPP
+#define INCLUDED_CONGESTION_CONTROLLER_HPP
+
+#include <ndn-cxx/util/time.hpp>
+
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+namespace ndn {
+namespace ntorrent {
+
+/**
+ * @brief The congestion control used to pace the Interests of a TorrentManager
+ *
+ * The controller keeps a congestion window, the maximum number of Interests that may be pending
+ * at any time. The window grows in slow start until the slow start threshold is reached and then
+ * in congestion avoidance following the algorithm of the subclass. Upon a loss (an Interest that
+ * timed out or a congestion NACK) the window is decreased by the subclass, at most once per
+ * round-trip time, as all the losses of a window are caused by the same congestion event.
+ */
+class CongestionController {
+public:
+  class Error : public std::runtime_error
+  {
+  public:
+    explicit
+    Error(const std::string& what)
+      : std::runtime_error(what)
+    {
+    }
+  };
+
+  enum {
+    // Number of Interests pending when the transfer starts
+    INITIAL_WINDOW = 10,
+    // Default maximum number of Interests pending at any time
+    MAX_WINDOW = 10000
+  };
+
+  /**
+   * @brief The name of the algorithm used unless another one is specified
+   */
+  static const char* DEFAULT_ALGORITHM;
+
+  /**
+   * @brief Create the congestion controller implementing the specified algorithm
+   * @param algorithm The name of the algorithm, either "aimd" or "cubic"
+   * @param maxWindow The maximum size of the congestion window
+   * @throws Error if the algorithm is not supported
+   */
+  static std::unique_ptr<CongestionController>
+  create(const std::string& algorithm, size_t maxWindow = MAX_WINDOW);
+
+  virtual
+  ~CongestionController() = default;
+
+  CongestionController(const CongestionController&) = delete;
+
+  CongestionController&
+  operator=(const CongestionController&) = delete;
+
+  /**
+   * @brief Return the number of Interests that may be pending (at least 1)
+   */
+  size_t
+  getWindow() const;
+
+  /**
+   * @brief Return the current (fractional) congestion window
+   */
+  double
+  getCongestionWindow() const;
+
+  /**
+   * @brief Return the slow start threshold
+   */
+  double
+  getSlowStartThreshold() const;
+
+  /**
+   * @brief Return the smoothed round-trip time of the samples seen so far (zero if none)
+   */
+  const time::nanoseconds&
+  getSmoothedRtt() const;
+
+  /**
+   * @brief Increase the window upon receiving a Data packet
+   * @param rtt The time elapsed since the Interest for the packet was sent
+   */
+  void
+  onData(const time::nanoseconds& rtt);
+
+  /**
+   * @brief Decrease the window upon a timeout or a congestion NACK
+   *
+   * Losses within one smoothed round-trip time of the last decrease are ignored.
+   */
+  void
+  onLoss();
+
+protected:
+  CongestionController(size_t maxWindow);
+
+  /**
+   * @brief Increase m_cwnd upon receiving a Data packet in congestion avoidance
+   *
+   * m_srtt is up to date when it is called.
+   */
+  virtual void
+  increaseWindow() = 0;
+
+  /**
+   * @brief Decrease m_cwnd upon a congestion event
+   */
+  virtual void
+  decreaseWindow() = 0;
+
+protected:
+  // The congestion window
+  double                        m_cwnd;
+  // The slow start threshold
+  double                        m_ssthresh;
+  // The maximum size of the congestion window
+  double                        m_maxWindow;
+  // The smoothed round-trip time
+  time::nanoseconds             m_srtt;
+
+private:
+  // Whether the window has been decreased at least once
+  bool                          m_hasDecreased;
+  // The time of the last decrease of the window
+  time::steady_clock::TimePoint m_lastDecrease;
+};
+
+/**
+ * @brief Additive increase, multiplicative decrease congestion control
+ *
+ * The window grows by one Interest per round-trip time and is halved upon a congestion event.
+ */
+class AimdCongestionController : public CongestionController {
+public:
+  explicit
+  AimdCongestionController(size_t maxWindow = MAX_WINDOW);
+
+protected:
+  void
+  increaseWindow() override;
+
+  void
+  decreaseWindow() override;
+
+private:
+  // The factor by which the window is multiplied upon a congestion event
+  static const double BETA;
+};
+
+/**
+ * @brief CUBIC congestion control (RFC 8312)
+ *
+ * The window grows as a cubic function of the time elapsed since the last congestion event,
+ * which probes quickly for bandwidth when far from the window of the last congestion event and
+ * slowly when close to it. The growth is independent of the round-trip time, so that the window
+ * opens quickly on high bandwidth, high latency paths. The window never grows slower than the one
+ * of an AIMD controller with the same decrease factor.
+ */
+class CubicCongestionController : public CongestionController {
+public:
+  explicit
+  CubicCongestionController(size_t maxWindow = MAX_WINDOW);
+
+protected:
+  void
+  increaseWindow() override;
+
+  void
+  decreaseWindow() override;
+
+private:
+  // The scaling constant of the cubic function
+  static const double C;
+  // The factor by which the window is multiplied upon a congestion event
+  static const double BETA;
+
+  // The window before the last congestion event
+  double                        m_wMax;
+  // The time (in seconds) the cubic function takes to grow back to m_wMax
+  double                        m_k;
+  // The window an AIMD controller would have
+  double                        m_wEst;
+  // Whether the current congestion avoidance epoch has started
+  bool                          m_inEpoch;
+  // The start of the current congestion avoidance epoch
+  time::steady_clock::TimePoint m_epochStart;
+};
+
+inline size_t
+CongestionController::getWindow() const
+{
+  return m_cwnd < 1 ? 1 : static_cast<size_t>(m_cwnd);
+}
+
+inline double
+CongestionController::getCongestionWindow() const
+{
+  return m_cwnd;
+}
+
+inline double
+CongestionController::getSlowStartThreshold() const
+{
+  return m_ssthresh;
+}
+
+inline const time::nanoseconds&
+CongestionController::getSmoothedRtt() const
+{
+  return m_srtt;
+}
+
+} // namespace ntorrent
+} // namespace ndn
+
+#endif // INCLUDED_CONGESTION_CONTROLLER_HPP
@@ -0,0 +1,200 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+* Copyright (c) 2016 Regents of the University of California.
+*
+* This file is part of the nTorrent codebase.
+*
+* nTorrent is free software: you can redistribute it and/or modify it under the
+* terms of the GNU Lesser General Public License as published by the Free Software
+* Foundation, either version 3 of the License, or (at your option) any later version.
+*
+* nTorrent is distributed in the hope that it will be useful, but WITHOUT ANY
+* WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+* PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+*
+* You should have received copies of the GNU General Public License and GNU Lesser
+* General Public License along with nTorrent, e.g., in COPYING.md file. If not, see
+* <http://www.gnu.org/licenses/>.
+*
+* See AUTHORS for complete list of nTorrent authors and contributors.
+*/
+
+#include "data-fetcher.hpp"
+#include "util/logging.hpp"
+#include "util/io-util.hpp"
+
+namespace ndn {
+namespace ntorrent {
+
+DataFetcher::DataFetcher(const ndn::Name&   torrentFileName,
+                         const std::string& dataPath,
+                         bool               seed,
+                         size_t             ioThreads,
+                         const std::string& congestionControl,
+                         bool               verifyOnResume,
+                         bool               lazyInitialize)
+  : m_torrentFileName(torrentFileName)
+  , m_dataPath(dataPath)
+  , m_seedFlag(seed)
+{
+  m_manager = make_shared<TorrentManager>(m_torrentFileName, m_dataPath, seed);
+  m_manager->setIoThreads(ioThreads);
+  m_manager->setCongestionController(CongestionController::create(congestionControl));
+  m_manager->setResumeVerification(verifyOnResume);
+  m_manager->setLazyInitialization(lazyInitialize);
+}
+
+DataFetcher::~DataFetcher()
+{
+}
+
+void
+DataFetcher::start(const time::milliseconds& timeout)
+{
+  m_manager->Initialize();
+  // downloading logic
+  this->implementFetchingLogic();
+  m_manager->processEvents(timeout);
+}
+
+void
+DataFetcher::pause()
+{
+  // TODO(Spyros): Implement asynchronous pause of the torrent downloading
+  // For now, do nothing...
+  throw(Error("Not implemented yet"));
+}
+
+void
+DataFetcher::resume()
+{
+  // TODO(Spyros): Implement asynchronous re-establishment of the torrent downloading
+  // For now, do nothing...
+  throw(Error("Not implemented yet"));
+}
+
+void
+DataFetcher::downloadTorrentFile()
+{
+  auto torrentPath = ".appdata/" + m_torrentFileName.get(-3).toUri() + "/torrent_files/";
+  m_manager->downloadTorrentFile(torrentPath,
+                                 bind(&DataFetcher::onTorrentFileSegmentReceived, this, _1),
+                                 bind(&DataFetcher::onDataRetrievalFailure, this, _1, _2));
+}
+
+void
+DataFetcher::downloadManifestFiles(const std::vector<ndn::Name>& manifestNames)
+{
+  auto manifestPath = ".appdata/" + m_torrentFileName.get(-3).toUri() + "/manifests/";
+  for (auto i = manifestNames.begin(); i != manifestNames.end(); i++) {
+    m_manager->download_file_manifest(*i,
+                                      manifestPath,
+                                      bind(&DataFetcher::onManifestReceived, this, _1),
+                                      bind(&DataFetcher::onDataRetrievalFailure, this, _1, _2));
+  }
+}
+
+void
+DataFetcher::retryPacket(const ndn::Name& packetName)
+{
+  this->downloadPackets({ packetName });
+}
+
+void
+DataFetcher::implementFetchingLogic() {
+  if (!m_manager->hasAllTorrentSegments()) {
+    this->downloadTorrentFile();
+  }
+  else {
+    LOG_INFO <<  m_torrentFileName << " complete" <<  std::endl;
+    std::vector<ndn::Name> namesToFetch;
+    m_manager->findFileManifestsToDownload(namesToFetch);
+    if (!namesToFetch.empty()) {
+      this->downloadManifestFiles(namesToFetch);
+    }
+    else {
+      LOG_INFO << "All manifests complete" <<  std::endl;
+      if (!m_manager->hasAllDataPackets()) {
+        this->downloadMissingPackets();
+      }
+      else {
+        LOG_INFO << "All data complete" <<  std::endl;
+        if (!m_seedFlag) {
+          m_manager->shutdown();
+        }
+      }
+    }
+  }
+}
+
+void
+DataFetcher::onDataPacketReceived(const ndn::Name& name)
+{
+  // Data Packet Received
+  LOG_INFO << "Data Packet Received: " << name;
+  m_retryMap.clear();
+}
+
+void
+DataFetcher::onTorrentFileSegmentReceived(const std::vector<Name>& manifestNames)
+{
+  // TODO(msweatt) Add parameter for torrent file
+  LOG_INFO << "Torrent Segment Received: " << m_torrentFileName << std::endl;
+  m_retryMap.clear();
+  this->downloadManifestFiles(manifestNames);
+}
+
+void
+DataFetcher::onManifestReceived(const std::vector<Name>& packetNames)
+{
+  if (packetNames.empty()) {
+    return;
+  }
+  LOG_INFO << "Manifest File Received: "
+            << packetNames[0].getSubName(0, packetNames[0].size()- 3) << std::endl;
+  m_retryMap.clear();
+  this->downloadPackets(packetNames);
+}
+
+void
+DataFetcher::onDataRetrievalFailure(const ndn::Name& name, const std::string& errorCode)
+{
+  // Data retrieval failure
+  if (m_retryMap[name] < MAX_RETRIES) {
+    m_retryMap[name]++;
+    uint32_t nameType = IoUtil::findType(name);
+    if (nameType == IoUtil::TORRENT_FILE) {
+      // this should never happen
+      LOG_ERROR << "Torrent File Segment Downloading Failed: " << name;
+      auto torrentPath = ".appdata/" + m_torrentFileName.get(-3).toUri() + "/torrent_files/";
+      m_manager->retryTorrentFileSegment(name,
+                                         torrentPath,
+                                         bind(&DataFetcher::onTorrentFileSegmentReceived, this, _1),
+                                         bind(&DataFetcher::onDataRetrievalFailure, this, _1, _2));
+    }
+    else if (nameType == IoUtil::FILE_MANIFEST) {
+      LOG_ERROR << "Manifest File Segment Downloading Failed: " << name;
+      auto manifestPath = ".appdata/" + m_torrentFileName.get(-3).toUri() + "/manifests/";
+      m_manager->retryFileManifestSegment(name,
+                                          manifestPath,
+                                          bind(&DataFetcher::onManifestReceived, this, _1),
+                                          bind(&DataFetcher::onDataRetrievalFailure, this, _1, _2));
+    }
+    else if (nameType == IoUtil::DATA_PACKET) {
+      LOG_ERROR << "Data Packet Downloading Failed: " << name;
+      this->retryPacket(name);
+    }
+    else {
+      // This should never happen
+      LOG_ERROR << "Unknown Packet Type Downloading Failed: " << name;
+    }
+  }
+  else {
+    m_retryMap.erase(name);
+    m_manager->cancelRetransmission(name);
+    LOG_INFO << "Giving up on " << name;
+  }
+}
+
+} // namespace ntorrent
+} // namespace ndn
@@ -0,0 +1,154 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+* Copyright (c) 2016 Regents of the University of California.
+*
+* This file is part of the nTorrent codebase.
+*
+* nTorrent is free software: you can redistribute it and/or modify it under the
+* terms of the GNU Lesser General Public License as published by the Free Software
+* Foundation, either version 3 of the License, or (at your option) any later version.
+*
+* nTorrent is distributed in the hope that it will be useful, but WITHOUT ANY
+* WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+* PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+*
+* You should have received copies of the GNU General Public License and GNU Lesser
+* General Public License along with nTorrent, e.g., in COPYING.md file. If not, see
+* <http://www.gnu.org/licenses/>.
+*
+* See AUTHORS for complete list of nTorrent authors and contributors.
+*/
+
+#ifndef DATA_FETCHER_HPP
+#define DATA_FETCHER_HPP
+
+#include "fetching-strategy-manager.hpp"
+#include "torrent-manager.hpp"
+
+#include <ndn-cxx/name.hpp>
+
+#include <unordered_map>
+
+namespace ndn {
+namespace ntorrent {
+
+/**
+ * @brief The common logic of the fetching strategies
+ *
+ * The fetcher downloads the torrent file and the file manifests, retries the failed retrievals
+ * and shuts the manager down once all the data is on disk. The order in which the Data packets are
+ * requested is left to the derived classes.
+ */
+class DataFetcher : public FetchingStrategyManager {
+  public:
+    class Error : public std::runtime_error
+    {
+    public:
+      explicit
+      Error(const std::string& what)
+        : std::runtime_error(what)
+      {
+      }
+    };
+
+    /**
+     * @brief Create a new DataFetcher
+     * @param torrentFileName The name of the torrent file
+     * @param dataPath The path that the manager would look for already stored data packets and
+     *                 will write new data packets
+     * @param ioThreads The number of threads used for disk I/O, 0 for synchronous disk I/O
+     * @param congestionControl The congestion control algorithm pacing the Interests ("aimd" or
+     *                          "cubic")
+     * @param verifyOnResume Whether to verify the data packets restored from the resume journal
+     *                       in the background
+     * @param lazyInitialize Whether to hash the data packets missing from the resume journal in
+     *                       the background
+     * @throws CongestionController::Error if the congestion control algorithm is not supported
+     */
+    DataFetcher(const ndn::Name&   torrentFileName,
+                const std::string& dataPath,
+                bool               seed,
+                size_t             ioThreads,
+                const std::string& congestionControl,
+                bool               verifyOnResume,
+                bool               lazyInitialize);
+
+    virtual
+    ~DataFetcher();
+
+    /**
+     * @brief Start the data fetcher
+     */
+    void
+    start(const time::milliseconds& timeout = time::milliseconds::zero());
+
+    /**
+     * @brief Pause the data fetcher
+     */
+    void
+    pause();
+
+    /**
+     * @brief Resume the data fetcher
+     */
+    void
+    resume();
+
+  protected:
+    void
+    downloadTorrentFile();
+
+    void
+    downloadManifestFiles(const std::vector<ndn::Name>& manifestsName);
+
+    void
+    implementFetchingLogic();
+
+    /**
+     * @brief Request the missing Data packets of the torrent, once all its manifests are on disk
+     */
+    virtual void
+    downloadMissingPackets() = 0;
+
+    /**
+     * @brief Request the Data packets @p packetsName of a file manifest that was received
+     */
+    virtual void
+    downloadPackets(const std::vector<ndn::Name>& packetsName) = 0;
+
+    /**
+     * @brief Request again the Data packet @p packetName whose retrieval failed
+     */
+    virtual void
+    retryPacket(const ndn::Name& packetName);
+
+    virtual void
+    onDataPacketReceived(const ndn::Name& name);
+
+    virtual void
+    onDataRetrievalFailure(const ndn::Name& name, const std::string& errorCode);
+
+    virtual void
+    onManifestReceived(const std::vector<Name>& packetNames);
+
+    virtual void
+    onTorrentFileSegmentReceived(const std::vector<Name>& manifestNames);
+
+  protected:
+    ndn::Name m_torrentFileName;
+    shared_ptr<TorrentManager> m_manager;
+
+  private:
+    enum
+    {
+      MAX_RETRIES = 5
+    };
+    std::unordered_map<Name, int> m_retryMap;
+    std::string m_dataPath;
+    bool m_seedFlag;
+};
+
+} // namespace ntorrent
+} // namespace ndn
+
+#endif // DATA_FETCHER_HPP
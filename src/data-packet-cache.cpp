@@ -0,0 +1,95 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+* Copyright (c) 2016 Regents of the University of California.
+*
+* This file is part of the nTorrent codebase.
+*
+* nTorrent is free software: you can redistribute it and/or modify it under the
+* terms of the GNU Lesser General Public License as published by the Free Software
+* Foundation, either version 3 of the License, or (at your option) any later version.
+*
+* nTorrent is distributed in the hope that it will be useful, but WITHOUT ANY
+* WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+* PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+*
+* You should have received copies of the GNU General Public License and GNU Lesser
+* General Public License along with nTorrent, e.g., in COPYING.md file. If not, see
+* <http://www.gnu.org/licenses/>.
+*
+* See AUTHORS for complete list of nTorrent authors and contributors.
+*/
+
+#include "data-packet-cache.hpp"
+
+namespace ndn {
+namespace ntorrent {
+
+std::shared_ptr<const Data>
+DataPacketCache::find(const Name& fullName)
+{
+  auto it = m_index.find(fullName);
+  if (m_index.end() == it) {
+    ++m_misses;
+    return nullptr;
+  }
+  ++m_hits;
+  // move the entry to the front of the list
+  m_entries.splice(m_entries.begin(), m_entries, it->second);
+  return it->second->second;
+}
+
+void
+DataPacketCache::insert(const Name& fullName, std::shared_ptr<const Data> data)
+{
+  auto size = data->wireEncode().size();
+  if (size > m_capacity) {
+    return;
+  }
+  erase(fullName);
+  m_entries.emplace_front(fullName, data);
+  m_index[fullName] = m_entries.begin();
+  m_bytes += size;
+  evict();
+}
+
+bool
+DataPacketCache::erase(const Name& fullName)
+{
+  auto it = m_index.find(fullName);
+  if (m_index.end() == it) {
+    return false;
+  }
+  m_bytes -= it->second->second->wireEncode().size();
+  m_entries.erase(it->second);
+  m_index.erase(it);
+  return true;
+}
+
+void
+DataPacketCache::clear()
+{
+  m_entries.clear();
+  m_index.clear();
+  m_bytes = 0;
+}
+
+void
+DataPacketCache::setCapacity(size_t capacity)
+{
+  m_capacity = capacity;
+  evict();
+}
+
+void
+DataPacketCache::evict()
+{
+  while (m_bytes > m_capacity && !m_entries.empty()) {
+    const auto& entry = m_entries.back();
+    m_bytes -= entry.second->wireEncode().size();
+    m_index.erase(entry.first);
+    m_entries.pop_back();
+  }
+}
+
+} // namespace ntorrent
+} // namespace ndn
@@ -0,0 +1,190 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+* Copyright (c) 2016 Regents of the University of California.
+*
+* This file is part of the nTorrent codebase.
+*
+* nTorrent is free software: you can redistribute it and/or modify it under the
+* terms of the GNU Lesser General Public License as published by the Free Software
+* Foundation, either version 3 of the License, or (at your option) any later version.
+*
+* nTorrent is distributed in the hope that it will be useful, but WITHOUT ANY
+* WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+* PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+*
+* You should have received copies of the GNU General Public License and GNU Lesser
+* General Public License along with nTorrent, e.g., in COPYING.md file. If not, see
+* <http://www.gnu.org/licenses/>.
+*
+* See AUTHORS for complete list of nTorrent authors and contributors.
+*/
+
+#ifndef INCLUDED_DATA_PACKET_CACHE_HPP
+#define INCLUDED_DATA_PACKET_CACHE_HPP
+
+#include <ndn-cxx/data.hpp>
+#include <ndn-cxx/name.hpp>
+
+#include <list>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+
+namespace ndn {
+namespace ntorrent {
+
+/**
+ * @brief A bounded LRU cache of signed and wire-encoded Data packets
+ *
+ * The cache is keyed by the full name (including the implicit digest) of each packet and is
+ * bounded by the total size in bytes of the wire encoding of the cached packets. It is used on the
+ * seeding path so that repeated Interests for the same packet are answered without reading the
+ * packet from disk and signing it again.
+ */
+class DataPacketCache {
+public:
+  /**
+   * @brief Create a new empty cache
+   * @param capacity The maximum number of bytes of wire-encoded packets held by the cache
+   */
+  explicit
+  DataPacketCache(size_t capacity = DEFAULT_CAPACITY);
+
+  ~DataPacketCache() = default;
+
+  /**
+   * @brief Find the packet with the specified full name
+   * @param fullName The full name (including the implicit digest) of the packet
+   * @return A pointer to the cached packet if found. Otherwise, nullptr
+   *
+   * A successful lookup marks the packet as the most recently used one. Every lookup updates
+   * either the hit or the miss counter of the cache.
+   */
+  std::shared_ptr<const Data>
+  find(const Name& fullName);
+
+  /**
+   * @brief Insert a packet to the cache
+   * @param fullName The full name (including the implicit digest) of the packet
+   * @param data The packet to be cached. It must already be signed.
+   *
+   * Evicts the least recently used packets until the cache fits in its capacity. Packets larger
+   * than the capacity of the cache are not inserted.
+   */
+  void
+  insert(const Name& fullName, std::shared_ptr<const Data> data);
+
+  /**
+   * @brief Erase the packet with the specified full name
+   * @return True if the packet was found and erased. Otherwise, false
+   */
+  bool
+  erase(const Name& fullName);
+
+  /**
+   * @brief Erase all the packets from the cache (the counters are not reset)
+   */
+  void
+  clear();
+
+  /**
+   * @brief Set the capacity of the cache in bytes, evicting packets if needed
+   */
+  void
+  setCapacity(size_t capacity);
+
+  /**
+   * @brief Return the capacity of the cache in bytes
+   */
+  size_t
+  capacity() const;
+
+  /**
+   * @brief Return the number of bytes of the wire encoding of all the cached packets
+   */
+  size_t
+  bytes() const;
+
+  /**
+   * @brief Return the number of cached packets
+   */
+  size_t
+  size() const;
+
+  /**
+   * @brief Return the number of lookups that found the requested packet
+   */
+  uint64_t
+  getHits() const;
+
+  /**
+   * @brief Return the number of lookups that did not find the requested packet
+   */
+  uint64_t
+  getMisses() const;
+
+  enum {
+    // Default capacity of the cache in bytes
+    DEFAULT_CAPACITY = 64 * 1024 * 1024
+  };
+
+private:
+  void
+  evict();
+
+private:
+  typedef std::list<std::pair<Name, std::shared_ptr<const Data>>> EntryList;
+
+  // The cached packets ordered from the most to the least recently used one
+  EntryList                                         m_entries;
+  // A map from the full name of each cached packet to its position in m_entries
+  std::unordered_map<Name, EntryList::iterator>     m_index;
+  size_t                                            m_capacity;
+  size_t                                            m_bytes;
+  uint64_t                                          m_hits;
+  uint64_t                                          m_misses;
+};
+
+inline
+DataPacketCache::DataPacketCache(size_t capacity)
+  : m_capacity(capacity)
+  , m_bytes(0)
+  , m_hits(0)
+  , m_misses(0)
+{
+}
+
+inline size_t
+DataPacketCache::capacity() const
+{
+  return m_capacity;
+}
+
+inline size_t
+DataPacketCache::bytes() const
+{
+  return m_bytes;
+}
+
+inline size_t
+DataPacketCache::size() const
+{
+  return m_entries.size();
+}
+
+inline uint64_t
+DataPacketCache::getHits() const
+{
+  return m_hits;
+}
+
+inline uint64_t
+DataPacketCache::getMisses() const
+{
+  return m_misses;
+}
+
+} // namespace ntorrent
+} // namespace ndn
+
+#endif // INCLUDED_DATA_PACKET_CACHE_HPP
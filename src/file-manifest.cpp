@@ -21,8 +21,11 @@
 #include "file-manifest.hpp"
 
 #include "util/io-util.hpp"
+#include "util/segment-index.hpp"
 #include "util/shared-constants.hpp"
+#include "util/thread-pool.hpp"
 
+#include <algorithm>
 #include <limits>
 
 #include <boost/assert.hpp>
@@ -31,8 +34,6 @@
 #include <boost/range/adaptors.hpp>
 #include <boost/range/irange.hpp>
 #include <boost/throw_exception.hpp>
-#include <ndn-cxx/security/key-chain.hpp>
-#include <ndn-cxx/security/signing-helpers.hpp>
 
 #include <ndn-cxx/encoding/tlv.hpp>
 
@@ -73,6 +74,19 @@ get_name_of_manifest(const std::string& filePath, const Name& manifestPrefix)
   return manifestName;
 }
 
+static uint64_t
+skipElement(Buffer::const_iterator& it, const Buffer::const_iterator& end)
+{
+  // Advance 'it' past the TLV element it points to, returning the length of its value
+  tlv::readType(it, end);
+  uint64_t length = tlv::readVarNumber(it, end);
+  if (length > static_cast<uint64_t>(end - it)) {
+    BOOST_THROW_EXCEPTION(FileManifest::Error("Truncated element in a FileManifest"));
+  }
+  it += length;
+  return length;
+}
+
 // CLASS METHODS
 std::pair<std::vector<FileManifest>, std::vector<Data>>
 FileManifest::generate(const std::string& filePath,
@@ -80,6 +94,20 @@ FileManifest::generate(const std::string& filePath,
                        size_t             subManifestSize,
                        size_t             dataPacketSize,
                        bool               returnData)
+{
+  ThreadPool pool(0);
+  return generate(filePath, manifestPrefix, subManifestSize, dataPacketSize, returnData, pool);
+}
+
+std::pair<std::vector<FileManifest>, std::vector<Data>>
+FileManifest::generate(const std::string& filePath,
+                       const Name&        manifestPrefix,
+                       size_t             subManifestSize,
+                       size_t             dataPacketSize,
+                       bool               returnData,
+                       ThreadPool&        pool,
+                       size_t             indexFanout,
+                       SigningService&    signer)
 {
   BOOST_ASSERT(0 < subManifestSize);
   BOOST_ASSERT(0 < dataPacketSize);
@@ -94,43 +122,66 @@ FileManifest::generate(const std::string& filePath,
                               !!(file_length % (subManifestSize * dataPacketSize));
   // Find the prefix for the Catalog
   auto manifestName = get_name_of_manifest(filePath, manifestPrefix);
-  std::vector<Data> allPackets;
-  if (returnData) {
-    allPackets.reserve(numSubManifests * subManifestSize);
-  }
+  size_t numDataPackets = file_length / dataPacketSize + !!(file_length % dataPacketSize);
   manifests.reserve(numSubManifests);
   for (auto subManifestNum : irange<size_t>(0, numSubManifests)) {
     auto curr_manifest_name = manifestName;
     // append the packet number
-    curr_manifest_name.appendSequenceNumber(manifests.size());
-    FileManifest curr_manifest(curr_manifest_name, dataPacketSize, manifestPrefix);
-    auto packets = IoUtil::packetize_file(path,
-                                          curr_manifest_name,
-                                          dataPacketSize,
-                                          subManifestSize,
-                                          subManifestNum);
-    if (returnData) {
+    curr_manifest_name.appendSequenceNumber(subManifestNum);
+    manifests.emplace_back(curr_manifest_name, dataPacketSize, manifestPrefix);
+    manifests.back().reserve(std::min(subManifestSize,
+                                      numDataPackets - subManifestNum * subManifestSize));
+  }
+  // Packetize the sub-manifests concurrently, each task only touching the sub-manifest (and the
+  // packets) at its own position, so that the result does not depend on the order of execution
+  std::vector<std::vector<Data>> subManifestPackets(returnData ? numSubManifests : 0);
+  std::vector<ThreadPool::Task> tasks;
+  tasks.reserve(numSubManifests);
+  for (auto subManifestNum : irange<size_t>(0, numSubManifests)) {
+    tasks.emplace_back([&, subManifestNum] {
+      auto& curr_manifest = manifests[subManifestNum];
+      auto packets = returnData ? &subManifestPackets[subManifestNum] : nullptr;
+      // Collect the Data packets into the sub-manifest as they are produced, only keeping them
+      // in memory if they are to be returned
+      IoUtil::packetize_file(path,
+                             curr_manifest.name(),
+                             dataPacketSize,
+                             subManifestSize,
+                             subManifestNum,
+                             [&curr_manifest, packets] (const Data& p,
+                                                         const Name& fullName) {
+                               curr_manifest.push_back(fullName);
+                               if (nullptr != packets) {
+                                 packets->push_back(p);
+                               }
+                             },
+                             signer);
+    });
+  }
+  pool.run(std::move(tasks));
+  std::vector<Data> allPackets;
+  if (returnData) {
+    allPackets.reserve(numDataPackets);
+    for (auto& packets : subManifestPackets) {
       allPackets.insert(allPackets.end(), packets.begin(), packets.end());
+      std::vector<Data>().swap(packets);
     }
-    curr_manifest.reserve(packets.size());
-    // Collect all the Data packets into the sub-manifests
-    for (const auto& p: packets) {
-      curr_manifest.push_back(p.getFullName());
-    }
-    // append the last manifest
-    manifests.push_back(curr_manifest);
   }
-  allPackets.shrink_to_fit();
-  manifests.shrink_to_fit();
-  // Set all the submanifest_ptrs and sign all the manifests
-  security::KeyChain key_chain;
+  // Set all the submanifest_ptrs and sign all the manifests, remembering their full names
+  std::vector<Name> fullNames(manifests.size());
   manifests.back().finalize();
-  key_chain.sign(manifests.back(), signingWithSha256());
-  for (auto it = manifests.rbegin() + 1; it != manifests.rend(); ++it) {
-    auto next = it - 1;
-    it->set_submanifest_ptr(std::make_shared<Name>(next->getFullName()));
-    it->finalize();
-    key_chain.sign(*it, signingWithSha256());
+  fullNames.back() = signer.sign(manifests.back());
+  for (size_t manifestNum = manifests.size() - 1; manifestNum-- > 0; ) {
+    auto& manifest = manifests[manifestNum];
+    manifest.set_submanifest_ptr(std::make_shared<Name>(fullNames[manifestNum + 1]));
+    // the sub-manifests after this one are signed by now, so it can list their full names
+    auto children = SegmentIndex::children(manifestNum, manifests.size(), indexFanout);
+    if (children.first < children.second) {
+      manifest.set_submanifest_index(std::vector<Name>(fullNames.begin() + children.first,
+                                                       fullNames.begin() + children.second));
+    }
+    manifest.finalize();
+    fullNames[manifestNum] = signer.sign(manifest);
   }
   return {manifests, allPackets};
 }
@@ -165,23 +216,17 @@ FileManifest::encodeContent(ndn::EncodingImpl<TAG>& encoder) const {
 
   size_t totalLength = 0;
 
-  // build suffix catalog
-  vector<Name> suffixCatalog;
-  suffixCatalog.reserve(m_catalog.size());
-  for (auto name: m_catalog) {
+  // encode the suffixes directly from the names of the catalog
+  const auto& names = catalog();
+  for (const auto& name : names | boost::adaptors::reversed) {
     if (!m_catalogPrefix.isPrefixOf(name)) {
       BOOST_THROW_EXCEPTION(Error(name.toUri() + " does not have the prefix "
                                                + m_catalogPrefix.toUri()));
     }
-    name = name.getSubName(m_catalogPrefix.size());
-    if (name.empty()) {
+    if (name.size() == m_catalogPrefix.size()) {
       BOOST_THROW_EXCEPTION(Error("Manifest cannot include empty string"));
     }
-    suffixCatalog.push_back(name);
-  }
-
-  for (const auto& name : suffixCatalog |  boost::adaptors::reversed) {
-    totalLength += name.wireEncode(encoder);
+    totalLength += prependSuffix(encoder, name, m_catalogPrefix.size());
   }
 
   totalLength += m_catalogPrefix.wireEncode(encoder);
@@ -204,21 +249,27 @@ FileManifest::push_back(const Name& name)
 {
   BOOST_ASSERT(name != m_catalogPrefix);
   BOOST_ASSERT(m_catalogPrefix.isPrefixOf(name));
-  m_catalog.push_back(name.toUri());
+  materializeCatalog();
+  m_catalog.push_back(name);
+  m_catalogLength += suffixEncodedSize(name, m_catalogPrefix.size());
 }
 
 bool
 FileManifest::remove(const ndn::Name& name) {
+  materializeCatalog();
   const auto it = std::find(m_catalog.begin(), m_catalog.end(), name);
   if (m_catalog.end() == it) {
     return false;
   }
+  m_catalogLength -= suffixEncodedSize(*it, m_catalogPrefix.size());
   m_catalog.erase(it);
   return true;
 }
 
 void
 FileManifest::finalize() {
+  // the content is encoded again, so the catalog no longer refers to the wire
+  materializeCatalog();
   m_catalog.shrink_to_fit();
   encodeContent();
 }
@@ -239,14 +290,27 @@ void FileManifest::encodeContent() {
   // Property    := DataSize | Signature
   resetWire();
 
+  // the length of the catalog is maintained as it changes, so only the other fields are
+  // estimated before encoding the content in a buffer of its size
   EncodingEstimator estimator;
-  size_t estimatedSize = encodeContent(estimator);
+  size_t valueLength = m_catalogLength;
+  valueLength += m_catalogPrefix.wireEncode(estimator);
+  valueLength += prependNonNegativeIntegerBlock(estimator, tlv::Content, m_dataPacketSize);
+  if (nullptr != m_submanifestPtr) {
+    valueLength += m_submanifestPtr->wireEncode(estimator);
+  }
+  size_t contentSize = tlv::sizeOfVarNumber(tlv::Content) + tlv::sizeOfVarNumber(valueLength) +
+                       valueLength;
 
-  EncodingBuffer buffer(estimatedSize, 0);
+  EncodingBuffer buffer(contentSize, 0);
   encodeContent(buffer);
 
   setContentType(tlv::ContentType_Blob);
   setContent(buffer.block());
+
+  MetaInfo metaInfo = getMetaInfo();
+  SegmentIndex::write(metaInfo, m_submanifestIndex);
+  setMetaInfo(metaInfo);
 }
 
 void
@@ -274,36 +338,79 @@ FileManifest::decodeContent() {
     BOOST_THROW_EXCEPTION(Error("Expected Content Type Blob"));
   }
 
-  const Block& content = Data::getContent();
-  content.parse();
+  m_submanifestIndex = SegmentIndex::read(getMetaInfo());
 
-  auto element = content.elements_begin();
-  if (content.elements_end() == element) {
+  // walk the elements without parsing the content, so that the names of the catalog are only
+  // decoded when they are accessed
+  const Block& content = Data::getContent();
+  const auto begin = content.value_begin();
+  const auto end = content.value_end();
+  auto it = begin;
+  if (end == it) {
     BOOST_THROW_EXCEPTION(Error("FileManifest with empty content"));
   }
-  if (element->type() == tlv::Name) {
-    Name name(*element);
-    m_submanifestPtr = std::make_shared<Name>(name);
-    ++element;
+  auto nextElement = [&content, &it, &end] {
+    auto elementBegin = it;
+    skipElement(it, end);
+    return Block(content, elementBegin, it);
+  };
+  Block element = nextElement();
+  if (element.type() == tlv::Name) {
+    m_submanifestPtr = std::make_shared<Name>(element);
+    element = nextElement();
   }
 
   // DataPacketSize
-  m_dataPacketSize = readNonNegativeInteger(*element);
-  ++element;
+  m_dataPacketSize = readNonNegativeInteger(element);
   // CatalogPrefix
-  m_catalogPrefix = Name(*element);
-  ++element;
+  m_catalogPrefix = Name(nextElement());
   // Catalog
   m_catalog.clear();
-  for (; element != content.elements_end(); ++element) {
-    element->parse();
-    Name name = m_catalogPrefix;
-    name.append(Name(*element));
-    if (name == m_catalogPrefix) {
+  m_wireCatalog = std::make_shared<WireCatalog>();
+  auto& offsets = m_wireCatalog->offsets;
+  while (end != it) {
+    offsets.push_back(static_cast<uint32_t>(it - begin));
+    auto typeBegin = it;
+    if (tlv::Name != tlv::readType(typeBegin, end)) {
+      BOOST_THROW_EXCEPTION(Error("Expected a Name in the catalog of a FileManifest"));
+    }
+    if (0 == skipElement(it, end)) {
       BOOST_THROW_EXCEPTION(Error("Empty name included in a FileManifest"));
     }
-    push_back(name);
   }
+  offsets.push_back(static_cast<uint32_t>(it - begin));
+  m_catalogLength = offsets.back() - offsets.front();
+}
+
+const std::vector<Name>&
+FileManifest::decodeCatalog() const
+{
+  // the copies sharing the catalog share the content it refers to, so any of them may decode it
+  auto& wireCatalog = *m_wireCatalog;
+  std::call_once(wireCatalog.decodeFlag, [this, &wireCatalog] {
+    const Block& content = Data::getContent();
+    const auto& offsets = wireCatalog.offsets;
+    wireCatalog.names.reserve(offsets.size() - 1);
+    for (size_t i = 0; i + 1 < offsets.size(); ++i) {
+      Name name = m_catalogPrefix;
+      name.append(Name(Block(content,
+                             content.value_begin() + offsets[i],
+                             content.value_begin() + offsets[i + 1])));
+      wireCatalog.names.push_back(std::move(name));
+    }
+  });
+  return wireCatalog.names;
+}
+
+void
+FileManifest::materializeCatalog()
+{
+  if (nullptr == m_wireCatalog) {
+    return;
+  }
+  // the other copies may still use the shared catalog
+  m_catalog = decodeCatalog();
+  m_wireCatalog.reset();
 }
 
 bool operator==(const FileManifest& lhs, const FileManifest& rhs) {
@@ -315,7 +422,8 @@ bool operator==(const FileManifest& lhs, const FileManifest& rhs) {
            && *rhs.submanifest_ptr() == *lhs.submanifest_ptr()
          )
       )
-      && lhs.catalog()          == rhs.catalog();
+      && lhs.catalog()          == rhs.catalog()
+      && lhs.submanifest_index() == rhs.submanifest_index();
 }
 
 bool operator!=(const FileManifest& lhs, const FileManifest& rhs) {
@@ -327,7 +435,8 @@ bool operator!=(const FileManifest& lhs, const FileManifest& rhs) {
          || *rhs.submanifest_ptr() != *lhs.submanifest_ptr()
         )
       )
-      || lhs.catalog()          != rhs.catalog();
+      || lhs.catalog()          != rhs.catalog()
+      || lhs.submanifest_index() != rhs.submanifest_index();
 }
 
 std::string
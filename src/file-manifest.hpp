@@ -21,8 +21,10 @@
 #ifndef INCLUDED_FILE_MANIFEST_HPP
 #define INCLUDED_FILE_MANIFEST_HPP
 
+#include <cstdint>
 #include <cstring>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <utility>
 #include <vector>
@@ -30,11 +32,15 @@
 #include <ndn-cxx/data.hpp>
 #include <ndn-cxx/name.hpp>
 
+#include "util/name-suffix.hpp"
 #include "util/shared-constants.hpp"
+#include "util/signing-service.hpp"
 
 namespace ndn {
 namespace ntorrent {
 
+class ThreadPool;
+
 class FileManifest : public Data {
 /**
 * \class FileManifest
@@ -70,6 +76,16 @@ class FileManifest : public Data {
            size_t             dataPacketSize,
            bool               returnData);
 
+  static std::pair<std::vector<FileManifest>, std::vector<Data>>
+  generate(const std::string& filePath,
+           const ndn::Name&   manifestPrefix,
+           size_t             subManifestSize,
+           size_t             dataPacketSize,
+           bool               returnData,
+           ThreadPool&        pool,
+           size_t             indexFanout = 0,
+           SigningService&    signer = *SigningService::getDefault());
+
   static
   Name
   manifestPrefix(const Name& manifestName);
@@ -81,13 +97,18 @@ class FileManifest : public Data {
    * @param subManifestSize The maximum number of data packets to be included in a sub-manifest
    * @param dataPacketSize The maximum number of bytes per Data packet packets for the file
    * @param returnData If true also return the Data
+   * @param pool The thread pool used to packetize the sub-manifests concurrently
+   * @param indexFanout If not 0, the sub-manifests are indexed in a tree of @p indexFanout
+   *        names per sub-manifest (see SegmentIndex), so that they can be requested in parallel
+   * @param signer The signing service signing the manifests and the Data packets
    *
    * @throws Error if there is any I/O issue when trying to read the filePath.
    *
    * Generates the FileManfiest(s) for the file at the specified 'filePath', splitting the manifest
    * into sub-manifests of size at most the specified 'subManifestSize'. Each sub-manifest is
    * composed of a  catalog of Data packets of at most the specified 'dataPacketSize'. Returns all
-   * of the manifests that were created in order. The behavior is undefined unless the
+   * of the manifests that were created in order. The output does not depend on the number of
+   * threads of the 'pool' used, if any. The behavior is undefined unless the
    * trailing component of of the manifestPrefix is a subComponent filePath and
    '* O < subManifestSize' and '0 < dataPacketSize'.
    */
@@ -159,9 +180,24 @@ class FileManifest : public Data {
   submanifest_ptr() const;
   /// Returns the 'submanifest_ptr' of this FileManifest, or 'nullptr' is none exists
 
+  const std::vector<Name>&
+  submanifest_index() const;
+  /// Returns the full names of the sub-manifests listed by the index of this FileManifest
+
   const std::vector<Name>&
   catalog() const;
-  /// Returns an unmodifiable reference to the 'catalog' of this FileManifest
+  /// Returns an unmodifiable reference to the 'catalog' of this FileManifest. The names of a
+  /// decoded FileManifest are decoded the first time any of them is accessed, once for all the
+  /// copies of the FileManifest, and it is safe to do so from several threads.
+
+  size_t
+  catalog_size() const;
+  /// Returns the number of names in the 'catalog' of this FileManifest
+
+  const Name&
+  catalog_name(size_t packetNum) const;
+  /// Returns the name at position 'packetNum' of the 'catalog' of this FileManifest. The behavior
+  /// is undefined unless 'packetNum < catalog_size()'.
 
  private:
   template<encoding::Tag TAG>
@@ -179,6 +215,10 @@ class FileManifest : public Data {
   set_submanifest_ptr(std::shared_ptr<Name> subManifestPtr);
   /// Sets the sub-manifest pointer of manifest to the specified 'subManifestPtr'
 
+  void
+  set_submanifest_index(const std::vector<Name>& subManifestIndex);
+  /// Sets the full names of the sub-manifests listed by the index of this FileManifest
+
   void
   push_back(const Name& name);
   /// Appends a Name to the catalog
@@ -218,12 +258,38 @@ private:
   encodeContent();
   /// Encodes the contents of this FileManifest into the content section of its Data packet.
 
+  const std::vector<Name>&
+  decodeCatalog() const;
+  /// Returns the names of the catalog decoded from the wire, decoding them on the first call.
+  /// The behavior is undefined unless 'm_wireCatalog' is set.
+
+  void
+  materializeCatalog();
+  /// Copies the names of a catalog decoded from the wire to 'm_catalog', so that it can be
+  /// modified.
+
+  struct WireCatalog {
+    // The offsets in the value of the content of the names of the catalog, followed by the
+    // offset of its end
+    std::vector<uint32_t> offsets;
+    std::once_flag        decodeFlag;
+    std::vector<Name>     names;
+  };
+  /// The catalog of a decoded FileManifest, shared by the copies of the FileManifest. Its names
+  /// are decoded once, under 'decodeFlag', by the first copy that accesses them.
+
 // DATA
  private:
-  size_t                 m_dataPacketSize;
-  Name                   m_catalogPrefix;
-  std::vector<Name>      m_catalog;
-  std::shared_ptr<Name>  m_submanifestPtr;
+  size_t                        m_dataPacketSize;
+  Name                          m_catalogPrefix;
+  // The names of the catalog, unless it is decoded from the wire
+  std::vector<Name>             m_catalog;
+  // The catalog decoded from the wire, or null once 'm_catalog' holds the names
+  std::shared_ptr<WireCatalog>  m_wireCatalog;
+  // The length of the encoding of the names of the catalog as suffixes of 'm_catalogPrefix'
+  size_t                        m_catalogLength;
+  std::shared_ptr<Name>         m_submanifestPtr;
+  std::vector<Name>             m_submanifestIndex;
 };
 
 /// Non-member functions
@@ -260,8 +326,13 @@ FileManifest::FileManifest(
 , m_dataPacketSize(dataPacketSize)
 , m_catalogPrefix(catalogPrefix)
 , m_catalog(catalog)
+, m_wireCatalog()
+, m_catalogLength(0)
 , m_submanifestPtr(subManifestPtr)
 {
+  for (const auto& packetName : m_catalog) {
+    m_catalogLength += suffixEncodedSize(packetName, m_catalogPrefix.size());
+  }
 }
 
 
@@ -275,9 +346,14 @@ FileManifest::FileManifest(
 : Data(name)
 , m_dataPacketSize(dataPacketSize)
 , m_catalogPrefix(catalogPrefix)
-, m_catalog(catalog)
+, m_catalog(std::move(catalog))
+, m_wireCatalog()
+, m_catalogLength(0)
 , m_submanifestPtr(subManifestPtr)
 {
+  for (const auto& packetName : m_catalog) {
+    m_catalogLength += suffixEncodedSize(packetName, m_catalogPrefix.size());
+  }
 }
 
 inline
@@ -286,7 +362,10 @@ FileManifest::FileManifest(const Block& block)
 , m_dataPacketSize(0)
 , m_catalogPrefix("")
 , m_catalog()
+, m_wireCatalog()
+, m_catalogLength(0)
 , m_submanifestPtr(nullptr)
+, m_submanifestIndex()
 {
   wireDecode(block);
 }
@@ -312,7 +391,20 @@ FileManifest::catalog_prefix() const
 inline const std::vector<Name>&
 FileManifest::catalog() const
 {
-  return m_catalog;
+  return nullptr == m_wireCatalog ? m_catalog : decodeCatalog();
+}
+
+inline size_t
+FileManifest::catalog_size() const
+{
+  return nullptr == m_wireCatalog ? m_catalog.size() : m_wireCatalog->offsets.size() - 1;
+}
+
+inline const Name&
+FileManifest::catalog_name(size_t packetNum) const
+{
+  BOOST_ASSERT(packetNum < catalog_size());
+  return catalog()[packetNum];
 }
 
 inline std::shared_ptr<Name>
@@ -321,6 +413,12 @@ FileManifest::submanifest_ptr() const
   return m_submanifestPtr;
 }
 
+inline const std::vector<Name>&
+FileManifest::submanifest_index() const
+{
+  return m_submanifestIndex;
+}
+
 inline size_t
 FileManifest::submanifest_number() const
 {
@@ -333,9 +431,16 @@ FileManifest::set_submanifest_ptr(std::shared_ptr<Name> subManifestPtr)
   m_submanifestPtr = subManifestPtr;
 }
 
+inline void
+FileManifest::set_submanifest_index(const std::vector<Name>& subManifestIndex)
+{
+  m_submanifestIndex = subManifestIndex;
+}
+
 inline void
 FileManifest::reserve(size_t capacity)
 {
+  materializeCatalog();
   m_catalog.reserve(capacity);
 }
 
@@ -24,19 +24,154 @@
 namespace ndn {
 namespace ntorrent {
 
+// The share of the pops of each class, when all of them are non-empty
+static const int64_t WEIGHTS[InterestQueue::NUM_PRIORITIES] = {
+  16, // TORRENT_FILE_PRIORITY
+  8,  // FILE_MANIFEST_PRIORITY
+  4,  // HIGH_DATA_PRIORITY
+  2,  // DATA_PRIORITY
+  1,  // LOW_DATA_PRIORITY
+  1,  // BITMAP_PRIORITY, which loses the ties with LOW_DATA_PRIORITY
+};
+
+InterestQueue::Ring::Ring()
+: entries(16)
+, head(0)
+, size(0)
+{
+}
+
+InterestQueue::Entry&
+InterestQueue::Ring::at(size_t i)
+{
+  return entries[(head + i) & (entries.size() - 1)];
+}
+
 void
-InterestQueue::push(shared_ptr<Interest> interest, DataCallback dataReceivedCallback,
-     TimeoutCallback dataFailedCallback)
+InterestQueue::Ring::push(const Entry& entry)
+{
+  if (size == entries.size()) {
+    // unwrap the entries into a buffer of twice the capacity
+    std::vector<Entry> unwrapped(2 * entries.size());
+    for (size_t i = 0; i < size; ++i) {
+      unwrapped[i] = at(i);
+    }
+    entries.swap(unwrapped);
+    head = 0;
+  }
+  at(size) = entry;
+  ++size;
+}
+
+InterestQueue::InterestQueue()
+: m_size(0)
+, m_credits()
+, m_scheduled(NUM_PRIORITIES)
 {
-  m_queue.push(std::make_tuple(interest, dataReceivedCallback, dataFailedCallback));
 }
 
-queueTuple
+InterestQueue::ContextId
+InterestQueue::createContext(DataCallback dataReceivedCallback, TimeoutCallback dataFailedCallback,
+                             const Name& forwardingHint)
+{
+  ContextId context;
+  if (m_freeContexts.empty()) {
+    context = m_contexts.size();
+    m_contexts.emplace_back();
+  }
+  else {
+    context = m_freeContexts.back();
+    m_freeContexts.pop_back();
+  }
+  auto& c = m_contexts[context];
+  c.onData = dataReceivedCallback;
+  c.onTimeout = dataFailedCallback;
+  c.forwardingHint = forwardingHint;
+  c.references = 1;
+  return context;
+}
+
+void
+InterestQueue::releaseContext(ContextId context)
+{
+  unreference(context);
+}
+
+void
+InterestQueue::push(ContextId context, const Name& name, Priority priority)
+{
+  auto& names = m_contexts[context].names;
+  pushEntry({context, static_cast<uint32_t>(names.size()), 0, NAMED_ENTRY}, priority);
+  names.push_back(name);
+}
+
+void
+InterestQueue::push(ContextId context, size_t manifestId, size_t packetNum, Priority priority)
+{
+  pushEntry({context, static_cast<uint32_t>(manifestId), static_cast<uint32_t>(packetNum),
+             CATALOG_ENTRY},
+            priority);
+}
+
+void
 InterestQueue::pop()
 {
-  queueTuple tup = m_queue.front();
-  m_queue.pop();
-  return tup;
+  auto& ring = m_rings[schedule()];
+  ContextId context = ring.at(0).context;
+  ring.head = (ring.head + 1) & (ring.entries.size() - 1);
+  --ring.size;
+  --m_size;
+  // an empty class neither keeps credit nor owes any
+  if (0 == ring.size) {
+    m_credits[m_scheduled] = 0;
+  }
+  m_scheduled = NUM_PRIORITIES;
+  unreference(context);
+}
+
+void
+InterestQueue::pushEntry(const Entry& entry, Priority priority)
+{
+  m_rings[priority].push(entry);
+  ++m_size;
+  ++m_contexts[entry.context].references;
+}
+
+void
+InterestQueue::unreference(ContextId context)
+{
+  auto& c = m_contexts[context];
+  if (0 != --c.references) {
+    return;
+  }
+  // release the callbacks and whatever they capture
+  c.onData = nullptr;
+  c.onTimeout = nullptr;
+  std::vector<Name>().swap(c.names);
+  m_freeContexts.push_back(context);
+}
+
+size_t
+InterestQueue::schedule() const
+{
+  if (NUM_PRIORITIES != m_scheduled) {
+    return m_scheduled;
+  }
+  int64_t totalWeight = 0;
+  for (size_t i = 0; i < NUM_PRIORITIES; ++i) {
+    if (0 == m_rings[i].size) {
+      continue;
+    }
+    m_credits[i] += WEIGHTS[i];
+    totalWeight += WEIGHTS[i];
+    if (NUM_PRIORITIES == m_scheduled || m_credits[i] > m_credits[m_scheduled]) {
+      m_scheduled = i;
+    }
+  }
+  if (NUM_PRIORITIES != m_scheduled) {
+    m_credits[m_scheduled] -= totalWeight;
+  }
+  return m_scheduled;
 }
 
 } // namespace ntorrent
@@ -19,49 +19,155 @@
 * See AUTHORS for complete list of nTorrent authors and contributors.
 */
 
+#ifndef INCLUDED_INTEREST_QUEUE_HPP
+#define INCLUDED_INTEREST_QUEUE_HPP
+
 #include <ndn-cxx/data.hpp>
 #include <ndn-cxx/face.hpp>
 #include <ndn-cxx/interest.hpp>
 
-#include <queue>
-#include <tuple>
-
-typedef std::tuple<std::shared_ptr<ndn::Interest>, ndn::DataCallback, ndn::TimeoutCallback> queueTuple;
+#include <cstdint>
+#include <vector>
 
 namespace ndn {
 namespace ntorrent {
 
+/**
+ * @brief A queue of the Interests we have yet to send
+ *
+ * The Interests are built when they are sent, so the queue only holds a small entry for each of
+ * them. The entries of the packets of a file manifest refer to the packet by the position of the
+ * manifest and of the packet in its catalog. The other entries refer to a name stored once in their
+ * context. The callbacks are stored in a context shared by all the entries of a download, which is
+ * released once the entries are popped and its creator releases it.
+ *
+ * The entries are queued by priority class, and the classes are served by smooth weighted
+ * round-robin: each non-empty class earns credit in proportion to its weight at every pop, and the
+ * class with the most credit is served. The segments of the torrent file and of the manifests,
+ * which unlock many more Interests, get most of the pops while a backlog of data packets is queued,
+ * and no non-empty class is ever starved.
+ */
 class InterestQueue
 {
 public:
-  InterestQueue() = default;
+  typedef uint32_t ContextId;
+
+  enum EntryType : uint8_t {
+    // The name is stored in the context of the entry
+    NAMED_ENTRY = 0,
+    // The name is the packet at @p packetNum in the catalog of the manifest at @p index
+    CATALOG_ENTRY = 1
+  };
+
+  enum Priority : uint8_t {
+    TORRENT_FILE_PRIORITY = 0,
+    FILE_MANIFEST_PRIORITY,
+    HIGH_DATA_PRIORITY,
+    DATA_PRIORITY,
+    LOW_DATA_PRIORITY,
+    // The requests for the bitmaps of the peers, which only refine the order of the downloads
+    BITMAP_PRIORITY,
+    NUM_PRIORITIES
+  };
+
+  struct Entry
+  {
+    // The context holding the callbacks (and the name) of the entry
+    ContextId     context;
+    // The position of the name in the context, or the id of the manifest of the packet
+    uint32_t      index;
+    // The position of the packet in the catalog of its manifest
+    uint32_t      packetNum;
+    EntryType     type;
+  };
+
+  InterestQueue();
 
   ~InterestQueue() = default;
 
   /**
-   * @brief Push a tuple to the Interest Queue
-   * @param interest A shared pointer to an Interest
-   * @param dataReceivedCallback Callback to be called when data is received for the given
-   *                             Interest
-   * @param dataFailedCallback Callback to be called when we fail to retrieve data for the
-   *                           given Interest
+   * @brief Create a context shared by Interests with the same callbacks
+   * @param dataReceivedCallback Callback to be called when data is received for one of the
+   *                             Interests
+   * @param dataFailedCallback Callback to be called when we fail to retrieve data for one of the
+   *                           Interests
+   * @param forwardingHint (optional) The routable prefix of the peer to which the Interests must
+   *                       be sent, by default the sender chooses it
    *
+   * The context is kept until the caller releases it and all its entries are popped.
+   */
+  ContextId
+  createContext(DataCallback dataReceivedCallback, TimeoutCallback dataFailedCallback,
+                const Name& forwardingHint = Name());
+
+  /**
+   * @brief Release the reference of the creator of @p context
    */
   void
-  push(shared_ptr<Interest> interest, DataCallback dataReceivedCallback,
-       TimeoutCallback dataFailedCallback);
+  releaseContext(ContextId context);
 
   /**
-   * @brief Pop a tuple from the Interest Queue
-   * @return A tuple of a shared pointer to an Interest, a callaback for successful data
-   *         retrieval and a callback for failed data retrieval
+   * @brief Push an entry for the Interest @p name to the Interest Queue
    */
-  queueTuple
+  void
+  push(ContextId context, const Name& name, Priority priority = DATA_PRIORITY);
+
+  /**
+   * @brief Push an entry for the packet @p packetNum of the manifest with the id @p manifestId
+   *
+   * The id of a manifest is given by its owner and must not change while the entry is queued, so
+   * that the entries do not need to be updated when manifests are added.
+   */
+  void
+  push(ContextId context, size_t manifestId, size_t packetNum,
+       Priority priority = DATA_PRIORITY);
+
+  /**
+   * @brief Pop the top entry of the Interest Queue
+   */
+  void
   pop();
 
   /**
-   * @brief Return the size of the queue (number of tuples)
-   * @return The number of tuples stored in the queue
+   * @brief Return the top entry of the Interest queue, the next entry of the class scheduled
+   *
+   * The queue must not be empty.
+   */
+  const Entry&
+  front() const;
+
+  /**
+   * @brief Return the number of entries of the class @p priority
+   */
+  size_t
+  size(Priority priority) const;
+
+  /**
+   * @brief Return the name of @p entry, which must be a NAMED_ENTRY
+   */
+  const Name&
+  getName(const Entry& entry) const;
+
+  /**
+   * @brief Return the callback for the Data received for the Interests of @p context
+   */
+  const DataCallback&
+  getDataCallback(ContextId context) const;
+
+  /**
+   * @brief Return the callback for the Interests of @p context that time out
+   */
+  const TimeoutCallback&
+  getTimeoutCallback(ContextId context) const;
+
+  /**
+   * @brief Return the forwarding hint of the Interests of @p context, empty if there is none
+   */
+  const Name&
+  getForwardingHint(ContextId context) const;
+
+  /**
+   * @brief Return the size of the queue (number of entries)
    */
   size_t
   size() const;
@@ -73,34 +179,104 @@ public:
   bool
   empty() const;
 
-  /**
-   * @brief Return the top element of the Interest queue
-   * @return The top tuple element of the Interest queue
-   */
-   queueTuple
-   front() const;
+private:
+  struct Context
+  {
+    DataCallback        onData;
+    TimeoutCallback     onTimeout;
+    std::vector<Name>   names;
+    Name                forwardingHint;
+    // The number of entries of the context in the queue, plus one until its creator releases it
+    size_t              references;
+  };
+
+  // A ring buffer of the entries of a class, whose capacity is a power of two
+  struct Ring
+  {
+    Ring();
+
+    Entry&
+    at(size_t i);
+
+    void
+    push(const Entry& entry);
+
+    std::vector<Entry>      entries;
+    size_t                  head;
+    size_t                  size;
+  };
+
+  void
+  pushEntry(const Entry& entry, Priority priority);
+
+  void
+  unreference(ContextId context);
+
+  // Return the class served next, scheduling one if none is
+  size_t
+  schedule() const;
 
 private:
-  std::queue<queueTuple> m_queue;
+  Ring                      m_rings[NUM_PRIORITIES];
+  size_t                    m_size;
+  // The credit of each class in the weighted round-robin
+  mutable int64_t           m_credits[NUM_PRIORITIES];
+  // The class scheduled to be served by the next pop, NUM_PRIORITIES if none is
+  mutable size_t            m_scheduled;
+  std::vector<Context>      m_contexts;
+  std::vector<ContextId>    m_freeContexts;
 };
 
 inline size_t
 InterestQueue::size() const
 {
-  return m_queue.size();
+  return m_size;
 }
 
 inline bool
 InterestQueue::empty() const
 {
-  return m_queue.empty();
+  return 0 == m_size;
 }
 
-inline queueTuple
+inline size_t
+InterestQueue::size(Priority priority) const
+{
+  return m_rings[priority].size;
+}
+
+inline const InterestQueue::Entry&
 InterestQueue::front() const
 {
-  return m_queue.front();
+  auto& ring = m_rings[schedule()];
+  return ring.entries[ring.head];
+}
+
+inline const Name&
+InterestQueue::getName(const Entry& entry) const
+{
+  return m_contexts[entry.context].names[entry.index];
+}
+
+inline const DataCallback&
+InterestQueue::getDataCallback(ContextId context) const
+{
+  return m_contexts[context].onData;
+}
+
+inline const TimeoutCallback&
+InterestQueue::getTimeoutCallback(ContextId context) const
+{
+  return m_contexts[context].onTimeout;
+}
+
+inline const Name&
+InterestQueue::getForwardingHint(ContextId context) const
+{
+  return m_contexts[context].forwardingHint;
 }
 
 } // namespace ntorrent
 } // namespace ndn
+
+#endif // INCLUDED_INTEREST_QUEUE_HPP
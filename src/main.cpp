@@ -18,13 +18,16 @@
  *
  * See AUTHORS.md for complete list of nTorrent authors and contributors.
  */
+#include "rarest-first-data-fetcher.hpp"
 #include "sequential-data-fetcher.hpp"
 #include "torrent-file.hpp"
 #include "util/io-util.hpp"
 #include "util/logging.hpp"
+#include "util/thread-pool.hpp"
 
 #include <iostream>
 #include <iterator>
+#include <memory>
 #include <stdexcept>
 #include <algorithm>
 #include <unordered_map>
@@ -69,6 +72,13 @@ int main(int argc, char *argv[])
       ("help,h", "produce help message")
       ("generate,g" , "-g <data directory> <output-path>? <names-per-segment>? <names-per-manifest-segment>? <data-packet-size>?")
       ("seed,s", "After download completes, continue to seed")
+      ("threads,j", po::value<size_t>(), "-j <n> Use <n> threads to generate a torrent (default: number of cores)")
+      ("manifest-index", po::value<size_t>(), "--manifest-index <fanout> Index the segments of the torrent-file and the sub-manifests of each file in a tree of <fanout> names per segment, so that downloaders can request them in parallel (default: no index)")
+      ("io-threads", po::value<size_t>(), "--io-threads <n> Use <n> threads for disk I/O when downloading and seeding (default: 1)")
+      ("congestion-control", po::value<std::string>(), (std::string("--congestion-control <algorithm> Pace the Interests with aimd | cubic (default: ") + CongestionController::DEFAULT_ALGORITHM + ")").c_str())
+      ("strategy", po::value<std::string>(), "--strategy <strategy> Fetch the data packets in sequential | rarest-first order (default: sequential)")
+      ("verify", "Hash the data restored from the resume journal again in the background on startup")
+      ("lazy-init", "Hash the data missing from the resume journal in the background on startup, so that seeding starts at once")
       ("dump,d", "-d <file> Dump the contents of the Data stored at the <file>.")
       ("log-level", po::value<std::string>(), "trace | debug | info | warming | error | fatal | console")
       ("args", po::value<std::vector<std::string> >(), "For arguments you want to specify without flags")
@@ -122,10 +132,18 @@ int main(int argc, char *argv[])
         auto namesPerManifest = args.size() >= 4 ? boost::lexical_cast<size_t>(args[3]) : 1024;
         auto dataPacketSize   = args.size() == 5 ? boost::lexical_cast<size_t>(args[4]) : 1024;
 
+        auto numThreads = vm.count("threads") ? vm["threads"].as<size_t>()
+                                              : ThreadPool::defaultNumThreads();
+        // the calling thread also runs tasks of the pool
+        ThreadPool pool(numThreads > 1 ? numThreads - 1 : 0);
+        auto indexFanout = vm.count("manifest-index") ? vm["manifest-index"].as<size_t>() : 0;
         const auto& content = TorrentFile::generate(dataPath,
                                                     namesPerSegment,
                                                     namesPerManifest,
-                                                    dataPacketSize);
+                                                    dataPacketSize,
+                                                    false,
+                                                    pool,
+                                                    indexFanout);
         const auto& torrentSegments = content.first;
         std::vector<FileManifest> manifests;
         for (const auto& ms : content.second) {
@@ -172,8 +190,26 @@ int main(int argc, char *argv[])
         auto torrentName = args[0];
         auto dataPath    = args[1];
         auto seedFlag    = (vm.count("seed") != 0);
-        SequentialDataFetcher fetcher(torrentName, dataPath, seedFlag);
-        fetcher.start();
+        auto ioThreads   = vm.count("io-threads") ? vm["io-threads"].as<size_t>() : 1;
+        auto congestionControl = vm.count("congestion-control")
+                                   ? vm["congestion-control"].as<std::string>()
+                                   : CongestionController::DEFAULT_ALGORITHM;
+        auto strategy = vm.count("strategy") ? vm["strategy"].as<std::string>() : "sequential";
+        auto verify   = (vm.count("verify") != 0);
+        auto lazyInit = (vm.count("lazy-init") != 0);
+        std::unique_ptr<FetchingStrategyManager> fetcher;
+        if ("sequential" == strategy) {
+          fetcher.reset(new SequentialDataFetcher(torrentName, dataPath, seedFlag, ioThreads,
+                                                  congestionControl, verify, lazyInit));
+        }
+        else if ("rarest-first" == strategy) {
+          fetcher.reset(new RarestFirstDataFetcher(torrentName, dataPath, seedFlag, ioThreads,
+                                                   congestionControl, verify, lazyInit));
+        }
+        else {
+          throw ndn::Error("Unsupported fetching strategy: " + strategy);
+        }
+        fetcher->start();
       }
     }
     else {
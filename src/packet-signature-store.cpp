@@ -0,0 +1,235 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+* Copyright (c) 2016 Regents of the University of California.
+*
+* This file is part of the nTorrent codebase.
+*
+* nTorrent is free software: you can redistribute it and/or modify it under the
+* terms of the GNU Lesser General Public License as published by the Free Software
+* Foundation, either version 3 of the License, or (at your option) any later version.
+*
+* nTorrent is distributed in the hope that it will be useful, but WITHOUT ANY
+* WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+* PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+*
+* You should have received copies of the GNU General Public License and GNU Lesser
+* General Public License along with nTorrent, e.g., in COPYING.md file. If not, see
+* <http://www.gnu.org/licenses/>.
+*
+* See AUTHORS for complete list of nTorrent authors and contributors.
+*/
+
+#include "packet-signature-store.hpp"
+
+#include "util/file-fingerprint.hpp"
+#include "util/io-util.hpp"
+#include "util/logging.hpp"
+
+#include <algorithm>
+#include <unordered_set>
+
+#include <boost/filesystem/fstream.hpp>
+
+#include <ndn-cxx/encoding/block-helpers.hpp>
+
+namespace fs = boost::filesystem;
+
+namespace ndn {
+namespace ntorrent {
+
+enum {
+  // The size of the implicit digest of the sub-manifest and the fingerprint of its data file
+  HEADER_SIZE = PacketSignatureStore::DIGEST_SIZE + 8 + 8 + 8
+};
+
+static void
+appendInteger(std::vector<uint8_t>& buffer, uint64_t value, size_t size)
+{
+  for (size_t i = 0; i < size; ++i) {
+    buffer.push_back(static_cast<uint8_t>(value >> (8 * i)));
+  }
+}
+
+static uint64_t
+readInteger(const uint8_t* buffer, size_t size)
+{
+  uint64_t value = 0;
+  for (size_t i = 0; i < size; ++i) {
+    value |= uint64_t(buffer[i]) << (8 * i);
+  }
+  return value;
+}
+
+PacketSignatureStore::Record&
+PacketSignatureStore::load(const FileManifest& manifest)
+{
+  const auto& manifestFullName = manifest.getFullName();
+  auto it = m_records.find(manifestFullName);
+  if (m_records.end() != it) {
+    return it->second;
+  }
+  Record& record = m_records[manifestFullName];
+  const auto& digest = manifestFullName.get(-1);
+  record.path = m_path + manifest.file_name() + "/" + to_string(manifest.submanifest_number());
+  record.dataPath = m_dataPath + manifest.file_name();
+  record.manifestDigest.assign(digest.value(), digest.value() + digest.value_size());
+  record.signatures.assign(manifest.catalog_size() * DIGEST_SIZE, 0);
+  record.dirty = false;
+
+  // read the signatures on disk, if they refer to this very sub-manifest
+  fs::ifstream is(record.path, fs::ifstream::binary);
+  if (!is) {
+    return record;
+  }
+  std::vector<uint8_t> header(HEADER_SIZE);
+  is.read(reinterpret_cast<char*>(header.data()), header.size());
+  if (is.gcount() != HEADER_SIZE ||
+      !std::equal(record.manifestDigest.begin(), record.manifestDigest.end(), header.begin())) {
+    return record;
+  }
+  // and to the data file as it is on disk
+  FileFingerprint recorded = {readInteger(&header[DIGEST_SIZE], 8),
+                              readInteger(&header[DIGEST_SIZE + 8], 8),
+                              readInteger(&header[DIGEST_SIZE + 16], 8)};
+  FileFingerprint fingerprint;
+  if (!fingerprint.read(record.dataPath) || recorded != fingerprint) {
+    LOG_INFO << "File changed since its signatures were written: " << record.dataPath << std::endl;
+    return record;
+  }
+  is.read(reinterpret_cast<char*>(record.signatures.data()), record.signatures.size());
+  if (static_cast<size_t>(is.gcount()) != record.signatures.size()) {
+    LOG_ERROR << "Truncated signature file: " << record.path << std::endl;
+    std::fill(record.signatures.begin() + is.gcount(), record.signatures.end(), 0);
+  }
+  return record;
+}
+
+shared_ptr<Block>
+PacketSignatureStore::find(const FileManifest& manifest, size_t packetNum)
+{
+  const auto& record = load(manifest);
+  if ((packetNum + 1) * DIGEST_SIZE > record.signatures.size()) {
+    return nullptr;
+  }
+  auto begin = record.signatures.begin() + packetNum * DIGEST_SIZE;
+  auto end = begin + DIGEST_SIZE;
+  if (std::all_of(begin, end, [] (uint8_t b) { return 0 == b; })) {
+    return nullptr;
+  }
+  return make_shared<Block>(encoding::makeBinaryBlock(tlv::SignatureValue, &*begin, DIGEST_SIZE));
+}
+
+void
+PacketSignatureStore::insert(const FileManifest& manifest, size_t packetNum, const Data& packet)
+{
+  SignatureValues signatures(1);
+  if (getSignatureValue(packet, signatures[0].second)) {
+    signatures[0].first = packetNum;
+    insert(manifest, signatures);
+  }
+}
+
+void
+PacketSignatureStore::insert(const FileManifest& manifest, const SignatureValues& signatures)
+{
+  if (signatures.empty()) {
+    return;
+  }
+  auto& record = load(manifest);
+  for (const auto& signature : signatures) {
+    if ((signature.first + 1) * DIGEST_SIZE > record.signatures.size()) {
+      continue;
+    }
+    std::copy(signature.second.begin(), signature.second.end(),
+              record.signatures.begin() + signature.first * DIGEST_SIZE);
+    record.dirty = true;
+    m_isDirty = true;
+  }
+}
+
+void
+PacketSignatureStore::markDirty(const Name& manifestName)
+{
+  auto it = m_records.find(manifestName);
+  if (m_records.end() != it) {
+    it->second.dirty = true;
+    m_isDirty = true;
+  }
+}
+
+bool
+PacketSignatureStore::getSignatureValue(const Data& packet, SignatureValue& value)
+{
+  const auto& signature = packet.getSignature();
+  const auto& signatureValue = signature.getValue();
+  if (tlv::DigestSha256 != signature.getType() || DIGEST_SIZE != signatureValue.value_size()) {
+    return false;
+  }
+  std::copy(signatureValue.value_begin(), signatureValue.value_end(), value.begin());
+  return true;
+}
+
+std::vector<PacketSignatureStore::Write>
+PacketSignatureStore::takeWrites()
+{
+  std::vector<Write> writes;
+  if (!m_isDirty) {
+    return writes;
+  }
+  m_isDirty = false;
+  std::unordered_set<std::string> dirtyFiles;
+  for (const auto& entry : m_records) {
+    if (entry.second.dirty) {
+      dirtyFiles.insert(entry.second.dataPath);
+    }
+  }
+  for (auto& entry : m_records) {
+    auto& record = entry.second;
+    if (0 == dirtyFiles.count(record.dataPath)) {
+      continue;
+    }
+    writes.push_back({entry.first,
+                      record.path,
+                      record.dataPath,
+                      record.manifestDigest,
+                      record.signatures});
+    record.dirty = false;
+  }
+  return writes;
+}
+
+std::vector<Name>
+PacketSignatureStore::write(const std::vector<Write>& writes) const
+{
+  std::vector<Name> failedManifests;
+  for (const auto& write : writes) {
+    FileFingerprint fingerprint;
+    if (!fingerprint.read(write.dataPath)) {
+      // there is nothing on disk the signatures could be checked against
+      continue;
+    }
+    std::vector<uint8_t> buffer(write.manifestDigest);
+    appendInteger(buffer, fingerprint.size, 8);
+    appendInteger(buffer, fingerprint.modificationTime, 8);
+    appendInteger(buffer, fingerprint.inode, 8);
+    buffer.insert(buffer.end(), write.signatures.begin(), write.signatures.end());
+    if (!IoUtil::replaceFile(write.path, buffer)) {
+      LOG_ERROR << "Write failed: " << write.path << std::endl;
+      failedManifests.push_back(write.manifestName);
+    }
+  }
+  return failedManifests;
+}
+
+bool
+PacketSignatureStore::flush()
+{
+  auto failedManifests = write(takeWrites());
+  for (const auto& manifestName : failedManifests) {
+    markDirty(manifestName);
+  }
+  return failedManifests.empty();
+}
+
+} // namespace ntorrent
+} // namespace ndn
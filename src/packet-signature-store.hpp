@@ -0,0 +1,215 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+* Copyright (c) 2016 Regents of the University of California.
+*
+* This file is part of the nTorrent codebase.
+*
+* nTorrent is free software: you can redistribute it and/or modify it under the
+* terms of the GNU Lesser General Public License as published by the Free Software
+* Foundation, either version 3 of the License, or (at your option) any later version.
+*
+* nTorrent is distributed in the hope that it will be useful, but WITHOUT ANY
+* WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+* PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+*
+* You should have received copies of the GNU General Public License and GNU Lesser
+* General Public License along with nTorrent, e.g., in COPYING.md file. If not, see
+* <http://www.gnu.org/licenses/>.
+*
+* See AUTHORS for complete list of nTorrent authors and contributors.
+*/
+
+#ifndef INCLUDED_PACKET_SIGNATURE_STORE_HPP
+#define INCLUDED_PACKET_SIGNATURE_STORE_HPP
+
+#include "file-manifest.hpp"
+
+#include <ndn-cxx/data.hpp>
+#include <ndn-cxx/encoding/block.hpp>
+#include <ndn-cxx/name.hpp>
+
+#include <array>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace ndn {
+namespace ntorrent {
+
+/**
+ * @brief A persistent store of the signatures of the Data packets of a torrent
+ *
+ * All the Data packets of a torrent are signed with a SHA-256 digest, so a packet is fully
+ * determined by its name, its content and its signature value. This store keeps the signature
+ * value of every packet that has been validated against its file manifest, so that the packet can
+ * be reconstructed from the bytes on disk without signing it again.
+ *
+ * The signatures of each sub-manifest are kept in a separate file
+ * <path>/<file_name>/<submanifest_number>, composed of the implicit digest of the sub-manifest and
+ * the fingerprint of the data file when the signatures were written, followed by one fixed-size
+ * record per packet of its catalog. The signatures of a data file that changed on disk since then
+ * are dropped, as a packet rebuilt from its new bytes would carry the signature of the old ones.
+ */
+class PacketSignatureStore {
+public:
+  enum {
+    // Size in bytes of a SHA-256 digest
+    DIGEST_SIZE = 32
+  };
+
+  // The signature value of a Data packet signed with a SHA-256 digest
+  typedef std::array<uint8_t, DIGEST_SIZE>                 SignatureValue;
+  // The sequence number of each packet of a sub-manifest with its signature value
+  typedef std::vector<std::pair<size_t, SignatureValue>>   SignatureValues;
+
+  /**
+   * @brief The signatures to be written to the file of a sub-manifest, see takeWrites
+   */
+  struct Write {
+    // The full name of the sub-manifest
+    Name                   manifestName;
+    std::string            path;
+    std::string            dataPath;
+    std::vector<uint8_t>   manifestDigest;
+    std::vector<uint8_t>   signatures;
+  };
+
+  /**
+   * @brief Create a new store
+   * @param path The path to the directory holding the signatures of the torrent on disk
+   * @param dataPath The path to the directory holding the data files of the torrent
+   */
+  PacketSignatureStore(const std::string& path, const std::string& dataPath);
+
+  ~PacketSignatureStore() = default;
+
+  /**
+   * @brief Find the signature value of a Data packet
+   * @param manifest The sub-manifest of the packet
+   * @param packetNum The sequence number of the packet in the catalog of @p manifest
+   * @return A pointer to the SignatureValue block of the packet if it is known, otherwise nullptr
+   */
+  shared_ptr<Block>
+  find(const FileManifest& manifest, size_t packetNum);
+
+  /**
+   * @brief Insert the signature value of a Data packet to the store
+   * @param manifest The sub-manifest of the packet
+   * @param packetNum The sequence number of the packet in the catalog of @p manifest
+   * @param packet The packet. Its full name must already be validated against @p manifest.
+   *
+   * Only packets signed with a SHA-256 digest are stored. The signature is written to disk on the
+   * next call to flush().
+   */
+  void
+  insert(const FileManifest& manifest, size_t packetNum, const Data& packet);
+
+  /**
+   * @brief Insert the signature values of several Data packets of a sub-manifest to the store
+   * @param manifest The sub-manifest of the packets
+   * @param signatures The signature values collected by getSignatureValue(), along with the
+   *                   sequence number of each packet in the catalog of @p manifest
+   *
+   * The threads validating the packets of a sub-manifest collect their signatures on their own,
+   * and insert them at once.
+   */
+  void
+  insert(const FileManifest& manifest, const SignatureValues& signatures);
+
+  /**
+   * @brief Get the signature value of a Data packet to be inserted to the store later
+   * @return True if @p packet is signed with a SHA-256 digest. Otherwise, false
+   */
+  static bool
+  getSignatureValue(const Data& packet, SignatureValue& value);
+
+  /**
+   * @brief Mark the signatures of the sub-manifest @p manifestName to be written on the next flush,
+   *        e.g. because writing them failed
+   */
+  void
+  markDirty(const Name& manifestName);
+
+  /**
+   * @brief Return whether there are signatures to write since the last flush
+   */
+  bool
+  isDirty() const;
+
+  /**
+   * @brief Take the signatures to be written since the last flush
+   *
+   * The signatures of all the loaded sub-manifests of a file are taken along with those inserted
+   * since the last flush, as the file changed since they were written, so that they are recorded
+   * with the current fingerprint of the file.
+   */
+  std::vector<Write>
+  takeWrites();
+
+  /**
+   * @brief Write the signatures taken by takeWrites to disk
+   * @return The full names of the sub-manifests whose signatures could not be written, which must
+   *         be marked as dirty
+   *
+   * Each file is replaced by a new one renamed over it, so that a crash leaves either of them. Only
+   * reads the data files on disk, so it may run on any thread.
+   */
+  std::vector<Name>
+  write(const std::vector<Write>& writes) const;
+
+  /**
+   * @brief Take the signatures to be written and write them to disk
+   * @return True if all the signatures were written successfully. Otherwise, false
+   */
+  bool
+  flush();
+
+private:
+  struct Record {
+    // The path to the file holding the signatures of this sub-manifest
+    std::string          path;
+    // The path to the data file of the sub-manifest
+    std::string          dataPath;
+    // The implicit digest of the sub-manifest
+    std::vector<uint8_t> manifestDigest;
+    // The signature value of each packet (all zeros if unknown)
+    std::vector<uint8_t> signatures;
+    // Whether there are signatures not written to disk yet
+    bool                 dirty;
+  };
+
+  /**
+   * @brief Return the record for @p manifest, loading it from disk if needed
+   */
+  Record&
+  load(const FileManifest& manifest);
+
+private:
+  std::string                         m_path;
+  std::string                         m_dataPath;
+  // A map from the full name of each sub-manifest to its record
+  std::unordered_map<Name, Record>    m_records;
+  // Whether any record has signatures not written to disk yet
+  bool                                m_isDirty;
+};
+
+inline
+PacketSignatureStore::PacketSignatureStore(const std::string& path, const std::string& dataPath)
+  : m_path(path)
+  , m_dataPath(dataPath)
+  , m_records()
+  , m_isDirty(false)
+{
+}
+
+inline bool
+PacketSignatureStore::isDirty() const
+{
+  return m_isDirty;
+}
+
+} // namespace ntorrent
+} // namespace ndn
+
+#endif // INCLUDED_PACKET_SIGNATURE_STORE_HPP
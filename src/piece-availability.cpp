@@ -0,0 +1,208 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+* Copyright (c) 2016 Regents of the University of California.
+*
+* This file is part of the nTorrent codebase.
+*
+* nTorrent is free software: you can redistribute it and/or modify it under the
+* terms of the GNU Lesser General Public License as published by the Free Software
+* Foundation, either version 3 of the License, or (at your option) any later version.
+*
+* nTorrent is distributed in the hope that it will be useful, but WITHOUT ANY
+* WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+* PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+*
+* You should have received copies of the GNU General Public License and GNU Lesser
+* General Public License along with nTorrent, e.g., in COPYING.md file. If not, see
+* <http://www.gnu.org/licenses/>.
+*
+* See AUTHORS for complete list of nTorrent authors and contributors.
+*/
+
+#include "piece-availability.hpp"
+
+#include <boost/assert.hpp>
+
+#include <algorithm>
+#include <limits>
+#include <utility>
+
+namespace ndn {
+namespace ntorrent {
+
+PieceAvailability::PieceAvailability()
+  : m_numPending(0)
+  , m_random(std::random_device()())
+{
+}
+
+void
+PieceAvailability::update(const Name& peer, const Name& manifestName,
+                          const std::vector<bool>& bitmap)
+{
+  auto& entry = m_manifests[manifestName];
+  if (entry.counts.size() < bitmap.size()) {
+    entry.counts.resize(bitmap.size(), 0);
+  }
+  auto& peerBitmap = entry.peers[peer];
+  for (size_t i = 0; i < std::max(peerBitmap.size(), bitmap.size()); ++i) {
+    bool had = i < peerBitmap.size() && peerBitmap[i];
+    bool has = i < bitmap.size() && bitmap[i];
+    if (had != has) {
+      setCount(entry, i, has ? entry.counts[i] + 1 : entry.counts[i] - 1);
+    }
+  }
+  peerBitmap = bitmap;
+}
+
+void
+PieceAvailability::addPacket(const Name& peer, const Name& manifestName, size_t packetIndex)
+{
+  auto& entry = m_manifests[manifestName];
+  if (entry.counts.size() <= packetIndex) {
+    entry.counts.resize(packetIndex + 1, 0);
+  }
+  auto& peerBitmap = entry.peers[peer];
+  if (peerBitmap.size() <= packetIndex) {
+    peerBitmap.resize(packetIndex + 1, false);
+  }
+  if (!peerBitmap[packetIndex]) {
+    peerBitmap[packetIndex] = true;
+    setCount(entry, packetIndex, entry.counts[packetIndex] + 1);
+  }
+}
+
+bool
+PieceAvailability::erasePeer(const Name& peer)
+{
+  bool found = false;
+  for (auto& manifest : m_manifests) {
+    auto& entry = manifest.second;
+    auto it = entry.peers.find(peer);
+    if (entry.peers.end() == it) {
+      continue;
+    }
+    for (size_t i = 0; i < it->second.size(); ++i) {
+      if (it->second[i]) {
+        setCount(entry, i, entry.counts[i] - 1);
+      }
+    }
+    entry.peers.erase(it);
+    found = true;
+  }
+  return found;
+}
+
+size_t
+PieceAvailability::getAvailability(const Name& manifestName, size_t packetIndex) const
+{
+  auto it = m_manifests.find(manifestName);
+  if (m_manifests.end() == it || it->second.counts.size() <= packetIndex) {
+    return 0;
+  }
+  return it->second.counts[packetIndex];
+}
+
+std::vector<Name>
+PieceAvailability::getPeers(const Name& manifestName, size_t packetIndex) const
+{
+  std::vector<Name> peers;
+  auto it = m_manifests.find(manifestName);
+  if (m_manifests.end() == it) {
+    return peers;
+  }
+  for (const auto& peer : it->second.peers) {
+    if (packetIndex < peer.second.size() && peer.second[packetIndex]) {
+      peers.push_back(peer.first);
+    }
+  }
+  return peers;
+}
+
+bool
+PieceAvailability::addPending(const Name& packetName)
+{
+  // .../<file_name>/<submanifest_num>/<packet_num>/<implicit_digest>
+  BOOST_ASSERT(2 <= packetName.size() && packetName.get(-2).isSequenceNumber());
+  auto& entry = m_manifests[packetName.getPrefix(-2)];
+  size_t packetIndex = packetName.get(-2).toSequenceNumber();
+  if (!entry.pending.emplace(packetIndex, Pending{packetName, 0}).second) {
+    return false;
+  }
+  insertInBucket(entry, packetIndex);
+  ++m_numPending;
+  return true;
+}
+
+std::vector<Name>
+PieceAvailability::takeRarest(size_t count)
+{
+  std::vector<Name> packetNames;
+  packetNames.reserve(std::min(count, m_numPending));
+  while (packetNames.size() < count && !m_buckets.empty()) {
+    // ties are broken by taking a random packet of the rarest bucket
+    const auto& bucket = m_buckets.begin()->second;
+    std::uniform_int_distribution<size_t> position(0, bucket.size() - 1);
+    auto slot = bucket[position(m_random)];
+    eraseFromBucket(*slot.entry, slot.packetIndex);
+    auto it = slot.entry->pending.find(slot.packetIndex);
+    packetNames.push_back(std::move(it->second.name));
+    slot.entry->pending.erase(it);
+    --m_numPending;
+  }
+  return packetNames;
+}
+
+size_t
+PieceAvailability::count(const Entry& entry, size_t packetIndex)
+{
+  return packetIndex < entry.counts.size() ? entry.counts[packetIndex] : 0;
+}
+
+size_t
+PieceAvailability::bucketKey(size_t count)
+{
+  // the packets no peer is known to have come last
+  return 0 == count ? std::numeric_limits<size_t>::max() : count;
+}
+
+void
+PieceAvailability::setCount(Entry& entry, size_t packetIndex, size_t count)
+{
+  bool isPending = entry.pending.end() != entry.pending.find(packetIndex);
+  if (isPending && bucketKey(count) != bucketKey(entry.counts[packetIndex])) {
+    eraseFromBucket(entry, packetIndex);
+    entry.counts[packetIndex] = count;
+    insertInBucket(entry, packetIndex);
+  }
+  else {
+    entry.counts[packetIndex] = count;
+  }
+}
+
+void
+PieceAvailability::insertInBucket(Entry& entry, size_t packetIndex)
+{
+  auto& bucket = m_buckets[bucketKey(count(entry, packetIndex))];
+  entry.pending.find(packetIndex)->second.position = bucket.size();
+  bucket.push_back({&entry, packetIndex});
+}
+
+void
+PieceAvailability::eraseFromBucket(Entry& entry, size_t packetIndex)
+{
+  auto bucket_it = m_buckets.find(bucketKey(count(entry, packetIndex)));
+  BOOST_ASSERT(m_buckets.end() != bucket_it);
+  auto& bucket = bucket_it->second;
+  size_t position = entry.pending.find(packetIndex)->second.position;
+  // move the last packet of the bucket to the position of the erased one
+  bucket[position] = bucket.back();
+  bucket[position].entry->pending.find(bucket[position].packetIndex)->second.position = position;
+  bucket.pop_back();
+  if (bucket.empty()) {
+    m_buckets.erase(bucket_it);
+  }
+}
+
+} // namespace ntorrent
+} // namespace ndn
@@ -0,0 +1,202 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+* Copyright (c) 2016 Regents of the University of California.
+*
+* This file is part of the nTorrent codebase.
+*
+* nTorrent is free software: you can redistribute it and/or modify it under the
+* terms of the GNU Lesser General Public License as published by the Free Software
+* Foundation, either version 3 of the License, or (at your option) any later version.
+*
+* nTorrent is distributed in the hope that it will be useful, but WITHOUT ANY
+* WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+* PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+*
+* You should have received copies of the GNU General Public License and GNU Lesser
+* General Public License along with nTorrent, e.g., in COPYING.md file. If not, see
+* <http://www.gnu.org/licenses/>.
+*
+* See AUTHORS for complete list of nTorrent authors and contributors.
+*/
+
+#ifndef INCLUDED_PIECE_AVAILABILITY_HPP
+#define INCLUDED_PIECE_AVAILABILITY_HPP
+
+#include <ndn-cxx/name.hpp>
+
+#include <map>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+namespace ndn {
+namespace ntorrent {
+
+/**
+ * @brief The number of peers known to have each Data packet of a torrent
+ *
+ * The peers are identified by their routable prefix. For each sub-manifest, the table keeps the
+ * bitmap of the packets every peer is known to have, either advertised by the peer or learned from
+ * the Data it served, and the number of peers having each packet. Fetching strategies use it to
+ * request the rarest packets first, so that the content spreads across the swarm instead of every
+ * peer requesting the same packets at the same time.
+ *
+ * The packets pending download are kept in buckets of equal availability, moved between buckets as
+ * the availability of each packet changes, so that taking the rarest ones does not depend on the
+ * number of packets pending.
+ */
+class PieceAvailability {
+public:
+  /**
+   * @brief Create a new empty table
+   */
+  PieceAvailability();
+
+  ~PieceAvailability() = default;
+
+  // The buckets of pending packets refer to the entries of the table
+  PieceAvailability(const PieceAvailability&) = delete;
+
+  PieceAvailability&
+  operator=(const PieceAvailability&) = delete;
+
+  /**
+   * @brief Set the packets of a sub-manifest that a peer has
+   * @param peer The routable prefix of the peer
+   * @param manifestName The name (without the implicit digest) of the sub-manifest
+   * @param bitmap The packets of the catalog of the sub-manifest that the peer has
+   *
+   * Replaces whatever was known about the packets of the sub-manifest the peer has.
+   */
+  void
+  update(const Name& peer, const Name& manifestName, const std::vector<bool>& bitmap);
+
+  /**
+   * @brief Record that a peer has a packet of a sub-manifest
+   * @param peer The routable prefix of the peer
+   * @param manifestName The name (without the implicit digest) of the sub-manifest
+   * @param packetIndex The position of the packet in the catalog of the sub-manifest
+   */
+  void
+  addPacket(const Name& peer, const Name& manifestName, size_t packetIndex);
+
+  /**
+   * @brief Forget everything known about the packets of a peer
+   * @return True if anything was known about the peer. Otherwise, false
+   */
+  bool
+  erasePeer(const Name& peer);
+
+  /**
+   * @brief Return the number of peers known to have a packet of a sub-manifest
+   * @param manifestName The name (without the implicit digest) of the sub-manifest
+   * @param packetIndex The position of the packet in the catalog of the sub-manifest
+   */
+  size_t
+  getAvailability(const Name& manifestName, size_t packetIndex) const;
+
+  /**
+   * @brief Return the routable prefixes of the peers known to have a packet of a sub-manifest
+   */
+  std::vector<Name>
+  getPeers(const Name& manifestName, size_t packetIndex) const;
+
+  /**
+   * @brief Add a packet to the packets pending download
+   * @param packetName The full name of the packet, as listed in the catalog of its sub-manifest
+   * @return False if the packet is already pending. Otherwise, true
+   */
+  bool
+  addPending(const Name& packetName);
+
+  /**
+   * @brief Remove the rarest packets pending download and return their full names
+   * @param count The maximum number of packets to be returned
+   *
+   * Return the packets known to the fewest peers, in increasing order of availability and in
+   * random order among packets of equal availability. The packets that no peer is known to have
+   * come last, as they can only be requested from the original publisher.
+   */
+  std::vector<Name>
+  takeRarest(size_t count);
+
+  /**
+   * @brief Return the number of packets pending download
+   */
+  size_t
+  numPending() const;
+
+  /**
+   * @brief Return the number of sub-manifests the table knows about
+   */
+  size_t
+  size() const;
+
+private:
+  struct Pending {
+    // The full name of the packet
+    Name                                           name;
+    // The position of the packet in the bucket of its availability
+    size_t                                         position;
+  };
+
+  struct Entry {
+    // The number of peers having each packet of the sub-manifest
+    std::vector<size_t>                            counts;
+    // The packets of the sub-manifest each peer has
+    std::unordered_map<Name, std::vector<bool>>    peers;
+    // The packets of the sub-manifest pending download, keyed by position in the catalog
+    std::unordered_map<size_t, Pending>            pending;
+  };
+
+  struct BucketSlot {
+    // The sub-manifest of the packet (the entries are never erased, nor moved by a rehash)
+    Entry*                                         entry;
+    // The position of the packet in the catalog of the sub-manifest
+    size_t                                         packetIndex;
+  };
+
+  // Return the number of peers having a packet of a sub-manifest
+  static size_t
+  count(const Entry& entry, size_t packetIndex);
+
+  // Return the key of the bucket of packets having @p count peers
+  static size_t
+  bucketKey(size_t count);
+
+  // Set the number of peers having a packet, moving it to another bucket if it is pending
+  void
+  setCount(Entry& entry, size_t packetIndex, size_t count);
+
+  void
+  insertInBucket(Entry& entry, size_t packetIndex);
+
+  void
+  eraseFromBucket(Entry& entry, size_t packetIndex);
+
+  // The availability of the packets of each sub-manifest, keyed by name without implicit digest
+  std::unordered_map<Name, Entry>                  m_manifests;
+  // The packets pending download, in buckets of equal availability, rarest first
+  std::map<size_t, std::vector<BucketSlot>>        m_buckets;
+  // The number of packets pending download
+  size_t                                           m_numPending;
+  // The generator used to break ties between packets of equal availability
+  std::mt19937                                     m_random;
+};
+
+inline size_t
+PieceAvailability::numPending() const
+{
+  return m_numPending;
+}
+
+inline size_t
+PieceAvailability::size() const
+{
+  return m_manifests.size();
+}
+
+} // namespace ntorrent
+} // namespace ndn
+
+#endif // INCLUDED_PIECE_AVAILABILITY_HPP
@@ -0,0 +1,120 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+* Copyright (c) 2016 Regents of the University of California.
+*
+* This file is part of the nTorrent codebase.
+*
+* nTorrent is free software: you can redistribute it and/or modify it under the
+* terms of the GNU Lesser General Public License as published by the Free Software
+* Foundation, either version 3 of the License, or (at your option) any later version.
+*
+* nTorrent is distributed in the hope that it will be useful, but WITHOUT ANY
+* WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+* PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+*
+* You should have received copies of the GNU General Public License and GNU Lesser
+* General Public License along with nTorrent, e.g., in COPYING.md file. If not, see
+* <http://www.gnu.org/licenses/>.
+*
+* See AUTHORS for complete list of nTorrent authors and contributors.
+*/
+
+#include "rarest-first-data-fetcher.hpp"
+#include "util/io-util.hpp"
+
+#include <algorithm>
+#include <set>
+
+namespace ndn {
+namespace ntorrent {
+
+RarestFirstDataFetcher::RarestFirstDataFetcher(const ndn::Name&   torrentFileName,
+                                               const std::string& dataPath,
+                                               bool               seed,
+                                               size_t             ioThreads,
+                                               const std::string& congestionControl,
+                                               bool               verifyOnResume,
+                                               bool               lazyInitialize)
+  : DataFetcher(torrentFileName, dataPath, seed, ioThreads, congestionControl, verifyOnResume,
+                lazyInitialize)
+  , m_outstandingPackets(0)
+{
+}
+
+RarestFirstDataFetcher::~RarestFirstDataFetcher()
+{
+}
+
+void
+RarestFirstDataFetcher::downloadMissingPackets()
+{
+  std::vector<ndn::Name> namesToFetch;
+  m_manager->findAllMissingDataPackets(namesToFetch);
+  this->downloadPackets(namesToFetch);
+}
+
+void
+RarestFirstDataFetcher::downloadPackets(const std::vector<ndn::Name>& packetsName)
+{
+  auto& availability = m_manager->getPieceAvailability();
+  std::set<Name> manifestNames;
+  for (const auto& name : packetsName) {
+    if (!m_manager->hasDataPacket(name) && availability.addPending(name)) {
+      // .../<file_name>/<submanifest_num>/<packet_num>/<implicit_digest>
+      manifestNames.insert(name.getPrefix(-2));
+    }
+  }
+  // learn which peers have the packets, for the batches after the first one
+  for (const auto& manifestName : manifestNames) {
+    m_manager->requestBitmaps(manifestName);
+  }
+  this->requestPackets();
+}
+
+void
+RarestFirstDataFetcher::retryPacket(const ndn::Name& packetName)
+{
+  // the packet competes again with the others, which may now be rarer
+  m_manager->getPieceAvailability().addPending(packetName);
+}
+
+void
+RarestFirstDataFetcher::requestPackets()
+{
+  // keep enough packets outstanding to fill the congestion window, but decide the order of the
+  // next batch only once half of the current one is received
+  size_t target = std::max<size_t>(MIN_OUTSTANDING_PACKETS,
+                                   2 * m_manager->getCongestionController().getWindow());
+  auto& availability = m_manager->getPieceAvailability();
+  if (0 == availability.numPending() || m_outstandingPackets > target / 2) {
+    return;
+  }
+  auto batch = availability.takeRarest(target - m_outstandingPackets);
+  // count the whole batch first, as the callbacks may run before download_data_packets returns
+  m_outstandingPackets += batch.size();
+  m_manager->download_data_packets(batch,
+                            bind(&RarestFirstDataFetcher::onDataPacketReceived, this, _1),
+                            bind(&RarestFirstDataFetcher::onDataRetrievalFailure, this, _1, _2));
+}
+
+void
+RarestFirstDataFetcher::onDataPacketReceived(const ndn::Name& name)
+{
+  DataFetcher::onDataPacketReceived(name);
+  --m_outstandingPackets;
+  this->requestPackets();
+}
+
+void
+RarestFirstDataFetcher::onDataRetrievalFailure(const ndn::Name& name,
+                                               const std::string& errorCode)
+{
+  if (IoUtil::findType(name) == IoUtil::DATA_PACKET) {
+    --m_outstandingPackets;
+  }
+  DataFetcher::onDataRetrievalFailure(name, errorCode);
+  this->requestPackets();
+}
+
+} // namespace ntorrent
+} // namespace ndn
@@ -0,0 +1,115 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+* Copyright (c) 2016 Regents of the University of California.
+*
+* This file is part of the nTorrent codebase.
+*
+* nTorrent is free software: you can redistribute it and/or modify it under the
+* terms of the GNU Lesser General Public License as published by the Free Software
+* Foundation, either version 3 of the License, or (at your option) any later version.
+*
+* nTorrent is distributed in the hope that it will be useful, but WITHOUT ANY
+* WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+* PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+*
+* You should have received copies of the GNU General Public License and GNU Lesser
+* General Public License along with nTorrent, e.g., in COPYING.md file. If not, see
+* <http://www.gnu.org/licenses/>.
+*
+* See AUTHORS for complete list of nTorrent authors and contributors.
+*/
+
+#ifndef RAREST_FIRST_DATA_FETCHER_HPP
+#define RAREST_FIRST_DATA_FETCHER_HPP
+
+#include "data-fetcher.hpp"
+
+#include <ndn-cxx/name.hpp>
+
+#include <vector>
+
+namespace ndn {
+namespace ntorrent {
+
+/**
+ * @brief A fetching strategy that requests the rarest Data packets first
+ *
+ * The missing Data packets are requested in increasing order of the number of peers known to
+ * have them (see PieceAvailability), with ties broken randomly, so that peers downloading the same
+ * torrent request different packets and spread them across the swarm.
+ *
+ * The order is decided in batches: only about twice the congestion window of packets are handed
+ * to the TorrentManager at a time, so that the order of the rest follows the availability learned
+ * in the meantime. The fetcher asks the known peers for the bitmaps of the sub-manifests it
+ * fetches as soon as it learns their packets.
+ */
+class RarestFirstDataFetcher : public DataFetcher {
+  public:
+    /**
+     * @brief Create a new RarestFirstDataFetcher
+     * @param torrentFileName The name of the torrent file
+     * @param dataPath The path that the manager would look for already stored data packets and
+     *                 will write new data packets
+     * @param ioThreads The number of threads used for disk I/O, 0 for synchronous disk I/O
+     * @param congestionControl The congestion control algorithm pacing the Interests ("aimd" or
+     *                          "cubic")
+     * @param verifyOnResume Whether to verify the data packets restored from the resume journal
+     *                       in the background
+     * @param lazyInitialize Whether to hash the data packets missing from the resume journal in
+     *                       the background
+     * @throws CongestionController::Error if the congestion control algorithm is not supported
+     */
+    RarestFirstDataFetcher(const ndn::Name&   torrentFileName,
+                           const std::string& dataPath,
+                           bool               seed = true,
+                           size_t             ioThreads = 0,
+                           const std::string& congestionControl =
+                            CongestionController::DEFAULT_ALGORITHM,
+                           bool               verifyOnResume = false,
+                           bool               lazyInitialize = false);
+
+    ~RarestFirstDataFetcher();
+
+  protected:
+    virtual void
+    downloadMissingPackets();
+
+    /**
+     * @brief Add packets to the ones to be requested, ask the peers for the bitmaps of their
+     *        sub-manifests and request the rarest ones
+     */
+    virtual void
+    downloadPackets(const std::vector<ndn::Name>& packetsName);
+
+    /**
+     * @brief Add the packet back to the ones to be requested, ranked by its current availability
+     */
+    virtual void
+    retryPacket(const ndn::Name& packetName);
+
+    /**
+     * @brief Hand the rarest packets to the manager until enough packets are outstanding
+     */
+    void
+    requestPackets();
+
+    virtual void
+    onDataPacketReceived(const ndn::Name& name);
+
+    virtual void
+    onDataRetrievalFailure(const ndn::Name& name, const std::string& errorCode);
+
+  private:
+    enum
+    {
+      // Minimum number of packets handed to the manager and not yet received
+      MIN_OUTSTANDING_PACKETS = 64
+    };
+    // The number of packets handed to the manager and not yet received or failed
+    size_t m_outstandingPackets;
+};
+
+} // namespace ntorrent
+} // namespace ndn
+
+#endif // RAREST_FIRST_DATA_FETCHER_HPP
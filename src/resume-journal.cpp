@@ -0,0 +1,290 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+* Copyright (c) 2016 Regents of the University of California.
+*
+* This file is part of the nTorrent codebase.
+*
+* nTorrent is free software: you can redistribute it and/or modify it under the
+* terms of the GNU Lesser General Public License as published by the Free Software
+* Foundation, either version 3 of the License, or (at your option) any later version.
+*
+* nTorrent is distributed in the hope that it will be useful, but WITHOUT ANY
+* WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+* PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+*
+* You should have received copies of the GNU General Public License and GNU Lesser
+* General Public License along with nTorrent, e.g., in COPYING.md file. If not, see
+* <http://www.gnu.org/licenses/>.
+*
+* See AUTHORS for complete list of nTorrent authors and contributors.
+*/
+
+#include "resume-journal.hpp"
+
+#include "util/file-fingerprint.hpp"
+#include "util/io-util.hpp"
+#include "util/logging.hpp"
+
+#include <algorithm>
+#include <iterator>
+
+#include <boost/filesystem.hpp>
+#include <boost/filesystem/fstream.hpp>
+
+namespace fs = boost::filesystem;
+
+namespace ndn {
+namespace ntorrent {
+
+static const uint8_t MAGIC[] = { 'N', 'T', 'J', '3' };
+
+enum {
+  MAGIC_SIZE         = sizeof(MAGIC),
+  RECORD_HEADER_SIZE = 8 + 8 + 8 + 4,
+  RANGE_SIZE         = ResumeJournal::DIGEST_SIZE + 4 + 4
+};
+
+static void
+appendInteger(std::vector<uint8_t>& buffer, uint64_t value, size_t size)
+{
+  for (size_t i = 0; i < size; ++i) {
+    buffer.push_back(static_cast<uint8_t>(value >> (8 * i)));
+  }
+}
+
+static uint64_t
+readInteger(const uint8_t* buffer, size_t size)
+{
+  uint64_t value = 0;
+  for (size_t i = 0; i < size; ++i) {
+    value |= uint64_t(buffer[i]) << (8 * i);
+  }
+  return value;
+}
+
+static std::string
+toDigestKey(const FileManifest& manifest)
+{
+  const auto& digest = manifest.getFullName().get(-1);
+  return std::string(reinterpret_cast<const char*>(digest.value()), digest.value_size());
+}
+
+static void
+appendRange(ResumeJournal::Write& write, const std::string& digest, size_t first, size_t count)
+{
+  write.ranges.insert(write.ranges.end(), digest.begin(), digest.end());
+  appendInteger(write.ranges, first, 4);
+  appendInteger(write.ranges, count, 4);
+  ++write.numRanges;
+}
+
+void
+ResumeJournal::load(const std::string& fileName, const std::string& filePath)
+{
+  m_loadedFile = fileName;
+  m_loadedRanges.clear();
+  m_numRecords.erase(fileName);
+
+  fs::ifstream is(m_path + fileName, fs::ifstream::binary);
+  if (!is) {
+    return;
+  }
+  const std::vector<uint8_t> buffer((std::istreambuf_iterator<char>(is)),
+                                    std::istreambuf_iterator<char>());
+  if (buffer.size() < MAGIC_SIZE || !std::equal(MAGIC, MAGIC + MAGIC_SIZE, buffer.begin())) {
+    LOG_ERROR << "Corrupt resume journal: " << m_path + fileName << std::endl;
+    return;
+  }
+  std::unordered_map<std::string, Ranges> ranges;
+  FileFingerprint recorded = {0, 0, 0};
+  size_t numRecords = 0;
+  size_t pos = MAGIC_SIZE;
+  while (buffer.size() - pos >= RECORD_HEADER_SIZE) {
+    recorded.size = readInteger(&buffer[pos], 8);
+    recorded.modificationTime = readInteger(&buffer[pos + 8], 8);
+    recorded.inode = readInteger(&buffer[pos + 16], 8);
+    size_t numRanges = readInteger(&buffer[pos + 24], 4);
+    pos += RECORD_HEADER_SIZE;
+    if ((buffer.size() - pos) / RANGE_SIZE < numRanges) {
+      break;
+    }
+    for (size_t i = 0; i < numRanges; ++i, pos += RANGE_SIZE) {
+      std::string digest(buffer.begin() + pos, buffer.begin() + pos + DIGEST_SIZE);
+      ranges[digest].emplace_back(readInteger(&buffer[pos + DIGEST_SIZE], 4),
+                                  readInteger(&buffer[pos + DIGEST_SIZE + 4], 4));
+    }
+    ++numRecords;
+  }
+  if (0 == numRecords || pos != buffer.size()) {
+    LOG_ERROR << "Corrupt resume journal: " << m_path + fileName << std::endl;
+    return;
+  }
+  FileFingerprint fingerprint;
+  if (!fingerprint.read(filePath) || recorded != fingerprint) {
+    LOG_INFO << "File changed since the resume journal was written: " << filePath << std::endl;
+    return;
+  }
+  m_loadedRanges.swap(ranges);
+  m_numRecords[fileName] = numRecords;
+}
+
+bool
+ResumeJournal::find(const FileManifest& manifest, const std::string& filePath,
+                    PacketBitmap& state)
+{
+  if (m_loadedFile != manifest.file_name()) {
+    load(manifest.file_name(), filePath);
+  }
+  auto it = m_loadedRanges.find(toDigestKey(manifest));
+  if (m_loadedRanges.end() == it) {
+    return false;
+  }
+  PacketBitmap bitmap(manifest.catalog_size());
+  for (const auto& range : it->second) {
+    if (range.first > bitmap.size() || bitmap.size() - range.first < range.second) {
+      LOG_ERROR << "Corrupt resume journal: " << m_path + manifest.file_name() << std::endl;
+      return false;
+    }
+    for (size_t packetNum = range.first; packetNum < range.first + range.second; ++packetNum) {
+      bitmap.set(packetNum);
+    }
+  }
+  state = std::move(bitmap);
+  return true;
+}
+
+void
+ResumeJournal::addPacket(const FileManifest& manifest, size_t packetNum)
+{
+  m_addedPackets[manifest.file_name()][toDigestKey(manifest)].push_back(packetNum);
+}
+
+std::vector<ResumeJournal::Write>
+ResumeJournal::takeWrites(const std::vector<FileManifest>& manifests,
+                          const std::vector<PacketBitmap>& states)
+{
+  // the journals we loaded may be replaced
+  m_loadedFile.clear();
+  m_loadedRanges.clear();
+
+  std::vector<Write> writes;
+  // append the added packets to the journals on disk, unless they are compacted
+  for (auto& file : m_addedPackets) {
+    const auto& fileName = file.first;
+    auto records_it = m_numRecords.find(fileName);
+    if (0 != m_dirtyFiles.count(fileName)) {
+      continue;
+    }
+    if (m_numRecords.end() == records_it || records_it->second >= COMPACT_RECORDS) {
+      m_dirtyFiles.insert(fileName);
+      continue;
+    }
+    Write write{fileName, false, 0, {}};
+    for (auto& entry : file.second) {
+      auto& packets = entry.second;
+      std::sort(packets.begin(), packets.end());
+      size_t first = packets.front();
+      size_t last = first;
+      for (auto packetNum : packets) {
+        if (packetNum > last + 1) {
+          appendRange(write, entry.first, first, last + 1 - first);
+          first = packetNum;
+        }
+        last = packetNum;
+      }
+      appendRange(write, entry.first, first, last + 1 - first);
+    }
+    ++records_it->second;
+    writes.push_back(std::move(write));
+  }
+  m_addedPackets.clear();
+  if (m_dirtyFiles.empty()) {
+    return writes;
+  }
+  // compact the journals from the states of the sub-manifests with data of each file
+  std::unordered_map<std::string, size_t> compacted;
+  for (const auto& fileName : m_dirtyFiles) {
+    compacted[fileName] = writes.size();
+    writes.push_back(Write{fileName, true, 0, {}});
+  }
+  for (size_t i = 0; i < manifests.size() && i < states.size(); ++i) {
+    auto compacted_it = compacted.find(manifests[i].file_name());
+    if (compacted.end() == compacted_it || 0 == states[i].size()) {
+      continue;
+    }
+    auto& write = writes[compacted_it->second];
+    auto digest = toDigestKey(manifests[i]);
+    size_t numRanges = write.numRanges;
+    size_t packetNum = 0;
+    while (packetNum < states[i].size()) {
+      size_t missing = states[i].findNextMissing(packetNum);
+      if (missing != packetNum) {
+        appendRange(write, digest, packetNum, missing - packetNum);
+      }
+      packetNum = missing + 1;
+    }
+    // a sub-manifest with data but none of its packets is still recorded
+    if (numRanges == write.numRanges) {
+      appendRange(write, digest, 0, 0);
+    }
+  }
+  for (const auto& file : compacted) {
+    if (0 != writes[file.second].numRanges) {
+      m_numRecords[file.first] = 1;
+    }
+    else {
+      m_numRecords.erase(file.first);
+    }
+  }
+  m_dirtyFiles.clear();
+  return writes;
+}
+
+std::vector<std::string>
+ResumeJournal::write(const std::vector<Write>& writes, const std::string& dataPath) const
+{
+  std::lock_guard<std::mutex> lock(m_writeMutex);
+  std::vector<std::string> failedFiles;
+  for (const auto& write : writes) {
+    fs::path journalPath(m_path + write.fileName);
+    FileFingerprint fingerprint = {0, 0, 0};
+    bool hasData = fingerprint.read(dataPath + write.fileName);
+    if (write.compact && (0 == write.numRanges || !hasData)) {
+      // there is nothing on disk to record
+      boost::system::error_code ec;
+      fs::remove(journalPath, ec);
+      continue;
+    }
+    std::vector<uint8_t> buffer;
+    if (write.compact) {
+      buffer.assign(MAGIC, MAGIC + MAGIC_SIZE);
+    }
+    appendInteger(buffer, fingerprint.size, 8);
+    appendInteger(buffer, fingerprint.modificationTime, 8);
+    appendInteger(buffer, fingerprint.inode, 8);
+    appendInteger(buffer, write.numRanges, 4);
+    buffer.insert(buffer.end(), write.ranges.begin(), write.ranges.end());
+    if (!hasData ||
+        !(write.compact ? IoUtil::replaceFile(journalPath, buffer)
+                        : IoUtil::writeFile(journalPath, buffer, true))) {
+      LOG_ERROR << "Write failed: " << journalPath.string() << std::endl;
+      failedFiles.push_back(write.fileName);
+    }
+  }
+  return failedFiles;
+}
+
+bool
+ResumeJournal::flush(const std::vector<FileManifest>& manifests,
+                     const std::vector<PacketBitmap>& states,
+                     const std::string&               dataPath)
+{
+  auto failedFiles = write(takeWrites(manifests, states), dataPath);
+  for (const auto& fileName : failedFiles) {
+    markDirty(fileName);
+  }
+  return failedFiles.empty();
+}
+
+} // namespace ntorrent
+} // namespace ndn
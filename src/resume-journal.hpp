@@ -0,0 +1,207 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+* Copyright (c) 2016 Regents of the University of California.
+*
+* This file is part of the nTorrent codebase.
+*
+* nTorrent is free software: you can redistribute it and/or modify it under the
+* terms of the GNU Lesser General Public License as published by the Free Software
+* Foundation, either version 3 of the License, or (at your option) any later version.
+*
+* nTorrent is distributed in the hope that it will be useful, but WITHOUT ANY
+* WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+* PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+*
+* You should have received copies of the GNU General Public License and GNU Lesser
+* General Public License along with nTorrent, e.g., in COPYING.md file. If not, see
+* <http://www.gnu.org/licenses/>.
+*
+* See AUTHORS for complete list of nTorrent authors and contributors.
+*/
+
+#ifndef INCLUDED_RESUME_JOURNAL_HPP
+#define INCLUDED_RESUME_JOURNAL_HPP
+
+#include "file-manifest.hpp"
+#include "util/packet-bitmap.hpp"
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace ndn {
+namespace ntorrent {
+
+/**
+ * @brief A persistent journal of the Data packets of a torrent that are on disk
+ *
+ * The journal lets a manager restore its state on startup without hashing the data on disk again.
+ * The packets of each file are kept in a separate file <path>/<file_name> as a sequence of records
+ * of the ranges of packets on disk, each with the size, the modification time (in nanoseconds) and
+ * the inode number of the data file when it was written:
+ *
+ *   Journal ::= MAGIC(4) Record+
+ *   Record  ::= FILE-SIZE(8) MODIFICATION-TIME(8) INODE(8) NUM-RANGES(4) Range*
+ *   Range   ::= MANIFEST-DIGEST(32) FIRST-PACKET(4) NUM-PACKETS(4)
+ *
+ * where the integers are little-endian. The packets written since the last flush are appended to
+ * the journal as a new record. The journal is compacted into a single record, written next to it
+ * and renamed over it, once it holds COMPACT_RECORDS records or when packets are dropped. The
+ * journal of a file is only trusted if the data file still has the size, modification time and
+ * inode number recorded by its last record, and the journals that are truncated or do not parse
+ * are ignored, so that a crash at any point at worst makes the manager hash the file again.
+ */
+class ResumeJournal {
+public:
+  /**
+   * @brief The records to be written to the journal of a file, see takeWrites
+   */
+  struct Write {
+    std::string            fileName;
+    // Whether the journal is replaced by the record, otherwise the record is appended to it
+    bool                   compact;
+    size_t                 numRanges;
+    // The encoded ranges of the record
+    std::vector<uint8_t>   ranges;
+  };
+
+  /**
+   * @brief Create a new journal
+   * @param path The path to the directory holding the journal of the torrent on disk
+   */
+  explicit
+  ResumeJournal(const std::string& path);
+
+  ~ResumeJournal() = default;
+
+  /**
+   * @brief Find the state of a sub-manifest recorded in the journal
+   * @param manifest The sub-manifest
+   * @param filePath The path to the data file of @p manifest
+   * @param state Set to the recorded state of @p manifest if it is found
+   * @return True if the data file is unchanged since the journal of the file was written and the
+   *         journal records the state of @p manifest. Otherwise, false.
+   */
+  bool
+  find(const FileManifest& manifest, const std::string& filePath, PacketBitmap& state);
+
+  /**
+   * @brief Record that the packet @p packetNum of @p manifest was written to disk
+   */
+  void
+  addPacket(const FileManifest& manifest, size_t packetNum);
+
+  /**
+   * @brief Mark the journal of the file @p fileName to be compacted from the states of its
+   *        sub-manifests on the next flush, e.g. because packets were dropped
+   */
+  void
+  markDirty(const std::string& fileName);
+
+  /**
+   * @brief Return whether there is anything to write since the last flush
+   */
+  bool
+  isDirty() const;
+
+  /**
+   * @brief Take the records to be written since the last flush
+   * @param manifests The sub-manifests of the torrent
+   * @param states The state of each sub-manifest in @p manifests (empty if there is no data)
+   *
+   * The journals to be compacted are built from @p states, the others only get the packets added
+   * since the last flush.
+   */
+  std::vector<Write>
+  takeWrites(const std::vector<FileManifest>& manifests,
+             const std::vector<PacketBitmap>& states);
+
+  /**
+   * @brief Write the records taken by takeWrites to disk
+   * @param writes The records to write, in the order they were taken
+   * @param dataPath The path to the directory holding the data files of the torrent
+   * @return The names of the files whose journal could not be written, which must be marked as
+   *         dirty
+   *
+   * Only reads the files on disk and the path of the journal, so it may run on any thread. The
+   * data files must be synced to the disk before the call, so that the journal never records a
+   * packet whose data could be lost.
+   */
+  std::vector<std::string>
+  write(const std::vector<Write>& writes, const std::string& dataPath) const;
+
+  /**
+   * @brief Take the records to be written and write them to disk
+   * @return True if all the journals were written successfully. Otherwise, false
+   */
+  bool
+  flush(const std::vector<FileManifest>& manifests,
+        const std::vector<PacketBitmap>& states,
+        const std::string&               dataPath);
+
+  enum {
+    // Size in bytes of a SHA-256 digest
+    DIGEST_SIZE = 32,
+    // Number of records after which the journal of a file is compacted
+    COMPACT_RECORDS = 64
+  };
+
+private:
+  /**
+   * @brief Load the journal of @p fileName if the data file at @p filePath matches it
+   */
+  void
+  load(const std::string& fileName, const std::string& filePath);
+
+private:
+  typedef std::vector<std::pair<size_t, size_t>> Ranges;
+
+  std::string                                                             m_path;
+  // The names of the files whose journal is to be compacted
+  std::unordered_set<std::string>                                         m_dirtyFiles;
+  // A map from the name of each file to the packets written since the last flush, by the implicit
+  // digest of their sub-manifest
+  std::unordered_map<std::string,
+                     std::unordered_map<std::string, std::vector<size_t>>> m_addedPackets;
+  // A map from the name of each file with a trusted journal on disk to its number of records
+  std::unordered_map<std::string, size_t>                                 m_numRecords;
+  // The name of the file whose journal was last loaded by find
+  std::string                                                             m_loadedFile;
+  // A map from the implicit digest of each sub-manifest in the loaded journal to its ranges of
+  // packets, as pairs of the first packet and the number of packets
+  std::unordered_map<std::string, Ranges>                                 m_loadedRanges;
+  // Serializes the writes of the records
+  mutable std::mutex                                                      m_writeMutex;
+};
+
+inline
+ResumeJournal::ResumeJournal(const std::string& path)
+  : m_path(path)
+  , m_dirtyFiles()
+  , m_addedPackets()
+  , m_numRecords()
+  , m_loadedFile()
+  , m_loadedRanges()
+{
+}
+
+inline void
+ResumeJournal::markDirty(const std::string& fileName)
+{
+  m_dirtyFiles.insert(fileName);
+}
+
+inline bool
+ResumeJournal::isDirty() const
+{
+  return !m_dirtyFiles.empty() || !m_addedPackets.empty();
+}
+
+} // namespace ntorrent
+} // namespace ndn
+
+#endif // INCLUDED_RESUME_JOURNAL_HPP
@@ -20,20 +20,20 @@
 */
 
 #include "sequential-data-fetcher.hpp"
-#include "util/logging.hpp"
-#include "util/io-util.hpp"
 
 namespace ndn {
 namespace ntorrent {
 
 SequentialDataFetcher::SequentialDataFetcher(const ndn::Name&   torrentFileName,
                                              const std::string& dataPath,
-                                             bool               seed)
-  : m_dataPath(dataPath)
-  , m_torrentFileName(torrentFileName)
-  , m_seedFlag(seed)
+                                             bool               seed,
+                                             size_t             ioThreads,
+                                             const std::string& congestionControl,
+                                             bool               verifyOnResume,
+                                             bool               lazyInitialize)
+  : DataFetcher(torrentFileName, dataPath, seed, ioThreads, congestionControl, verifyOnResume,
+                lazyInitialize)
 {
-  m_manager = make_shared<TorrentManager>(m_torrentFileName, m_dataPath, seed);
 }
 
 SequentialDataFetcher::~SequentialDataFetcher()
@@ -41,145 +41,20 @@ SequentialDataFetcher::~SequentialDataFetcher()
 }
 
 void
-SequentialDataFetcher::start(const time::milliseconds& timeout)
+SequentialDataFetcher::downloadMissingPackets()
 {
-  m_manager->Initialize();
-  // downloading logic
-  this->implementSequentialLogic();
-  m_manager->processEvents(timeout);
-}
-
-void
-SequentialDataFetcher::pause()
-{
-  // TODO(Spyros): Implement asyncrhonous pause of the torrent downloading
-  // For now, do nothing...
-  throw(Error("Not implemented yet"));
-}
-
-void
-SequentialDataFetcher::resume()
-{
-  // TODO(Spyros): Implement asyncrhonous re-establishment of the torrent downloading
-  // For now, do nothing...
-  throw(Error("Not implemented yet"));
-}
-
-void
-SequentialDataFetcher::downloadTorrentFile()
-{
-  auto torrentPath = ".appdata/" + m_torrentFileName.get(-3).toUri() + "/torrent_files/";
-  m_manager->downloadTorrentFile(torrentPath,
-                                 bind(&SequentialDataFetcher::onTorrentFileSegmentReceived, this, _1),
-                                 bind(&SequentialDataFetcher::onDataRetrievalFailure, this, _1, _2));
-}
-
-void
-SequentialDataFetcher::downloadManifestFiles(const std::vector<ndn::Name>& manifestNames)
-{
-  auto manifestPath = ".appdata/" + m_torrentFileName.get(-3).toUri() + "/manifests/";
-  for (auto i = manifestNames.begin(); i != manifestNames.end(); i++) {
-    m_manager->download_file_manifest(*i,
-                              manifestPath,
-                              bind(&SequentialDataFetcher::onManifestReceived, this, _1),
-                              bind(&SequentialDataFetcher::onDataRetrievalFailure, this, _1, _2));
-  }
+  // the missing packets are requested as the window opens
+  m_manager->downloadMissingDataPackets(
+    bind(&SequentialDataFetcher::onDataPacketReceived, this, _1),
+    bind(&SequentialDataFetcher::onDataRetrievalFailure, this, _1, _2));
 }
 
 void
 SequentialDataFetcher::downloadPackets(const std::vector<ndn::Name>& packetsName)
 {
-  for (auto i = packetsName.begin(); i != packetsName.end(); i++) {
-    m_manager->download_data_packet(*i,
-                              bind(&SequentialDataFetcher::onDataPacketReceived, this, _1),
-                              bind(&SequentialDataFetcher::onDataRetrievalFailure, this, _1, _2));
-  }
-}
-
-void
-SequentialDataFetcher::implementSequentialLogic() {
-  if (!m_manager->hasAllTorrentSegments()) {
-    this->downloadTorrentFile();
-  }
-  else {
-    LOG_INFO <<  m_torrentFileName << " complete" <<  std::endl;
-    std::vector<ndn::Name> namesToFetch;
-    m_manager->findFileManifestsToDownload(namesToFetch);
-    if (!namesToFetch.empty()) {
-      this->downloadManifestFiles(namesToFetch);
-    }
-    else {
-      LOG_INFO << "All manifests complete" <<  std::endl;
-      m_manager->findAllMissingDataPackets(namesToFetch);
-      if (!namesToFetch.empty()) {
-        this->downloadPackets(namesToFetch);
-      }
-      else {
-        LOG_INFO << "All data complete" <<  std::endl;
-        if (!m_seedFlag) {
-          m_manager->shutdown();
-        }
-      }
-    }
-  }
-}
-
-void
-SequentialDataFetcher::onDataPacketReceived(const ndn::Name& name)
-{
-  // Data Packet Received
-  LOG_INFO << "Data Packet Received: " << name;
-  m_retryMap.clear();
-}
-
-void
-SequentialDataFetcher::onTorrentFileSegmentReceived(const std::vector<Name>& manifestNames)
-{
-  // TODO(msweatt) Add parameter for torrent file
-  LOG_INFO << "Torrent Segment Received: " << m_torrentFileName << std::endl;
-  m_retryMap.clear();
-  this->downloadManifestFiles(manifestNames);
-}
-
-void
-SequentialDataFetcher::onManifestReceived(const std::vector<Name>& packetNames)
-{
-  LOG_INFO << "Manifest File Received: "
-            << packetNames[0].getSubName(0, packetNames[0].size()- 3) << std::endl;
-  m_retryMap.clear();
-  this->downloadPackets(packetNames);
-}
-
-void
-SequentialDataFetcher::onDataRetrievalFailure(const ndn::Name& name,
-                                              const std::string& errorCode)
-{
-  // Data retrieval failure
-  if (m_retryMap[name] < MAX_RETRIES) {
-    m_retryMap[name]++;
-    uint32_t nameType = IoUtil::findType(name);
-    if (nameType == IoUtil::TORRENT_FILE) {
-      // this should never happen
-      LOG_ERROR << "Torrent File Segment Downloading Failed: " << name;
-      this->downloadTorrentFile();
-    }
-    else if (nameType == IoUtil::FILE_MANIFEST) {
-      LOG_ERROR << "Manifest File Segment Downloading Failed: " << name;
-      this->downloadManifestFiles({ name });
-    }
-    else if (nameType == IoUtil::DATA_PACKET) {
-      LOG_ERROR << "Data Packet Downloading Failed: " << name;
-      this->downloadPackets({ name });
-    }
-    else {
-      // This should never happen
-      LOG_ERROR << "Unknown Packet Type Downloading Failed: " << name;
-    }
-  }
-  else {
-    m_retryMap.erase(name);
-    LOG_INFO << "Giving up on " << name;
-  }
+  m_manager->download_data_packets(packetsName,
+                            bind(&SequentialDataFetcher::onDataPacketReceived, this, _1),
+                            bind(&SequentialDataFetcher::onDataRetrievalFailure, this, _1, _2));
 }
 
 } // namespace ntorrent
@@ -22,92 +22,47 @@
 #ifndef SEQUENTIAL_DATA_FETCHER_HPP
 #define SEQUENTIAL_DATA_FETCHER_HPP
 
-#include "fetching-strategy-manager.hpp"
-#include "torrent-manager.hpp"
-
-#include <ndn-cxx/name.hpp>
-
-#include <unordered_map>
+#include "data-fetcher.hpp"
 
 namespace ndn {
 namespace ntorrent {
 
-class SequentialDataFetcher : FetchingStrategyManager {
+/**
+ * @brief A fetching strategy that requests the Data packets in the order of the torrent
+ */
+class SequentialDataFetcher : public DataFetcher {
   public:
-    class Error : public std::runtime_error
-	  {
-  	public:
-  	  explicit
-  	  Error(const std::string& what)
-  	    : std::runtime_error(what)
-  	  {
-  	  }
-  	};
     /**
      * @brief Create a new SequentialDataFetcher
      * @param torrentFileName The name of the torrent file
      * @param dataPath The path that the manager would look for already stored data packets and
      *                 will write new data packets
+     * @param ioThreads The number of threads used for disk I/O, 0 for synchronous disk I/O
+     * @param congestionControl The congestion control algorithm pacing the Interests ("aimd" or
+     *                          "cubic")
+     * @param verifyOnResume Whether to verify the data packets restored from the resume journal
+     *                       in the background
+     * @param lazyInitialize Whether to hash the data packets missing from the resume journal in
+     *                       the background
+     * @throws CongestionController::Error if the congestion control algorithm is not supported
      */
     SequentialDataFetcher(const ndn::Name&   torrentFileName,
                           const std::string& dataPath,
-                          bool               seed =  true);
+                          bool               seed =  true,
+                          size_t             ioThreads = 0,
+                          const std::string& congestionControl =
+                            CongestionController::DEFAULT_ALGORITHM,
+                          bool               verifyOnResume = false,
+                          bool               lazyInitialize = false);
 
     ~SequentialDataFetcher();
 
-    /**
-     * @brief Start the sequential data fetcher
-     */
-    void
-    start(const time::milliseconds& timeout = time::milliseconds::zero());
-
-    /**
-     * @brief Pause the sequential data fetcher
-     */
-    void
-    pause();
-
-    /**
-     * @brief Resume the sequential data fetcher
-     */
-    void
-    resume();
-
   protected:
-    void
-    downloadTorrentFile();
-
-    void
-    downloadManifestFiles(const std::vector<ndn::Name>& manifestsName);
-
-    void
-    downloadPackets(const std::vector<ndn::Name>& packetsName);
-
-    void
-    implementSequentialLogic();
-
     virtual void
-    onDataPacketReceived(const ndn::Name& name);
+    downloadMissingPackets();
 
     virtual void
-    onDataRetrievalFailure(const ndn::Name& name, const std::string& errorCode);
-
-    virtual void
-    onManifestReceived(const std::vector<Name>& packetNames);
-
-    virtual void
-    onTorrentFileSegmentReceived(const std::vector<Name>& manifestNames);
-
-  private:
-    enum
-    {
-      MAX_RETRIES = 5
-    };
-    std::unordered_map<Name, int> m_retryMap;
-    std::string m_dataPath;
-    ndn::Name m_torrentFileName;
-    shared_ptr<TorrentManager> m_manager;
-    bool m_seedFlag;
+    downloadPackets(const std::vector<ndn::Name>& packetsName);
 };
 
 } // namespace ntorrent
@@ -23,14 +23,28 @@
 
 #include <boost/throw_exception.hpp>
 
+#include <algorithm>
+
 namespace ndn {
 namespace ntorrent {
 
+const time::milliseconds StatsTableRecord::INITIAL_RTO = time::seconds(1);
+const time::milliseconds StatsTableRecord::MIN_RTO = time::milliseconds(200);
+const time::milliseconds StatsTableRecord::MAX_RTO = time::seconds(60);
+
+StatsTableRecord::StatsTableRecord()
+  : StatsTableRecord(Name())
+{
+}
+
 StatsTableRecord::StatsTableRecord(const Name& recordName)
   : m_recordName(recordName)
   , m_sentInterests(0)
   , m_receivedData(0)
   , m_successRate(0)
+  , m_srtt(0)
+  , m_rttVar(0)
+  , m_rto(INITIAL_RTO)
 {
 }
 
@@ -39,6 +53,9 @@ StatsTableRecord::StatsTableRecord(const StatsTableRecord& record)
   , m_sentInterests(record.getRecordSentInterests())
   , m_receivedData(record.getRecordReceivedData())
   , m_successRate(record.getRecordSuccessRate())
+  , m_srtt(record.getSmoothedRtt())
+  , m_rttVar(record.getRttVariation())
+  , m_rto(record.getRto())
 {
 }
 
@@ -59,6 +76,30 @@ StatsTableRecord::incrementReceivedData()
   m_successRate = m_receivedData / float(m_sentInterests);
 }
 
+void
+StatsTableRecord::addRttSample(const time::nanoseconds& rtt)
+{
+  if (!hasRttSample()) {
+    m_srtt = std::max(rtt, time::nanoseconds(1));
+    m_rttVar = rtt / 2;
+  }
+  else {
+    // RTTVAR is updated first, with the SRTT before the sample
+    auto delta = m_srtt > rtt ? m_srtt - rtt : rtt - m_srtt;
+    m_rttVar = (m_rttVar * 3 + delta) / 4;
+    m_srtt = std::max((m_srtt * 7 + rtt) / 8, time::nanoseconds(1));
+  }
+  auto rto = time::duration_cast<time::milliseconds>(m_srtt + std::max<time::nanoseconds>(
+                                                     time::milliseconds(1), m_rttVar * 4));
+  m_rto = std::min(std::max(rto, MIN_RTO), MAX_RTO);
+}
+
+void
+StatsTableRecord::backoffRto()
+{
+  m_rto = std::min(m_rto * 2, MAX_RTO);
+}
+
 StatsTableRecord&
 StatsTableRecord::operator=(const StatsTableRecord& other)
 {
@@ -66,6 +107,9 @@ StatsTableRecord::operator=(const StatsTableRecord& other)
   m_sentInterests = other.getRecordSentInterests();
   m_receivedData = other.getRecordReceivedData();
   m_successRate = other.getRecordSuccessRate();
+  m_srtt = other.getSmoothedRtt();
+  m_rttVar = other.getRttVariation();
+  m_rto = other.getRto();
   return (*this);
 }
 
@@ -20,6 +20,7 @@
 */
 
 #include <ndn-cxx/name.hpp>
+#include <ndn-cxx/util/time.hpp>
 
 namespace ndn {
 namespace ntorrent {
@@ -42,7 +43,7 @@ public:
   /**
    * @brief Create a new empty record
    */
-  StatsTableRecord() = default;
+  StatsTableRecord();
 
   /**
    * @brief Create a new record
@@ -94,17 +95,68 @@ public:
   void
   incrementReceivedData();
 
+  /**
+   * @brief Update the round-trip time estimates of the record with a new sample (RFC 6298)
+   * @param rtt The time elapsed between sending an Interest and receiving its Data
+   *
+   * The sample must not come from an Interest that was retransmitted after a timeout, as it is
+   * ambiguous which transmission the Data answers (Karn's algorithm). The retransmission timeout
+   * is recomputed from the new estimates, which cancels any backoff.
+   */
+  void
+  addRttSample(const time::nanoseconds& rtt);
+
+  /**
+   * @brief Double the retransmission timeout of the record upon a timeout (up to MAX_RTO)
+   */
+  void
+  backoffRto();
+
+  /**
+   * @brief Return whether the record has received at least one round-trip time sample
+   */
+  bool
+  hasRttSample() const;
+
+  /**
+   * @brief Get the smoothed round-trip time of the record (zero without samples)
+   */
+  const time::nanoseconds&
+  getSmoothedRtt() const;
+
+  /**
+   * @brief Get the round-trip time variation of the record (zero without samples)
+   */
+  const time::nanoseconds&
+  getRttVariation() const;
+
+  /**
+   * @brief Get the retransmission timeout of the record, used as the lifetime of its Interests
+   */
+  const time::milliseconds&
+  getRto() const;
+
   /**
    * @brief Assignment operator
    */
   StatsTableRecord&
   operator=(const StatsTableRecord& other);
 
+  // The retransmission timeout before the first round-trip time sample
+  static const time::milliseconds INITIAL_RTO;
+  // The lower bound of the retransmission timeout
+  static const time::milliseconds MIN_RTO;
+  // The upper bound of the retransmission timeout
+  static const time::milliseconds MAX_RTO;
+
 private:
   Name m_recordName;
   uint64_t m_sentInterests;
   uint64_t m_receivedData;
   double m_successRate;
+  time::nanoseconds m_srtt;
+  time::nanoseconds m_rttVar;
+  time::milliseconds m_rto;
 };
 
 /**
@@ -143,6 +195,30 @@ StatsTableRecord::getRecordSuccessRate() const
   return m_successRate;
 }
 
+inline bool
+StatsTableRecord::hasRttSample() const
+{
+  return m_srtt != time::nanoseconds::zero();
+}
+
+inline const time::nanoseconds&
+StatsTableRecord::getSmoothedRtt() const
+{
+  return m_srtt;
+}
+
+inline const time::nanoseconds&
+StatsTableRecord::getRttVariation() const
+{
+  return m_rttVar;
+}
+
+inline const time::milliseconds&
+StatsTableRecord::getRto() const
+{
+  return m_rto;
+}
+
 
 }  // namespace ntorrent
 }  // namespace ndn
@@ -21,10 +21,9 @@
 
 #include "torrent-file.hpp"
 #include "util/io-util.hpp"
+#include "util/segment-index.hpp"
 #include "util/shared-constants.hpp"
-
-#include <ndn-cxx/security/key-chain.hpp>
-#include <ndn-cxx/security/signing-helpers.hpp>
+#include "util/thread-pool.hpp"
 
 #include <algorithm>
 
@@ -50,6 +49,9 @@ TorrentFile::TorrentFile(const Name& torrentFileName,
   , m_torrentFilePtr(torrentFilePtr)
   , m_catalog(catalog)
 {
+  for (const auto& name : m_catalog) {
+    m_catalogLength += suffixEncodedSize(name, m_commonPrefix.size());
+  }
 }
 
 TorrentFile::TorrentFile(const Name& torrentFileName,
@@ -59,6 +61,9 @@ TorrentFile::TorrentFile(const Name& torrentFileName,
   , m_commonPrefix(commonPrefix)
   , m_catalog(catalog)
 {
+  for (const auto& name : m_catalog) {
+    m_catalogLength += suffixEncodedSize(name, m_commonPrefix.size());
+  }
 }
 
 TorrentFile::TorrentFile(const Block& block)
@@ -66,14 +71,6 @@ TorrentFile::TorrentFile(const Block& block)
   this->wireDecode(block);
 }
 
-void
-TorrentFile::createSuffixCatalog()
-{
-  for (auto i = m_catalog.begin() ; i != m_catalog.end(); ++i) {
-    m_suffixCatalog.push_back((*i).getSubName(m_commonPrefix.size()));
-  }
-}
-
 shared_ptr<Name>
 TorrentFile::getTorrentFilePtr() const
 {
@@ -83,15 +80,6 @@ TorrentFile::getTorrentFilePtr() const
   return nullptr;
 }
 
-void
-TorrentFile::constructLongNames()
-{
-  for (auto i = m_suffixCatalog.begin(); i != m_suffixCatalog.end(); ++i) {
-      Name commonPrefix = m_commonPrefix;
-      m_catalog.push_back(commonPrefix.append((*i)));
-  }
-}
-
 template<encoding::Tag TAG>
 size_t
 TorrentFile::encodeContent(EncodingImpl<TAG>& encoder) const
@@ -111,10 +99,9 @@ TorrentFile::encodeContent(EncodingImpl<TAG>& encoder) const
   //                  Name
 
   size_t totalLength = 0;
-  for (const auto& name : m_suffixCatalog |  boost::adaptors::reversed) {
-    size_t fileManifestSuffixLength = 0;
-    fileManifestSuffixLength += name.wireEncode(encoder);
-    totalLength += fileManifestSuffixLength;
+  // encode the suffixes directly from the names of the catalog
+  for (const auto& name : m_catalog |  boost::adaptors::reversed) {
+    totalLength += prependSuffix(encoder, name, m_commonPrefix.size());
   }
   totalLength += m_commonPrefix.wireEncode(encoder);
   if (!m_torrentFilePtr.empty()) {
@@ -133,6 +120,7 @@ TorrentFile::erase(const Name& name)
 {
   auto found = std::find(m_catalog.begin(), m_catalog.end(), name);
   if (found != m_catalog.end()) {
+    m_catalogLength -= suffixEncodedSize(*found, m_commonPrefix.size());
     m_catalog.erase(found);
     return true;
   }
@@ -144,14 +132,25 @@ TorrentFile::encodeContent()
 {
   resetWire();
 
+  // the length of the catalog is maintained as it changes, so only the other fields are
+  // estimated before encoding the content in a buffer of its size
   EncodingEstimator estimator;
-  size_t estimatedSize = encodeContent(estimator);
+  size_t valueLength = m_catalogLength + m_commonPrefix.wireEncode(estimator);
+  if (!m_torrentFilePtr.empty()) {
+    valueLength += m_torrentFilePtr.wireEncode(estimator);
+  }
+  size_t contentSize = tlv::sizeOfVarNumber(tlv::Content) + tlv::sizeOfVarNumber(valueLength) +
+                       valueLength;
 
-  EncodingBuffer buffer(estimatedSize, 0);
+  EncodingBuffer buffer(contentSize, 0);
   encodeContent(buffer);
 
   setContentType(tlv::ContentType_Blob);
   setContent(buffer.block());
+
+  MetaInfo metaInfo = getMetaInfo();
+  SegmentIndex::write(metaInfo, m_segmentIndex);
+  setMetaInfo(metaInfo);
 }
 
 void
@@ -175,6 +174,8 @@ TorrentFile::decodeContent()
       BOOST_THROW_EXCEPTION(Error("Expected Content Type Blob"));
   }
 
+  m_segmentIndex = SegmentIndex::read(getMetaInfo());
+
   const Block& content = Data::getContent();
   content.parse();
 
@@ -200,14 +201,16 @@ TorrentFile::decodeContent()
     m_commonPrefix = name;
   }
   element++;
+  m_catalogLength = 0;
   for (; element != content.elements_end(); ++element) {
     element->parse();
     Name fileManifestSuffix(*element);
     if (fileManifestSuffix.empty())
       BOOST_THROW_EXCEPTION(Error("Empty manifest file name included in the torrent-file"));
-    this->insertToSuffixCatalog(fileManifestSuffix);
+    m_catalog.push_back(Name(m_commonPrefix).append(fileManifestSuffix));
+    m_catalogLength += element->size();
   }
-  if (m_suffixCatalog.size() == 0) {
+  if (m_catalog.size() == 0) {
     BOOST_THROW_EXCEPTION(Error("Torrent-file with empty catalog of file manifest names"));
   }
 }
@@ -216,18 +219,14 @@ void
 TorrentFile::wireDecode(const Block& wire)
 {
   m_catalog.clear();
-  m_suffixCatalog.clear();
   Data::wireDecode(wire);
   this->decodeContent();
-  this->constructLongNames();
 }
 
 void
 TorrentFile::finalize()
 {
-  this->createSuffixCatalog();
   this->encodeContent();
-  m_suffixCatalog.clear();
 }
 
 std::pair<std::vector<TorrentFile>,
@@ -238,6 +237,23 @@ TorrentFile::generate(const std::string& directoryPath,
                       size_t subManifestSize,
                       size_t dataPacketSize,
                       bool returnData)
+{
+  ThreadPool pool(0);
+  return generate(directoryPath, namesPerSegment, subManifestSize, dataPacketSize, returnData,
+                  pool);
+}
+
+std::pair<std::vector<TorrentFile>,
+          std::vector<std::pair<std::vector<FileManifest>,
+                                std::vector<Data>>>>
+TorrentFile::generate(const std::string& directoryPath,
+                      size_t namesPerSegment,
+                      size_t subManifestSize,
+                      size_t dataPacketSize,
+                      bool returnData,
+                      ThreadPool& pool,
+                      size_t indexFanout,
+                      SigningService& signer)
 {
   //TODO(spyros) Adapt this support subdirectories in 'directoryPath'
   BOOST_ASSERT(0 < namesPerSegment);
@@ -258,21 +274,31 @@ TorrentFile::generate(const std::string& directoryPath,
 
   Name torrentName(commonPrefix.toUri() + "/torrent-file");
   TorrentFile currentTorrentFile(torrentName, commonPrefix, {});
-  std::vector<std::pair<std::vector<FileManifest>, std::vector<Data>>> manifestPairs;
   // sort all the file names lexicographically
   std::set<std::string> fileNames;
   for (auto i = directoryPtr; i != Io::recursive_directory_iterator(); ++i) {
     fileNames.insert(i->path().string());
   }
-  size_t manifestFileCounter = 0u;
+  // generate the manifests of all the files concurrently, each at the position of its file
+  Name manifestPrefix(prefix +
+                      directoryPathName.getSubName(directoryPathName.size() - 1).toUri());
+  std::vector<std::pair<std::vector<FileManifest>, std::vector<Data>>>
+    manifestPairs(fileNames.size());
+  std::vector<ThreadPool::Task> tasks;
+  tasks.reserve(fileNames.size());
+  size_t fileNum = 0;
   for (const auto& fileName : fileNames) {
-    Name manifestPrefix(prefix +
-                        directoryPathName.getSubName(directoryPathName.size() - 1).toUri());
-    std::pair<std::vector<FileManifest>, std::vector<Data>> currentManifestPair =
-                                                    FileManifest::generate(fileName,
-                                                    manifestPrefix, subManifestSize,
-                                                    dataPacketSize, returnData);
-
+    tasks.emplace_back([&, fileName, fileNum] {
+      manifestPairs[fileNum] = FileManifest::generate(fileName, manifestPrefix, subManifestSize,
+                                                      dataPacketSize, returnData, pool,
+                                                      indexFanout, signer);
+    });
+    ++fileNum;
+  }
+  pool.run(std::move(tasks));
+  // build the torrent file segments from the manifests, in the order of the files
+  size_t manifestFileCounter = 0u;
+  for (auto& currentManifestPair : manifestPairs) {
     if (manifestFileCounter != 0 && 0 == manifestFileCounter % namesPerSegment) {
       torrentSegments.push_back(currentTorrentFile);
       Name currentTorrentName = torrentName;
@@ -282,21 +308,26 @@ TorrentFile::generate(const std::string& directoryPath,
     currentTorrentFile.insert(currentManifestPair.first[0].getFullName());
     currentManifestPair.first.shrink_to_fit();
     currentManifestPair.second.shrink_to_fit();
-    manifestPairs.push_back(currentManifestPair);
     ++manifestFileCounter;
   }
 
   // Sign and append the last torrent-file
-  security::KeyChain keyChain;
   currentTorrentFile.finalize();
-  keyChain.sign(currentTorrentFile, signingWithSha256());
   torrentSegments.push_back(currentTorrentFile);
-
-  for (auto it = torrentSegments.rbegin() + 1; it != torrentSegments.rend(); ++it) {
-    auto next = it - 1;
-    it->setTorrentFilePtr(next->getFullName());
-    it->finalize();
-    keyChain.sign(*it, signingWithSha256());
+  std::vector<Name> fullNames(torrentSegments.size());
+  fullNames.back() = signer.sign(torrentSegments.back());
+
+  for (size_t segmentNum = torrentSegments.size() - 1; segmentNum-- > 0; ) {
+    auto& segment = torrentSegments[segmentNum];
+    segment.setTorrentFilePtr(fullNames[segmentNum + 1]);
+    // the segments after this one are signed by now, so it can list their full names
+    auto children = SegmentIndex::children(segmentNum, torrentSegments.size(), indexFanout);
+    if (children.first < children.second) {
+      segment.setSegmentIndex(std::vector<Name>(fullNames.begin() + children.first,
+                                                fullNames.begin() + children.second));
+    }
+    segment.finalize();
+    fullNames[segmentNum] = signer.sign(segment);
   }
 
   torrentSegments.shrink_to_fit();
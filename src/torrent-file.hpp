@@ -23,6 +23,7 @@
 #define TORRENT_FILE_HPP
 
 #include "file-manifest.hpp"
+#include "util/name-suffix.hpp"
 
 #include <ndn-cxx/name.hpp>
 #include <ndn-cxx/encoding/block.hpp>
@@ -108,6 +109,13 @@ public:
   const std::vector<Name>&
   getCatalog() const;
 
+  /**
+   * @brief Get the full names of the segments of the torrent-file listed by the index of this
+   *        segment
+   */
+  const std::vector<Name>&
+  getSegmentIndex() const;
+
   /**
    * @brief Get the segment number for this torrent file
    */
@@ -177,6 +185,31 @@ public:
            size_t dataPacketSize,
            bool returnData = false);
 
+  /**
+   * @brief Given a directory path for the torrent file, it generates the torrent file
+   *
+   * @param pool The thread pool used to generate the file manifests of the files concurrently
+   * @param indexFanout If not 0, the segments of the torrent-file and the sub-manifests of each
+   *        file are indexed in a tree of @p indexFanout names per segment (see SegmentIndex), so
+   *        that they can be requested in parallel
+   * @param signer The signing service signing the segments, the manifests and the Data packets
+   *
+   * Behaves as the overload above, generating the manifests of the files and their sub-manifests
+   * concurrently on the threads of the specified 'pool'. The segments, the manifests and their
+   * order are identical to those generated serially.
+   **/
+  static std::pair<std::vector<TorrentFile>,
+            std::vector<std::pair<std::vector<FileManifest>,
+                                  std::vector<Data>>>>
+  generate(const std::string& directoryPath,
+           size_t namesPerSegment,
+           size_t subManifestSize,
+           size_t dataPacketSize,
+           bool returnData,
+           ThreadPool& pool,
+           size_t indexFanout = 0,
+           SigningService& signer = *SigningService::getDefault());
+
 protected:
   /**
    * @brief prepend torrent file as a Content block to the encoder
@@ -199,43 +232,24 @@ private:
   hasTorrentFilePtr() const;
 
   /**
-   * @brief Create a catalog of suffixes for the names of the file manifests
-   *
-   * To optimize encoding and decoding, we encode the name of the file manifests
-   * as suffixes along with their common prefix.
-   *
-   */
-  void
-  createSuffixCatalog();
-
-  /**
-   * @brief Construct the catalog of long names from a catalog of suffixes for the file
-   *        manifests' name
-   *
-   * After decoding a torrent-file from its wire format, we construct the catalog of
-   * long names from the decoded common prefix and suffixes
-   *
-   */
-  void
-  constructLongNames();
-
-  /**
-   * @brief Insert a suffix to the suffix catalog
+   * @brief Set the pointer of the current torrent-file segment to the next segment
    */
   void
-  insertToSuffixCatalog(const PartialName& suffix);
+  setTorrentFilePtr(const Name& ptrName);
 
   /**
-   * @brief Set the pointer of the current torrent-file segment to the next segment
+   * @brief Set the full names of the later segments listed by the index of this segment
    */
   void
-  setTorrentFilePtr(const Name& ptrName);
+  setSegmentIndex(const std::vector<Name>& segmentIndex);
 
 private:
   Name m_commonPrefix;
   Name m_torrentFilePtr;
-  std::vector<ndn::Name> m_suffixCatalog;
   std::vector<ndn::Name> m_catalog;
+  std::vector<ndn::Name> m_segmentIndex;
+  // The length of the encoding of the names of the catalog as suffixes of the common prefix
+  size_t m_catalogLength = 0;
 };
 
 inline
@@ -268,18 +282,25 @@ inline void
 TorrentFile::insert(const Name& name)
 {
   m_catalog.push_back(name);
+  m_catalogLength += suffixEncodedSize(name, m_commonPrefix.size());
 }
 
 inline void
-TorrentFile::insertToSuffixCatalog(const PartialName& suffix)
+TorrentFile::setTorrentFilePtr(const Name& ptrName)
+{
+  m_torrentFilePtr = ptrName;
+}
+
+inline const std::vector<Name>&
+TorrentFile::getSegmentIndex() const
 {
-  m_suffixCatalog.push_back(suffix);
+  return m_segmentIndex;
 }
 
 inline void
-TorrentFile::setTorrentFilePtr(const Name& ptrName)
+TorrentFile::setSegmentIndex(const std::vector<Name>& segmentIndex)
 {
-  m_torrentFilePtr = ptrName;
+  m_segmentIndex = segmentIndex;
 }
 
 inline const Name&
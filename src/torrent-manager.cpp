@@ -28,13 +28,16 @@
 
 #include <boost/asio/io_service.hpp>
 #include <boost/filesystem.hpp>
+#include <boost/throw_exception.hpp>
 
 #include <ndn-cxx/data.hpp>
-#include <ndn-cxx/security/key-chain.hpp>
-#include <ndn-cxx/security/signing-helpers.hpp>
 #include <ndn-cxx/util/io.hpp>
 
+#include <algorithm>
+#include <functional>
+#include <mutex>
 #include <set>
+#include <stdexcept>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -48,18 +51,23 @@ namespace ndn {
 namespace ntorrent {
 
 static vector<TorrentFile>
-intializeTorrentSegments(const string& torrentFilePath, const Name& initialSegmentName)
+intializeTorrentSegments(const string&   torrentFilePath,
+                         const Name&     initialSegmentName,
+                         SigningService& signer)
 {
-  security::KeyChain key_chain;
   Name currSegmentFullName = initialSegmentName;
   vector<TorrentFile> torrentSegments = IoUtil::load_directory<TorrentFile>(torrentFilePath);
+  vector<Data*> unsignedSegments;
+  unsignedSegments.reserve(torrentSegments.size());
+  for (auto& segment : torrentSegments) {
+    unsignedSegments.push_back(&segment);
+  }
+  auto fullNames = signer.sign(unsignedSegments);
   // Starting with the initial segment name, verify the names, loading next name from torrentSegment
-  for (auto it = torrentSegments.begin(); it != torrentSegments.end(); ++it) {
-    TorrentFile& segment = *it;
-    key_chain.sign(segment, signingWithSha256());
-    if (segment.getFullName() != currSegmentFullName) {
-      vector<TorrentFile> correctSegments(torrentSegments.begin(), it);
-      torrentSegments.swap(correctSegments);
+  for (size_t i = 0; i < torrentSegments.size(); ++i) {
+    const TorrentFile& segment = torrentSegments[i];
+    if (fullNames[i] != currSegmentFullName) {
+      torrentSegments.erase(torrentSegments.begin() + i, torrentSegments.end());
       break;
     }
     // load the next full name
@@ -72,20 +80,22 @@ intializeTorrentSegments(const string& torrentFilePath, const Name& initialSegme
 }
 
 static vector<FileManifest>
-intializeFileManifests(const string& manifestPath, const vector<TorrentFile>& torrentSegments)
+intializeFileManifests(const string&              manifestPath,
+                       const vector<TorrentFile>& torrentSegments,
+                       SigningService&            signer)
 {
-  security::KeyChain key_chain;
-
   vector<FileManifest> manifests = IoUtil::load_directory<FileManifest>(manifestPath);
   if (manifests.empty()) {
     return manifests;
   }
 
   // sign the manifests
-  std::for_each(manifests.begin(), manifests.end(),
-                [&key_chain](FileManifest& m){
-                  key_chain.sign(m,signingWithSha256());
-                });
+  vector<Data*> unsignedManifests;
+  unsignedManifests.reserve(manifests.size());
+  for (auto& m : manifests) {
+    unsignedManifests.push_back(&m);
+  }
+  auto fullNames = signer.sign(unsignedManifests);
 
   // put all names of initial manifests from the valid torrent files into a set
   std::vector<ndn::Name> validInitialManifestNames;
@@ -96,6 +106,7 @@ intializeFileManifests(const string& manifestPath, const vector<TorrentFile>& to
                                     catalog.end());
   }
   auto manifest_it =  manifests.begin();
+  auto fullName_it = fullNames.begin();
   std::vector<FileManifest> output;
   output.reserve(manifests.size());
 
@@ -107,57 +118,60 @@ intializeFileManifests(const string& manifestPath, const vector<TorrentFile>& to
     }
     auto fileName = manifest_it->file_name();
     // sequential collect all valid segments
-    while (manifest_it != manifests.end() && manifest_it->getFullName() == validName) {
+    while (manifest_it != manifests.end() && *fullName_it == validName) {
       output.push_back(*manifest_it);
       if (manifest_it->submanifest_ptr() != nullptr) {
         validName = *manifest_it->submanifest_ptr();
         ++manifest_it;
+        ++fullName_it;
       }
       else {
         ++manifest_it;
+        ++fullName_it;
         break;
       }
     }
     // skip the remain segments for this file (all invalid)
     while (manifests.end() != manifest_it && manifest_it->file_name() == fileName) {
       ++manifest_it;
+      ++fullName_it;
     }
   }
   return output;
 }
 
-static vector<Data>
-initializeDataPackets(const string&      filePath,
-                      const FileManifest manifest,
-                      size_t             subManifestSize)
+static size_t
+initializeDataPackets(const string&       filePath,
+                      const FileManifest& manifest,
+                      size_t              subManifestSize,
+                      SigningService&     signer,
+                      const std::function<void(size_t, const Data&)>& onValidPacket)
 {
-  vector<Data> packets;
-  auto subManifestNum = manifest.submanifest_number();
-
-  packets =  IoUtil::packetize_file(filePath,
-                                    manifest.name(),
-                                    manifest.data_packet_size(),
-                                    subManifestSize,
-                                    subManifestNum);
-
-  auto catalog = manifest.catalog();
-  // Filter out invalid packet names
-  std::remove_if(packets.begin(), packets.end(),
-                [&packets, &catalog](const Data& p) {
-                  return catalog.end() == std::find(catalog.begin(),
-                                                     catalog.end(),
-                                                     p.getFullName());
-                });
-  return packets;
+  // Packetize the data on disk one packet at a time, reporting the packets matching the catalog
+  size_t packetNum = 0;
+  return IoUtil::packetize_file(filePath,
+                                manifest.name(),
+                                manifest.data_packet_size(),
+                                subManifestSize,
+                                manifest.submanifest_number(),
+                                [&manifest, &packetNum, &onValidPacket] (const Data& p,
+                                                                         const Name& fullName) {
+                                  if (packetNum < manifest.catalog_size() &&
+                                      manifest.catalog_name(packetNum) == fullName) {
+                                    onValidPacket(packetNum, p);
+                                  }
+                                  ++packetNum;
+                                },
+                                signer);
 }
 
-static std::vector<bool>
+static PacketBitmap
 initializeFileState(const string&       dataPath,
                     const FileManifest& manifest,
                     size_t              subManifestSize)
 {
   // construct the file name
-  return vector<bool>(manifest.catalog().size());
+  return PacketBitmap(manifest.catalog_size());
 }
 
 //==================================================================================================
@@ -178,10 +192,11 @@ void TorrentManager::Initialize()
     torrentName = m_torrentFileName.getSubName(1 + scheme.size(), m_torrentFileName.size() - (3 + scheme.size()));
   }
 
-  m_updateHandler = make_shared<UpdateHandler>(torrentName, m_keyChain,
+  m_updateHandler = make_shared<UpdateHandler>(torrentName, m_signingService,
                                                make_shared<StatsTable>(m_statsTable), m_face,
                                                std::bind(&TorrentManager::eraseOwnRoutablePrefix,
                                                          this));
+  m_updateHandler->setBitmapProvider(std::bind(&TorrentManager::findFileState, this, _1, _2));
 
   // .../<torrent_name>/torrent-file/<implicit_digest>
   string dataPath = ".appdata/" + m_torrentFileName.get(-3).toUri();
@@ -192,21 +207,28 @@ void TorrentManager::Initialize()
   if (!Io::exists(torrentFilePath)) {
     return;
   }
-  m_torrentSegments = intializeTorrentSegments(torrentFilePath, m_torrentFileName);
+  m_torrentSegments = intializeTorrentSegments(torrentFilePath, m_torrentFileName,
+                                               *m_signingService);
+  indexTorrentSegments();
   if (m_torrentSegments.empty()) {
     return;
   }
-  m_fileManifests   = intializeFileManifests(manifestPath, m_torrentSegments);
+  m_fileManifests   = intializeFileManifests(manifestPath, m_torrentSegments, *m_signingService);
+  indexFileManifests();
+  m_fileStates.assign(m_fileManifests.size(), PacketBitmap());
 
   // get the submanifest sizes
   for (const auto& m : m_fileManifests) {
     if (m.submanifest_number() == 0) {
       auto manifestFileName = m.file_name();
-      m_subManifestSizes[manifestFileName] = m.catalog().size();
+      m_subManifestSizes[manifestFileName] = m.catalog_size();
     }
   }
 
-  for (const auto& m : m_fileManifests) {
+  // the sub-manifests whose data is hashed before returning
+  std::vector<size_t> manifestsToHash;
+  for (size_t i = 0; i < m_fileManifests.size(); ++i) {
+    const auto& m = m_fileManifests[i];
     // construct the file name
     auto fileName = m.file_name();
     fs::path filePath = m_dataPath + fileName;
@@ -217,72 +239,90 @@ void TorrentManager::Initialize()
       }
       continue;
     }
-    auto packets = initializeDataPackets(filePath.string(), m, m_subManifestSizes[m.file_name()]);
-    // If there are any valid packets, add corresponding state to manager
-    if (!packets.empty()) {
-      m_fileStates[m.getFullName()] = initializeFileState(m_dataPath,
-                                                          m,
-                                                          m_subManifestSizes[m.file_name()]);
-      auto& fileBitMap = m_fileStates[m.getFullName()];
-      auto read_it = packets.begin();
-      size_t i = 0;
-      for (auto name : m.catalog()) {
-        if (read_it == packets.end()) {
-          break;
+    // restore the state recorded in the resume journal, if the file has not changed since
+    PacketBitmap journalState;
+    if (m_resumeJournal.find(m, filePath.string(), journalState)) {
+      m_fileStates[i] = std::move(journalState);
+      if (m_verifyResume) {
+        verifyFileState(i);
+      }
+      continue;
+    }
+    if (m_lazyInitialize) {
+      // the packets are hashed in the background, the prefix of the file is registered from its
+      // manifests alone
+      ++m_pendingFileHashes;
+      hashFileState(i, [this, fileName] (PacketBitmap& fileState, const PacketBitmap& valid) {
+        if (0 != valid.count()) {
+          // packets may have been written while the file was hashed
+          if (0 == fileState.size()) {
+            fileState = PacketBitmap(valid.size());
+          }
+          for (size_t packetNum = 0; packetNum < valid.size(); ++packetNum) {
+            if (valid.test(packetNum)) {
+              fileState.set(packetNum);
+            }
+          }
+          m_resumeJournal.markDirty(fileName);
         }
-        if (name == read_it->getFullName()) {
-          ++read_it;
-          fileBitMap[i] = true;
+        // record the hashed files as soon as they are all hashed
+        if (0 == --m_pendingFileHashes) {
+          flushResumeJournal();
         }
-        ++i;
-      }
-      for (const auto& d : packets) {
-        seed(d);
-      }
+      });
+      continue;
     }
+    manifestsToHash.push_back(i);
   }
-  for (const auto& t : m_torrentSegments) {
-    seed(t);
-  }
-  for (const auto& m : m_fileManifests) {
-   seed(m);
+  hashDataPackets(manifestsToHash);
+  // register the prefixes from the torrent file and the manifests alone, the Data packets under
+  // them are produced only when Interests for them arrive
+  seed(m_torrentSegments.front());
+  for (size_t i = 0; i < m_fileManifests.size(); ++i) {
+    // the sub-manifests of a file share its prefix
+    if (0 == i || m_fileManifests[i - 1].file_name() != m_fileManifests[i].file_name()) {
+      seed(m_fileManifests[i]);
+    }
   }
+  // record the hashed files, so that the next startup does not hash them again
+  flushResumeJournal(true);
 }
 
 shared_ptr<Name>
 TorrentManager::findTorrentFileSegmentToDownload() const
 {
-  // if we have no segments
-  if (m_torrentSegments.empty()) {
+  // if we do not have the initial segment
+  auto found = findTorrentSegment(m_torrentFileName.getPrefix(-1));
+  if (m_torrentSegments.size() == found) {
     return make_shared<Name>(m_torrentFileName);
   }
-  // otherwise just return the next segment ptr of the last segment we have
-  return m_torrentSegments.back().getTorrentFilePtr();
+  // the segments listed by an index may have been received out of order, so walk the chain of
+  // segments we have from the initial one up to the first one we are missing
+  auto next = m_torrentSegments[found].getTorrentFilePtr();
+  while (nullptr != next &&
+         m_torrentSegments.size() != (found = findTorrentSegment(next->getPrefix(-1)))) {
+    next = m_torrentSegments[found].getTorrentFilePtr();
+  }
+  return next;
 }
 
 shared_ptr<Name>
 TorrentManager::findManifestSegmentToDownload(const Name& manifestName) const
 {
-  //sequentially find whether we have downloaded any segments of this manifest file
-  Name manifestPrefix = FileManifest::manifestPrefix(manifestName);
-  auto it = std::find_if(m_fileManifests.rbegin(), m_fileManifests.rend(),
-                      [&manifestPrefix] (const FileManifest& f) {
-                        return manifestPrefix.isPrefixOf(f.getName());
-                      });
-
-  // if we do not have any segments of the file manifest
-  if (it == m_fileManifests.rend()) {
-    return make_shared<Name>(manifestName);
-  }
-
-  // if we already have the requested segment of the file manifest
-  if (it->submanifest_number() >= manifestName.get(manifestName.size() - 2).toSequenceNumber()) {
-    return it->submanifest_ptr();
-  }
   // if we do not have the requested segment
-  else {
+  size_t last = findFileManifest(manifestName.getPrefix(-1));
+  if (m_fileManifests.size() == last) {
     return make_shared<Name>(manifestName);
   }
+  // the segments listed by an index may have been received out of order, so walk the segments
+  // of the file we have after the requested one up to the first one we are missing
+  while (last + 1 < m_fileManifests.size() &&
+         m_fileManifests[last + 1].file_name() == m_fileManifests[last].file_name() &&
+         m_fileManifests[last + 1].submanifest_number() ==
+           m_fileManifests[last].submanifest_number() + 1) {
+    ++last;
+  }
+  return m_fileManifests[last].submanifest_ptr();
 }
 
 void
@@ -306,26 +346,17 @@ TorrentManager::findFileManifestsToDownload(std::vector<Name>& manifestNames) co
 bool
 TorrentManager::hasDataPacket(const Name& dataName) const
 {
-
-  auto manifest_it = std::find_if(m_fileManifests.begin(), m_fileManifests.end(),
-                                 [&dataName](const FileManifest& m) {
-                                   return m.getName().isPrefixOf(dataName);
-                                 });
+  // .../<file_name>/<submanifest_num>/<packet_num>/<implicit_digest>
+  auto manifestIndex = findFileManifest(dataName.getSubName(0, dataName.size() - 2));
 
   // if we do not have the file manifest, just return false
-  if (manifest_it == m_fileManifests.end()) {
+  if (m_fileManifests.size() == manifestIndex) {
     return false;
   }
 
-  // that corresponds to the specific submanifest
-  auto fileState_it = m_fileStates.find(manifest_it->getFullName());
-  if (m_fileStates.end() != fileState_it) {
-    const auto& fileState = fileState_it->second;
-    auto dataNum = dataName.get(dataName.size() - 2).toSequenceNumber();
-    // find whether we have the requested packet from the bitmap
-    return fileState[dataNum];
-  }
-  return false;
+  // find whether we have the requested packet from the bitmap of the specific submanifest
+  auto dataNum = dataName.get(dataName.size() - 2).toSequenceNumber();
+  return m_fileStates[manifestIndex].test(dataNum);
 }
 
 void
@@ -338,12 +369,7 @@ TorrentManager::findDataPacketsToDownload(const Name& manifestName, std::vector<
                                  });
 
   for (auto j = manifest_it; j != m_fileManifests.end(); j++) {
-    auto& fileState = m_fileStates[j->getFullName()];
-    for (size_t dataNum = 0; dataNum < j->catalog().size(); ++dataNum) {
-      if (!fileState[dataNum]) {
-        packetNames.push_back(j->catalog()[dataNum]);
-      }
-    }
+    findMissingDataPackets(j - m_fileManifests.begin(), packetNames);
 
     // check that the next manifest in the vector refers to the next segment of the same file
     if ((j + 1) != m_fileManifests.end() && (j+1)->file_name() != manifest_it->file_name()) {
@@ -355,23 +381,30 @@ TorrentManager::findDataPacketsToDownload(const Name& manifestName, std::vector<
 void
 TorrentManager::findAllMissingDataPackets(std::vector<Name>& packetNames) const
 {
-  for (auto j = m_fileManifests.begin(); j != m_fileManifests.end(); ++j) {
-    auto fileState_it = m_fileStates.find(j->getFullName());
-    // if we have no packets from this file
-    if (m_fileStates.end() == fileState_it) {
-      packetNames.reserve(packetNames.size() + j->catalog().size());
-      packetNames.insert(packetNames.end(), j->catalog().begin(), j->catalog().end());
-    }
-    // find the packets that we are missing
-    else {
-      const auto &fileState =  fileState_it->second;
-      for (auto i = j->catalog().begin(); i != j->catalog().end(); i++) {
-        auto dataNum = i->get(i->size() - 2).toSequenceNumber();
-        if (!fileState[dataNum]) {
-          packetNames.push_back(*i);
-        }
-      }
+  for (size_t i = 0; i < m_fileManifests.size(); ++i) {
+    findMissingDataPackets(i, packetNames);
+  }
+}
+
+void
+TorrentManager::findMissingDataPackets(size_t manifestIndex, std::vector<Name>& packetNames) const
+{
+  const auto& manifest = m_fileManifests[manifestIndex];
+  const auto& fileState = m_fileStates[manifestIndex];
+  // if we have no packets from this file
+  if (0 == fileState.size()) {
+    packetNames.reserve(packetNames.size() + manifest.catalog_size());
+    for (size_t dataNum = 0; dataNum < manifest.catalog_size(); ++dataNum) {
+      packetNames.push_back(manifest.catalog_name(dataNum));
     }
+    return;
+  }
+  packetNames.reserve(packetNames.size() + fileState.size() - fileState.count());
+  // skip the packets that we have a word at a time
+  for (size_t dataNum = fileState.findFirstMissing();
+       dataNum < fileState.size() && dataNum < manifest.catalog_size();
+       dataNum = fileState.findNextMissing(dataNum + 1)) {
+    packetNames.push_back(manifest.catalog_name(dataNum));
   }
 }
 
@@ -379,15 +412,15 @@ void
 TorrentManager::downloadTorrentFileSegment(const ndn::Name& name,
                                            const std::string& path,
                                            TorrentFileReceivedCallback onSuccess,
-                                           FailedCallback onFailed)
+                                           FailedCallback onFailed,
+                                           bool followPointer)
 {
-  shared_ptr<Interest> interest = createInterest(name);
-
-  auto dataReceived = [path, onSuccess, onFailed, this]
+  auto dataReceived = [path, onSuccess, onFailed, followPointer, this]
                                             (const Interest& interest, const Data& data) {
       m_pendingInterests.erase(interest.getName());
+      m_indexListedSegments.erase(interest.getName());
       // Stats Table update here...
-      m_stats_table_iter->incrementReceivedData();
+      recordReceivedData(interest);
       m_retries = 0;
       std::vector<Name> manifestNames;
       TorrentFile file(data.wireEncode());
@@ -400,17 +433,32 @@ TorrentManager::downloadTorrentFileSegment(const ndn::Name& name,
       const std::vector<Name>& manifestCatalog = file.getCatalog();
       manifestNames.insert(manifestNames.end(), manifestCatalog.begin(), manifestCatalog.end());
 
-      shared_ptr<Name> nextSegmentPtr = file.getTorrentFilePtr();
+      // request the next segments before handing out the manifest names of this one
+      if (!file.getSegmentIndex().empty()) {
+        // the segments listed by the index are requested at once, without following pointers
+        for (const auto& segmentName : file.getSegmentIndex()) {
+          if (m_torrentSegmentIndex.count(segmentName.getPrefix(-1)) == 0) {
+            this->downloadTorrentFileSegment(segmentName, path, onSuccess, onFailed, false);
+          }
+        }
+      }
+      else if (followPointer) {
+        shared_ptr<Name> nextSegmentPtr = file.getTorrentFilePtr();
+        // skip the segments we already have
+        while (nullptr != nextSegmentPtr &&
+               m_torrentSegmentIndex.count(nextSegmentPtr->getPrefix(-1)) != 0) {
+          const auto& next = m_torrentSegments[findTorrentSegment(nextSegmentPtr->getPrefix(-1))];
+          nextSegmentPtr = next.getTorrentFilePtr();
+        }
+        if (nextSegmentPtr != nullptr) {
+          this->downloadTorrentFileSegment(*nextSegmentPtr, path, onSuccess, onFailed, true);
+        }
+      }
       if (onSuccess) {
         onSuccess(manifestNames);
       }
-      if (nextSegmentPtr != nullptr) {
-        this->downloadTorrentFileSegment(*nextSegmentPtr, path, onSuccess, onFailed);
-      }
       this->sendInterest();
-      if (!hasPendingInterests() && !m_seedFlag) {
-        shutdown();
-      }
+      shutdownIfComplete();
   };
 
   auto dataFailed = [path, name, onSuccess, onFailed, this]
@@ -427,12 +475,15 @@ TorrentManager::downloadTorrentFileSegment(const ndn::Name& name,
       onFailed(interest.getName(), "Unknown error");
     }
     this->sendInterest();
-    if (!hasPendingInterests() && !m_seedFlag) {
-      shutdown();
-    }
+    shutdownIfComplete();
   };
-  LOG_DEBUG << "Pushing to the Interest Queue: " << *interest << std::endl;
-  m_interestQueue->push(interest, dataReceived, dataFailed);
+  if (!followPointer) {
+    m_indexListedSegments.insert(name);
+  }
+  LOG_DEBUG << "Pushing to the Interest Queue: " << name << std::endl;
+  auto context = m_interestQueue->createContext(dataReceived, dataFailed);
+  m_interestQueue->push(context, name, InterestQueue::TORRENT_FILE_PRIORITY);
+  m_interestQueue->releaseContext(context);
   this->sendInterest();
 }
 
@@ -442,12 +493,11 @@ TorrentManager::downloadTorrentFile(const std::string& path,
                                     FailedCallback onFailed)
 {
   shared_ptr<Name> searchRes = this->findTorrentFileSegmentToDownload();
-  auto manifestNames = make_shared<std::vector<Name>>();
   if (m_updateHandler->needsUpdate() && !(m_updateHandler->getOwnRoutablePrefix().empty())) {
     //m_updateHandler->sendAliveInterest(m_stats_table_iter);
   }
   if (searchRes != nullptr) {
-    this->downloadTorrentFileSegment(*searchRes, path, onSuccess, onFailed);
+    this->downloadTorrentFileSegment(*searchRes, path, onSuccess, onFailed, true);
   }
   else {
     std::vector<Name> manifests;
@@ -465,16 +515,42 @@ TorrentManager::download_file_manifest(const Name&              manifestName,
                                        TorrentManager::FailedCallback           onFailed)
 {
   shared_ptr<Name> searchRes = findManifestSegmentToDownload(manifestName);
-  auto packetNames = make_shared<std::vector<Name>>();
   if (m_updateHandler->needsUpdate() && !(m_updateHandler->getOwnRoutablePrefix().empty())) {
     m_updateHandler->sendAliveInterest(m_stats_table_iter);
   }
   if (searchRes == nullptr) {
-    this->findDataPacketsToDownload(manifestName, *packetNames);
-    onSuccess(*packetNames);
+    std::vector<Name> packetNames;
+    this->findDataPacketsToDownload(manifestName, packetNames);
+    onSuccess(packetNames);
+    return;
+  }
+  this->downloadFileManifestSegment(*searchRes, path, onSuccess, onFailed, true);
+}
+
+void
+TorrentManager::retryTorrentFileSegment(const Name&                 segmentName,
+                                        const std::string&          path,
+                                        TorrentFileReceivedCallback onSuccess,
+                                        FailedCallback              onFailed)
+{
+  if (m_torrentSegmentIndex.count(segmentName.getPrefix(-1)) != 0) {
+    return;
+  }
+  bool followPointer = m_indexListedSegments.count(segmentName) == 0;
+  this->downloadTorrentFileSegment(segmentName, path, onSuccess, onFailed, followPointer);
+}
+
+void
+TorrentManager::retryFileManifestSegment(const Name&              segmentName,
+                                         const std::string&       path,
+                                         ManifestReceivedCallback onSuccess,
+                                         FailedCallback           onFailed)
+{
+  if (m_fileManifestIndex.count(segmentName.getPrefix(-1)) != 0) {
     return;
   }
-  this->downloadFileManifestSegment(*searchRes, path, packetNames, onSuccess, onFailed);
+  bool followPointer = m_indexListedSegments.count(segmentName) == 0;
+  this->downloadFileManifestSegment(segmentName, path, onSuccess, onFailed, followPointer);
 }
 
 void
@@ -486,24 +562,102 @@ TorrentManager::download_data_packet(const Name& packetName,
     onSuccess(packetName);
     return;
   }
+  auto context = createDataPacketContext(onSuccess, onFailed);
+  queueDataPacket(context, packetName);
+  m_interestQueue->releaseContext(context);
+  this->sendInterest();
+}
+
+void
+TorrentManager::download_data_packets(const std::vector<Name>& packetNames,
+                                      DataReceivedCallback     onSuccess,
+                                      FailedCallback           onFailed)
+{
+  // all the packets share the callbacks
+  auto context = createDataPacketContext(onSuccess, onFailed);
+  for (const auto& packetName : packetNames) {
+    if (this->hasDataPacket(packetName)) {
+      onSuccess(packetName);
+    }
+    else {
+      queueDataPacket(context, packetName);
+    }
+  }
+  m_interestQueue->releaseContext(context);
+  this->sendInterest();
+}
+
+void
+TorrentManager::downloadMissingDataPackets(DataReceivedCallback onSuccess, FailedCallback onFailed)
+{
+  auto context = createDataPacketContext(onSuccess, onFailed);
+  if (nullptr != m_missingPacketCursor) {
+    m_interestQueue->releaseContext(m_missingPacketCursor->context);
+  }
+  m_missingPacketCursor.reset(new MissingPacketCursor{0, 0, context});
+  this->sendInterest();
+}
+
+bool
+TorrentManager::hasAllDataPackets() const
+{
+  for (size_t i = 0; i < m_fileManifests.size(); ++i) {
+    const auto& fileState = m_fileStates[i];
+    if (fileState.size() != m_fileManifests[i].catalog_size() || !fileState.isComplete()) {
+      return false;
+    }
+  }
+  return true;
+}
 
-  shared_ptr<Interest> interest = this->createInterest(packetName);
+void
+TorrentManager::queueDataPacket(InterestQueue::ContextId context, const Name& packetName)
+{
+  LOG_DEBUG << "Pushing to the Interest Queue: " << packetName << std::endl;
+  // .../<file_name>/<submanifest_num>/<packet_num>/<implicit_digest>
+  if (packetName.size() >= 2) {
+    auto index_it = m_fileManifestIndex.find(packetName.getSubName(0, packetName.size() - 2));
+    if (m_fileManifestIndex.end() != index_it && packetName.get(-2).isSequenceNumber()) {
+      // the packets of the manifests we have are referred to by their position in the catalog
+      auto manifestIndex = m_fileManifestPositions[index_it->second];
+      const auto& manifest = m_fileManifests[manifestIndex];
+      auto packetNum = packetName.get(-2).toSequenceNumber();
+      if (packetNum < manifest.catalog_size() && manifest.catalog_name(packetNum) == packetName) {
+        m_interestQueue->push(context, index_it->second, packetNum,
+                              findDataPriority(manifestIndex));
+        return;
+      }
+    }
+  }
+  m_interestQueue->push(context, packetName);
+}
 
+InterestQueue::ContextId
+TorrentManager::createDataPacketContext(DataReceivedCallback onSuccess, FailedCallback onFailed)
+{
   auto dataReceived = [onSuccess, onFailed, this]
                                           (const Interest& interest, const Data& data) {
     m_pendingInterests.erase(interest.getName());
-    // Write data to disk...
-    if(writeData(data)) {
-      seed(data);
-    }
     // Stats Table update here...
-    m_stats_table_iter->incrementReceivedData();
+    recordReceivedData(interest);
     m_retries = 0;
-    onSuccess(data.getName());
-    this->sendInterest();
-    if (!hasPendingInterests() && !m_seedFlag) {
-      shutdown();
+    // the routable prefix that served the packet has it
+    const auto& dataName = data.getName();
+    const auto& hint = interest.getForwardingHint();
+    if (!hint.empty() && !dataName.empty() && dataName.get(-1).isSequenceNumber() &&
+        m_fileManifestIndex.count(dataName.getPrefix(-1)) != 0) {
+      m_pieceAvailability.addPacket(hint.begin()->name, dataName.getPrefix(-1),
+                                    dataName.get(-1).toSequenceNumber());
     }
+    // Write data to disk, without waiting for the write to send the next Interests
+    writeDataAsync(data, [onSuccess, data, this] (bool written) {
+      if (written) {
+        seed(data);
+      }
+      onSuccess(data.getName());
+    });
+    this->sendInterest();
+    shutdownIfComplete();
   };
 
   auto dataFailed = [onFailed, this]
@@ -518,13 +672,65 @@ TorrentManager::download_data_packet(const Name& packetName,
     }
     onFailed(interest.getName(), "Unknown failure");
     this->sendInterest();
-    if (!hasPendingInterests() && !m_seedFlag) {
-      shutdown();
-    }
+    shutdownIfComplete();
   };
-  LOG_DEBUG << "Pushing to the Interest Queue: " << *interest << std::endl;
-  m_interestQueue->push(interest, dataReceived, dataFailed);
-  this->sendInterest();
+  return m_interestQueue->createContext(dataReceived, dataFailed);
+}
+
+void
+TorrentManager::setFilePriority(const std::string& fileName, InterestQueue::Priority priority)
+{
+  if (priority < InterestQueue::HIGH_DATA_PRIORITY || priority > InterestQueue::LOW_DATA_PRIORITY) {
+    BOOST_THROW_EXCEPTION(std::invalid_argument("Not a priority of data packets"));
+  }
+  if (InterestQueue::DATA_PRIORITY == priority) {
+    m_filePriorities.erase(fileName);
+  }
+  else {
+    m_filePriorities[fileName] = priority;
+  }
+}
+
+InterestQueue::Priority
+TorrentManager::findDataPriority(size_t manifestIndex) const
+{
+  if (m_filePriorities.empty()) {
+    return InterestQueue::DATA_PRIORITY;
+  }
+  auto it = m_filePriorities.find(m_fileManifests[manifestIndex].file_name());
+  return m_filePriorities.end() != it ? it->second : InterestQueue::DATA_PRIORITY;
+}
+
+bool
+TorrentManager::queueNextMissingDataPacket()
+{
+  if (nullptr == m_missingPacketCursor) {
+    return false;
+  }
+  auto& cursor = *m_missingPacketCursor;
+  while (cursor.manifestIndex < m_fileManifests.size()) {
+    const auto& manifest = m_fileManifests[cursor.manifestIndex];
+    const auto& fileState = m_fileStates[cursor.manifestIndex];
+    // if we have no packets from this file, all of them are missing
+    auto packetNum = 0 == fileState.size() ? cursor.packetNum
+                                           : fileState.findNextMissing(cursor.packetNum);
+    if (packetNum >= manifest.catalog_size()) {
+      ++cursor.manifestIndex;
+      cursor.packetNum = 0;
+      continue;
+    }
+    cursor.packetNum = packetNum + 1;
+    // the packet may have been requested already, e.g., when retrying it
+    if (0 != m_pendingInterests.count(manifest.catalog_name(packetNum))) {
+      continue;
+    }
+    m_interestQueue->push(cursor.context, m_fileManifestIds[cursor.manifestIndex], packetNum,
+                          findDataPriority(cursor.manifestIndex));
+    return true;
+  }
+  m_interestQueue->releaseContext(cursor.context);
+  m_missingPacketCursor.reset();
+  return false;
 }
 
 void TorrentManager::seed(const Data& data) {
@@ -548,7 +754,8 @@ void TorrentManager::seed(const Data& data) {
     default:
       break;
   }
-  if (prefix) {
+  // each prefix is registered once
+  if (prefix && m_registeredPrefixes.insert(*prefix).second) {
     m_face->setInterestFilter(*prefix,
                              bind(&TorrentManager::onInterestReceived, this, _1, _2),
                              RegisterPrefixSuccessCallback(),
@@ -556,56 +763,355 @@ void TorrentManager::seed(const Data& data) {
   }
 }
 
+void
+TorrentManager::setIoThreads(size_t numThreads)
+{
+  m_ioPool.reset(0 == numThreads ? nullptr : new ThreadPool(numThreads));
+}
+
+void
+TorrentManager::flushResumeJournal(bool wait)
+{
+  m_unjournaledPackets = 0;
+  if (!m_resumeJournal.isDirty() && !m_signatureStore.isDirty()) {
+    return;
+  }
+  if (!wait && m_isFlushingJournal) {
+    // the records are appended in order, so the next flush waits for the current one
+    m_isJournalFlushPending = true;
+    return;
+  }
+  auto writes = make_shared<std::vector<ResumeJournal::Write>>(
+                  m_resumeJournal.takeWrites(m_fileManifests, m_fileStates));
+  auto signatureWrites = make_shared<std::vector<PacketSignatureStore::Write>>(
+                           m_signatureStore.takeWrites());
+  auto failedFiles = make_shared<std::vector<std::string>>();
+  auto failedManifests = make_shared<std::vector<Name>>();
+  auto write = [this, writes, signatureWrites, failedFiles, failedManifests] {
+    // the journal must never record a packet whose data is not on the disk yet
+    std::vector<std::string> failedPaths;
+    if (m_fileWriters.sync(failedPaths)) {
+      *failedFiles = m_resumeJournal.write(*writes, m_dataPath);
+      *failedManifests = m_signatureStore.write(*signatureWrites);
+      return;
+    }
+    std::unordered_set<std::string> unsyncedFiles;
+    for (const auto& path : failedPaths) {
+      LOG_ERROR << "Sync failed, the resume journal is not written: " << path << std::endl;
+      if (0 == path.compare(0, m_dataPath.size(), m_dataPath)) {
+        unsyncedFiles.insert(path.substr(m_dataPath.size()));
+      }
+    }
+    std::vector<ResumeJournal::Write> syncedWrites;
+    for (const auto& w : *writes) {
+      if (0 == unsyncedFiles.count(w.fileName)) {
+        syncedWrites.push_back(w);
+      }
+    }
+    *failedFiles = m_resumeJournal.write(syncedWrites, m_dataPath);
+    failedFiles->insert(failedFiles->end(), unsyncedFiles.begin(), unsyncedFiles.end());
+    // nor the signatures of a file without its fingerprint once it is on the disk
+    std::vector<PacketSignatureStore::Write> syncedSignatureWrites;
+    for (const auto& w : *signatureWrites) {
+      if (failedPaths.end() == std::find(failedPaths.begin(), failedPaths.end(), w.dataPath)) {
+        syncedSignatureWrites.push_back(w);
+      }
+      else {
+        failedManifests->push_back(w.manifestName);
+      }
+    }
+    auto failed = m_signatureStore.write(syncedSignatureWrites);
+    failedManifests->insert(failedManifests->end(), failed.begin(), failed.end());
+  };
+  auto onWritten = [this, failedFiles, failedManifests] {
+    // the journals that failed are compacted from the state of the manager on the next flush
+    for (const auto& fileName : *failedFiles) {
+      m_resumeJournal.markDirty(fileName);
+    }
+    for (const auto& manifestName : *failedManifests) {
+      m_signatureStore.markDirty(manifestName);
+    }
+  };
+  if (wait) {
+    write();
+    onWritten();
+    return;
+  }
+  m_isFlushingJournal = true;
+  runIo(write, [this, onWritten] {
+                 onWritten();
+                 m_isFlushingJournal = false;
+                 if (m_isJournalFlushPending) {
+                   m_isJournalFlushPending = false;
+                   flushResumeJournal();
+                 }
+               });
+}
+
+void
+TorrentManager::hashDataPackets(const std::vector<size_t>& manifestIndexes)
+{
+  if (manifestIndexes.empty()) {
+    return;
+  }
+  // the tasks only read the shared state of the manager, except under the lock
+  std::vector<std::string> filePaths;
+  std::vector<size_t> subManifestSizes;
+  size_t numTotal = 0;
+  for (auto i : manifestIndexes) {
+    const auto& fileName = m_fileManifests[i].file_name();
+    filePaths.push_back(m_dataPath + fileName);
+    subManifestSizes.push_back(m_subManifestSizes[fileName]);
+    numTotal += m_fileManifests[i].catalog_size();
+  }
+  std::mutex mutex;
+  size_t numHashed = 0;
+  std::vector<ThreadPool::Task> tasks;
+  tasks.reserve(manifestIndexes.size());
+  for (size_t task = 0; task < manifestIndexes.size(); ++task) {
+    tasks.emplace_back([&, task] {
+      auto i = manifestIndexes[task];
+      const auto& m = m_fileManifests[i];
+      auto fileBitMap = initializeFileState(m_dataPath, m, subManifestSizes[task]);
+      // the signatures are collected by the task, then inserted at once under the lock
+      PacketSignatureStore::SignatureValues signatures;
+      auto onPacket = [&] (size_t packetNum, const Data& d) {
+        fileBitMap.set(packetNum);
+        PacketSignatureStore::SignatureValue value;
+        if (PacketSignatureStore::getSignatureValue(d, value)) {
+          signatures.emplace_back(packetNum, value);
+        }
+      };
+      auto numPackets = initializeDataPackets(filePaths[task],
+                                              m,
+                                              subManifestSizes[task],
+                                              *m_signingService,
+                                              onPacket);
+      std::lock_guard<std::mutex> lock(mutex);
+      m_signatureStore.insert(m, signatures);
+      // If there is any data for this manifest on disk, add corresponding state to manager
+      if (0 != numPackets) {
+        m_fileStates[i] = std::move(fileBitMap);
+        m_resumeJournal.markDirty(m.file_name());
+      }
+      numHashed += m.catalog_size();
+      if (m_onHashProgress) {
+        m_onHashProgress(numHashed, numTotal);
+      }
+    });
+  }
+  // the calling thread also runs tasks of the pool
+  ThreadPool pool(m_hashThreads > 1 ? m_hashThreads - 1 : 0);
+  pool.run(std::move(tasks));
+}
+
+void
+TorrentManager::hashFileState(size_t manifestIndex, const FileStateHashedCallback& onHashed)
+{
+  const auto& manifest = m_fileManifests[manifestIndex];
+  auto subManifestSize = m_subManifestSizes[manifest.file_name()];
+  auto filePath = m_dataPath + manifest.file_name();
+  auto valid = make_shared<PacketBitmap>(manifest.catalog_size());
+  auto signer = m_signingService;
+  runIo([manifest, subManifestSize, filePath, valid, signer] {
+          // the packets of a file we cannot read are all invalid
+          try {
+            initializeDataPackets(filePath, manifest, subManifestSize, *signer,
+                                  [&valid] (size_t packetNum, const Data&) {
+                                    valid->set(packetNum);
+                                  });
+          }
+          catch (const std::exception& e) {
+            LOG_ERROR << "Hashing failed: " << filePath << ": " << e.what() << std::endl;
+          }
+        },
+        [this, manifest, valid, onHashed] {
+          // the manifest may have moved while the file was hashed
+          auto manifestIndex = findFileManifest(manifest.name());
+          if (m_fileManifests.size() != manifestIndex) {
+            onHashed(m_fileStates[manifestIndex], *valid);
+          }
+        });
+}
+
+void
+TorrentManager::verifyFileState(size_t manifestIndex)
+{
+  const auto& manifest = m_fileManifests[manifestIndex];
+  auto manifestName = manifest.getFullName();
+  auto fileName = manifest.file_name();
+  // the packets written after the journal was loaded were never recorded, so only the packets
+  // restored from the journal are verified
+  auto restored = make_shared<PacketBitmap>(m_fileStates[manifestIndex]);
+  hashFileState(manifestIndex, [this, manifestName, fileName, restored] (PacketBitmap& fileState,
+                                                                         const PacketBitmap& valid) {
+    size_t numInvalid = 0;
+    for (size_t packetNum = 0; packetNum < restored->size(); ++packetNum) {
+      if (restored->test(packetNum) && !valid.test(packetNum) && fileState.reset(packetNum)) {
+        ++numInvalid;
+      }
+    }
+    if (0 != numInvalid) {
+      LOG_ERROR << numInvalid << " packets of " << manifestName
+                << " restored from the resume journal do not match the data on disk" << std::endl;
+      m_resumeJournal.markDirty(fileName);
+    }
+  });
+}
+
+void
+TorrentManager::runIo(const std::function<void()>& work, const std::function<void()>& onComplete)
+{
+  if (nullptr == m_ioPool) {
+    work();
+    onComplete();
+    return;
+  }
+  ++m_pendingIoOps;
+  m_ioPool->post([this, work, onComplete] {
+    work();
+    m_face->getIoService().post([this, onComplete] {
+      --m_pendingIoOps;
+      onComplete();
+      shutdownIfComplete();
+    });
+  });
+}
+
+void
+TorrentManager::shutdownIfComplete()
+{
+  if (!hasPendingInterests() && 0 == m_pendingIoOps && !m_seedFlag) {
+    shutdown();
+  }
+}
+
 void
 TorrentManager::shutdown()
 {
+  // the event loop stops, so the journal is written before returning
+  flushResumeJournal(true);
+  m_fileWriters.sync();
+  m_timedOutInterests.clear();
   m_face->getIoService().stop();
 }
 
+void
+TorrentManager::cancelRetransmission(const Name& interestName)
+{
+  m_timedOutInterests.erase(interestName);
+}
+
 // = = = = = = = = = = = = = = = = = = = = = = = = = = = = = = = = = = = = = = = = = = = = = = = = =
 //                                Protected Helpers
 // = = = = = = = = = = = = = = = = = = = = = = = = = = = = = = = = = = = = = = = = = = = = = = = = =
 
 bool TorrentManager::writeData(const Data& packet)
+{
+  const auto manifest = prepareDataWrite(packet);
+  if (nullptr == manifest) {
+    return false;
+  }
+  // write data to disk
+  auto subManifestSize = m_subManifestSizes[manifest->file_name()];
+  auto filePath = m_dataPath + manifest->file_name();
+  bool written = IoUtil::writeData(packet, *manifest, subManifestSize, filePath, m_fileWriters);
+  if (written) {
+    m_mappedFiles.markGrown(filePath);
+  }
+  return completeDataWrite(packet, written);
+}
+
+void
+TorrentManager::writeDataAsync(const Data& packet, const std::function<void(bool)>& onWritten)
+{
+  const auto manifest = prepareDataWrite(packet);
+  if (nullptr == manifest) {
+    onWritten(false);
+    return;
+  }
+  auto subManifestSize = m_subManifestSizes[manifest->file_name()];
+  auto filePath = m_dataPath + manifest->file_name();
+  // the write only needs the packet size and the position of the sub-manifest, so the worker gets
+  // a copy of the manifest without its catalog
+  FileManifest header(manifest->name(), manifest->data_packet_size(), manifest->catalog_prefix());
+  // make sure that the content of the packet is encoded before it is shared with the worker
+  packet.getContent();
+  auto written = make_shared<bool>(false);
+  runIo([this, packet, header, subManifestSize, filePath, written] {
+          *written = IoUtil::writeData(packet, header, subManifestSize, filePath, m_fileWriters);
+          if (*written) {
+            // the packet is only served once written, so its read will map the file again
+            m_mappedFiles.markGrown(filePath);
+          }
+        },
+        [this, packet, written, onWritten] {
+          onWritten(completeDataWrite(packet, *written));
+        });
+}
+
+const FileManifest*
+TorrentManager::prepareDataWrite(const Data& packet)
 {
   // find correct manifest
   const auto& packetName = packet.getName();
-  auto manifest_it = std::find_if(m_fileManifests.begin(), m_fileManifests.end(),
-                                 [&packetName](const FileManifest& m) {
-                                   return m.getName().isPrefixOf(packetName);
-                                 });
-  if (m_fileManifests.end() == manifest_it) {
-    return false;
+  auto manifestIndex = findFileManifest(packetName.getSubName(0, packetName.size() - 1));
+  if (m_fileManifests.size() == manifestIndex) {
+    return nullptr;
   }
+  const auto& manifest = m_fileManifests[manifestIndex];
   // get file state out
-  auto fileState_it = m_fileStates.find(manifest_it->getFullName());
+  auto& fileState = m_fileStates[manifestIndex];
   // if there is no open stream to the file
-  if(fileState_it == m_fileStates.end()) {
-    fs::path filePath = m_dataPath + manifest_it->file_name();
+  if (0 == fileState.size()) {
+    fs::path filePath = m_dataPath + manifest.file_name();
     if (!Io::exists(filePath)) {
       IoUtil::create_directories(filePath.parent_path());
     }
-    m_fileStates[manifest_it->getFullName()] =
-                initializeFileState(m_dataPath,
-                                    *manifest_it,
-                                    m_subManifestSizes[manifest_it->file_name()]);
+    fileState = initializeFileState(m_dataPath,
+                                    manifest,
+                                    m_subManifestSizes[manifest.file_name()]);
   }
-  auto& fileState = m_fileStates[manifest_it->getFullName()];
   auto packetNum = packetName.get(packetName.size() - 1).toSequenceNumber();
   // if we already have the packet, do not rewrite it.
-  if (fileState[packetNum]) {
+  if (packetNum >= fileState.size() || fileState.test(packetNum)) {
+    return nullptr;
+  }
+  return &manifest;
+}
+
+bool
+TorrentManager::completeDataWrite(const Data& packet, bool written)
+{
+  if (!written) {
+    LOG_ERROR << "Write failed: " << packet.getFullName() << std::endl;
     return false;
   }
-  // write data to disk
-  auto subManifestSize = m_subManifestSizes[manifest_it->file_name()];
-  auto filePath = m_dataPath + manifest_it->file_name();
-  if (IoUtil::writeData(packet, *manifest_it, subManifestSize, filePath)) {;
-    // update bitmap
-    fileState[packetNum] = true;
-    return true;
+  const auto& packetName = packet.getName();
+  auto manifestIndex = findFileManifest(packetName.getSubName(0, packetName.size() - 1));
+  // the state of the manager was reinitialized while the packet was being written
+  if (m_fileManifests.size() == manifestIndex) {
+    return false;
   }
-  LOG_ERROR << "Write failed: " << packet.getFullName() << std::endl;
-  return false;
+  const auto& manifest = m_fileManifests[manifestIndex];
+  auto packetNum = packetName.get(packetName.size() - 1).toSequenceNumber();
+  // update bitmap
+  auto& fileState = m_fileStates[manifestIndex];
+  if (packetNum >= fileState.size()) {
+    return false;
+  }
+  fileState.set(packetNum);
+  // remember the signature of the packet, so that we can serve it without signing it again
+  if (packetNum < manifest.catalog_size() &&
+      packet.getFullName() == manifest.catalog_name(packetNum)) {
+    m_signatureStore.insert(manifest, packetNum, packet);
+  }
+  // record the packet in the resume journal once enough packets are written
+  m_resumeJournal.addPacket(manifest, packetNum);
+  if (++m_unjournaledPackets >= JOURNAL_FLUSH_INTERVAL) {
+    flushResumeJournal();
+  }
+  return true;
 }
 
 bool
@@ -613,62 +1119,144 @@ TorrentManager::writeTorrentSegment(const TorrentFile& segment, const std::strin
 {
   // validate  the torrent
   auto torrentPrefix = m_torrentFileName.getSubName(0, m_torrentFileName.size() - 1);
+  if (!torrentPrefix.isPrefixOf(segment.getName())) {
+    return false;
+  }
   // check if we already have it
-  if (torrentPrefix.isPrefixOf(segment.getName()) &&
-      m_torrentSegments.end() == std::find(m_torrentSegments.begin(), m_torrentSegments.end(),
-                                           segment))
-  {
-    if(IoUtil::writeTorrentSegment(segment, path)) {
-      auto it = std::find_if(m_torrentSegments.begin(), m_torrentSegments.end(),
-                             [&segment](const TorrentFile& t){
-                               return segment.getSegmentNumber() < t.getSegmentNumber() ;
-                            });
-      m_torrentSegments.insert(it, segment);
-      return true;
+  auto position = findTorrentSegment(segment.getName());
+  if (m_torrentSegments.size() != position) {
+    if (m_torrentSegments[position].getFullName() != segment.getFullName()) {
+      LOG_ERROR << "Conflicting torrent file segment: " << segment.getFullName() << std::endl;
     }
+    return false;
   }
-  return false;
+  // the segments are sorted by segment number
+  auto it = std::upper_bound(m_torrentSegments.begin(), m_torrentSegments.end(), segment,
+                             [] (const TorrentFile& lhs, const TorrentFile& rhs) {
+                               return lhs.getSegmentNumber() < rhs.getSegmentNumber();
+                             });
+  it = m_torrentSegments.insert(it, segment);
+  indexTorrentSegment(it - m_torrentSegments.begin());
+  // write the segment to disk, it is already being served from memory
+  persistTorrentSegment(segment, path, 1);
+  return true;
 }
 
 
 bool TorrentManager::writeFileManifest(const FileManifest& manifest, const std::string& path)
 {
-  if (m_fileManifests.end() == std::find(m_fileManifests.begin(), m_fileManifests.end(),
-                                           manifest))
-  {
-    // update the state of the manager
-    if (0 == manifest.submanifest_number()) {
-      m_subManifestSizes[manifest.file_name()] = manifest.catalog().size();
-    }
-    if(IoUtil::writeFileManifest(manifest, path)) {
-      // add to collection
-      auto it = std::find_if(m_fileManifests.begin(), m_fileManifests.end(),
-                             [&manifest](const FileManifest& m){
-                               return m.file_name() >  manifest.file_name()
-                               ||    (m.file_name() == manifest.file_name()
-                                  && (m.submanifest_number() > manifest.submanifest_number()));
-                            });
-      m_fileManifests.insert(it, manifest);
-      return true;
+  // check if we already have it
+  auto position = findFileManifest(manifest.name());
+  if (m_fileManifests.size() != position) {
+    if (m_fileManifests[position].getFullName() != manifest.getFullName()) {
+      LOG_ERROR << "Conflicting file manifest: " << manifest.getFullName() << std::endl;
     }
+    return false;
   }
-  return false;
+  // update the state of the manager
+  if (0 == manifest.submanifest_number()) {
+    m_subManifestSizes[manifest.file_name()] = manifest.catalog_size();
+  }
+  // add to collection, sorted by file name and sub-manifest number
+  auto it = std::upper_bound(m_fileManifests.begin(), m_fileManifests.end(), manifest,
+                             [] (const FileManifest& lhs, const FileManifest& rhs) {
+                               auto lhsFileName = lhs.file_name();
+                               auto rhsFileName = rhs.file_name();
+                               return lhsFileName < rhsFileName ||
+                                      (lhsFileName == rhsFileName &&
+                                       lhs.submanifest_number() < rhs.submanifest_number());
+                             });
+  size_t manifestIndex = it - m_fileManifests.begin();
+  m_fileStates.insert(m_fileStates.begin() + manifestIndex, PacketBitmap());
+  // keep the lazy download at the same manifest
+  if (nullptr != m_missingPacketCursor &&
+      (manifestIndex < m_missingPacketCursor->manifestIndex ||
+       (manifestIndex == m_missingPacketCursor->manifestIndex &&
+        0 != m_missingPacketCursor->packetNum))) {
+    ++m_missingPacketCursor->manifestIndex;
+  }
+  it = m_fileManifests.insert(it, manifest);
+  indexFileManifest(it - m_fileManifests.begin());
+  // write the manifest to disk, it is already being served from memory
+  persistFileManifest(manifest, path, 1);
+  return true;
+}
+
+void
+TorrentManager::persistTorrentSegment(const TorrentFile& segment, const std::string& path,
+                                      size_t attempt)
+{
+  auto failed = make_shared<bool>(false);
+  runIo([segment, path, failed] {
+          try {
+            // false only if the same segment is already on disk
+            IoUtil::writeTorrentSegment(segment, path);
+          }
+          catch (const std::exception& e) {
+            LOG_ERROR << "Write failed: " << segment.getFullName() << ": " << e.what() << std::endl;
+            *failed = true;
+          }
+        },
+        [this, segment, path, attempt, failed] {
+          if (!*failed) {
+            return;
+          }
+          if (attempt < MAX_WRITE_ATTEMPTS) {
+            persistTorrentSegment(segment, path, attempt + 1);
+            return;
+          }
+          // forget the segment, so that it is downloaded (and written) again
+          auto position = findTorrentSegment(segment.getName());
+          if (m_torrentSegments.size() != position) {
+            LOG_ERROR << "Giving up on writing " << segment.getFullName() << std::endl;
+            eraseTorrentSegment(position);
+          }
+        });
+}
+
+void
+TorrentManager::persistFileManifest(const FileManifest& manifest, const std::string& path,
+                                    size_t attempt)
+{
+  auto failed = make_shared<bool>(false);
+  runIo([manifest, path, failed] {
+          try {
+            // false only if the same manifest is already on disk
+            IoUtil::writeFileManifest(manifest, path);
+          }
+          catch (const std::exception& e) {
+            LOG_ERROR << "Write failed: " << manifest.getFullName() << ": " << e.what()
+                      << std::endl;
+            *failed = true;
+          }
+        },
+        [this, manifest, path, attempt, failed] {
+          if (!*failed) {
+            return;
+          }
+          if (attempt < MAX_WRITE_ATTEMPTS) {
+            persistFileManifest(manifest, path, attempt + 1);
+            return;
+          }
+          // the packets of the manifest may already be on disk, so it is kept in memory and is
+          // only missing on the next startup, which downloads it again
+          LOG_ERROR << "Giving up on writing " << manifest.getFullName() << std::endl;
+        });
 }
 
 void
 TorrentManager::downloadFileManifestSegment(const Name& manifestName,
                                             const std::string& path,
-                                            std::shared_ptr<std::vector<Name>> packetNames,
                                             TorrentManager::ManifestReceivedCallback onSuccess,
-                                            TorrentManager::FailedCallback onFailed)
+                                            TorrentManager::FailedCallback onFailed,
+                                            bool followPointer)
 {
-  shared_ptr<Interest> interest = this->createInterest(manifestName);
-
-  auto dataReceived = [packetNames, path, onSuccess, onFailed, this]
+  auto dataReceived = [path, onSuccess, onFailed, followPointer, this]
                                           (const Interest& interest, const Data& data) {
     m_pendingInterests.erase(interest.getName());
+    m_indexListedSegments.erase(interest.getName());
     // Stats Table update here...
-    m_stats_table_iter->incrementReceivedData();
+    recordReceivedData(interest);
     m_retries = 0;
 
     FileManifest file(data.wireEncode());
@@ -681,22 +1269,34 @@ TorrentManager::downloadFileManifestSegment(const Name& manifestName,
       onFailed(interest.getName(), "Write Failed");
     }
 
-    const std::vector<Name>& packetsCatalog = file.catalog();
-    packetNames->insert(packetNames->end(), packetsCatalog.begin(), packetsCatalog.end());
-    shared_ptr<Name> nextSegmentPtr = file.submanifest_ptr();
-    if (nextSegmentPtr != nullptr) {
-      this->downloadFileManifestSegment(*nextSegmentPtr, path, packetNames, onSuccess, onFailed);
+    // request the next segments before handing out the packets of this one, so that the
+    // discovery of the rest of the manifest overlaps with the download of its data
+    if (!file.submanifest_index().empty()) {
+      // the segments listed by the index are requested at once, without following pointers
+      for (const auto& segmentName : file.submanifest_index()) {
+        if (m_fileManifestIndex.count(segmentName.getPrefix(-1)) == 0) {
+          this->downloadFileManifestSegment(segmentName, path, onSuccess, onFailed, false);
+        }
+      }
     }
-    else {
-      onSuccess(*packetNames);
+    else if (followPointer) {
+      shared_ptr<Name> nextSegmentPtr = file.submanifest_ptr();
+      // skip the segments we already have
+      while (nullptr != nextSegmentPtr &&
+             m_fileManifestIndex.count(nextSegmentPtr->getPrefix(-1)) != 0) {
+        const auto& next = m_fileManifests[findFileManifest(nextSegmentPtr->getPrefix(-1))];
+        nextSegmentPtr = next.submanifest_ptr();
+      }
+      if (nextSegmentPtr != nullptr) {
+        this->downloadFileManifestSegment(*nextSegmentPtr, path, onSuccess, onFailed, true);
+      }
     }
+    onSuccess(file.catalog());
     this->sendInterest();
-    if (!hasPendingInterests() && !m_seedFlag) {
-      shutdown();
-    }
+    shutdownIfComplete();
   };
 
-  auto dataFailed = [packetNames, path, manifestName, onFailed, this]
+  auto dataFailed = [path, manifestName, onFailed, this]
                                                 (const Interest& interest) {
     m_pendingInterests.erase(interest.getName());
     m_retries++;
@@ -708,8 +1308,13 @@ TorrentManager::downloadFileManifestSegment(const Name& manifestName,
     onFailed(interest.getName(), "Unknown failure");
     this->sendInterest();
   };
-  LOG_DEBUG << "Pushing to the Interest Queue: " << *interest << std::endl;
-  m_interestQueue->push(interest, dataReceived, dataFailed);
+  if (!followPointer) {
+    m_indexListedSegments.insert(manifestName);
+  }
+  LOG_DEBUG << "Pushing to the Interest Queue: " << manifestName << std::endl;
+  auto context = m_interestQueue->createContext(dataReceived, dataFailed);
+  m_interestQueue->push(context, manifestName, InterestQueue::FILE_MANIFEST_PRIORITY);
+  m_interestQueue->releaseContext(context);
   this->sendInterest();
 }
 
@@ -719,49 +1324,93 @@ TorrentManager::onInterestReceived(const InterestFilter& filter, const Interest&
   // handle if it is a torrent-file
   LOG_DEBUG << "Interest Received: " << interest << std::endl;
   const auto& interestName = interest.getName();
-  std::shared_ptr<Data> data = nullptr;
-  auto cmp = [&interestName](const Data& t){return t.getFullName() == interestName;};
-  // determine if it is torrent file (that we have)
-  auto torrent_it =  std::find_if(m_torrentSegments.begin(), m_torrentSegments.end(), cmp);
-  if (m_torrentSegments.end() != torrent_it) {
-    data = std::make_shared<Data>(*torrent_it);
-  }
-  else {
+  std::shared_ptr<const Data> data = nullptr;
+  // strip the implicit digest to look up the name in the indices
+  auto dataName = interestName.getSubName(0, interestName.size() - 1);
+  switch (IoUtil::findType(interestName)) {
+    // determine if it is torrent file (that we have)
+    case IoUtil::NAME_TYPE::TORRENT_FILE: {
+      auto position = findTorrentSegment(dataName);
+      if (m_torrentSegments.size() != position) {
+        const auto& segment = m_torrentSegments[position];
+        if (segment.getFullName() == interestName) {
+          data = std::make_shared<Data>(segment);
+        }
+      }
+    } break;
     // determine if it is manifest (that we have)
-    auto manifest_it = std::find_if(m_fileManifests.begin(), m_fileManifests.end(), cmp);
-    if (m_fileManifests.end() != manifest_it) {
-      data = std::make_shared<Data>(*manifest_it) ;
-    }
-    else {
-      // determine if it is data packet (that we have)
-      auto manifestName = interestName.getSubName(0, interestName.size() - 2);
-      auto map_it = std::find_if(m_fileStates.begin(), m_fileStates.end(),
-                                       [&manifestName](const std::pair<Name,
-                                                                       std::vector<bool>>& kv){
-                                        return manifestName.isPrefixOf(kv.first
-                                          );
-                                      });
-      if (m_fileStates.end() != map_it) {
-        auto packetName = interestName.getSubName(0, interestName.size() - 1);
-        // get out the bitmap to be sure we have the packet
-        auto& fileState = map_it->second;
-        const auto &bitmap = fileState;
-        auto packetNum = packetName.get(packetName.size() - 1).toSequenceNumber();
-        if (bitmap[packetNum]) {
-          // get the manifest
-          auto manifest_it = std::find_if(m_fileManifests.begin(), m_fileManifests.end(),
-                                          [&manifestName](const FileManifest& m) {
-                                            return manifestName.isPrefixOf(m.name());
-                                          });
-          auto manifestFileName = manifest_it->file_name();
-          auto filePath = m_dataPath + manifestFileName;
-          data = IoUtil::readDataPacket(interestName,
-                                        *manifest_it,
-                                        m_subManifestSizes[manifestFileName],
-                                        filePath);
+    case IoUtil::NAME_TYPE::FILE_MANIFEST: {
+      auto manifestIndex = findFileManifest(dataName);
+      if (m_fileManifests.size() != manifestIndex) {
+        const auto& manifest = m_fileManifests[manifestIndex];
+        if (manifest.getFullName() == interestName) {
+          data = std::make_shared<Data>(manifest);
         }
       }
+    } break;
+    // determine if it is data packet (that we have)
+    case IoUtil::NAME_TYPE::DATA_PACKET: {
+      // packets are cached once validated, or once rebuilt from the bytes on disk with a stored
+      // signature, which the store drops if the file changed on disk since it was recorded
+      data = m_dataPacketCache.find(interestName);
+      if (nullptr != data) {
+        break;
+      }
+      auto manifestIndex = findFileManifest(dataName.getSubName(0, dataName.size() - 1));
+      if (m_fileManifests.size() == manifestIndex) {
+        break;
+      }
+      const auto& manifest = m_fileManifests[manifestIndex];
+      // get out the bitmap to be sure we have the packet
+      auto packetNum = dataName.get(dataName.size() - 1).toSequenceNumber();
+      if (!m_fileStates[manifestIndex].test(packetNum)) {
+        break;
+      }
+      auto manifestFileName = manifest.file_name();
+      auto filePath = m_dataPath + manifestFileName;
+      auto subManifestSize = m_subManifestSizes[manifestFileName];
+      // if we know the signature of the packet, there is no need to sign it again
+      auto signatureValue = m_signatureStore.find(manifest, packetNum);
+      // the read only needs the packet size and the position of the sub-manifest, so the worker
+      // gets a copy of the manifest without its catalog
+      FileManifest header(manifest.name(), manifest.data_packet_size(), manifest.catalog_prefix());
+      auto packet = make_shared<shared_ptr<Data>>();
+      // answer the Interest once the packet is read from disk
+      runIo([this, interestName, header, subManifestSize, filePath, signatureValue, packet] {
+              if (nullptr != signatureValue) {
+                *packet = IoUtil::readDataPacket(interestName,
+                                                 header,
+                                                 subManifestSize,
+                                                 filePath,
+                                                 *signatureValue,
+                                                 &m_mappedFiles);
+              }
+              else {
+                *packet = IoUtil::readDataPacket(interestName,
+                                                 header,
+                                                 subManifestSize,
+                                                 filePath,
+                                                 &m_mappedFiles,
+                                                 *m_signingService);
+              }
+            },
+            [this, interest, dataName, packetNum, signatureValue, packet] {
+              if (nullptr == *packet) {
+                LOG_ERROR << "NACK: " << interest << std::endl;
+                return;
+              }
+              auto manifestIndex = findFileManifest(dataName.getPrefix(-1));
+              if (nullptr == signatureValue && m_fileManifests.size() != manifestIndex) {
+                m_signatureStore.insert(m_fileManifests[manifestIndex], packetNum, **packet);
+              }
+              m_dataPacketCache.insert(interest.getName(), *packet);
+              m_face->put(**packet);
+            });
+      return;
     }
+    case IoUtil::NAME_TYPE::UNKNOWN:
+    default:
+      break;
   }
   if (nullptr != data) {
     m_face->put(*data);
@@ -783,21 +1432,27 @@ TorrentManager::onRegisterFailed(const Name& prefix, const std::string& reason)
 }
 
 shared_ptr<Interest>
-TorrentManager::createInterest(Name name)
+TorrentManager::createInterest(Name name, const Name& forwardingHint)
 {
   shared_ptr<Interest> interest = make_shared<Interest>(name);
-  interest->setInterestLifetime(time::milliseconds(2000));
+  // the lifetime is set from the retransmission timeout of the prefix when the Interest is sent
   interest->setMustBeFresh(true);
 
-  // Select routable prefix
+  // Select routable prefix, the requested one if any, otherwise preferring the ones known to have
+  // the requested packet
+  auto record = forwardingHint.empty() ? findPacketHolder(name)
+                                       : m_statsTable.find(forwardingHint);
+  if (m_statsTable.end() == record) {
+    record = m_stats_table_iter;
+  }
   // Create and set the forwarding hint
   Delegation del;
   del.preference = 1;
-  del.name = m_stats_table_iter->getRecordName();
+  del.name = record->getRecordName();
   DelegationList list({del});
 
   // Stats Table update here...
-  m_stats_table_iter->incrementSentInterests();
+  record->incrementSentInterests();
 
   m_sortingCounter++;
   if (m_sortingCounter >= SORTING_INTERVAL) {
@@ -822,6 +1477,12 @@ void
 TorrentManager::nackCallBack(const Interest& i, const lp::Nack& n) {
   LOG_DEBUG << "Nack received: " << n.getReason() << ": " << i << std::endl;
   auto it = m_pendingInterests.find(i.getName());
+  if (m_pendingInterests.end() == it) {
+    return;
+  }
+  if (lp::NackReason::CONGESTION == n.getReason()) {
+    m_congestionController->onLoss();
+  }
   Name routablePrefix = (i.getForwardingHint().begin())->name;
   if (m_stats_table_iter->getRecordName() == routablePrefix) {
     m_stats_table_iter++;
@@ -843,6 +1504,9 @@ TorrentManager::nackCallBack(const Interest& i, const lp::Nack& n) {
   }
 
   newInterest.setForwardingHint(list);
+  setInterestLifetime(newInterest);
+  // the NACKed Interest brings no Data, so the round-trip time is measured from the resend
+  std::get<2>(it->second) = time::steady_clock::now();
   LOG_DEBUG << "Resending Interest with LINK: " << m_stats_table_iter->getRecordName()
             << std::endl;
 
@@ -851,18 +1515,253 @@ TorrentManager::nackCallBack(const Interest& i, const lp::Nack& n) {
                           std::get<1>(it->second));
  }
 
+StatsTable::iterator
+TorrentManager::findPacketHolder(const Name& name)
+{
+  // .../<file_name>/<submanifest_num>/<packet_num>/<implicit_digest>
+  if (name.size() < 2 || !name.get(-2).isSequenceNumber()) {
+    return m_statsTable.end();
+  }
+  Name manifestName = name.getPrefix(-2);
+  if (0 == m_fileManifestIndex.count(manifestName)) {
+    return m_statsTable.end();
+  }
+  auto peers = m_pieceAvailability.getPeers(manifestName, name.get(-2).toSequenceNumber());
+  if (peers.empty()) {
+    return m_statsTable.end();
+  }
+  // the table is sorted by success rate, so pick the best of the peers
+  return std::find_if(m_statsTable.begin(), m_statsTable.end(),
+                      [&peers] (const StatsTableRecord& record) {
+                        return peers.end() != std::find(peers.begin(), peers.end(),
+                                                        record.getRecordName());
+                      });
+}
+
+void
+TorrentManager::recordReceivedData(const Interest& interest)
+{
+  auto record = findRoutablePrefixRecord(interest);
+  if (m_statsTable.end() != record && 0 != record->getRecordSentInterests()) {
+    record->incrementReceivedData();
+  }
+}
+
+bool
+TorrentManager::findFileState(const Name& manifestName, std::vector<bool>& bitmap) const
+{
+  auto manifestIndex = findFileManifest(manifestName);
+  if (m_fileManifests.size() == manifestIndex) {
+    return false;
+  }
+  const auto& fileState = m_fileStates[manifestIndex];
+  if (0 == fileState.size()) {
+    bitmap.assign(m_fileManifests[manifestIndex].catalog_size(), false);
+  }
+  else {
+    bitmap = fileState.toVector();
+  }
+  return true;
+}
+
+void
+TorrentManager::requestBitmaps(const Name& manifestName)
+{
+  const auto& ownRoutablePrefix = m_updateHandler->getOwnRoutablePrefix();
+  auto now = time::steady_clock::now();
+  auto bitmapName = m_updateHandler->getBitmapName(manifestName);
+  for (const auto& record : m_statsTable) {
+    const auto& peer = record.getRecordName();
+    if (peer == ownRoutablePrefix) {
+      continue;
+    }
+    // skip the bitmaps that are already requested or were received recently
+    auto& nextRequest = m_bitmapRequests[std::make_pair(peer, manifestName)];
+    if (now < nextRequest) {
+      continue;
+    }
+    nextRequest = now + time::milliseconds(BITMAP_REFRESH_INTERVAL);
+    auto dataReceived = [this, manifestName] (const Interest& interest, const Data& data) {
+      m_pendingInterests.erase(interest.getName());
+      recordReceivedData(interest);
+      // the Interest may have been sent again to another peer after a NACK
+      const auto& peer = interest.getForwardingHint().begin()->name;
+      std::vector<bool> bitmap;
+      if (UpdateHandler::decodeBitmap(data, bitmap)) {
+        m_pieceAvailability.update(peer, manifestName, bitmap);
+        m_bitmapRequests[std::make_pair(peer, manifestName)] =
+          time::steady_clock::now() + time::milliseconds(BITMAP_REFRESH_INTERVAL);
+      }
+      this->sendInterest();
+    };
+    auto dataFailed = [this] (const Interest& interest) {
+      // the peer does not have the sub-manifest or is unreachable, so we learn nothing
+      m_pendingInterests.erase(interest.getName());
+      LOG_DEBUG << "BITMAP Interest timed out: " << interest << std::endl;
+      this->sendInterest();
+    };
+    auto context = m_interestQueue->createContext(dataReceived, dataFailed, peer);
+    m_interestQueue->push(context, bitmapName, InterestQueue::BITMAP_PRIORITY);
+    m_interestQueue->releaseContext(context);
+  }
+}
+
+StatsTable::iterator
+TorrentManager::findRoutablePrefixRecord(const Interest& interest)
+{
+  const auto& hint = interest.getForwardingHint();
+  if (hint.empty()) {
+    return m_statsTable.end();
+  }
+  return m_statsTable.find(hint.begin()->name);
+}
+
+void
+TorrentManager::setInterestLifetime(Interest& interest)
+{
+  auto record = findRoutablePrefixRecord(interest);
+  interest.setInterestLifetime(m_statsTable.end() != record ? record->getRto()
+                                                            : StatsTableRecord::INITIAL_RTO);
+}
+
 void
 TorrentManager::sendInterest()
 {
-  while (m_pendingInterests.size() < WINDOW_SIZE && !m_interestQueue->empty()) {
-    queueTuple tup = m_interestQueue->pop();
-    m_pendingInterests.insert({std::get<0>(tup)->getName(), std::make_tuple(std::get<1>(tup),
-                               std::get<2>(tup))});
-    LOG_DEBUG << "Sending: " <<  *(std::get<0>(tup)) << std::endl;
-    m_face->expressInterest(*std::get<0>(tup), std::get<1>(tup),
+  // the packets we are missing are requested only as the window opens
+  while (m_pendingInterests.size() < m_congestionController->getWindow() &&
+         (!m_interestQueue->empty() || queueNextMissingDataPacket())) {
+    // build the Interest of the entry now that it is sent
+    const auto& entry = m_interestQueue->front();
+    shared_ptr<Interest> interestPtr =
+      InterestQueue::CATALOG_ENTRY == entry.type ?
+        createInterest(m_fileManifests[m_fileManifestPositions[entry.index]]
+                         .catalog_name(entry.packetNum)) :
+        createInterest(m_interestQueue->getName(entry),
+                       m_interestQueue->getForwardingHint(entry.context));
+    DataCallback onData = m_interestQueue->getDataCallback(entry.context);
+    TimeoutCallback onTimeout = m_interestQueue->getTimeoutCallback(entry.context);
+    m_interestQueue->pop();
+    // feed the RTT estimator and the congestion controller before the callbacks erase the
+    // pending Interest and send the next ones
+    DataCallback dataReceived = [onData, this] (const Interest& interest, const Data& data) {
+      m_timedOutInterests.erase(interest.getName());
+      auto it = m_pendingInterests.find(interest.getName());
+      if (m_pendingInterests.end() != it) {
+        auto record = findRoutablePrefixRecord(interest);
+        time::nanoseconds rtt = time::steady_clock::now() - std::get<2>(it->second);
+        if (std::get<3>(it->second)) {
+          // Karn's algorithm: the Data may answer the Interest that timed out
+          if (m_statsTable.end() != record) {
+            rtt = record->getSmoothedRtt();
+          }
+        }
+        else if (m_statsTable.end() != record) {
+          record->addRttSample(rtt);
+        }
+        m_congestionController->onData(rtt);
+      }
+      onData(interest, data);
+    };
+    TimeoutCallback dataFailed = [onTimeout, this] (const Interest& interest) {
+      auto record = findRoutablePrefixRecord(interest);
+      if (m_statsTable.end() != record) {
+        record->backoffRto();
+      }
+      m_timedOutInterests.insert(interest.getName());
+      m_congestionController->onLoss();
+      onTimeout(interest);
+    };
+    Interest& interest = *interestPtr;
+    setInterestLifetime(interest);
+    bool isRetransmission = m_timedOutInterests.erase(interest.getName()) != 0;
+    m_pendingInterests.insert({interest.getName(),
+                               std::make_tuple(dataReceived, dataFailed,
+                                               time::steady_clock::now(), isRetransmission)});
+    LOG_DEBUG << "Sending: " << interest << std::endl;
+    m_face->expressInterest(interest, dataReceived,
                             std::bind(&TorrentManager::nackCallBack, this, _1, _2),
-                            std::get<2>(tup));
+                            dataFailed);
+  }
+}
+
+void
+TorrentManager::indexTorrentSegments()
+{
+  m_torrentSegmentIndex.clear();
+  m_torrentSegmentIds.clear();
+  m_torrentSegmentPositions.clear();
+  for (size_t i = 0; i < m_torrentSegments.size(); ++i) {
+    indexTorrentSegment(i);
+  }
+}
+
+void
+TorrentManager::indexTorrentSegment(size_t position)
+{
+  // only the positions of the segments after it change, no name is hashed again
+  size_t id = m_torrentSegmentPositions.size();
+  m_torrentSegmentIndex[m_torrentSegments[position].getName()] = id;
+  m_torrentSegmentPositions.push_back(position);
+  m_torrentSegmentIds.insert(m_torrentSegmentIds.begin() + position, id);
+  for (size_t i = position + 1; i < m_torrentSegmentIds.size(); ++i) {
+    m_torrentSegmentPositions[m_torrentSegmentIds[i]] = i;
+  }
+}
+
+void
+TorrentManager::eraseTorrentSegment(size_t position)
+{
+  m_torrentSegmentIndex.erase(m_torrentSegments[position].getName());
+  m_torrentSegments.erase(m_torrentSegments.begin() + position);
+  m_torrentSegmentIds.erase(m_torrentSegmentIds.begin() + position);
+  for (size_t i = position; i < m_torrentSegmentIds.size(); ++i) {
+    m_torrentSegmentPositions[m_torrentSegmentIds[i]] = i;
+  }
+}
+
+size_t
+TorrentManager::findTorrentSegment(const Name& segmentName) const
+{
+  auto index_it = m_torrentSegmentIndex.find(segmentName);
+  if (m_torrentSegmentIndex.end() == index_it) {
+    return m_torrentSegments.size();
+  }
+  return m_torrentSegmentPositions[index_it->second];
+}
+
+void
+TorrentManager::indexFileManifests()
+{
+  m_fileManifestIndex.clear();
+  m_fileManifestIds.clear();
+  m_fileManifestPositions.clear();
+  for (size_t i = 0; i < m_fileManifests.size(); ++i) {
+    indexFileManifest(i);
+  }
+}
+
+void
+TorrentManager::indexFileManifest(size_t position)
+{
+  // the manifest gets a new id, so that the queued packets of the other manifests keep referring
+  // to them
+  size_t id = m_fileManifestPositions.size();
+  m_fileManifestIndex[m_fileManifests[position].name()] = id;
+  m_fileManifestPositions.push_back(position);
+  m_fileManifestIds.insert(m_fileManifestIds.begin() + position, id);
+  for (size_t i = position + 1; i < m_fileManifestIds.size(); ++i) {
+    m_fileManifestPositions[m_fileManifestIds[i]] = i;
+  }
+}
+
+size_t
+TorrentManager::findFileManifest(const Name& manifestName) const
+{
+  auto index_it = m_fileManifestIndex.find(manifestName);
+  if (m_fileManifestIndex.end() == index_it) {
+    return m_fileManifests.size();
   }
+  return m_fileManifestPositions[index_it->second];
 }
 
 void
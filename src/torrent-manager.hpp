@@ -22,21 +22,32 @@
 #ifndef INCLUDED_TORRENT_FILE_MANAGER_H
 #define INCLUDED_TORRENT_FILE_MANAGER_H
 
+#include "congestion-controller.hpp"
+#include "data-packet-cache.hpp"
 #include "file-manifest.hpp"
 #include "interest-queue.hpp"
+#include "packet-signature-store.hpp"
+#include "piece-availability.hpp"
+#include "resume-journal.hpp"
 #include "torrent-file.hpp"
 #include "update-handler.hpp"
+#include "util/file-writer-pool.hpp"
+#include "util/mapped-file.hpp"
+#include "util/packet-bitmap.hpp"
+#include "util/signing-service.hpp"
+#include "util/thread-pool.hpp"
 
 #include <ndn-cxx/data.hpp>
 #include <ndn-cxx/face.hpp>
 #include <ndn-cxx/interest.hpp>
 #include <ndn-cxx/link.hpp>
 #include <ndn-cxx/name.hpp>
-#include <ndn-cxx/security/key-chain.hpp>
 
 #include <functional>
+#include <map>
 #include <memory>
 #include <string>
+#include <utility>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
@@ -55,7 +66,11 @@ class TorrentManager : noncopyable {
    typedef std::function<void(const std::vector<ndn::Name>&)>        ManifestReceivedCallback;
    typedef std::function<void(const std::vector<ndn::Name>&)>        TorrentFileReceivedCallback;
    typedef std::function<void(const ndn::Name&, const std::string&)> FailedCallback;
-   typedef std::tuple<DataCallback, TimeoutCallback>                 PendingInterestQueueEntry;
+   typedef std::function<void(size_t, size_t)>                        HashProgressCallback;
+   // The callbacks of a pending Interest, the time it was (last) sent and whether it is sent
+   // again after a timeout
+   typedef std::tuple<DataCallback, TimeoutCallback,
+                      time::steady_clock::TimePoint, bool>           PendingInterestQueueEntry;
    typedef std::unordered_map<ndn::Name, PendingInterestQueueEntry>  PendingInterestQueue;
 
    /*
@@ -63,14 +78,17 @@ class TorrentManager : noncopyable {
     * @param torrentFileName The full name of the initial segment of the torrent file
     * @param dataPath The path to the location on disk to use for the torrent data
     * @param face Optional face object to be used for data retrieval
+    * @param signingService Optional signing service used to sign and validate the packets of the
+    *        torrent, shared with the rest of the process by default
     *
     * The behavior is undefined unless Initialize() is called before calling any other method on a
     * TorrentManger object.
     */
-   TorrentManager(const ndn::Name&      torrentFileName,
-                  const std::string&    dataPath,
-                  bool                  seed = true,
-                  std::shared_ptr<Face> face = nullptr);
+   TorrentManager(const ndn::Name&                torrentFileName,
+                  const std::string&              dataPath,
+                  bool                            seed = true,
+                  std::shared_ptr<Face>           face = nullptr,
+                  std::shared_ptr<SigningService> signingService = nullptr);
 
   /*
    * @brief Initialize the state of this object.
@@ -78,6 +96,10 @@ class TorrentManager : noncopyable {
    * Read and validate from disk all torrent file segments, file manifests, and data packets for
    * the torrent file managed by this object initializing all state in this manager respectively.
    * Also seeds all validated data.
+   *
+   * The data packets of the files left unchanged since the last run are restored from the resume
+   * journal instead of being hashed again (see setResumeVerification). The prefixes are registered
+   * from the torrent file and the manifests alone, each one once (see setLazyInitialization).
   */
   void
   Initialize();
@@ -154,6 +176,12 @@ class TorrentManager : noncopyable {
   void
   findAllMissingDataPackets(std::vector<Name>& packetNames) const;
 
+  /*
+   * \brief Return whether we have all the data packets of the file manifests we have
+   */
+  bool
+  hasAllDataPackets() const;
+
   bool
   hasPendingInterests() const;
 
@@ -162,6 +190,14 @@ class TorrentManager : noncopyable {
    */
   void
   shutdown();
+
+  /*
+   * @brief Forget that the Interest for a name timed out, once we give up on requesting it
+   * @param interestName The name of the Interest that is not sent again
+   */
+  void
+  cancelRetransmission(const Name& interestName);
+
   /*
    * @brief Download the torrent file
    * @param path The path to write the downloaded segments
@@ -183,9 +219,10 @@ class TorrentManager : noncopyable {
    * @brief Download a file manifest
    * @param manifestName The name of the manifest file to be downloaded
    * @param path The path to write the downloaded segments
-   * @param onSuccess Callback to be called if we successfully download all the
-   *                  segments of the file manifest. It passes the names of the data packets
-   *                  to be downloaded to the callback
+   * @param onSuccess Callback to be called as each segment of the file manifest is
+   *                  downloaded. It passes the names of the data packets of the segment
+   *                  to be downloaded to the callback, so that they can be downloaded while
+   *                  the next segments are
    * @param onFailed Callaback to be called if we fail to download a segment of
    *                 the file manifest. It passes the name of the data packet that failed
    *                 to download and a failure reason
@@ -199,6 +236,38 @@ class TorrentManager : noncopyable {
                          ManifestReceivedCallback onSuccess,
                          FailedCallback           onFailed);
 
+  /*
+   * @brief Retry downloading a torrent file segment that failed to download
+   * @param segmentName The name of the segment that failed to download
+   * @param path The path to write the torrent file segment on disk
+   * @param onSuccess Callback to be called with the manifest names of the segment
+   * @param onFailed Callback to be called if we fail again to download the segment
+   *
+   * Only the failed segment is requested again. The segments after it are requested by
+   * following its pointer, unless it was listed by the segment index.
+   */
+  void
+  retryTorrentFileSegment(const Name&                 segmentName,
+                          const std::string&          path,
+                          TorrentFileReceivedCallback onSuccess,
+                          FailedCallback              onFailed);
+
+  /*
+   * @brief Retry downloading a file manifest segment that failed to download
+   * @param segmentName The name of the segment that failed to download
+   * @param path The path to write the file manifest segment on disk
+   * @param onSuccess Callback to be called with the data packet names of the segment
+   * @param onFailed Callback to be called if we fail again to download the segment
+   *
+   * Only the failed segment is requested again. The segments after it are requested by
+   * following its pointer, unless it was listed by the sub-manifest index.
+   */
+  void
+  retryFileManifestSegment(const Name&              segmentName,
+                           const std::string&       path,
+                           ManifestReceivedCallback onSuccess,
+                           FailedCallback           onFailed);
+
   /*
    * @brief Download a data packet
    * @param packetName The name of the data packet to be downloaded
@@ -215,6 +284,43 @@ class TorrentManager : noncopyable {
                        DataReceivedCallback onSuccess,
                        FailedCallback       onFailed);
 
+  /*
+   * @brief Set the priority of the data packets of the file @p fileName
+   * @param priority InterestQueue::HIGH_DATA_PRIORITY, DATA_PRIORITY (the default) or
+   *                 LOW_DATA_PRIORITY
+   * @throws std::invalid_argument if @p priority is not a priority of data packets
+   *
+   * The Interests of the files of higher priority get a larger share of the window than the
+   * others, and apply to the packets queued from now on.
+   */
+  void
+  setFilePriority(const std::string& fileName, InterestQueue::Priority priority);
+
+  /*
+   * @brief Download the data packets @p packetNames
+   *
+   * Like download_data_packet for each of the packets, but the packets share a single copy of
+   * the callbacks while they wait in the Interest queue.
+   */
+  void
+  download_data_packets(const std::vector<Name>& packetNames,
+                        DataReceivedCallback     onSuccess,
+                        FailedCallback           onFailed);
+
+  /*
+   * @brief Download all the data packets we are currently missing
+   * @param onSuccess Callback to be called for each data packet we successfully download
+   * @param onFailed Callaback to be called for each data packet we fail to download
+   *
+   * The names of the missing packets are produced from the file states as the congestion window
+   * opens, instead of being queued all at once, so that the memory used stays proportional to
+   * the window. The packets that fail are not requested again, unless passed to
+   * download_data_packet. Calling this method again restarts the download from the first
+   * missing packet.
+   */
+  void
+  downloadMissingDataPackets(DataReceivedCallback onSuccess, FailedCallback onFailed);
+
   // Seed the specified 'data' to the network.
   void
   seed(const Data& data);
@@ -226,6 +332,112 @@ class TorrentManager : noncopyable {
   void
   processEvents(const time::milliseconds& timeout = time::milliseconds(0));
 
+  /**
+   * @brief Return the cache of signed Data packets used to answer Interests for torrent data
+   */
+  const DataPacketCache&
+  getDataPacketCache() const;
+
+  /**
+   * @brief Set the maximum number of bytes of the Data packets cached for seeding
+   */
+  void
+  setDataPacketCacheCapacity(size_t capacity);
+
+  /**
+   * @brief Run the disk I/O of the downloaded and seeded Data on @p numThreads worker threads
+   *
+   * The reads and writes run on the worker threads and their completions are posted back to the
+   * event loop of the face, so that a slow disk does not stall the processing of Interests and
+   * Data. With no worker threads (the default), the disk I/O runs synchronously inside the
+   * callbacks of the face.
+   */
+  void
+  setIoThreads(size_t numThreads);
+
+  /**
+   * @brief Verify the data packets restored from the resume journal in the background
+   *
+   * The journal of a file is trusted as long as the file keeps the size and the modification time
+   * recorded with it. When the verification is enabled, Initialize also hashes the data packets
+   * restored from the journal on the I/O threads, and marks the ones that do not match their
+   * manifest as missing. It is disabled by default.
+   */
+  void
+  setResumeVerification(bool verify);
+
+  /**
+   * @brief Hash the data packets missing from the resume journal in the background
+   *
+   * By default, Initialize hashes the files that are not in the resume journal before it returns.
+   * When the initialization is lazy, these files are hashed on the I/O threads instead, and the
+   * packets of each sub-manifest are added to the state of the manager once it is hashed, so that
+   * the time to start seeding does not depend on the size of the torrent. Until then, the packets
+   * count as missing, so that they may be downloaded again.
+   */
+  void
+  setLazyInitialization(bool lazy);
+
+  /**
+   * @brief Hash the files missing from the resume journal on @p numThreads threads in Initialize
+   *
+   * The sub-manifests are hashed concurrently, so that hashing a large torrent is bound by the
+   * disk rather than by a single core. By default, there is one thread per core.
+   */
+  void
+  setHashThreads(size_t numThreads);
+
+  /**
+   * @brief Report the progress of the hashing in Initialize to @p onProgress
+   *
+   * The callback receives the number of packets hashed so far and the total number of packets
+   * to hash, once per hashed sub-manifest. It is called on the hashing threads, one call at a
+   * time.
+   */
+  void
+  setHashProgressCallback(const HashProgressCallback& onProgress);
+
+  /**
+   * @brief Set the congestion controller that paces the Interests sent by this manager
+   *
+   * The controller decides how many Interests may be pending at any time. It is fed with the
+   * round-trip time of every received Data packet and with every timeout and congestion NACK.
+   * The default controller is an AimdCongestionController.
+   */
+  void
+  setCongestionController(std::unique_ptr<CongestionController> controller);
+
+  /**
+   * @brief Return the congestion controller that paces the Interests sent by this manager
+   */
+  const CongestionController&
+  getCongestionController() const;
+
+  /**
+   * @brief Return the number of peers known to have each Data packet of the torrent
+   *
+   * The manager records that a peer has a packet whenever the routable prefix of the peer serves
+   * it. Fetching strategies read the table to choose which packets to request first.
+   */
+  PieceAvailability&
+  getPieceAvailability();
+
+  const PieceAvailability&
+  getPieceAvailability() const;
+
+  /**
+   * @brief Ask every known peer which packets of a sub-manifest it has
+   * @param manifestName The name (without the implicit digest) of the sub-manifest
+   *
+   * The bitmaps the peers advertise update the piece availability of this manager, after which
+   * the Interests for the packets of the sub-manifest are routed to a peer known to have them.
+   * The requests are queued in the lowest priority class, paced by the congestion window like
+   * any other Interest, and a peer is asked for the bitmap of a sub-manifest at most once every
+   * BITMAP_REFRESH_INTERVAL milliseconds.
+   */
+  void
+  requestBitmaps(const Name& manifestName);
+
  protected:
   /**
    * \brief Write @p packet composed of torrent date to disk.
@@ -237,13 +449,24 @@ class TorrentManager : noncopyable {
   bool
   writeData(const Data& packet);
 
+  /**
+   * \brief Write @p packet composed of torrent date to disk on the I/O threads of this manager
+   * @param packet The data packet to be written to the disk
+   * @param onWritten Callback called on the event loop once the write completes, passed 'true'
+   *                  if the data was successfully written to disk 'false' otherwise
+   * Behavior is undefined unless the corresponding file manifest has already been downloaded.
+   */
+  void
+  writeDataAsync(const Data& packet, const std::function<void(bool)>& onWritten);
+
   /*
    * \brief Write the @p segment torrent segment to disk at the specified path.
    * @param segment The torrent file segment to be written to disk
    * @param path The path at which to write the torrent file segment
-   * Write the segment to disk, return 'true' if data successfully written to disk 'false'
-   * otherwise. Behavior is undefined unless @segment is a correct segment for the torrent file of
-   * this manager and @p path is the directory used for all segments of this torrent file.
+   * Add the segment to this manager and write it to disk, return 'true' if the segment was added
+   * 'false' otherwise. The segment is written on the I/O threads of this manager, if any.
+   * Behavior is undefined unless @segment is a correct segment for the torrent file of this
+   * manager and @p path is the directory used for all segments of this torrent file.
    */
   bool
   writeTorrentSegment(const TorrentFile& segment, const std::string& path);
@@ -252,10 +475,11 @@ class TorrentManager : noncopyable {
    * \brief Write the @p manifest file manifest to disk at the specified @p path.
    * @param manifest The file manifest  to be written to disk
    * @param path The path at which to write the file manifest
-   * Write the file manifest to disk, return 'true' if data successfully written to disk 'false'
-   * otherwise. Behavior is undefined unless @manifest is a correct file manifest for a file in the
-   * torrent file of this manager and @p path is the directory used for all file manifests of this
-   * torrent file.
+   * Add the file manifest to this manager and write it to disk, return 'true' if the manifest was
+   * added 'false' otherwise. The manifest is written on the I/O threads of this manager, if any.
+   * Behavior is undefined unless @manifest is a correct file manifest for a file in the torrent
+   * file of this manager and @p path is the directory used for all file manifests of this torrent
+   * file.
    */
   bool
   writeFileManifest(const FileManifest& manifest, const std::string& path);
@@ -264,42 +488,50 @@ class TorrentManager : noncopyable {
    * \brief Download the segments of the torrent file
    * @param name The name of the torrent file to be downloaded
    * @param path The path to write the torrent file on disk
-   * @param onSuccess Optional callback to be called when all the segments of the torrent file
-   *                  have been downloaded. The default value is an empty callback.
+   * @param onSuccess Optional callback to be called with the manifest names of each segment of
+   *                  the torrent file as soon as the segment is downloaded
    * @param onFailed Optional callback to be called when we fail to download a segment of the
    *                 torrent file. The default value is an empty callback.
+   * @param followPointer Whether to download the next segments by following their pointers,
+   *                      which is not needed for the segments listed by an index
    *
    */
   void
   downloadTorrentFileSegment(const ndn::Name& name,
                              const std::string& path,
                              TorrentFileReceivedCallback onSuccess,
-                             FailedCallback onFailed);
+                             FailedCallback onFailed,
+                             bool followPointer);
 
   /*
    * \brief Download the segments of a file manifest
    * @param manifestName The name of the file manifest to be downloaded
    * @param path The path to write the file manifest on disk
-   * @param packetNames A vector containing the name of the data packets in the file manifest
-   * @param onSuccess Callback to be called when all the segments of the file manifest have been
-   *                  downloaded
+   * @param onSuccess Callback to be called with the names of the data packets of each segment of
+   *                  the file manifest as soon as the segment is downloaded
    * @param onFailed Callback to be called when we fail to download a file manifest segment
+   * @param followPointer Whether to download the next segments by following their pointers,
+   *                      which is not needed for the segments listed by an index
    *
    */
   void
   downloadFileManifestSegment(const Name& manifestName,
                               const std::string& path,
-                              std::shared_ptr<std::vector<Name>> packetNames,
                               ManifestReceivedCallback onSuccess,
-                              FailedCallback onFailed);
+                              FailedCallback onFailed,
+                              bool followPointer);
 
   enum {
     // Number of times to retry if a routable prefix fails to retrieve data
     MAX_NUM_OF_RETRIES = 5,
     // Number of Interests to be sent before sorting the stats table
     SORTING_INTERVAL = 100,
-    // Maximum window size used for sending new Interests out
-    WINDOW_SIZE = 50
+    // Number of data packets to be written before the resume journal is written
+    JOURNAL_FLUSH_INTERVAL = 4096,
+    // Number of times to try writing a torrent file segment or a file manifest to disk
+    MAX_WRITE_ATTEMPTS = 3,
+    // Time in milliseconds before the bitmap of a sub-manifest is requested again from a peer
+    BITMAP_REFRESH_INTERVAL = 10000
   };
 
   void onDataReceived(const Data& data);
@@ -313,23 +545,186 @@ class TorrentManager : noncopyable {
   void
   eraseOwnRoutablePrefix();
 
+  /*
+   * \brief Index all the torrent file segments of this manager, giving each of them a new id
+   */
+  void
+  indexTorrentSegments();
+
+  /*
+   * \brief Index the torrent file segment just inserted at @p position of m_torrentSegments
+   *
+   * The segment gets a new id, and the segments after it are moved to the next position.
+   */
+  void
+  indexTorrentSegment(size_t position);
+
+  /*
+   * \brief Remove the torrent file segment at @p position of m_torrentSegments from the manager
+   */
+  void
+  eraseTorrentSegment(size_t position);
+
+  /*
+   * \brief Return the position in m_torrentSegments of the torrent file segment named
+   *        @p segmentName (without the implicit digest), or the number of segments if we do not
+   *        have it
+   */
+  size_t
+  findTorrentSegment(const Name& segmentName) const;
+
+  /*
+   * \brief Index all the file manifests of this manager, giving each of them a new id
+   */
+  void
+  indexFileManifests();
+
+  /*
+   * \brief Index the file manifest just inserted at @p position of m_fileManifests
+   *
+   * The manifest gets a new id, and the manifests after it are moved to the next position.
+   */
+  void
+  indexFileManifest(size_t position);
+
+  /*
+   * \brief Return the position in m_fileManifests of the file manifest named @p manifestName
+   *        (without the implicit digest), or the number of file manifests if we do not have it
+   */
+  size_t
+  findFileManifest(const Name& manifestName) const;
+
 protected:
-  // A map from each fileManifest a bitmap of which Data packets this manager currently has
-  mutable std::unordered_map<Name, std::vector<bool>>                 m_fileStates;
+  // The bitmap of which Data packets this manager currently has for each file manifest, at the
+  // position of the manifest in m_fileManifests (empty if none of the packets are on disk)
+  std::vector<PacketBitmap>                                           m_fileStates;
   // A map for each initial manifest to the size for the sub-manifest
   std::unordered_map<std::string, size_t>                             m_subManifestSizes;
   // The segments of the TorrentFile this manager has
   std::vector<TorrentFile>                                            m_torrentSegments;
   // The FileManifests this manager has
   std::vector<FileManifest>                                           m_fileManifests;
+  // A map from the name (without the implicit digest) of each torrent file segment to its id,
+  // which does not change when other segments are inserted before it
+  std::unordered_map<Name, size_t>                                    m_torrentSegmentIndex;
+  // The id of the torrent file segment at each position of m_torrentSegments
+  std::vector<size_t>                                                 m_torrentSegmentIds;
+  // The position in m_torrentSegments of the torrent file segment with each id
+  std::vector<size_t>                                                 m_torrentSegmentPositions;
+  // A map from the name (without the implicit digest) of each file manifest to its id, which does
+  // not change when other manifests are inserted before it
+  std::unordered_map<Name, size_t>                                    m_fileManifestIndex;
+  // The id of the file manifest at each position of m_fileManifests
+  std::vector<size_t>                                                 m_fileManifestIds;
+  // The position in m_fileManifests of the file manifest with each id
+  std::vector<size_t>                                                 m_fileManifestPositions;
+  // The names of the requested segments that were listed by an index, which are retried
+  // without following their pointers
+  std::unordered_set<Name>                                            m_indexListedSegments;
   // The name of the initial segment of the torrent file for this manager
   Name                                                                m_torrentFileName;
   // The path to the location on disk of the Data packet for this manager
   std::string                                                         m_dataPath;
 
 private:
+  // Create the Interest for @p name, sent to the peer @p forwardingHint if it is not empty
   shared_ptr<Interest>
-  createInterest(Name name);
+  createInterest(Name name, const Name& forwardingHint = Name());
+
+  // Return the manifest of @p packet if the packet is to be written, creating the state of the
+  // file if needed. Otherwise, return nullptr.
+  const FileManifest*
+  prepareDataWrite(const Data& packet);
+
+  // Update the state of the manager once @p packet is written, return @p written
+  bool
+  completeDataWrite(const Data& packet, bool written);
+
+  // Write @p segment to disk on the I/O threads. If the write fails after MAX_WRITE_ATTEMPTS
+  // attempts, the segment is dropped from the manager, so that it is downloaded again.
+  void
+  persistTorrentSegment(const TorrentFile& segment, const std::string& path, size_t attempt);
+
+  // Write @p manifest to disk on the I/O threads, trying up to MAX_WRITE_ATTEMPTS times
+  void
+  persistFileManifest(const FileManifest& manifest, const std::string& path, size_t attempt);
+
+  // Sync the data written to disk, then write the resume journal and the signature store on the
+  // I/O threads, or before returning if @p wait is true. The files that fail to sync are not
+  // written to the journal nor the store, they are marked dirty instead.
+  void
+  flushResumeJournal(bool wait = false);
+
+  // Hash the packets on disk of the manifests at @p manifestIndexes concurrently and set their
+  // state, reporting the progress to m_onHashProgress
+  void
+  hashDataPackets(const std::vector<size_t>& manifestIndexes);
+
+  typedef std::function<void(PacketBitmap& fileState, const PacketBitmap& valid)>
+    FileStateHashedCallback;
+
+  // Hash the packets on disk of the manifest at @p manifestIndex on the I/O threads, then call
+  // @p onHashed on the event loop with the state of the manifest and the packets matching it
+  void
+  hashFileState(size_t manifestIndex, const FileStateHashedCallback& onHashed);
+
+  // Hash the packets of the manifest at @p manifestIndex restored from the resume journal on the
+  // I/O threads, then mark the ones that do not match the manifest as missing
+  void
+  verifyFileState(size_t manifestIndex);
+
+  // Run @p work on the I/O threads, then @p onComplete on the event loop of the face
+  void
+  runIo(const std::function<void()>& work, const std::function<void()>& onComplete);
+
+  // Shut down if there is nothing left to download or write and we are not seeding
+  void
+  shutdownIfComplete();
+
+  // Return the record of the best routable prefix known to have the packet @p name, or
+  // m_statsTable.end() if there is none or @p name is not the full name of a Data packet
+  StatsTable::iterator
+  findPacketHolder(const Name& name);
+
+  // Count a Data packet received for @p interest in the record of its routable prefix
+  void
+  recordReceivedData(const Interest& interest);
+
+  // Set @p bitmap to the packets of the sub-manifest @p manifestName we have and return true, or
+  // return false if we do not have the sub-manifest
+  bool
+  findFileState(const Name& manifestName, std::vector<bool>& bitmap) const;
+
+  // Queue an Interest for the data packet @p packetName in @p context, without sending it
+  void
+  queueDataPacket(InterestQueue::ContextId context, const Name& packetName);
+
+  // Return the priority of the packets of the manifest at @p manifestIndex
+  InterestQueue::Priority
+  findDataPriority(size_t manifestIndex) const;
+
+  // Create a context in the Interest queue for the data packets downloaded with the callbacks
+  // @p onSuccess and @p onFailed
+  InterestQueue::ContextId
+  createDataPacketContext(DataReceivedCallback onSuccess, FailedCallback onFailed);
+
+  // Queue an Interest for the next packet of the download of the missing packets and return true,
+  // or return false if there is none
+  bool
+  queueNextMissingDataPacket();
+
+  // Append the names of the packets of the manifest at @p manifestIndex we are missing
+  void
+  findMissingDataPackets(size_t manifestIndex, std::vector<Name>& packetNames) const;
+
+  // Return the stats table record of the routable prefix in the forwarding hint of @p interest,
+  // or m_statsTable.end() if there is none
+  StatsTable::iterator
+  findRoutablePrefixRecord(const Interest& interest);
+
+  // Set the lifetime of @p interest to the retransmission timeout of its routable prefix
+  void
+  setInterestLifetime(Interest& interest);
 
   void
   sendInterest();
@@ -337,6 +732,15 @@ private:
   void
   nackCallBack(const Interest& i, const lp::Nack& n);
 
+  // The state of downloadMissingDataPackets: the position of the next packet to consider and the
+  // context of the callbacks of the download in the Interest queue
+  struct MissingPacketCursor
+  {
+    size_t                                                            manifestIndex;
+    size_t                                                            packetNum;
+    InterestQueue::ContextId                                          context;
+  };
+
   // A flag to determine if upon completion we should continue seeding
   bool                                                                m_seedFlag;
   // Face used for network communication
@@ -349,32 +753,99 @@ private:
   uint64_t                                                            m_retries;
   // Number of Interests sent since last sorting
   uint64_t                                                            m_sortingCounter;
-  // Keychain instance
-  shared_ptr<KeyChain>                                                m_keyChain;
+  // The signing service signing and validating the packets of the torrent
+  shared_ptr<SigningService>                                          m_signingService;
+  // A cache of the signed Data packets recently read from disk to answer Interests
+  DataPacketCache                                                     m_dataPacketCache;
+  // The signatures of the validated Data packets, used to rebuild packets without signing them
+  PacketSignatureStore                                                m_signatureStore;
+  // The packets on disk of the files of the torrent, used to restore the state on startup
+  ResumeJournal                                                       m_resumeJournal;
+  // The number of data packets written since the resume journal was last written
+  size_t                                                              m_unjournaledPackets;
+  // Whether the resume journal is being written on the I/O threads
+  bool                                                                m_isFlushingJournal;
+  // Whether the resume journal is to be written again once the current write completes
+  bool                                                                m_isJournalFlushPending;
+  // Whether to verify the data packets restored from the resume journal
+  bool                                                                m_verifyResume;
+  // Whether to hash the files missing from the resume journal in the background
+  bool                                                                m_lazyInitialize;
+  // The number of sub-manifests being hashed in the background by Initialize
+  size_t                                                              m_pendingFileHashes;
+  // The number of threads hashing the files in Initialize
+  size_t                                                              m_hashThreads;
+  // The callback reporting the progress of the hashing in Initialize (may be empty)
+  HashProgressCallback                                                m_onHashProgress;
+  // The prefixes registered to answer Interests
+  std::unordered_set<Name>                                            m_registeredPrefixes;
+  // The memory mappings of the files of the torrent, used to read the Data packets we serve
+  MappedFileRegistry                                                  m_mappedFiles;
+  // The open files of the torrent to which received Data packets are written
+  FileWriterPool                                                      m_fileWriters;
   // A collection for all interests that have been sent for which we have not received a response
   PendingInterestQueue                                                m_pendingInterests;
   // A queue to hold all interests for requested data that we have yet to send
   shared_ptr<InterestQueue>                                           m_interestQueue;
+  // The names of the Interests that timed out and are not answered or given up on yet, whose
+  // next round-trip time is ambiguous
+  std::unordered_set<Name>                                            m_timedOutInterests;
+  // The congestion controller deciding how many Interests may be pending
+  std::unique_ptr<CongestionController>                               m_congestionController;
+  // The priority of the data packets of the files that do not have the default one
+  std::unordered_map<std::string, InterestQueue::Priority>            m_filePriorities;
+  // The download of the missing packets in progress (null if there is none)
+  std::unique_ptr<MissingPacketCursor>                                m_missingPacketCursor;
+  // The number of peers known to have each Data packet of the torrent
+  PieceAvailability                                                   m_pieceAvailability;
+  // The time after which the bitmap of each sub-manifest may be requested again from each peer
+  std::map<std::pair<Name, Name>, time::steady_clock::TimePoint>      m_bitmapRequests;
   // TODO(spyros) Fix and reintegrate update handler
   // // Update Handler instance
   shared_ptr<UpdateHandler>                                           m_updateHandler;
+  // The number of disk operations running on the I/O threads whose completion is pending
+  size_t                                                              m_pendingIoOps;
+  // The worker threads running the disk I/O (null if the disk I/O is synchronous)
+  // Declared last, so that the queued disk operations complete before the rest is destroyed
+  std::unique_ptr<ThreadPool>                                         m_ioPool;
 };
 
 inline
-TorrentManager::TorrentManager(const ndn::Name&      torrentFileName,
-                               const std::string&    dataPath,
-                               bool                  seed,
-                               std::shared_ptr<Face> face)
+TorrentManager::TorrentManager(const ndn::Name&                torrentFileName,
+                               const std::string&              dataPath,
+                               bool                            seed,
+                               std::shared_ptr<Face>           face,
+                               std::shared_ptr<SigningService> signingService)
 : m_fileStates()
 , m_torrentSegments()
 , m_fileManifests()
+, m_torrentSegmentIndex()
+, m_torrentSegmentIds()
+, m_torrentSegmentPositions()
+, m_fileManifestIndex()
+, m_fileManifestIds()
+, m_fileManifestPositions()
+, m_indexListedSegments()
 , m_torrentFileName(torrentFileName)
 , m_dataPath(dataPath)
 , m_seedFlag(seed)
 , m_face(face)
 , m_retries(0)
 , m_sortingCounter(0)
-, m_keyChain(new KeyChain())
+, m_signingService(nullptr != signingService ? signingService
+                                            : SigningService::getDefault())
+, m_signatureStore(".appdata/" + torrentFileName.get(-3).toUri() + "/signatures/", dataPath)
+, m_resumeJournal(".appdata/" + torrentFileName.get(-3).toUri() + "/journal/")
+, m_unjournaledPackets(0)
+, m_isFlushingJournal(false)
+, m_isJournalFlushPending(false)
+, m_verifyResume(false)
+, m_lazyInitialize(false)
+, m_pendingFileHashes(0)
+, m_hashThreads(ThreadPool::defaultNumThreads())
+, m_onHashProgress()
+, m_congestionController(CongestionController::create(CongestionController::DEFAULT_ALGORITHM))
+, m_pendingIoOps(0)
 {
   m_interestQueue = make_shared<InterestQueue>();
 
@@ -396,6 +867,76 @@ TorrentManager::processEvents(const time::milliseconds& timeout)
   m_face->processEvents(timeout);
 }
 
+inline
+const DataPacketCache&
+TorrentManager::getDataPacketCache() const
+{
+  return m_dataPacketCache;
+}
+
+inline
+void
+TorrentManager::setDataPacketCacheCapacity(size_t capacity)
+{
+  m_dataPacketCache.setCapacity(capacity);
+}
+
+inline
+void
+TorrentManager::setResumeVerification(bool verify)
+{
+  m_verifyResume = verify;
+}
+
+inline
+void
+TorrentManager::setLazyInitialization(bool lazy)
+{
+  m_lazyInitialize = lazy;
+}
+
+inline
+void
+TorrentManager::setHashThreads(size_t numThreads)
+{
+  m_hashThreads = numThreads;
+}
+
+inline
+void
+TorrentManager::setHashProgressCallback(const HashProgressCallback& onProgress)
+{
+  m_onHashProgress = onProgress;
+}
+
+inline
+void
+TorrentManager::setCongestionController(std::unique_ptr<CongestionController> controller)
+{
+  m_congestionController = std::move(controller);
+}
+
+inline
+const CongestionController&
+TorrentManager::getCongestionController() const
+{
+  return *m_congestionController;
+}
+
+inline
+PieceAvailability&
+TorrentManager::getPieceAvailability()
+{
+  return m_pieceAvailability;
+}
+
+inline
+const PieceAvailability&
+TorrentManager::getPieceAvailability() const
+{
+  return m_pieceAvailability;
+}
+
 inline
 bool
 TorrentManager::hasAllTorrentSegments() const
@@ -414,7 +955,8 @@ inline
 bool
 TorrentManager::hasPendingInterests() const
 {
-  return !m_pendingInterests.empty() || !m_interestQueue->empty();
+  return !m_pendingInterests.empty() || !m_interestQueue->empty() ||
+         nullptr != m_missingPacketCursor;
 }
 
 }  // end ntorrent
@@ -20,6 +20,7 @@
 */
 
 #include "update-handler.hpp"
+#include "util/bitmap-codec.hpp"
 #include "util/logging.hpp"
 
 #include <boost/asio/io_service.hpp>
@@ -54,6 +55,85 @@ UpdateHandler::sendAliveInterest(StatsTable::iterator iter)
                           bind(&UpdateHandler::tryNextRoutablePrefix, this, _1));
 }
 
+void
+UpdateHandler::sendBitmapInterest(const Name& manifestName, const Name& peer,
+                                  OnBitmapReceived onReceived)
+{
+  Interest interest(getBitmapName(manifestName));
+  interest.setInterestLifetime(time::milliseconds(1000));
+  interest.setMustBeFresh(true);
+
+  // Create and set the forwarding hint
+  Delegation del;
+  del.preference = 1;
+  del.name = peer;
+  interest.setForwardingHint(DelegationList({del}));
+
+  LOG_DEBUG << "Sending BITMAP Interest: " << interest << std::endl;
+
+  auto bitmapReceived = [peer, manifestName, onReceived] (const Interest&, const Data& data) {
+    std::vector<bool> bitmap;
+    if (decodeBitmap(data, bitmap)) {
+      onReceived(peer, manifestName, bitmap);
+    }
+  };
+  // the peer does not have the sub-manifest or is unreachable, so we learn nothing
+  m_face->expressInterest(interest, bitmapReceived,
+                          [] (const Interest& interest, const lp::Nack&) {
+                            LOG_DEBUG << "BITMAP Interest NACKed: " << interest << std::endl;
+                          },
+                          [] (const Interest& interest) {
+                            LOG_DEBUG << "BITMAP Interest timed out: " << interest << std::endl;
+                          });
+}
+
+Name
+UpdateHandler::getBitmapName(const Name& manifestName) const
+{
+  return Name(getBitmapPrefix()).append(manifestName);
+}
+
+bool
+UpdateHandler::decodeBitmap(const Data& data, std::vector<bool>& bitmap)
+{
+  const Block& content = data.getContent();
+  try {
+    bitmap = BitmapCodec::decode(content.value(), content.value_size());
+  }
+  catch (const BitmapCodec::Error& e) {
+    LOG_ERROR << "Invalid BITMAP received: " << data.getName() << ": " << e.what() << std::endl;
+    return false;
+  }
+  return true;
+}
+
+Name
+UpdateHandler::getBitmapPrefix() const
+{
+  return Name(SharedConstants::commonPrefix).append("NTORRENT").append(m_torrentName)
+                                            .append("BITMAP");
+}
+
+void
+UpdateHandler::onBitmapInterestReceived(const InterestFilter& filter, const Interest& interest)
+{
+  LOG_DEBUG << "BITMAP Interest Received: " << interest.getName().toUri() << std::endl;
+  Name manifestName = interest.getName().getSubName(getBitmapPrefix().size());
+  std::vector<bool> bitmap;
+  if (!m_bitmapProvider || !m_bitmapProvider(manifestName, bitmap)) {
+    return;
+  }
+  auto encoded = BitmapCodec::encode(bitmap);
+
+  shared_ptr<Data> data = make_shared<Data>(interest.getName());
+  data->setContentType(tlv::ContentType_Blob);
+  // the bitmap changes as we download, so it should not be cached for long
+  data->setFreshnessPeriod(time::milliseconds(1000));
+  data->setContent(encoded.data(), encoded.size());
+  m_signingService->sign(*data, signingWithSha256());
+  m_face->put(*data);
+}
+
 shared_ptr<Data>
 UpdateHandler::createDataPacket(const Name& name)
 {
@@ -176,6 +256,10 @@ UpdateHandler::learnOwnRoutablePrefix(OnReceivedOwnRoutablePrefix onReceivedOwnR
                               bind(&UpdateHandler::onInterestReceived, this, _1, _2),
                               RegisterPrefixSuccessCallback(),
                               bind(&UpdateHandler::onRegisterFailed, this, _1, _2));
+    m_face->setInterestFilter(getBitmapPrefix(),
+                              bind(&UpdateHandler::onBitmapInterestReceived, this, _1, _2),
+                              RegisterPrefixSuccessCallback(),
+                              bind(&UpdateHandler::onRegisterFailed, this, _1, _2));
 
     onReceivedOwnRoutablePrefix();
   };
@@ -201,7 +285,7 @@ UpdateHandler::onInterestReceived(const InterestFilter& filter, const Interest&
 {
   LOG_INFO << "ALIVE Interest Received: " << interest.getName().toUri() << std::endl;
   shared_ptr<Data> data = this->createDataPacket(interest.getName());
-  m_keyChain->sign(*data, signingWithSha256());
+  m_signingService->sign(*data, signingWithSha256());
   m_face->put(*data);
 }
 
@@ -24,10 +24,13 @@
 
 #include "stats-table.hpp"
 #include "util/shared-constants.hpp"
+#include "util/signing-service.hpp"
 
 #include <ndn-cxx/face.hpp>
 #include <ndn-cxx/interest.hpp>
-#include <ndn-cxx/security/key-chain.hpp>
+
+#include <functional>
+#include <vector>
 
 namespace ndn {
 namespace ntorrent {
@@ -35,6 +38,13 @@ namespace ntorrent {
 class UpdateHandler {
 public:
   typedef std::function<void()> OnReceivedOwnRoutablePrefix;
+  // Fill the bitmap of the packets we have of the sub-manifest and return true, or return false
+  // if we do not know the sub-manifest
+  typedef std::function<bool(const Name& manifestName,
+                             std::vector<bool>& bitmap)> BitmapProvider;
+  typedef std::function<void(const Name& peer,
+                             const Name& manifestName,
+                             const std::vector<bool>& bitmap)> OnBitmapReceived;
 
   class Error : public tlv::Error
   {
@@ -46,7 +56,7 @@ public:
     }
   };
 
-  UpdateHandler(Name torrentName, shared_ptr<KeyChain> keyChain,
+  UpdateHandler(Name torrentName, shared_ptr<SigningService> signingService,
                 shared_ptr<StatsTable> statsTable, shared_ptr<Face> face,
                 OnReceivedOwnRoutablePrefix onReceivedOwnRoutablePrefix = {});
 
@@ -60,6 +70,39 @@ public:
   void
   sendAliveInterest(StatsTable::iterator iter);
 
+  /**
+   * @brief Set the callback providing the bitmaps advertised to the peers
+   *
+   * The peers request the bitmap of the packets of a sub-manifest we have with a BITMAP Interest:
+   * <commonPrefix>/NTORRENT/<torrent_name>/BITMAP/<sub-manifest name without implicit digest>
+   * and receive it encoded with the BitmapCodec. Without a provider, BITMAP Interests are not
+   * answered.
+   */
+  void
+  setBitmapProvider(BitmapProvider provider);
+
+  /**
+   * @brief Send a BITMAP Interest to learn which packets of a sub-manifest a peer has
+   * @param manifestName The name (without the implicit digest) of the sub-manifest
+   * @param peer The routable prefix of the peer, used as the forwarding hint of the Interest
+   * @param onReceived Callback called with the bitmap of the peer, if it answers
+   */
+  void
+  sendBitmapInterest(const Name& manifestName, const Name& peer, OnBitmapReceived onReceived);
+
+  /**
+   * @brief Return the name of the BITMAP Interest for the sub-manifest @p manifestName
+   */
+  Name
+  getBitmapName(const Name& manifestName) const;
+
+  /**
+   * @brief Decode the bitmap carried by the answer to a BITMAP Interest
+   * @return True if @p data carries a valid bitmap. Otherwise, false
+   */
+  static bool
+  decodeBitmap(const Data& data, std::vector<bool>& bitmap);
+
   /**
    * @brief Check whether we need to send out an "ALIVE" interest
    * @return True if an "ALIVE" interest should be sent out, otherwise false
@@ -92,6 +135,15 @@ private:
   void
   onRegisterFailed(const Name& prefix, const std::string& reason);
 
+  void
+  onBitmapInterestReceived(const InterestFilter& filter, const Interest& interest);
+
+  /**
+   * @brief Return the prefix of the BITMAP Interests of this torrent
+   */
+  Name
+  getBitmapPrefix() const;
+
   /**
    * @brief Encode the first MAX_NUM_OF_ENCODED_NAMES prefixes of the table into a data packet
    * @param name The name of the data packet
@@ -123,19 +175,20 @@ private:
 
 private:
   Name m_torrentName;
-  shared_ptr<KeyChain> m_keyChain;
+  shared_ptr<SigningService> m_signingService;
   shared_ptr<StatsTable> m_statsTable;
   shared_ptr<Face> m_face;
   Name m_ownRoutablePrefix;
   size_t m_ownRoutablPrefixRetries;
+  BitmapProvider m_bitmapProvider;
 };
 
 inline
-UpdateHandler::UpdateHandler(Name torrentName, shared_ptr<KeyChain> keyChain,
+UpdateHandler::UpdateHandler(Name torrentName, shared_ptr<SigningService> signingService,
                              shared_ptr<StatsTable> statsTable, shared_ptr<Face> face,
                              OnReceivedOwnRoutablePrefix onReceivedOwnRoutablePrefix)
 : m_torrentName(torrentName)
-, m_keyChain(keyChain)
+, m_signingService(signingService)
 , m_statsTable(statsTable)
 , m_face(face)
 , m_ownRoutablPrefixRetries(0)
@@ -154,6 +207,12 @@ UpdateHandler::getOwnRoutablePrefix()
   return m_ownRoutablePrefix;
 }
 
+inline void
+UpdateHandler::setBitmapProvider(BitmapProvider provider)
+{
+  m_bitmapProvider = provider;
+}
+
 } // namespace ntorrent
 } // namespace ndn
 
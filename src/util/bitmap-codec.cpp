@@ -0,0 +1,142 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+* Copyright (c) 2016 Regents of the University of California.
+*
+* This file is part of the nTorrent codebase.
+*
+* nTorrent is free software: you can redistribute it and/or modify it under the
+* terms of the GNU Lesser General Public License as published by the Free Software
+* Foundation, either version 3 of the License, or (at your option) any later version.
+*
+* nTorrent is distributed in the hope that it will be useful, but WITHOUT ANY
+* WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+* PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+*
+* You should have received copies of the GNU General Public License and GNU Lesser
+* General Public License along with nTorrent, e.g., in COPYING.md file. If not, see
+* <http://www.gnu.org/licenses/>.
+*
+* See AUTHORS for complete list of nTorrent authors and contributors.
+*/
+
+#include "util/bitmap-codec.hpp"
+
+#include <boost/throw_exception.hpp>
+
+namespace ndn {
+namespace ntorrent {
+
+static void
+appendVarNumber(std::vector<uint8_t>& buffer, uint64_t number)
+{
+  while (number >= 0x80) {
+    buffer.push_back(static_cast<uint8_t>(number | 0x80));
+    number >>= 7;
+  }
+  buffer.push_back(static_cast<uint8_t>(number));
+}
+
+static uint64_t
+readVarNumber(const uint8_t*& begin, const uint8_t* end)
+{
+  uint64_t number = 0;
+  for (int shift = 0; shift < 64; shift += 7) {
+    if (begin == end) {
+      BOOST_THROW_EXCEPTION(BitmapCodec::Error("Truncated bitmap"));
+    }
+    uint8_t byte = *begin++;
+    number |= static_cast<uint64_t>(byte & 0x7f) << shift;
+    if (0 == (byte & 0x80)) {
+      return number;
+    }
+  }
+  BOOST_THROW_EXCEPTION(BitmapCodec::Error("Malformed number in bitmap"));
+}
+
+std::vector<uint8_t>
+BitmapCodec::encode(const std::vector<bool>& bitmap)
+{
+  auto runLength = encode(bitmap, RUN_LENGTH);
+  auto packed = encode(bitmap, PACKED);
+  return runLength.size() < packed.size() ? runLength : packed;
+}
+
+std::vector<uint8_t>
+BitmapCodec::encode(const std::vector<bool>& bitmap, Format format)
+{
+  std::vector<uint8_t> buffer;
+  buffer.push_back(format);
+  appendVarNumber(buffer, bitmap.size());
+  if (PACKED == format) {
+    size_t offset = buffer.size();
+    buffer.resize(offset + (bitmap.size() + 7) / 8, 0);
+    for (size_t i = 0; i < bitmap.size(); ++i) {
+      if (bitmap[i]) {
+        buffer[offset + i / 8] |= static_cast<uint8_t>(1 << (i % 8));
+      }
+    }
+  }
+  else {
+    bool value = false;
+    size_t run = 0;
+    for (size_t i = 0; i < bitmap.size(); ++i) {
+      if (bitmap[i] != value) {
+        appendVarNumber(buffer, run);
+        value = !value;
+        run = 0;
+      }
+      ++run;
+    }
+    if (0 != run) {
+      appendVarNumber(buffer, run);
+    }
+  }
+  return buffer;
+}
+
+std::vector<bool>
+BitmapCodec::decode(const uint8_t* buffer, size_t size)
+{
+  const uint8_t* begin = buffer;
+  const uint8_t* end = buffer + size;
+  if (begin == end) {
+    BOOST_THROW_EXCEPTION(Error("Empty bitmap"));
+  }
+  uint8_t format = *begin++;
+  uint64_t numBits = readVarNumber(begin, end);
+  if (numBits > MAX_NUM_BITS) {
+    BOOST_THROW_EXCEPTION(Error("Bitmap too large"));
+  }
+
+  std::vector<bool> bitmap;
+  if (PACKED == format) {
+    if (static_cast<uint64_t>(end - begin) != (numBits + 7) / 8) {
+      BOOST_THROW_EXCEPTION(Error("Packed bitmap of the wrong size"));
+    }
+    bitmap.resize(numBits, false);
+    for (size_t i = 0; i < numBits; ++i) {
+      bitmap[i] = (begin[i / 8] >> (i % 8)) & 1;
+    }
+  }
+  else if (RUN_LENGTH == format) {
+    bool value = false;
+    while (begin != end) {
+      uint64_t run = readVarNumber(begin, end);
+      if (run > numBits - bitmap.size()) {
+        BOOST_THROW_EXCEPTION(Error("Run past the end of the bitmap"));
+      }
+      bitmap.insert(bitmap.end(), run, value);
+      value = !value;
+    }
+    if (bitmap.size() != numBits) {
+      BOOST_THROW_EXCEPTION(Error("Runs do not cover the bitmap"));
+    }
+  }
+  else {
+    BOOST_THROW_EXCEPTION(Error("Unknown bitmap format"));
+  }
+  return bitmap;
+}
+
+} // namespace ntorrent
+} // namespace ndn
@@ -0,0 +1,90 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+* Copyright (c) 2016 Regents of the University of California.
+*
+* This file is part of the nTorrent codebase.
+*
+* nTorrent is free software: you can redistribute it and/or modify it under the
+* terms of the GNU Lesser General Public License as published by the Free Software
+* Foundation, either version 3 of the License, or (at your option) any later version.
+*
+* nTorrent is distributed in the hope that it will be useful, but WITHOUT ANY
+* WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+* PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+*
+* You should have received copies of the GNU General Public License and GNU Lesser
+* General Public License along with nTorrent, e.g., in COPYING.md file. If not, see
+* <http://www.gnu.org/licenses/>.
+*
+* See AUTHORS for complete list of nTorrent authors and contributors.
+*/
+
+#ifndef INCLUDED_UTIL_BITMAP_CODEC_HPP
+#define INCLUDED_UTIL_BITMAP_CODEC_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace ndn {
+namespace ntorrent {
+
+/**
+ * @brief A compact wire format for the bitmaps of the packets of a sub-manifest that a peer has
+ *
+ * Bitmap ::= FORMAT-BYTE NUM-BITS-VARINT Payload
+ *
+ * The payload is either the bits packed eight to a byte (least significant bit first), or the
+ * lengths of the alternating runs of 0s and 1s as varints, starting with a (possibly empty) run of
+ * 0s. The encoder picks whichever is smaller, so that the nearly empty and nearly complete bitmaps
+ * peers exchange most of the time take a few bytes, and no bitmap takes more than one byte over
+ * its packed size. Varints are encoded 7 bits to a byte, least significant group first.
+ */
+class BitmapCodec {
+public:
+  class Error : public std::runtime_error
+  {
+  public:
+    explicit
+    Error(const std::string& what)
+      : std::runtime_error(what)
+    {
+    }
+  };
+
+  enum Format {
+    PACKED = 0,
+    RUN_LENGTH = 1
+  };
+
+  enum {
+    // Maximum number of bits of a decoded bitmap (the packets of a sub-manifest)
+    MAX_NUM_BITS = 1 << 24
+  };
+
+  /**
+   * @brief Encode @p bitmap in the smaller of the two formats
+   */
+  static std::vector<uint8_t>
+  encode(const std::vector<bool>& bitmap);
+
+  /**
+   * @brief Encode @p bitmap in the specified format
+   */
+  static std::vector<uint8_t>
+  encode(const std::vector<bool>& bitmap, Format format);
+
+  /**
+   * @brief Decode the bitmap encoded in the @p size bytes at @p buffer
+   * @throws Error if the buffer does not hold a well-formed bitmap of at most MAX_NUM_BITS bits
+   */
+  static std::vector<bool>
+  decode(const uint8_t* buffer, size_t size);
+};
+
+} // namespace ntorrent
+} // namespace ndn
+
+#endif // INCLUDED_UTIL_BITMAP_CODEC_HPP
@@ -0,0 +1,110 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+* Copyright (c) 2016 Regents of the University of California.
+*
+* This file is part of the nTorrent codebase.
+*
+* nTorrent is free software: you can redistribute it and/or modify it under the
+* terms of the GNU Lesser General Public License as published by the Free Software
+* Foundation, either version 3 of the License, or (at your option) any later version.
+*
+* nTorrent is distributed in the hope that it will be useful, but WITHOUT ANY
+* WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+* PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+*
+* You should have received copies of the GNU General Public License and GNU Lesser
+* General Public License along with nTorrent, e.g., in COPYING.md file. If not, see
+* <http://www.gnu.org/licenses/>.
+*
+* See AUTHORS for complete list of nTorrent authors and contributors.
+*/
+
+#include "util/digest-signer.hpp"
+
+#include "util/sha256-kernel.hpp"
+
+#include <ndn-cxx/encoding/block-helpers.hpp>
+#include <ndn-cxx/encoding/encoding-buffer.hpp>
+#include <ndn-cxx/security/digest-sha256.hpp>
+
+#include <deque>
+
+namespace ndn {
+namespace ntorrent {
+
+namespace {
+
+// Room for the TLV headers and the SignatureInfo of a packet
+const size_t HEADER_RESERVE = 64;
+// Room for the SignatureValue appended to the unsigned portion of a packet
+const size_t SIGNATURE_RESERVE = 64;
+
+// Return the size of a buffer large enough to encode @p data without growing it
+size_t
+encodedSize(const Data& data)
+{
+  return data.getName().wireEncode().size() + data.getMetaInfo().wireEncode().size()
+       + data.getContent().size() + HEADER_RESERVE + SIGNATURE_RESERVE;
+}
+
+Block
+makeSignatureValue(const Sha256Kernel::Digest& digest)
+{
+  return encoding::makeBinaryBlock(tlv::SignatureValue, digest.data(), digest.size());
+}
+
+Name
+makeFullName(const Data& data, const Sha256Kernel::Digest& digest)
+{
+  Name fullName = data.getName();
+  fullName.appendImplicitSha256Digest(digest.data(), digest.size());
+  return fullName;
+}
+
+} // namespace
+
+Name
+DigestSigner::sign(Data& data)
+{
+  data.setSignature(DigestSha256());
+  EncodingBuffer encoder(encodedSize(data), SIGNATURE_RESERVE);
+  data.wireEncode(encoder, true);
+  auto signature = Sha256Kernel::compute(encoder.buf(), encoder.size());
+  const auto& wire = data.wireEncode(encoder, makeSignatureValue(signature));
+  return makeFullName(data, Sha256Kernel::compute(wire.wire(), wire.size()));
+}
+
+std::vector<Name>
+DigestSigner::sign(const std::vector<Data*>& packets)
+{
+  size_t count = packets.size();
+  std::deque<EncodingBuffer> encoders;
+  std::vector<const uint8_t*> buffers(count);
+  std::vector<size_t> sizes(count);
+  // hash the unsigned portions of the packets
+  for (size_t i = 0; i < count; ++i) {
+    packets[i]->setSignature(DigestSha256());
+    encoders.emplace_back(encodedSize(*packets[i]), SIGNATURE_RESERVE);
+    packets[i]->wireEncode(encoders[i], true);
+    buffers[i] = encoders[i].buf();
+    sizes[i] = encoders[i].size();
+  }
+  std::vector<Sha256Kernel::Digest> digests(count);
+  Sha256Kernel::computeBatch(buffers.data(), sizes.data(), count, digests.data());
+  // then the signed packets, for their implicit digests
+  for (size_t i = 0; i < count; ++i) {
+    const auto& wire = packets[i]->wireEncode(encoders[i], makeSignatureValue(digests[i]));
+    buffers[i] = wire.wire();
+    sizes[i] = wire.size();
+  }
+  Sha256Kernel::computeBatch(buffers.data(), sizes.data(), count, digests.data());
+  std::vector<Name> fullNames;
+  fullNames.reserve(count);
+  for (size_t i = 0; i < count; ++i) {
+    fullNames.push_back(makeFullName(*packets[i], digests[i]));
+  }
+  return fullNames;
+}
+
+} // namespace ntorrent
+} // namespace ndn
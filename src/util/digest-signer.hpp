@@ -0,0 +1,63 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+* Copyright (c) 2016 Regents of the University of California.
+*
+* This file is part of the nTorrent codebase.
+*
+* nTorrent is free software: you can redistribute it and/or modify it under the
+* terms of the GNU Lesser General Public License as published by the Free Software
+* Foundation, either version 3 of the License, or (at your option) any later version.
+*
+* nTorrent is distributed in the hope that it will be useful, but WITHOUT ANY
+* WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+* PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+*
+* You should have received copies of the GNU General Public License and GNU Lesser
+* General Public License along with nTorrent, e.g., in COPYING.md file. If not, see
+* <http://www.gnu.org/licenses/>.
+*
+* See AUTHORS for complete list of nTorrent authors and contributors.
+*/
+
+#ifndef INCLUDED_UTIL_DIGEST_SIGNER_HPP
+#define INCLUDED_UTIL_DIGEST_SIGNER_HPP
+
+#include <ndn-cxx/data.hpp>
+#include <ndn-cxx/name.hpp>
+
+#include <vector>
+
+namespace ndn {
+namespace ntorrent {
+
+/**
+ * @brief Sign Data packets with a SHA-256 digest, computing their full names on the way
+ *
+ * A packet signed by this class is identical to one signed by KeyChain::sign with
+ * signingWithSha256(), but neither a KeyChain nor ndn::util::Sha256 is involved: both the
+ * signature and the implicit digest of the packet are computed by the Sha256Kernel, and the full
+ * name is returned instead of being computed again by Data::getFullName().
+ */
+class DigestSigner {
+public:
+  /**
+   * @brief Sign @p data with a SHA-256 digest and return its full name
+   */
+  static Name
+  sign(Data& data);
+
+  /**
+   * @brief Sign each of the @p packets with a SHA-256 digest and return their full names, in the
+   *        same order
+   *
+   * The packets are hashed together, which is faster than signing them one at a time when the
+   * Sha256Kernel hashes several buffers at a time.
+   */
+  static std::vector<Name>
+  sign(const std::vector<Data*>& packets);
+};
+
+} // namespace ntorrent
+} // namespace ndn
+
+#endif // INCLUDED_UTIL_DIGEST_SIGNER_HPP
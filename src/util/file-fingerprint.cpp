@@ -0,0 +1,48 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+* Copyright (c) 2016 Regents of the University of California.
+*
+* This file is part of the nTorrent codebase.
+*
+* nTorrent is free software: you can redistribute it and/or modify it under the
+* terms of the GNU Lesser General Public License as published by the Free Software
+* Foundation, either version 3 of the License, or (at your option) any later version.
+*
+* nTorrent is distributed in the hope that it will be useful, but WITHOUT ANY
+* WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+* PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+*
+* You should have received copies of the GNU General Public License and GNU Lesser
+* General Public License along with nTorrent, e.g., in COPYING.md file. If not, see
+* <http://www.gnu.org/licenses/>.
+*
+* See AUTHORS for complete list of nTorrent authors and contributors.
+*/
+
+#include "util/file-fingerprint.hpp"
+
+#include <sys/stat.h>
+
+namespace ndn {
+namespace ntorrent {
+
+bool
+FileFingerprint::read(const std::string& filePath)
+{
+  struct stat st;
+  if (0 != ::stat(filePath.c_str(), &st)) {
+    return false;
+  }
+#ifdef __APPLE__
+  const auto& mtime = st.st_mtimespec;
+#else
+  const auto& mtime = st.st_mtim;
+#endif
+  size = st.st_size;
+  modificationTime = uint64_t(mtime.tv_sec) * 1000000000 + mtime.tv_nsec;
+  inode = st.st_ino;
+  return true;
+}
+
+} // namespace ntorrent
+} // namespace ndn
@@ -0,0 +1,70 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+* Copyright (c) 2016 Regents of the University of California.
+*
+* This file is part of the nTorrent codebase.
+*
+* nTorrent is free software: you can redistribute it and/or modify it under the
+* terms of the GNU Lesser General Public License as published by the Free Software
+* Foundation, either version 3 of the License, or (at your option) any later version.
+*
+* nTorrent is distributed in the hope that it will be useful, but WITHOUT ANY
+* WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+* PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+*
+* You should have received copies of the GNU General Public License and GNU Lesser
+* General Public License along with nTorrent, e.g., in COPYING.md file. If not, see
+* <http://www.gnu.org/licenses/>.
+*
+* See AUTHORS for complete list of nTorrent authors and contributors.
+*/
+
+#ifndef INCLUDED_UTIL_FILE_FINGERPRINT_HPP
+#define INCLUDED_UTIL_FILE_FINGERPRINT_HPP
+
+#include <cstdint>
+#include <string>
+
+namespace ndn {
+namespace ntorrent {
+
+/**
+ * @brief The size, the modification time and the inode number of a file
+ *
+ * The metadata saved next to the data of a file, e.g., the resume journal or the signatures of its
+ * packets, is only trusted while the file keeps the fingerprint recorded with it. The modification
+ * time is kept in nanoseconds, as a file rewritten in place within a second keeps the same
+ * modification time in seconds.
+ */
+struct FileFingerprint {
+  /**
+   * @brief Read the fingerprint of the file at @p filePath
+   * @return True if the file exists. Otherwise, false
+   */
+  bool
+  read(const std::string& filePath);
+
+  uint64_t size;
+  // in nanoseconds since the epoch
+  uint64_t modificationTime;
+  uint64_t inode;
+};
+
+inline bool
+operator==(const FileFingerprint& lhs, const FileFingerprint& rhs)
+{
+  return lhs.size             == rhs.size             &&
+         lhs.modificationTime == rhs.modificationTime &&
+         lhs.inode            == rhs.inode;
+}
+
+inline bool
+operator!=(const FileFingerprint& lhs, const FileFingerprint& rhs)
+{
+  return !(lhs == rhs);
+}
+
+} // namespace ntorrent
+} // namespace ndn
+
+#endif // INCLUDED_UTIL_FILE_FINGERPRINT_HPP
@@ -0,0 +1,168 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+* Copyright (c) 2016 Regents of the University of California.
+*
+* This file is part of the nTorrent codebase.
+*
+* nTorrent is free software: you can redistribute it and/or modify it under the
+* terms of the GNU Lesser General Public License as published by the Free Software
+* Foundation, either version 3 of the License, or (at your option) any later version.
+*
+* nTorrent is distributed in the hope that it will be useful, but WITHOUT ANY
+* WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+* PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+*
+* You should have received copies of the GNU General Public License and GNU Lesser
+* General Public License along with nTorrent, e.g., in COPYING.md file. If not, see
+* <http://www.gnu.org/licenses/>.
+*
+* See AUTHORS for complete list of nTorrent authors and contributors.
+*/
+
+#include "util/file-writer-pool.hpp"
+
+#include <cerrno>
+#include <iterator>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace ndn {
+namespace ntorrent {
+
+FileWriterPool::FileWriterPool(size_t             maxOpenFiles,
+                               size_t             syncBytes,
+                               time::milliseconds syncInterval)
+  : m_maxOpenFiles(0 < maxOpenFiles ? maxOpenFiles : 1)
+  , m_syncBytes(syncBytes)
+  , m_syncInterval(syncInterval)
+  , m_unsyncedBytes(0)
+  , m_lastSync(time::steady_clock::now())
+{
+}
+
+FileWriterPool::~FileWriterPool()
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  while (!m_files.empty()) {
+    close(m_files.begin());
+  }
+}
+
+bool
+FileWriterPool::write(const std::string& path, uint64_t offset, const uint8_t* data, size_t size)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto it = open(path);
+  if (m_files.end() == it) {
+    return false;
+  }
+  // positional writes may be partial, write until all the bytes are written
+  size_t written = 0;
+  while (written < size) {
+    auto rval = ::pwrite(it->fd, data + written, size - written, offset + written);
+    if (rval < 0) {
+      if (EINTR == errno) {
+        continue;
+      }
+      return false;
+    }
+    written += rval;
+  }
+  it->unsyncedBytes += size;
+  m_unsyncedBytes += size;
+  if (m_unsyncedBytes >= m_syncBytes ||
+      time::steady_clock::now() - m_lastSync >= m_syncInterval) {
+    syncAll();
+  }
+  return true;
+}
+
+bool
+FileWriterPool::sync()
+{
+  std::vector<std::string> failedPaths;
+  return sync(failedPaths);
+}
+
+bool
+FileWriterPool::sync(std::vector<std::string>& failedPaths)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  syncAll();
+  if (m_failedPaths.empty()) {
+    return true;
+  }
+  failedPaths.insert(failedPaths.end(), m_failedPaths.begin(), m_failedPaths.end());
+  m_failedPaths.clear();
+  return false;
+}
+
+bool
+FileWriterPool::close(const std::string& path)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto index_it = m_index.find(path);
+  if (m_index.end() == index_it) {
+    return true;
+  }
+  return close(index_it->second);
+}
+
+FileWriterPool::FileList::iterator
+FileWriterPool::open(const std::string& path)
+{
+  auto index_it = m_index.find(path);
+  if (m_index.end() != index_it) {
+    // mark the file as the most recently used one
+    m_files.splice(m_files.begin(), m_files, index_it->second);
+    return index_it->second;
+  }
+  int fd = ::open(path.c_str(), O_WRONLY | O_CREAT, 0644);
+  if (fd < 0) {
+    return m_files.end();
+  }
+  while (m_files.size() >= m_maxOpenFiles) {
+    auto last = std::prev(m_files.end());
+    auto lastPath = last->path;
+    if (!close(last)) {
+      m_failedPaths.insert(lastPath);
+    }
+  }
+  m_files.push_front(File{path, fd, 0});
+  m_index[path] = m_files.begin();
+  return m_files.begin();
+}
+
+bool
+FileWriterPool::close(FileList::iterator it)
+{
+  bool rval = 0 == it->unsyncedBytes || 0 == ::fsync(it->fd);
+  rval = (0 == ::close(it->fd)) && rval;
+  m_unsyncedBytes -= it->unsyncedBytes;
+  m_index.erase(it->path);
+  m_files.erase(it);
+  return rval;
+}
+
+void
+FileWriterPool::syncAll()
+{
+  for (auto& f : m_files) {
+    if (0 == f.unsyncedBytes) {
+      continue;
+    }
+    if (0 != ::fsync(f.fd)) {
+      // the writes are kept unsynced, so that the file is synced again
+      m_failedPaths.insert(f.path);
+      continue;
+    }
+    m_unsyncedBytes -= f.unsyncedBytes;
+    f.unsyncedBytes = 0;
+  }
+  m_lastSync = time::steady_clock::now();
+}
+
+} // namespace ntorrent
+} // namespace ndn
@@ -0,0 +1,174 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+* Copyright (c) 2016 Regents of the University of California.
+*
+* This file is part of the nTorrent codebase.
+*
+* nTorrent is free software: you can redistribute it and/or modify it under the
+* terms of the GNU Lesser General Public License as published by the Free Software
+* Foundation, either version 3 of the License, or (at your option) any later version.
+*
+* nTorrent is distributed in the hope that it will be useful, but WITHOUT ANY
+* WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+* PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+*
+* You should have received copies of the GNU General Public License and GNU Lesser
+* General Public License along with nTorrent, e.g., in COPYING.md file. If not, see
+* <http://www.gnu.org/licenses/>.
+*
+* See AUTHORS for complete list of nTorrent authors and contributors.
+*/
+
+#ifndef INCLUDED_UTIL_FILE_WRITER_POOL_HPP
+#define INCLUDED_UTIL_FILE_WRITER_POOL_HPP
+
+#include <ndn-cxx/util/time.hpp>
+
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace ndn {
+namespace ntorrent {
+
+/**
+ * @brief A thread-safe pool of open file descriptors used to write data at arbitrary offsets
+ *
+ * At most 'maxOpenFiles' descriptors are kept open, closing the least recently written file when
+ * another one is needed. Writes are positional, so they need no seeking and may arrive in any
+ * order. Written data is not flushed to the disk on every write. Instead, all the files with
+ * unsynced writes are synced once 'syncBytes' bytes have been written since the last sync, once
+ * 'syncInterval' has elapsed since the last sync, when a file is closed and on 'sync'.
+ *
+ * A file that fails to sync keeps its unsynced writes, and the failure is reported by the next
+ * call to 'sync', even if the file was closed in between to make room for another one.
+ */
+class FileWriterPool {
+public:
+  enum {
+    DEFAULT_MAX_OPEN_FILES = 64,
+    DEFAULT_SYNC_BYTES     = 64 * 1024 * 1024
+  };
+
+  /**
+   * @brief Create a new pool with no open files
+   * @param maxOpenFiles The maximum number of descriptors kept open
+   * @param syncBytes The number of bytes written after which the files are synced
+   * @param syncInterval The time after which the files with unsynced writes are synced
+   */
+  explicit
+  FileWriterPool(size_t             maxOpenFiles = DEFAULT_MAX_OPEN_FILES,
+                 size_t             syncBytes    = DEFAULT_SYNC_BYTES,
+                 time::milliseconds syncInterval = time::seconds(5));
+
+  /**
+   * @brief Sync and close all the open files
+   */
+  ~FileWriterPool();
+
+  FileWriterPool(const FileWriterPool&) = delete;
+
+  FileWriterPool&
+  operator=(const FileWriterPool&) = delete;
+
+  /**
+   * @brief Write @p size bytes starting at @p data at the offset @p offset of the file at @p path
+   * Create the file if it does not exist. Return true if all the bytes were written, otherwise
+   * false. The files synced because of this write that fail to sync are reported by 'sync'.
+   */
+  bool
+  write(const std::string& path, uint64_t offset, const uint8_t* data, size_t size);
+
+  /**
+   * @brief Sync all the files with unsynced writes to the disk
+   * @return True if all the files were synced successfully since the last call, otherwise false
+   */
+  bool
+  sync();
+
+  /**
+   * @brief Sync all the files with unsynced writes to the disk
+   * @param failedPaths The paths of the files that failed to sync since the last call
+   *                    (used as an output vector of paths)
+   * @return True if all the files were synced successfully since the last call, otherwise false
+   */
+  bool
+  sync(std::vector<std::string>& failedPaths);
+
+  /**
+   * @brief Sync and close the file at @p path, if it is open
+   * @return False if the file was open and could not be synced, otherwise true
+   */
+  bool
+  close(const std::string& path);
+
+  /**
+   * @brief Return the number of open files
+   */
+  size_t
+  size() const;
+
+  /**
+   * @brief Return the number of bytes written since the last sync
+   */
+  size_t
+  unsyncedBytes() const;
+
+private:
+  struct File {
+    std::string path;
+    int         fd;
+    // the number of bytes written to the file since it was last synced
+    size_t      unsyncedBytes;
+  };
+
+  typedef std::list<File> FileList;
+
+  // Return the open file at @p path, opening it (and closing another file) if needed
+  // Return m_files.end() if the file cannot be opened.
+  FileList::iterator
+  open(const std::string& path);
+
+  bool
+  close(FileList::iterator it);
+
+  // Sync all the files with unsynced writes, recording the ones that fail in m_failedPaths
+  void
+  syncAll();
+
+private:
+  // The open files, most recently written first
+  FileList                                                m_files;
+  std::unordered_map<std::string, FileList::iterator>     m_index;
+  size_t                                                  m_maxOpenFiles;
+  size_t                                                  m_syncBytes;
+  time::milliseconds                                      m_syncInterval;
+  size_t                                                  m_unsyncedBytes;
+  time::steady_clock::TimePoint                           m_lastSync;
+  // The files that failed to sync and are not reported by 'sync' yet
+  std::unordered_set<std::string>                         m_failedPaths;
+  mutable std::mutex                                      m_mutex;
+};
+
+inline size_t
+FileWriterPool::size() const
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_files.size();
+}
+
+inline size_t
+FileWriterPool::unsyncedBytes() const
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_unsyncedBytes;
+}
+
+} // namespace ntorrent
+} // namespace ndn
+
+#endif // INCLUDED_UTIL_FILE_WRITER_POOL_HPP
@@ -23,13 +23,20 @@
 
 #include "file-manifest.hpp"
 #include "torrent-file.hpp"
+#include "util/file-writer-pool.hpp"
 #include "util/logging.hpp"
+#include "util/mapped-file.hpp"
 
 #include <boost/filesystem.hpp>
 #include <boost/filesystem/fstream.hpp>
 
-#include <ndn-cxx/security/key-chain.hpp>
-#include <ndn-cxx/security/signing-helpers.hpp>
+#include <ndn-cxx/security/digest-sha256.hpp>
+
+#include <algorithm>
+#include <cerrno>
+
+#include <fcntl.h>
+#include <unistd.h>
 
 namespace fs = boost::filesystem;
 
@@ -39,77 +46,136 @@ using std::vector;
 namespace ndn {
 namespace ntorrent {
 
-std::vector<ndn::Data>
+// the approximate number of bytes read from disk at a time when packetizing a file
+static const size_t PACKETIZE_BUFFER_SIZE = 1024 * 1024;
+
+namespace {
+
+// A file descriptor closed when it goes out of scope
+struct ScopedFd
+{
+  explicit
+  ScopedFd(int fd)
+    : fd(fd)
+  {
+  }
+
+  ~ScopedFd()
+  {
+    if (0 <= fd) {
+      ::close(fd);
+    }
+  }
+
+  int fd;
+};
+
+// Sync the entries of the directory at @p path to the disk
+bool
+syncDirectory(const fs::path& path)
+{
+  int fd = ::open(path.c_str(), O_RDONLY | O_DIRECTORY);
+  if (fd < 0) {
+    return false;
+  }
+  bool rval = 0 == ::fsync(fd);
+  return 0 == ::close(fd) && rval;
+}
+
+// Advise the kernel that the @p size bytes at @p offset of @p fd are about to be read
+void
+adviseWillRead(int fd, size_t offset, size_t size)
+{
+#ifdef POSIX_FADV_WILLNEED
+  ::posix_fadvise(fd, offset, size, POSIX_FADV_WILLNEED);
+#endif // POSIX_FADV_WILLNEED
+}
+
+} // namespace
+
+size_t
 IoUtil::packetize_file(const fs::path& filePath,
                        const ndn::Name& commonPrefix,
                        size_t dataPacketSize,
                        size_t subManifestSize,
-                       size_t subManifestNum)
+                       size_t subManifestNum,
+                       const PacketSink& sink,
+                       SigningService& signer)
 {
   BOOST_ASSERT(0 < dataPacketSize);
-  size_t APPROX_BUFFER_SIZE = std::numeric_limits<int>::max(); // 2 * 1024 * 1024 *1024
-  auto file_size = fs::file_size(filePath);
-  auto start_offset = subManifestNum * subManifestSize * dataPacketSize;
+  size_t file_size = fs::file_size(filePath);
+  size_t start_offset = subManifestNum * subManifestSize * dataPacketSize;
+  if (file_size <= start_offset) {
+    return 0;
+  }
   // determine the number of bytes in this submanifest
-  auto subManifestLength = subManifestSize * dataPacketSize;
-  auto remainingFileLength = file_size - start_offset;
-  subManifestLength = remainingFileLength < subManifestLength
-                    ? remainingFileLength
-                    : subManifestLength;
-  vector<ndn::Data> packets;
-  packets.reserve(subManifestLength/dataPacketSize + 1);
-  fs::ifstream fs(filePath, fs::ifstream::binary);
-  if (!fs) {
+  size_t subManifestLength = std::min(subManifestSize * dataPacketSize, file_size - start_offset);
+  ScopedFd file(::open(filePath.string().c_str(), O_RDONLY));
+  if (file.fd < 0) {
     BOOST_THROW_EXCEPTION(Data::Error("IO Error when opening" + filePath.string()));
   }
-  // ensure that buffer is large enough to contain whole packets
-  // buffer size is either the entire file or the smallest number of data packets >= 2 GB
-  auto buffer_size =
-    subManifestLength < APPROX_BUFFER_SIZE   ?
-    subManifestLength                        :
-    APPROX_BUFFER_SIZE % dataPacketSize == 0 ?
-    APPROX_BUFFER_SIZE :
-    APPROX_BUFFER_SIZE + dataPacketSize - (APPROX_BUFFER_SIZE % dataPacketSize);
-  vector<char> file_bytes;
-  file_bytes.reserve(buffer_size);
+  // the buffer always holds a whole number of packets
+  size_t packetsPerRead = std::max<size_t>(1, PACKETIZE_BUFFER_SIZE / dataPacketSize);
+  vector<char> file_bytes(packetsPerRead * dataPacketSize);
+  vector<Data> packets;
+  packets.reserve(packetsPerRead);
+  vector<Data*> unsignedPackets;
+  unsignedPackets.reserve(packetsPerRead);
   size_t bytes_read = 0;
-  fs.seekg(start_offset);
-  while(fs && bytes_read < subManifestLength && !fs.eof()) {
-    // read the file into the buffer
-    fs.read(&file_bytes.front(), buffer_size);
-    auto read_size = fs.gcount();
-    if (fs.bad() || read_size < 0) {
+  size_t packetNum = 0;
+  adviseWillRead(file.fd, start_offset, std::min(file_bytes.size(), subManifestLength));
+  while (bytes_read < subManifestLength) {
+    size_t request_size = std::min(file_bytes.size(), subManifestLength - bytes_read);
+    auto read_size = ::pread(file.fd, &file_bytes.front(), request_size, start_offset + bytes_read);
+    if (read_size < 0) {
+      if (EINTR == errno) {
+        continue;
+      }
       BOOST_THROW_EXCEPTION(Data::Error("IO Error when reading" + filePath.string()));
     }
     bytes_read += read_size;
-    char *curr_start = &file_bytes.front();
-    for (size_t i = 0u; i < buffer_size; i += dataPacketSize) {
+    // read the next buffer ahead while this one is packetized
+    if (bytes_read < subManifestLength) {
+      adviseWillRead(file.fd, start_offset + bytes_read,
+                     std::min(file_bytes.size(), subManifestLength - bytes_read));
+    }
+    packets.clear();
+    unsignedPackets.clear();
+    for (size_t i = 0u; i < static_cast<size_t>(read_size); i += dataPacketSize) {
       // Build a packet from the data
       Name packetName = commonPrefix;
-      packetName.appendSequenceNumber(packets.size());
-      Data d(packetName);
-      auto content_length = i + dataPacketSize > buffer_size ? buffer_size - i : dataPacketSize;
-      d.setContent(encoding::makeBinaryBlock(tlv::Content, curr_start, content_length));
-      curr_start += content_length;
-      // append to the collection
-      packets.push_back(d);
+      packetName.appendSequenceNumber(packetNum++);
+      packets.emplace_back(packetName);
+      auto content_length = std::min<size_t>(dataPacketSize, read_size - i);
+      packets.back().setContent(encoding::makeBinaryBlock(tlv::Content, &file_bytes[i],
+                                                          content_length));
+      unsignedPackets.push_back(&packets.back());
+    }
+    // sign the packets of the buffer together
+    auto fullNames = signer.sign(unsignedPackets);
+    for (size_t i = 0; i < packets.size(); ++i) {
+      sink(packets[i], fullNames[i]);
+    }
+    // the file was truncated while reading it
+    if (static_cast<size_t>(read_size) < request_size) {
+      break;
     }
-    file_bytes.clear();
-    // recompute the buffer_size
-    buffer_size =
-      subManifestLength - bytes_read < APPROX_BUFFER_SIZE ?
-      subManifestLength - bytes_read                      :
-      APPROX_BUFFER_SIZE % dataPacketSize == 0            ?
-      APPROX_BUFFER_SIZE                                  :
-      APPROX_BUFFER_SIZE + dataPacketSize - (APPROX_BUFFER_SIZE % dataPacketSize);
-  }
-  fs.close();
-  packets.shrink_to_fit();
-  ndn::security::KeyChain key_chain;
-  // sign all the packets
-  for (auto& p : packets) {
-    key_chain.sign(p, signingWithSha256());
   }
+  return packetNum;
+}
+
+std::vector<ndn::Data>
+IoUtil::packetize_file(const fs::path& filePath,
+                       const ndn::Name& commonPrefix,
+                       size_t dataPacketSize,
+                       size_t subManifestSize,
+                       size_t subManifestNum,
+                       SigningService& signer)
+{
+  vector<ndn::Data> packets;
+  packetize_file(filePath, commonPrefix, dataPacketSize, subManifestSize, subManifestNum,
+                 [&packets] (const Data& d, const Name&) { packets.push_back(d); }, signer);
+  packets.shrink_to_fit();
   return packets;
 }
 
@@ -159,31 +225,100 @@ IoUtil::writeData(const Data&         packet,
                   size_t              subManifestSize,
                   const std::string&  filePath)
 {
-  fs::ofstream os (filePath, fs::ofstream::binary | fs::ofstream::out | fs::ofstream::app);
+  FileWriterPool writers(1);
+  return writeData(packet, manifest, subManifestSize, filePath, writers);
+}
+
+bool
+IoUtil::writeData(const Data&         packet,
+                  const FileManifest& manifest,
+                  size_t              subManifestSize,
+                  const std::string&  filePath,
+                  FileWriterPool&     writers)
+{
   auto packetName = packet.getName();
   auto packetNum = packetName.get(packetName.size() - 1).toSequenceNumber();
   auto dataPacketSize = manifest.data_packet_size();
   auto initial_offset = manifest.submanifest_number() * subManifestSize * dataPacketSize;
   auto packetOffset =  initial_offset + packetNum * dataPacketSize;
   // write data to disk
-  os.seekp(packetOffset);
-  try {
-    auto content = packet.getContent();
-    std::vector<char> data(content.value_begin(), content.value_end());
-    return os.write(&data[0], data.size()).good() && os.flush().good();
-  }
-  catch (io::Error &e) {
-    LOG_ERROR << e.what() << std::endl;
+  const auto& content = packet.getContent();
+  if (!writers.write(filePath, packetOffset, content.value(), content.value_size())) {
+    LOG_ERROR << "Write failed: " << filePath << std::endl;
     return false;
   }
+  return true;
 }
 
-std::shared_ptr<Data>
-IoUtil::readDataPacket(const Name&         packetFullName,
+bool
+IoUtil::writeFile(const fs::path& path, const std::vector<uint8_t>& buffer, bool append)
+{
+  int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | (append ? O_APPEND : O_TRUNC), 0644);
+  if (fd < 0) {
+    return false;
+  }
+  size_t written = 0;
+  while (written < buffer.size()) {
+    auto n = ::write(fd, buffer.data() + written, buffer.size() - written);
+    if (n < 0 && EINTR != errno) {
+      break;
+    }
+    written += std::max<ssize_t>(n, 0);
+  }
+  bool rval = written == buffer.size() && 0 == ::fsync(fd);
+  return 0 == ::close(fd) && rval;
+}
+
+bool
+IoUtil::replaceFile(const fs::path& path, const std::vector<uint8_t>& buffer)
+{
+  auto directory = path.parent_path();
+  boost::system::error_code ec;
+  if (!fs::exists(directory)) {
+    fs::create_directories(directory, ec);
+  }
+  // the new file and its entry must be on the disk before it replaces the old one, then the rename
+  // itself is synced
+  fs::path tmpPath(path.string() + ".tmp");
+  if (ec || !writeFile(tmpPath, buffer, false) || !syncDirectory(directory)) {
+    return false;
+  }
+  fs::rename(tmpPath, path, ec);
+  return !ec && syncDirectory(directory);
+}
+
+static std::shared_ptr<Data>
+readUnsignedDataPacket(const Name&         packetFullName,
                        const FileManifest& manifest,
                        size_t              subManifestSize,
-                       const std::string&  filePath)
+                       const std::string&  filePath,
+                       MappedFileRegistry* mappedFiles)
 {
+  auto packetName = packetFullName.getSubName(0, packetFullName.size() - 1);
+  if (nullptr != mappedFiles) {
+    // build the content straight from the mapping of the file
+    size_t dataPacketSize = manifest.data_packet_size();
+    size_t packetNum = packetFullName.get(packetFullName.size() - 2).toSequenceNumber();
+    size_t offset = (manifest.submanifest_number() * subManifestSize + packetNum)
+                  * dataPacketSize;
+    auto file = mappedFiles->get(filePath, offset + dataPacketSize);
+    if (nullptr == file) {
+      LOG_ERROR << "Bad read" << std::endl;
+      return nullptr;
+    }
+    // bound a read reaching the end of the mapping by the file on disk, so that a file truncated
+    // since it was mapped is not read past its end
+    size_t fileSize = offset + dataPacketSize < file->size() ? file->size() : file->currentSize();
+    if (fileSize <= offset) {
+      LOG_ERROR << "Bad read" << std::endl;
+      return nullptr;
+    }
+    auto d = make_shared<Data>(packetName);
+    d->setContent(encoding::makeBinaryBlock(tlv::Content,
+                                            file->data() + offset,
+                                            std::min(dataPacketSize, fileSize - offset)));
+    return d;
+  }
   fs::fstream is (filePath, fs::fstream::in | fs::fstream::binary);
   auto dataPacketSize = manifest.data_packet_size();
   auto start_offset = manifest.submanifest_number() * subManifestSize * dataPacketSize;
@@ -203,12 +338,45 @@ IoUtil::readDataPacket(const Name&         packetFullName,
   return nullptr;
  }
  // construct packet
- auto packetName = packetFullName.getSubName(0, packetFullName.size() - 1);
  auto d = make_shared<Data>(packetName);
  d->setContent(encoding::makeBinaryBlock(tlv::Content, &bytes.front(), read_size));
- ndn::security::KeyChain key_chain;
- key_chain.sign(*d, signingWithSha256());
- return d->getFullName() == packetFullName ? d : nullptr;
+ return d;
+}
+
+std::shared_ptr<Data>
+IoUtil::readDataPacket(const Name&         packetFullName,
+                       const FileManifest& manifest,
+                       size_t              subManifestSize,
+                       const std::string&  filePath,
+                       MappedFileRegistry* mappedFiles,
+                       SigningService&     signer)
+{
+  auto d = readUnsignedDataPacket(packetFullName, manifest, subManifestSize, filePath,
+                                  mappedFiles);
+  if (nullptr == d) {
+    return nullptr;
+  }
+  return signer.sign(*d) == packetFullName ? d : nullptr;
+}
+
+std::shared_ptr<Data>
+IoUtil::readDataPacket(const Name&         packetFullName,
+                       const FileManifest& manifest,
+                       size_t              subManifestSize,
+                       const std::string&  filePath,
+                       const Block&        signatureValue,
+                       MappedFileRegistry* mappedFiles)
+{
+  auto d = readUnsignedDataPacket(packetFullName, manifest, subManifestSize, filePath,
+                                  mappedFiles);
+  if (nullptr == d) {
+    return nullptr;
+  }
+  DigestSha256 signature;
+  signature.setValue(signatureValue);
+  d->setSignature(signature);
+  d->wireEncode();
+  return d;
 }
 
 IoUtil::NAME_TYPE
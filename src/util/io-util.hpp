@@ -22,12 +22,15 @@
 #ifndef INCLUDED_UTIL_IO_UTIL_H
 #define INCLUDED_UTIL_IO_UTIL_H
 
+#include "util/signing-service.hpp"
+
 #include <boost/filesystem.hpp>
 
 #include <ndn-cxx/data.hpp>
 #include <ndn-cxx/name.hpp>
 #include <ndn-cxx/util/io.hpp>
 
+#include <functional>
 #include <set>
 #include <string>
 #include <vector>
@@ -40,6 +43,8 @@ namespace Io = boost::filesystem;
 
 class TorrentFile;
 class FileManifest;
+class FileWriterPool;
+class MappedFileRegistry;
 
 class IoUtil {
  public:
@@ -66,12 +71,45 @@ class IoUtil {
   static bool create_directories(const boost::filesystem::path& dirPath);
 
 
+  /*
+   * A callback receiving each signed Data packet produced by 'packetize_file', along with its
+   * full name
+   */
+  typedef std::function<void(const ndn::Data&, const ndn::Name&)> PacketSink;
+
+  /*
+   * @brief Packetize the @p subManifestNum sub-manifest of the file at @p filePath
+   * @param filePath The path to the file on disk
+   * @param commonPrefix The name prefix of the Data packets (name of the sub-manifest)
+   * @param dataPacketSize The size of the content of each Data packet
+   * @param subManifestSize The number of Data packets in each sub-manifest
+   * @param subManifestNum The number of the sub-manifest to packetize
+   * @param sink The callback invoked with each signed Data packet and its full name, in order
+   * @param signer (optional) The signing service signing the packets
+   * Read the file in fixed-size chunks, build and sign the Data packets of one chunk at a time and
+   * pass them to @p sink, so that the memory used is independent of the size of the file. Return
+   * the number of packets produced. Throw Data::Error if the file cannot be read.
+   */
+  static size_t
+  packetize_file(const boost::filesystem::path& filePath,
+                 const ndn::Name& commonPrefix,
+                 size_t dataPacketSize,
+                 size_t subManifestSize,
+                 size_t subManifestNum,
+                 const PacketSink& sink,
+                 SigningService& signer = *SigningService::getDefault());
+
+  /*
+   * @brief Packetize the @p subManifestNum sub-manifest of the file at @p filePath
+   * Return all the signed Data packets of the sub-manifest in memory.
+   */
   static std::vector<ndn::Data>
   packetize_file(const boost::filesystem::path& filePath,
                  const ndn::Name& commonPrefix,
                  size_t dataPacketSize,
                  size_t subManifestSize,
-                 size_t subManifestNum);
+                 size_t subManifestNum,
+                 SigningService& signer = *SigningService::getDefault());
 
   /*
    * @brief Write the @p segment torrent segment to disk at the specified path.
@@ -110,12 +148,48 @@ class IoUtil {
             size_t              subManifestSize,
             const std::string&  filePath);
 
+  /*
+   * @brief Write @p packet composed of torrent date to disk using the open files of @p writers
+   * @param packet The data packet to be written to the disk
+   * @param filePath The path to the file on disk to which we should write the Data
+   * @param writers The pool of open files through which the data is written
+   * Write the content of the Data packet at its offset in the file, return 'true' if data
+   * successfully written 'false' otherwise. The data is synced to the disk according to the
+   * policy of @p writers. Behavior is undefined unless the corresponding file manifest has already
+   * been downloaded.
+   */
+  static bool
+  writeData(const Data&         packet,
+            const FileManifest& manifest,
+            size_t              subManifestSize,
+            const std::string&  filePath,
+            FileWriterPool&     writers);
+
+  /*
+   * @brief Write @p buffer to the file at @p path and sync the file to the disk
+   * @param append Whether @p buffer is appended to the file instead of replacing its content
+   * Return 'true' if the whole buffer was written and synced, 'false' otherwise.
+   */
+  static bool
+  writeFile(const boost::filesystem::path& path, const std::vector<uint8_t>& buffer, bool append);
+
+  /*
+   * @brief Replace the file at @p path by one holding @p buffer
+   * The buffer is written to a temporary file renamed over @p path once synced, so that a crash
+   * leaves either the old or the new file on the disk. Return 'true' on success, 'false'
+   * otherwise.
+   */
+  static bool
+  replaceFile(const boost::filesystem::path& path, const std::vector<uint8_t>& buffer);
+
   /*
    * @brief Read a data packet from the provided stream
    * @param packetFullName The fullname of the expected Data packet
    * @param manifest The file manifest for the requested  Data packet
    * @param subManifestSize The number of Data packets in each catalog for this Data packet
    * @param filePath The path on disk to the file containing the requested data
+   * @param mappedFiles (optional) The mappings of files used to read the data instead of a stream
+   * @param signer (optional) The signing service signing the packet
    * Read the data  packet from the @p is stream, validate it against the provided @p packetFullName
    * and @p manifest, if successful return a pointer to the packet, otherwise return nullptr.
    */
@@ -123,7 +197,30 @@ class IoUtil {
   readDataPacket(const Name&         packetFullName,
                  const FileManifest& manifest,
                  size_t              subManifestSize,
-                 const std::string&  filePath);
+                 const std::string&  filePath,
+                 MappedFileRegistry* mappedFiles = nullptr,
+                 SigningService&     signer = *SigningService::getDefault());
+
+  /*
+   * @brief Read a data packet from disk using a known signature
+   * @param packetFullName The fullname of the expected Data packet
+   * @param manifest The file manifest for the requested  Data packet
+   * @param subManifestSize The number of Data packets in each catalog for this Data packet
+   * @param filePath The path on disk to the file containing the requested data
+   * @param signatureValue The SignatureValue block of the SHA-256 digest signature of the packet
+   * @param mappedFiles (optional) The mappings of files used to read the data instead of a stream
+   * Read the content of the packet from disk and put it in an envelope carrying the provided
+   * signature, without signing or hashing the packet. Return a pointer to the packet if the
+   * content was read successfully, otherwise return nullptr. The behavior is undefined unless
+   * @p signatureValue is the signature of a packet previously validated against @p manifest.
+   */
+  static std::shared_ptr<Data>
+  readDataPacket(const Name&         packetFullName,
+                 const FileManifest& manifest,
+                 size_t              subManifestSize,
+                 const std::string&  filePath,
+                 const Block&        signatureValue,
+                 MappedFileRegistry* mappedFiles = nullptr);
 
   /*
    * @brief Return the type of the specified name
@@ -0,0 +1,129 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+* Copyright (c) 2016 Regents of the University of California.
+*
+* This file is part of the nTorrent codebase.
+*
+* nTorrent is free software: you can redistribute it and/or modify it under the
+* terms of the GNU Lesser General Public License as published by the Free Software
+* Foundation, either version 3 of the License, or (at your option) any later version.
+*
+* nTorrent is distributed in the hope that it will be useful, but WITHOUT ANY
+* WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+* PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+*
+* You should have received copies of the GNU General Public License and GNU Lesser
+* General Public License along with nTorrent, e.g., in COPYING.md file. If not, see
+* <http://www.gnu.org/licenses/>.
+*
+* See AUTHORS for complete list of nTorrent authors and contributors.
+*/
+
+#include "util/mapped-file.hpp"
+
+#include <algorithm>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace ndn {
+namespace ntorrent {
+
+std::shared_ptr<MappedFile>
+MappedFile::open(const std::string& path)
+{
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return nullptr;
+  }
+  struct stat st;
+  if (0 != ::fstat(fd, &st) || 0 >= st.st_size) {
+    ::close(fd);
+    return nullptr;
+  }
+  size_t size = st.st_size;
+  void* addr = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+  // the mapping remains valid after closing the descriptor
+  ::close(fd);
+  if (MAP_FAILED == addr) {
+    return nullptr;
+  }
+  return std::shared_ptr<MappedFile>(new MappedFile(path,
+                                                    static_cast<const uint8_t*>(addr),
+                                                    size));
+}
+
+MappedFile::MappedFile(const std::string& path, const uint8_t* data, size_t size)
+  : m_path(path)
+  , m_data(data)
+  , m_size(size)
+{
+}
+
+size_t
+MappedFile::currentSize() const
+{
+  struct stat st;
+  if (0 != ::stat(m_path.c_str(), &st)) {
+    return 0;
+  }
+  return std::min(m_size, static_cast<size_t>(st.st_size));
+}
+
+MappedFile::~MappedFile()
+{
+  ::munmap(const_cast<uint8_t*>(m_data), m_size);
+}
+
+std::shared_ptr<const MappedFile>
+MappedFileRegistry::get(const std::string& path, size_t minSize)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto it = m_files.find(path);
+  // map the file again only if it may have grown since it was mapped
+  if (m_files.end() != it && (it->second.file->size() >= minSize || !it->second.isGrown)) {
+    return it->second.file;
+  }
+  std::shared_ptr<const MappedFile> file = MappedFile::open(path);
+  if (nullptr == file) {
+    return nullptr;
+  }
+  m_files[path] = Entry{file, false};
+  return file;
+}
+
+void
+MappedFileRegistry::markGrown(const std::string& path)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto it = m_files.find(path);
+  if (m_files.end() != it) {
+    it->second.isGrown = true;
+  }
+}
+
+void
+MappedFileRegistry::erase(const std::string& path)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_files.erase(path);
+}
+
+void
+MappedFileRegistry::clear()
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_files.clear();
+}
+
+size_t
+MappedFileRegistry::size() const
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_files.size();
+}
+
+} // namespace ntorrent
+} // namespace ndn
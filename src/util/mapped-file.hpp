@@ -0,0 +1,164 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+* Copyright (c) 2016 Regents of the University of California.
+*
+* This file is part of the nTorrent codebase.
+*
+* nTorrent is free software: you can redistribute it and/or modify it under the
+* terms of the GNU Lesser General Public License as published by the Free Software
+* Foundation, either version 3 of the License, or (at your option) any later version.
+*
+* nTorrent is distributed in the hope that it will be useful, but WITHOUT ANY
+* WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+* PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+*
+* You should have received copies of the GNU General Public License and GNU Lesser
+* General Public License along with nTorrent, e.g., in COPYING.md file. If not, see
+* <http://www.gnu.org/licenses/>.
+*
+* See AUTHORS for complete list of nTorrent authors and contributors.
+*/
+
+#ifndef INCLUDED_UTIL_MAPPED_FILE_HPP
+#define INCLUDED_UTIL_MAPPED_FILE_HPP
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace ndn {
+namespace ntorrent {
+
+/**
+ * @brief A read-only shared memory mapping of a file
+ *
+ * The mapping covers the file as it was when the mapping was created. Writes to the file through
+ * other descriptors within the mapped range are visible through the mapping.
+ *
+ * Accessing a mapped byte past the end of the file raises SIGBUS, which happens if the file is
+ * truncated after it was mapped. The data files of a torrent are never truncated by nTorrent,
+ * so only an external truncation can cause this. Readers reaching the end of the mapping, where a
+ * truncation cuts first, should bound their read by currentSize().
+ */
+class MappedFile {
+public:
+  /**
+   * @brief Map the whole file at the specified @p path
+   * @return A pointer to the mapping, or nullptr if the file cannot be opened or mapped (e.g. it
+   *         is empty)
+   */
+  static std::shared_ptr<MappedFile>
+  open(const std::string& path);
+
+  ~MappedFile();
+
+  MappedFile(const MappedFile&) = delete;
+
+  MappedFile&
+  operator=(const MappedFile&) = delete;
+
+  /**
+   * @brief Return a pointer to the first mapped byte of the file
+   */
+  const uint8_t*
+  data() const;
+
+  /**
+   * @brief Return the number of mapped bytes
+   */
+  size_t
+  size() const;
+
+  /**
+   * @brief Return the number of mapped bytes that are still backed by the file on disk
+   *
+   * This is smaller than size() if the file was truncated since it was mapped, and 0 if it was
+   * removed.
+   */
+  size_t
+  currentSize() const;
+
+private:
+  MappedFile(const std::string& path, const uint8_t* data, size_t size);
+
+private:
+  std::string    m_path;
+  const uint8_t* m_data;
+  size_t         m_size;
+};
+
+/**
+ * @brief A thread-safe collection of the mappings of the files of a torrent, keyed by path
+ *
+ * Each file is mapped once, and mapped again only when a range past the end of its current
+ * mapping is requested after the file was marked as grown. The size of a file is therefore not
+ * checked on every read reaching its end, e.g., of its final packet.
+ */
+class MappedFileRegistry {
+public:
+  MappedFileRegistry() = default;
+
+  ~MappedFileRegistry() = default;
+
+  /**
+   * @brief Return a mapping of the file at @p path covering the range [0, @p minSize) if possible
+   * @return The mapping of the file, which covers fewer than @p minSize bytes if the file is
+   *         shorter than that. Returns nullptr if the file cannot be mapped.
+   */
+  std::shared_ptr<const MappedFile>
+  get(const std::string& path, size_t minSize);
+
+  /**
+   * @brief Mark the file at @p path as possibly grown past its mapping, e.g., after a write
+   */
+  void
+  markGrown(const std::string& path);
+
+  /**
+   * @brief Forget the mapping of the file at @p path
+   * Existing references to the mapping remain valid.
+   */
+  void
+  erase(const std::string& path);
+
+  /**
+   * @brief Forget all the mappings
+   */
+  void
+  clear();
+
+  /**
+   * @brief Return the number of files mapped
+   */
+  size_t
+  size() const;
+
+private:
+  struct Entry {
+    std::shared_ptr<const MappedFile> file;
+    // Whether the file may have grown since it was mapped
+    bool                              isGrown;
+  };
+
+  std::unordered_map<std::string, Entry> m_files;
+  mutable std::mutex                     m_mutex;
+};
+
+inline const uint8_t*
+MappedFile::data() const
+{
+  return m_data;
+}
+
+inline size_t
+MappedFile::size() const
+{
+  return m_size;
+}
+
+} // namespace ntorrent
+} // namespace ndn
+
+#endif // INCLUDED_UTIL_MAPPED_FILE_HPP
@@ -0,0 +1,69 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+* Copyright (c) 2016 Regents of the University of California.
+*
+* This file is part of the nTorrent codebase.
+*
+* nTorrent is free software: you can redistribute it and/or modify it under the
+* terms of the GNU Lesser General Public License as published by the Free Software
+* Foundation, either version 3 of the License, or (at your option) any later version.
+*
+* nTorrent is distributed in the hope that it will be useful, but WITHOUT ANY
+* WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+* PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+*
+* You should have received copies of the GNU General Public License and GNU Lesser
+* General Public License along with nTorrent, e.g., in COPYING.md file. If not, see
+* <http://www.gnu.org/licenses/>.
+*
+* See AUTHORS for complete list of nTorrent authors and contributors.
+*/
+
+#ifndef INCLUDED_UTIL_NAME_SUFFIX_HPP
+#define INCLUDED_UTIL_NAME_SUFFIX_HPP
+
+#include <ndn-cxx/encoding/encoding-buffer.hpp>
+#include <ndn-cxx/encoding/tlv.hpp>
+#include <ndn-cxx/name.hpp>
+
+#include <cstddef>
+
+namespace ndn {
+namespace ntorrent {
+
+/**
+ * @brief Return the size of the encoding as a Name of the components of @p name after its first
+ *        @p prefixSize components
+ */
+inline size_t
+suffixEncodedSize(const Name& name, size_t prefixSize)
+{
+  size_t valueLength = 0;
+  for (size_t i = prefixSize; i < name.size(); ++i) {
+    valueLength += name[i].size();
+  }
+  return tlv::sizeOfVarNumber(tlv::Name) + tlv::sizeOfVarNumber(valueLength) + valueLength;
+}
+
+/**
+ * @brief Prepend to @p encoder the components of @p name after its first @p prefixSize
+ *        components as a Name, without building the suffix
+ * @return The size of the prepended encoding
+ */
+template<encoding::Tag TAG>
+size_t
+prependSuffix(EncodingImpl<TAG>& encoder, const Name& name, size_t prefixSize)
+{
+  size_t totalLength = 0;
+  for (size_t i = name.size(); i > prefixSize; --i) {
+    totalLength += name[i - 1].wireEncode(encoder);
+  }
+  totalLength += encoder.prependVarNumber(totalLength);
+  totalLength += encoder.prependVarNumber(tlv::Name);
+  return totalLength;
+}
+
+} // namespace ntorrent
+} // namespace ndn
+
+#endif // INCLUDED_UTIL_NAME_SUFFIX_HPP
@@ -0,0 +1,116 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+* Copyright (c) 2016 Regents of the University of California.
+*
+* This file is part of the nTorrent codebase.
+*
+* nTorrent is free software: you can redistribute it and/or modify it under the
+* terms of the GNU Lesser General Public License as published by the Free Software
+* Foundation, either version 3 of the License, or (at your option) any later version.
+*
+* nTorrent is distributed in the hope that it will be useful, but WITHOUT ANY
+* WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+* PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+*
+* You should have received copies of the GNU General Public License and GNU Lesser
+* General Public License along with nTorrent, e.g., in COPYING.md file. If not, see
+* <http://www.gnu.org/licenses/>.
+*
+* See AUTHORS for complete list of nTorrent authors and contributors.
+*/
+
+#include "util/packet-bitmap.hpp"
+
+#include <algorithm>
+
+namespace ndn {
+namespace ntorrent {
+
+PacketBitmap::PacketBitmap(size_t size)
+: m_words((size + WORD_BITS - 1) / WORD_BITS, 0)
+, m_size(size)
+, m_count(0)
+, m_firstMissing(0)
+{
+}
+
+PacketBitmap::PacketBitmap(const std::vector<bool>& bitmap)
+: PacketBitmap(bitmap.size())
+{
+  for (size_t i = 0; i < bitmap.size(); ++i) {
+    if (bitmap[i]) {
+      set(i);
+    }
+  }
+}
+
+bool
+PacketBitmap::set(size_t packetNum)
+{
+  if (packetNum >= m_size) {
+    return false;
+  }
+  uint64_t& word = m_words[packetNum / WORD_BITS];
+  uint64_t mask = uint64_t(1) << (packetNum % WORD_BITS);
+  if (0 != (word & mask)) {
+    return false;
+  }
+  word |= mask;
+  ++m_count;
+  return true;
+}
+
+bool
+PacketBitmap::reset(size_t packetNum)
+{
+  if (packetNum >= m_size) {
+    return false;
+  }
+  uint64_t& word = m_words[packetNum / WORD_BITS];
+  uint64_t mask = uint64_t(1) << (packetNum % WORD_BITS);
+  if (0 == (word & mask)) {
+    return false;
+  }
+  word &= ~mask;
+  --m_count;
+  m_firstMissing = std::min(m_firstMissing, packetNum);
+  return true;
+}
+
+size_t
+PacketBitmap::findNextMissing(size_t from) const
+{
+  if (from >= m_size || isComplete()) {
+    return m_size;
+  }
+  size_t wordNum = from / WORD_BITS;
+  // the bits before @p from count as set
+  uint64_t missing = ~m_words[wordNum] & (~uint64_t(0) << (from % WORD_BITS));
+  while (0 == missing) {
+    if (++wordNum == m_words.size()) {
+      return m_size;
+    }
+    missing = ~m_words[wordNum];
+  }
+  // the unused bits of the last word are never set, so the result may be past the end
+  size_t packetNum = wordNum * WORD_BITS + __builtin_ctzll(missing);
+  return packetNum < m_size ? packetNum : m_size;
+}
+
+std::vector<bool>
+PacketBitmap::toVector() const
+{
+  std::vector<bool> bitmap(m_size, false);
+  for (size_t wordNum = 0; wordNum < m_words.size(); ++wordNum) {
+    uint64_t word = m_words[wordNum];
+    // visit the packets we have only
+    while (0 != word) {
+      bitmap[wordNum * WORD_BITS + __builtin_ctzll(word)] = true;
+      word &= word - 1;
+    }
+  }
+  return bitmap;
+}
+
+} // namespace ntorrent
+} // namespace ndn
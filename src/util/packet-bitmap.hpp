@@ -0,0 +1,157 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+* Copyright (c) 2016 Regents of the University of California.
+*
+* This file is part of the nTorrent codebase.
+*
+* nTorrent is free software: you can redistribute it and/or modify it under the
+* terms of the GNU Lesser General Public License as published by the Free Software
+* Foundation, either version 3 of the License, or (at your option) any later version.
+*
+* nTorrent is distributed in the hope that it will be useful, but WITHOUT ANY
+* WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+* PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+*
+* You should have received copies of the GNU General Public License and GNU Lesser
+* General Public License along with nTorrent, e.g., in COPYING.md file. If not, see
+* <http://www.gnu.org/licenses/>.
+*
+* See AUTHORS for complete list of nTorrent authors and contributors.
+*/
+
+#ifndef INCLUDED_UTIL_PACKET_BITMAP_HPP
+#define INCLUDED_UTIL_PACKET_BITMAP_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace ndn {
+namespace ntorrent {
+
+/**
+ * @brief The set of the packets of a sub-manifest that a manager has
+ *
+ * The bits are packed in 64-bit words, and the number of bits set is maintained as packets are
+ * added, so that completion checks are O(1) and the scans for missing packets skip a word of
+ * packets we have at a time. The first missing packet is cached, so that looking it up is O(1)
+ * amortized while the packets are received mostly in order.
+ */
+class PacketBitmap {
+public:
+  /**
+   * @brief Create a bitmap of @p size packets, none of which we have
+   */
+  explicit
+  PacketBitmap(size_t size = 0);
+
+  /**
+   * @brief Create a bitmap with the packets set in @p bitmap
+   */
+  explicit
+  PacketBitmap(const std::vector<bool>& bitmap);
+
+  /**
+   * @brief Return the number of packets of the bitmap
+   */
+  size_t
+  size() const;
+
+  /**
+   * @brief Return the number of packets we have
+   */
+  size_t
+  count() const;
+
+  /**
+   * @brief Return whether we have all the packets
+   */
+  bool
+  isComplete() const;
+
+  /**
+   * @brief Return whether we have the packet @p packetNum (false if it is out of range)
+   */
+  bool
+  test(size_t packetNum) const;
+
+  /**
+   * @brief Mark the packet @p packetNum as received
+   * @return true if the packet was not set before, false if it was set or is out of range
+   */
+  bool
+  set(size_t packetNum);
+
+  /**
+   * @brief Mark the packet @p packetNum as missing
+   * @return true if the packet was set before, false if it was not set or is out of range
+   */
+  bool
+  reset(size_t packetNum);
+
+  /**
+   * @brief Return the first packet we are missing, or size() if the bitmap is complete
+   */
+  size_t
+  findFirstMissing() const;
+
+  /**
+   * @brief Return the first packet at or after @p from we are missing, or size() if there is none
+   */
+  size_t
+  findNextMissing(size_t from) const;
+
+  /**
+   * @brief Return the bitmap as one bool per packet
+   */
+  std::vector<bool>
+  toVector() const;
+
+private:
+  enum {
+    WORD_BITS = 64
+  };
+
+  std::vector<uint64_t>   m_words;
+  size_t                  m_size;
+  size_t                  m_count;
+  // No packet before m_firstMissing is missing
+  mutable size_t          m_firstMissing;
+};
+
+inline size_t
+PacketBitmap::size() const
+{
+  return m_size;
+}
+
+inline size_t
+PacketBitmap::count() const
+{
+  return m_count;
+}
+
+inline bool
+PacketBitmap::isComplete() const
+{
+  return m_count == m_size;
+}
+
+inline bool
+PacketBitmap::test(size_t packetNum) const
+{
+  return packetNum < m_size &&
+         0 != (m_words[packetNum / WORD_BITS] & (uint64_t(1) << (packetNum % WORD_BITS)));
+}
+
+inline size_t
+PacketBitmap::findFirstMissing() const
+{
+  m_firstMissing = findNextMissing(m_firstMissing);
+  return m_firstMissing;
+}
+
+} // namespace ntorrent
+} // namespace ndn
+
+#endif // INCLUDED_UTIL_PACKET_BITMAP_HPP
@@ -0,0 +1,89 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+* Copyright (c) 2016 Regents of the University of California.
+*
+* This file is part of the nTorrent codebase.
+*
+* nTorrent is free software: you can redistribute it and/or modify it under the
+* terms of the GNU Lesser General Public License as published by the Free Software
+* Foundation, either version 3 of the License, or (at your option) any later version.
+*
+* nTorrent is distributed in the hope that it will be useful, but WITHOUT ANY
+* WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+* PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+*
+* You should have received copies of the GNU General Public License and GNU Lesser
+* General Public License along with nTorrent, e.g., in COPYING.md file. If not, see
+* <http://www.gnu.org/licenses/>.
+*
+* See AUTHORS for complete list of nTorrent authors and contributors.
+*/
+
+#include "util/segment-index.hpp"
+
+#include <ndn-cxx/encoding/block-helpers.hpp>
+#include <ndn-cxx/encoding/encoding-buffer.hpp>
+
+#include <algorithm>
+
+#include <boost/range/adaptors.hpp>
+
+namespace ndn {
+namespace ntorrent {
+
+std::pair<size_t, size_t>
+SegmentIndex::children(size_t position, size_t numSegments, size_t fanout)
+{
+  if (0 == fanout || position >= numSegments) {
+    return std::make_pair(numSegments, numSegments);
+  }
+  // the children of the last segments lie past the end of the chain
+  if (position > (numSegments - 1) / fanout) {
+    return std::make_pair(numSegments, numSegments);
+  }
+  size_t first = position * fanout + 1;
+  size_t last = first + std::min(fanout, numSegments - first);
+  return std::make_pair(first, last);
+}
+
+std::vector<Name>
+SegmentIndex::read(const MetaInfo& metaInfo)
+{
+  std::vector<Name> names;
+  const Block* index = metaInfo.findAppMetaInfo(SEGMENT_INDEX_TYPE);
+  if (nullptr == index) {
+    return names;
+  }
+  index->parse();
+  auto element = index->elements_begin();
+  if (index->elements_end() == element ||
+      INDEX_VERSION_TYPE != element->type() ||
+      VERSION != readNonNegativeInteger(*element)) {
+    return names;
+  }
+  for (++element; element != index->elements_end(); ++element) {
+    names.emplace_back(*element);
+  }
+  return names;
+}
+
+void
+SegmentIndex::write(MetaInfo& metaInfo, const std::vector<Name>& names)
+{
+  metaInfo.removeAppMetaInfo(SEGMENT_INDEX_TYPE);
+  if (names.empty()) {
+    return;
+  }
+  EncodingBuffer buffer;
+  size_t totalLength = 0;
+  for (const auto& name : names | boost::adaptors::reversed) {
+    totalLength += name.wireEncode(buffer);
+  }
+  totalLength += prependNonNegativeIntegerBlock(buffer, INDEX_VERSION_TYPE, VERSION);
+  buffer.prependVarNumber(totalLength);
+  buffer.prependVarNumber(SEGMENT_INDEX_TYPE);
+  metaInfo.addAppMetaInfo(buffer.block());
+}
+
+} // namespace ntorrent
+} // namespace ndn
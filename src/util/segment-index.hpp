@@ -0,0 +1,96 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+* Copyright (c) 2016 Regents of the University of California.
+*
+* This file is part of the nTorrent codebase.
+*
+* nTorrent is free software: you can redistribute it and/or modify it under the
+* terms of the GNU Lesser General Public License as published by the Free Software
+* Foundation, either version 3 of the License, or (at your option) any later version.
+*
+* nTorrent is distributed in the hope that it will be useful, but WITHOUT ANY
+* WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+* PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+*
+* You should have received copies of the GNU General Public License and GNU Lesser
+* General Public License along with nTorrent, e.g., in COPYING.md file. If not, see
+* <http://www.gnu.org/licenses/>.
+*
+* See AUTHORS for complete list of nTorrent authors and contributors.
+*/
+
+#ifndef INCLUDED_UTIL_SEGMENT_INDEX_HPP
+#define INCLUDED_UTIL_SEGMENT_INDEX_HPP
+
+#include <ndn-cxx/meta-info.hpp>
+#include <ndn-cxx/name.hpp>
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace ndn {
+namespace ntorrent {
+
+/**
+ * @brief An index of the full names of the segments of a chain (the segments of a torrent-file
+ *        or the sub-manifests of a file), carried in the AppMetaInfo of the segments
+ *
+ * The segments form a tree of a given fanout in the order of the chain: the segment at position
+ * i lists the segments at positions fanout * i + 1 to fanout * i + fanout. Every segment only
+ * lists segments after it, so the index is built back to front along with the pointers, and a
+ * reader that requests all the segments listed by each segment it receives discovers a chain of
+ * n segments in about log_fanout(n) round trips. With a fanout of at least n - 1 the first
+ * segment lists all the others.
+ *
+ * SegmentIndex ::= SEGMENT-INDEX-TYPE TLV-LENGTH
+ *                  IndexVersion
+ *                  Name*
+ *
+ * IndexVersion ::= INDEX-VERSION-TYPE TLV-LENGTH
+ *                  nonNegativeInteger
+ *
+ * Readers that do not know the index, or its version, ignore it and follow the pointers.
+ */
+class SegmentIndex {
+public:
+  enum {
+    // The TLV type of the AppMetaInfo block of the index
+    SEGMENT_INDEX_TYPE = 128,
+    // The TLV type of the version of the index
+    INDEX_VERSION_TYPE = 129,
+    // The version of the index written and understood by this code
+    VERSION = 1
+  };
+
+  /**
+   * @brief Return the range [first, last) of the positions of the segments listed by the segment
+   *        at @p position of a chain of @p numSegments segments, indexed with @p fanout
+   *
+   * A fanout of 0 means no index, so the range is empty.
+   */
+  static std::pair<size_t, size_t>
+  children(size_t position, size_t numSegments, size_t fanout);
+
+  /**
+   * @brief Return the names listed by the index in @p metaInfo
+   *
+   * The result is empty if there is no index or its version is not known.
+   *
+   * @throws tlv::Error if the index is malformed
+   */
+  static std::vector<Name>
+  read(const MetaInfo& metaInfo);
+
+  /**
+   * @brief Replace the index in @p metaInfo with one listing @p names, or remove it if there are
+   *        no names
+   */
+  static void
+  write(MetaInfo& metaInfo, const std::vector<Name>& names);
+};
+
+} // namespace ntorrent
+} // namespace ndn
+
+#endif // INCLUDED_UTIL_SEGMENT_INDEX_HPP
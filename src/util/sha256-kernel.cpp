@@ -0,0 +1,422 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+* Copyright (c) 2016 Regents of the University of California.
+*
+* This file is part of the nTorrent codebase.
+*
+* nTorrent is free software: you can redistribute it and/or modify it under the
+* terms of the GNU Lesser General Public License as published by the Free Software
+* Foundation, either version 3 of the License, or (at your option) any later version.
+*
+* nTorrent is distributed in the hope that it will be useful, but WITHOUT ANY
+* WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+* PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+*
+* You should have received copies of the GNU General Public License and GNU Lesser
+* General Public License along with nTorrent, e.g., in COPYING.md file. If not, see
+* <http://www.gnu.org/licenses/>.
+*
+* See AUTHORS for complete list of nTorrent authors and contributors.
+*/
+
+#include "util/sha256-kernel.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define NTORRENT_SHA256_X86 1
+#include <cpuid.h>
+#include <immintrin.h>
+#endif // x86 && __GNUC__
+
+namespace ndn {
+namespace ntorrent {
+
+namespace {
+
+const uint32_t K[64] = {
+  0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+  0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+  0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+  0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+  0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+  0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+  0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+  0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+const uint32_t INITIAL_STATE[8] = {
+  0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+};
+
+// The blocks hashed by lanes with no block left to hash
+const uint8_t ZERO_BLOCK[Sha256Kernel::BLOCK_SIZE] = {};
+
+inline uint32_t
+loadBigEndian(const uint8_t* bytes)
+{
+  return uint32_t(bytes[0]) << 24 | uint32_t(bytes[1]) << 16 | uint32_t(bytes[2]) << 8 | bytes[3];
+}
+
+inline uint32_t
+rotr(uint32_t x, int n)
+{
+  return (x >> n) | (x << (32 - n));
+}
+
+// The last one or two blocks of a message: its bytes after the last full block, the padding and
+// the length of the message in bits
+struct Tail
+{
+  Tail()
+    : numBlocks(0)
+  {
+  }
+
+  Tail(const uint8_t* data, size_t size)
+  {
+    assign(data, size);
+  }
+
+  void
+  assign(const uint8_t* data, size_t size)
+  {
+    size_t remaining = size % Sha256Kernel::BLOCK_SIZE;
+    if (0 != remaining) {
+      std::memcpy(bytes, data + size - remaining, remaining);
+    }
+    bytes[remaining] = 0x80;
+    numBlocks = remaining + 9 <= Sha256Kernel::BLOCK_SIZE ? 1 : 2;
+    size_t end = numBlocks * Sha256Kernel::BLOCK_SIZE;
+    std::fill(bytes + remaining + 1, bytes + end - 8, 0);
+    uint64_t numBits = uint64_t(size) * 8;
+    for (size_t i = 0; i < 8; ++i) {
+      bytes[end - 1 - i] = static_cast<uint8_t>(numBits >> (8 * i));
+    }
+  }
+
+  uint8_t bytes[2 * Sha256Kernel::BLOCK_SIZE];
+  size_t  numBlocks;
+};
+
+typedef void (*CompressFunction)(uint32_t state[8], const uint8_t* blocks, size_t numBlocks);
+
+void
+compressPortable(uint32_t state[8], const uint8_t* blocks, size_t numBlocks)
+{
+  for (; 0 != numBlocks; --numBlocks, blocks += Sha256Kernel::BLOCK_SIZE) {
+    uint32_t w[64];
+    for (size_t t = 0; t < 16; ++t) {
+      w[t] = loadBigEndian(blocks + 4 * t);
+    }
+    for (size_t t = 16; t < 64; ++t) {
+      uint32_t s0 = rotr(w[t - 15], 7) ^ rotr(w[t - 15], 18) ^ (w[t - 15] >> 3);
+      uint32_t s1 = rotr(w[t - 2], 17) ^ rotr(w[t - 2], 19) ^ (w[t - 2] >> 10);
+      w[t] = w[t - 16] + s0 + w[t - 7] + s1;
+    }
+    uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+    uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+    for (size_t t = 0; t < 64; ++t) {
+      uint32_t t1 = h + (rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25)) + ((e & f) ^ (~e & g)) + K[t] + w[t];
+      uint32_t t2 = (rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+      h = g;
+      g = f;
+      f = e;
+      e = d + t1;
+      d = c;
+      c = b;
+      b = a;
+      a = t1 + t2;
+    }
+    state[0] += a;
+    state[1] += b;
+    state[2] += c;
+    state[3] += d;
+    state[4] += e;
+    state[5] += f;
+    state[6] += g;
+    state[7] += h;
+  }
+}
+
+Sha256Kernel::Digest
+computeWith(CompressFunction compress, const uint8_t* data, size_t size)
+{
+  uint32_t state[8];
+  std::copy(INITIAL_STATE, INITIAL_STATE + 8, state);
+  compress(state, data, size / Sha256Kernel::BLOCK_SIZE);
+  Tail tail(data, size);
+  compress(state, tail.bytes, tail.numBlocks);
+  Sha256Kernel::Digest digest;
+  for (size_t i = 0; i < 8; ++i) {
+    for (size_t j = 0; j < 4; ++j) {
+      digest[4 * i + j] = static_cast<uint8_t>(state[i] >> (24 - 8 * j));
+    }
+  }
+  return digest;
+}
+
+#ifdef NTORRENT_SHA256_X86
+
+__attribute__((target("sha,sse4.1")))
+void
+compressShaNi(uint32_t state[8], const uint8_t* blocks, size_t numBlocks)
+{
+  const __m128i byteSwap = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+  // the state is kept as ABEF and CDGH
+  __m128i tmp = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(state)), 0xB1);
+  __m128i state1 = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(state + 4)),
+                                     0x1B);
+  __m128i state0 = _mm_alignr_epi8(tmp, state1, 8);
+  state1 = _mm_blend_epi16(state1, tmp, 0xF0);
+
+  for (; 0 != numBlocks; --numBlocks, blocks += Sha256Kernel::BLOCK_SIZE) {
+    __m128i savedState0 = state0;
+    __m128i savedState1 = state1;
+    // the last four groups of four words of the message schedule
+    __m128i w[4];
+    for (size_t i = 0; i < 16; ++i) {
+      if (i < 4) {
+        w[i] = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(blocks + 16 * i)),
+                                byteSwap);
+      }
+      else {
+        __m128i sum = _mm_add_epi32(_mm_sha256msg1_epu32(w[i & 3], w[(i + 1) & 3]),
+                                    _mm_alignr_epi8(w[(i + 3) & 3], w[(i + 2) & 3], 4));
+        w[i & 3] = _mm_sha256msg2_epu32(sum, w[(i + 3) & 3]);
+      }
+      __m128i message = _mm_add_epi32(w[i & 3],
+                                      _mm_loadu_si128(reinterpret_cast<const __m128i*>(K + 4 * i)));
+      state1 = _mm_sha256rnds2_epu32(state1, state0, message);
+      state0 = _mm_sha256rnds2_epu32(state0, state1, _mm_shuffle_epi32(message, 0x0E));
+    }
+    state0 = _mm_add_epi32(state0, savedState0);
+    state1 = _mm_add_epi32(state1, savedState1);
+  }
+
+  tmp = _mm_shuffle_epi32(state0, 0x1B);
+  state1 = _mm_shuffle_epi32(state1, 0xB1);
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(state), _mm_blend_epi16(tmp, state1, 0xF0));
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(state + 4), _mm_alignr_epi8(state1, tmp, 8));
+}
+
+__attribute__((target("avx2")))
+inline __m256i
+rotr8x(__m256i x, int n)
+{
+  return _mm256_or_si256(_mm256_srli_epi32(x, n), _mm256_slli_epi32(x, 32 - n));
+}
+
+// Hash the @p count (at most NUM_LANES) buffers in the lanes of the AVX2 registers
+__attribute__((target("avx2")))
+void
+computeAvx2(const uint8_t* const* buffers, const size_t* sizes, size_t count,
+            Sha256Kernel::Digest* digests)
+{
+  enum { NUM_LANES = Sha256Kernel::NUM_LANES };
+  const uint8_t* data[NUM_LANES];
+  size_t numFullBlocks[NUM_LANES];
+  size_t numBlocks[NUM_LANES];
+  Tail tails[NUM_LANES];
+  size_t maxNumBlocks = 0;
+  for (size_t lane = 0; lane < NUM_LANES; ++lane) {
+    // the lanes past count hash an empty buffer
+    data[lane] = lane < count ? buffers[lane] : ZERO_BLOCK;
+    size_t size = lane < count ? sizes[lane] : 0;
+    tails[lane].assign(data[lane], size);
+    numFullBlocks[lane] = size / Sha256Kernel::BLOCK_SIZE;
+    numBlocks[lane] = numFullBlocks[lane] + tails[lane].numBlocks;
+    maxNumBlocks = std::max(maxNumBlocks, numBlocks[lane]);
+  }
+
+  __m256i state[8];
+  for (size_t i = 0; i < 8; ++i) {
+    state[i] = _mm256_set1_epi32(INITIAL_STATE[i]);
+  }
+  for (size_t block = 0; block < maxNumBlocks; ++block) {
+    const uint8_t* blocks[NUM_LANES];
+    alignas(32) int32_t active[NUM_LANES];
+    for (size_t lane = 0; lane < NUM_LANES; ++lane) {
+      if (block < numFullBlocks[lane]) {
+        blocks[lane] = data[lane] + block * Sha256Kernel::BLOCK_SIZE;
+      }
+      else if (block < numBlocks[lane]) {
+        blocks[lane] = tails[lane].bytes + (block - numFullBlocks[lane]) * Sha256Kernel::BLOCK_SIZE;
+      }
+      else {
+        blocks[lane] = ZERO_BLOCK;
+      }
+      active[lane] = block < numBlocks[lane] ? -1 : 0;
+    }
+    // the message schedule of each lane, sixteen words at a time
+    __m256i w[16];
+    for (size_t t = 0; t < 16; ++t) {
+      w[t] = _mm256_setr_epi32(loadBigEndian(blocks[0] + 4 * t), loadBigEndian(blocks[1] + 4 * t),
+                               loadBigEndian(blocks[2] + 4 * t), loadBigEndian(blocks[3] + 4 * t),
+                               loadBigEndian(blocks[4] + 4 * t), loadBigEndian(blocks[5] + 4 * t),
+                               loadBigEndian(blocks[6] + 4 * t), loadBigEndian(blocks[7] + 4 * t));
+    }
+    __m256i a = state[0], b = state[1], c = state[2], d = state[3];
+    __m256i e = state[4], f = state[5], g = state[6], h = state[7];
+    for (size_t t = 0; t < 64; ++t) {
+      if (t >= 16) {
+        __m256i w15 = w[(t - 15) & 15];
+        __m256i w2 = w[(t - 2) & 15];
+        __m256i s0 = _mm256_xor_si256(_mm256_xor_si256(rotr8x(w15, 7), rotr8x(w15, 18)),
+                                      _mm256_srli_epi32(w15, 3));
+        __m256i s1 = _mm256_xor_si256(_mm256_xor_si256(rotr8x(w2, 17), rotr8x(w2, 19)),
+                                      _mm256_srli_epi32(w2, 10));
+        w[t & 15] = _mm256_add_epi32(_mm256_add_epi32(w[t & 15], s0),
+                                     _mm256_add_epi32(w[(t - 7) & 15], s1));
+      }
+      __m256i bigSigma1 = _mm256_xor_si256(_mm256_xor_si256(rotr8x(e, 6), rotr8x(e, 11)),
+                                           rotr8x(e, 25));
+      __m256i choice = _mm256_xor_si256(_mm256_and_si256(e, f), _mm256_andnot_si256(e, g));
+      __m256i t1 = _mm256_add_epi32(_mm256_add_epi32(h, bigSigma1),
+                                    _mm256_add_epi32(choice,
+                                                     _mm256_add_epi32(_mm256_set1_epi32(K[t]),
+                                                                      w[t & 15])));
+      __m256i bigSigma0 = _mm256_xor_si256(_mm256_xor_si256(rotr8x(a, 2), rotr8x(a, 13)),
+                                           rotr8x(a, 22));
+      __m256i majority = _mm256_or_si256(_mm256_and_si256(a, b),
+                                         _mm256_and_si256(c, _mm256_or_si256(a, b)));
+      __m256i t2 = _mm256_add_epi32(bigSigma0, majority);
+      h = g;
+      g = f;
+      f = e;
+      e = _mm256_add_epi32(d, t1);
+      d = c;
+      c = b;
+      b = a;
+      a = _mm256_add_epi32(t1, t2);
+    }
+    // the lanes whose buffer is hashed keep their state
+    __m256i mask = _mm256_load_si256(reinterpret_cast<const __m256i*>(active));
+    __m256i result[8] = { a, b, c, d, e, f, g, h };
+    for (size_t i = 0; i < 8; ++i) {
+      state[i] = _mm256_blendv_epi8(state[i], _mm256_add_epi32(state[i], result[i]), mask);
+    }
+  }
+
+  for (size_t i = 0; i < 8; ++i) {
+    alignas(32) uint32_t words[NUM_LANES];
+    _mm256_store_si256(reinterpret_cast<__m256i*>(words), state[i]);
+    for (size_t lane = 0; lane < count; ++lane) {
+      for (size_t j = 0; j < 4; ++j) {
+        digests[lane][4 * i + j] = static_cast<uint8_t>(words[lane] >> (24 - 8 * j));
+      }
+    }
+  }
+}
+
+bool
+cpuSupports(Sha256Kernel::Implementation implementation)
+{
+  unsigned int eax = 0, ebx = 0, ecx = 0, edx = 0;
+  if (__get_cpuid_max(0, nullptr) < 7 || !__get_cpuid(1, &eax, &ebx, &ecx, &edx)) {
+    return false;
+  }
+  bool hasSsse3 = 0 != (ecx & (1u << 9));
+  bool hasSse41 = 0 != (ecx & (1u << 19));
+  bool hasOsxsave = 0 != (ecx & (1u << 27));
+  bool hasAvx = 0 != (ecx & (1u << 28));
+  __cpuid_count(7, 0, eax, ebx, ecx, edx);
+  switch (implementation) {
+    case Sha256Kernel::SHA_NI:
+      return hasSsse3 && hasSse41 && 0 != (ebx & (1u << 29));
+    case Sha256Kernel::AVX2: {
+      if (!hasOsxsave || !hasAvx || 0 == (ebx & (1u << 5))) {
+        return false;
+      }
+      // the operating system must save the AVX registers
+      unsigned int xcr0Low = 0, xcr0High = 0;
+      __asm__("xgetbv" : "=a"(xcr0Low), "=d"(xcr0High) : "c"(0));
+      return 0x6 == (xcr0Low & 0x6);
+    }
+    default:
+      return true;
+  }
+}
+
+#else
+
+bool
+cpuSupports(Sha256Kernel::Implementation implementation)
+{
+  return Sha256Kernel::PORTABLE == implementation;
+}
+
+#endif // NTORRENT_SHA256_X86
+
+Sha256Kernel::Implementation
+detectBest()
+{
+  if (cpuSupports(Sha256Kernel::SHA_NI)) {
+    return Sha256Kernel::SHA_NI;
+  }
+  if (cpuSupports(Sha256Kernel::AVX2)) {
+    return Sha256Kernel::AVX2;
+  }
+  return Sha256Kernel::PORTABLE;
+}
+
+} // namespace
+
+Sha256Kernel::Implementation
+Sha256Kernel::best()
+{
+  static const Implementation implementation = detectBest();
+  return implementation;
+}
+
+bool
+Sha256Kernel::isSupported(Implementation implementation)
+{
+  return cpuSupports(implementation);
+}
+
+const char*
+Sha256Kernel::toString(Implementation implementation)
+{
+  switch (implementation) {
+    case SHA_NI:
+      return "sha-ni";
+    case AVX2:
+      return "avx2";
+    default:
+      return "portable";
+  }
+}
+
+Sha256Kernel::Digest
+Sha256Kernel::compute(const uint8_t* data, size_t size, Implementation implementation)
+{
+#ifdef NTORRENT_SHA256_X86
+  if (SHA_NI == implementation) {
+    return computeWith(&compressShaNi, data, size);
+  }
+#endif // NTORRENT_SHA256_X86
+  return computeWith(&compressPortable, data, size);
+}
+
+void
+Sha256Kernel::computeBatch(const uint8_t* const* buffers, const size_t* sizes, size_t count,
+                           Digest* digests, Implementation implementation)
+{
+#ifdef NTORRENT_SHA256_X86
+  if (AVX2 == implementation) {
+    for (size_t first = 0; first < count; first += NUM_LANES) {
+      computeAvx2(buffers + first, sizes + first, std::min<size_t>(NUM_LANES, count - first),
+                  digests + first);
+    }
+    return;
+  }
+#endif // NTORRENT_SHA256_X86
+  for (size_t i = 0; i < count; ++i) {
+    digests[i] = compute(buffers[i], sizes[i], implementation);
+  }
+}
+
+} // namespace ntorrent
+} // namespace ndn
@@ -0,0 +1,104 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+* Copyright (c) 2016 Regents of the University of California.
+*
+* This file is part of the nTorrent codebase.
+*
+* nTorrent is free software: you can redistribute it and/or modify it under the
+* terms of the GNU Lesser General Public License as published by the Free Software
+* Foundation, either version 3 of the License, or (at your option) any later version.
+*
+* nTorrent is distributed in the hope that it will be useful, but WITHOUT ANY
+* WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+* PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+*
+* You should have received copies of the GNU General Public License and GNU Lesser
+* General Public License along with nTorrent, e.g., in COPYING.md file. If not, see
+* <http://www.gnu.org/licenses/>.
+*
+* See AUTHORS for complete list of nTorrent authors and contributors.
+*/
+
+
+#ifndef INCLUDED_UTIL_SHA256_KERNEL_HPP
+#define INCLUDED_UTIL_SHA256_KERNEL_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace ndn {
+namespace ntorrent {
+
+/**
+ * @brief A SHA-256 kernel hashing the Data packets of a torrent
+ *
+ * Every packet of a torrent is hashed twice, once for its DigestSha256 signature and once for its
+ * implicit digest, so the hashing dominates packetizing and verifying the data on disk. The kernel
+ * uses the SHA extensions of the CPU when it has them. Otherwise, batches of buffers are hashed
+ * NUM_LANES at a time in the lanes of the AVX2 registers, and single buffers with portable code.
+ * The implementation is picked once, at the first call, from the features of the CPU.
+ */
+class Sha256Kernel {
+public:
+  enum {
+    DIGEST_SIZE = 32,
+    BLOCK_SIZE  = 64,
+    // Number of buffers hashed together by the AVX2 implementation
+    NUM_LANES   = 8
+  };
+
+  typedef std::array<uint8_t, DIGEST_SIZE> Digest;
+
+  enum Implementation {
+    // Portable C++, one buffer at a time
+    PORTABLE = 0,
+    // AVX2, NUM_LANES buffers at a time (portable for single buffers)
+    AVX2     = 1,
+    // The SHA extensions of x86 processors, one buffer at a time
+    SHA_NI   = 2
+  };
+
+  /**
+   * @brief Return the fastest implementation supported by the CPU
+   */
+  static Implementation
+  best();
+
+  /**
+   * @brief Return whether the CPU supports @p implementation
+   */
+  static bool
+  isSupported(Implementation implementation);
+
+  /**
+   * @brief Return the name of @p implementation
+   */
+  static const char*
+  toString(Implementation implementation);
+
+  /**
+   * @brief Return the digest of the @p size bytes at @p data
+   *
+   * The behavior is undefined unless the CPU supports @p implementation.
+   */
+  static Digest
+  compute(const uint8_t* data, size_t size, Implementation implementation = best());
+
+  /**
+   * @brief Set @p digests[i] to the digest of the @p sizes[i] bytes at @p buffers[i], for each of
+   *        the @p count buffers
+   *
+   * Hashing a batch of buffers of similar sizes is faster than hashing them one at a time when
+   * the implementation hashes several buffers at a time. The behavior is undefined unless the
+   * CPU supports @p implementation.
+   */
+  static void
+  computeBatch(const uint8_t* const* buffers, const size_t* sizes, size_t count, Digest* digests,
+               Implementation implementation = best());
+};
+
+} // namespace ntorrent
+} // namespace ndn
+
+#endif // INCLUDED_UTIL_SHA256_KERNEL_HPP
@@ -0,0 +1,75 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+* Copyright (c) 2016 Regents of the University of California.
+*
+* This file is part of the nTorrent codebase.
+*
+* nTorrent is free software: you can redistribute it and/or modify it under the
+* terms of the GNU Lesser General Public License as published by the Free Software
+* Foundation, either version 3 of the License, or (at your option) any later version.
+*
+* nTorrent is distributed in the hope that it will be useful, but WITHOUT ANY
+* WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+* PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+*
+* You should have received copies of the GNU General Public License and GNU Lesser
+* General Public License along with nTorrent, e.g., in COPYING.md file. If not, see
+* <http://www.gnu.org/licenses/>.
+*
+* See AUTHORS for complete list of nTorrent authors and contributors.
+*/
+
+#include "util/signing-service.hpp"
+
+#include "util/digest-signer.hpp"
+
+namespace ndn {
+namespace ntorrent {
+
+SigningService::SigningService()
+: m_keyChainMutex()
+, m_keyChain()
+{
+}
+
+SigningService::SigningService(std::shared_ptr<KeyChain> keyChain)
+: m_keyChainMutex()
+, m_keyChain(keyChain)
+{
+}
+
+std::shared_ptr<SigningService>
+SigningService::getDefault()
+{
+  static const auto signingService = std::make_shared<SigningService>();
+  return signingService;
+}
+
+Name
+SigningService::sign(Data& data)
+{
+  return DigestSigner::sign(data);
+}
+
+std::vector<Name>
+SigningService::sign(const std::vector<Data*>& packets)
+{
+  return DigestSigner::sign(packets);
+}
+
+void
+SigningService::sign(Data& data, const security::SigningInfo& params)
+{
+  if (security::SigningInfo::SIGNER_TYPE_SHA256 == params.getSignerType()) {
+    DigestSigner::sign(data);
+    return;
+  }
+  std::lock_guard<std::mutex> lock(m_keyChainMutex);
+  if (nullptr == m_keyChain) {
+    m_keyChain = std::make_shared<KeyChain>();
+  }
+  m_keyChain->sign(data, params);
+}
+
+} // namespace ntorrent
+} // namespace ndn
@@ -0,0 +1,100 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+* Copyright (c) 2016 Regents of the University of California.
+*
+* This file is part of the nTorrent codebase.
+*
+* nTorrent is free software: you can redistribute it and/or modify it under the
+* terms of the GNU Lesser General Public License as published by the Free Software
+* Foundation, either version 3 of the License, or (at your option) any later version.
+*
+* nTorrent is distributed in the hope that it will be useful, but WITHOUT ANY
+* WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+* PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+*
+* You should have received copies of the GNU General Public License and GNU Lesser
+* General Public License along with nTorrent, e.g., in COPYING.md file. If not, see
+* <http://www.gnu.org/licenses/>.
+*
+* See AUTHORS for complete list of nTorrent authors and contributors.
+*/
+
+#ifndef INCLUDED_UTIL_SIGNING_SERVICE_HPP
+#define INCLUDED_UTIL_SIGNING_SERVICE_HPP
+
+#include <ndn-cxx/data.hpp>
+#include <ndn-cxx/name.hpp>
+#include <ndn-cxx/security/key-chain.hpp>
+#include <ndn-cxx/security/signing-info.hpp>
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace ndn {
+namespace ntorrent {
+
+/**
+ * @brief The signing context shared by IoUtil, the generators and the TorrentManager
+ *
+ * The packets of a torrent are signed with a SHA-256 digest, which needs no key: they are signed
+ * by the DigestSigner without any lock, so that the threads packetizing or serving files can sign
+ * concurrently. Signing with a key needs a KeyChain, whose construction opens the PIB and the
+ * TPM, so it is constructed once, the first time it is needed, and used by one thread at a time.
+ */
+class SigningService {
+public:
+  /**
+   * @brief Create a signing service constructing its KeyChain the first time it is needed
+   */
+  SigningService();
+
+  /**
+   * @brief Create a signing service signing with a key through @p keyChain
+   */
+  explicit
+  SigningService(std::shared_ptr<KeyChain> keyChain);
+
+  SigningService(const SigningService&) = delete;
+
+  SigningService&
+  operator=(const SigningService&) = delete;
+
+  /**
+   * @brief Return the signing service shared by the whole process
+   */
+  static std::shared_ptr<SigningService>
+  getDefault();
+
+  /**
+   * @brief Sign @p data with a SHA-256 digest and return its full name
+   */
+  Name
+  sign(Data& data);
+
+  /**
+   * @brief Sign each of the @p packets with a SHA-256 digest and return their full names, in the
+   *        same order
+   */
+  std::vector<Name>
+  sign(const std::vector<Data*>& packets);
+
+  /**
+   * @brief Sign @p data as specified by @p params
+   *
+   * Packets signed with a SHA-256 digest are signed without the KeyChain.
+   */
+  void
+  sign(Data& data, const security::SigningInfo& params);
+
+private:
+  // Guards the construction and the use of the KeyChain
+  std::mutex                m_keyChainMutex;
+  // The KeyChain signing with a key (null until first needed)
+  std::shared_ptr<KeyChain> m_keyChain;
+};
+
+} // namespace ntorrent
+} // namespace ndn
+
+#endif // INCLUDED_UTIL_SIGNING_SERVICE_HPP
@@ -0,0 +1,162 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+* Copyright (c) 2016 Regents of the University of California.
+*
+* This file is part of the nTorrent codebase.
+*
+* nTorrent is free software: you can redistribute it and/or modify it under the
+* terms of the GNU Lesser General Public License as published by the Free Software
+* Foundation, either version 3 of the License, or (at your option) any later version.
+*
+* nTorrent is distributed in the hope that it will be useful, but WITHOUT ANY
+* WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+* PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+*
+* You should have received copies of the GNU General Public License and GNU Lesser
+* General Public License along with nTorrent, e.g., in COPYING.md file. If not, see
+* <http://www.gnu.org/licenses/>.
+*
+* See AUTHORS for complete list of nTorrent authors and contributors.
+*/
+
+#include "util/thread-pool.hpp"
+
+namespace ndn {
+namespace ntorrent {
+
+ThreadPool::ThreadPool(size_t numThreads)
+  : m_stopped(false)
+{
+  m_threads.reserve(numThreads);
+  for (size_t i = 0; i < numThreads; ++i) {
+    m_threads.emplace_back(&ThreadPool::workerLoop, this);
+  }
+}
+
+ThreadPool::~ThreadPool()
+{
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stopped = true;
+  }
+  m_changed.notify_all();
+  for (auto& t : m_threads) {
+    t.join();
+  }
+}
+
+size_t
+ThreadPool::defaultNumThreads()
+{
+  auto n = std::thread::hardware_concurrency();
+  return 0 == n ? 1 : n;
+}
+
+void
+ThreadPool::run(std::vector<Task> tasks)
+{
+  if (tasks.empty()) {
+    return;
+  }
+  if (m_threads.empty()) {
+    std::exception_ptr error;
+    for (auto& t : tasks) {
+      try {
+        t();
+      }
+      catch (...) {
+        if (!error) {
+          error = std::current_exception();
+        }
+      }
+    }
+    if (error) {
+      std::rethrow_exception(error);
+    }
+    return;
+  }
+  auto batch = std::make_shared<Batch>();
+  batch->remaining = tasks.size();
+  std::unique_lock<std::mutex> lock(m_mutex);
+  for (auto& t : tasks) {
+    m_queue.emplace_back(std::move(t), batch);
+  }
+  // wake up the idle workers as well as the threads waiting in 'run', so that they help too
+  m_changed.notify_all();
+  // help with the queued tasks until all the tasks of this batch are completed
+  while (0 != batch->remaining) {
+    if (!runOne(lock)) {
+      m_changed.wait(lock);
+    }
+  }
+  if (batch->error) {
+    std::rethrow_exception(batch->error);
+  }
+}
+
+void
+ThreadPool::post(Task task)
+{
+  if (m_threads.empty()) {
+    try {
+      task();
+    }
+    catch (...) {
+    }
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_queue.emplace_back(std::move(task), nullptr);
+  }
+  m_changed.notify_one();
+}
+
+void
+ThreadPool::workerLoop()
+{
+  std::unique_lock<std::mutex> lock(m_mutex);
+  while (true) {
+    if (runOne(lock)) {
+      continue;
+    }
+    if (m_stopped) {
+      return;
+    }
+    m_changed.wait(lock);
+  }
+}
+
+bool
+ThreadPool::runOne(std::unique_lock<std::mutex>& lock)
+{
+  if (m_queue.empty()) {
+    return false;
+  }
+  auto entry = std::move(m_queue.front());
+  m_queue.pop_front();
+  lock.unlock();
+  std::exception_ptr error;
+  try {
+    entry.first();
+  }
+  catch (...) {
+    error = std::current_exception();
+  }
+  lock.lock();
+  if (nullptr == entry.second) {
+    return true;
+  }
+  auto& batch = *entry.second;
+  if (error && !batch.error) {
+    batch.error = error;
+  }
+  --batch.remaining;
+  if (0 == batch.remaining) {
+    m_changed.notify_all();
+  }
+  return true;
+}
+
+} // namespace ntorrent
+} // namespace ndn
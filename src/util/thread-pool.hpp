@@ -0,0 +1,130 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+* Copyright (c) 2016 Regents of the University of California.
+*
+* This file is part of the nTorrent codebase.
+*
+* nTorrent is free software: you can redistribute it and/or modify it under the
+* terms of the GNU Lesser General Public License as published by the Free Software
+* Foundation, either version 3 of the License, or (at your option) any later version.
+*
+* nTorrent is distributed in the hope that it will be useful, but WITHOUT ANY
+* WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+* PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+*
+* You should have received copies of the GNU General Public License and GNU Lesser
+* General Public License along with nTorrent, e.g., in COPYING.md file. If not, see
+* <http://www.gnu.org/licenses/>.
+*
+* See AUTHORS for complete list of nTorrent authors and contributors.
+*/
+
+#ifndef INCLUDED_UTIL_THREAD_POOL_HPP
+#define INCLUDED_UTIL_THREAD_POOL_HPP
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ndn {
+namespace ntorrent {
+
+/**
+ * @brief A fixed-size pool of worker threads running batches of independent tasks
+ *
+ * Tasks are submitted either in batches through 'run', which returns once every task of the batch
+ * has completed, or one at a time through 'post', which does not wait for the task. The calling
+ * thread executes queued tasks while it waits, so a task may itself call 'run' on the same pool
+ * without the risk of all workers blocking on each other. A pool with no worker threads runs every
+ * task on the calling thread, in order.
+ */
+class ThreadPool {
+public:
+  typedef std::function<void()> Task;
+
+  /**
+   * @brief Create a pool with @p numThreads worker threads
+   */
+  explicit
+  ThreadPool(size_t numThreads = defaultNumThreads());
+
+  /**
+   * @brief Run the queued tasks, then stop and join all the worker threads
+   * The behavior is undefined if any call to 'run' is in progress.
+   */
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool&) = delete;
+
+  ThreadPool&
+  operator=(const ThreadPool&) = delete;
+
+  /**
+   * @brief Run all the @p tasks and wait for them to complete
+   * @param tasks The tasks to be run. There are no guarantees on the order in which they run.
+   * @throws The first exception thrown by any of the tasks, once all of them have completed
+   */
+  void
+  run(std::vector<Task> tasks);
+
+  /**
+   * @brief Queue @p task to be run by a worker thread and return immediately
+   * A pool with no worker threads runs the task on the calling thread before returning. Exceptions
+   * escaping a posted task are discarded, so tasks are expected to handle their own errors.
+   */
+  void
+  post(Task task);
+
+  /**
+   * @brief Return the number of worker threads of this pool
+   */
+  size_t
+  size() const;
+
+  /**
+   * @brief Return the number of hardware threads available, or 1 if it cannot be determined
+   */
+  static size_t
+  defaultNumThreads();
+
+private:
+  // The completion state of a set of tasks passed to 'run' (null for posted tasks)
+  struct Batch {
+    size_t             remaining;
+    std::exception_ptr error;
+  };
+
+  void
+  workerLoop();
+
+  // Pop and execute a task of the queue, return false if the queue is empty
+  // The behavior is undefined unless m_mutex is locked by @p lock.
+  bool
+  runOne(std::unique_lock<std::mutex>& lock);
+
+private:
+  typedef std::pair<Task, std::shared_ptr<Batch>> QueueEntry;
+
+  std::vector<std::thread>  m_threads;
+  std::deque<QueueEntry>    m_queue;
+  std::mutex                m_mutex;
+  // signaled when tasks are queued, when a batch completes and when the pool is stopped
+  std::condition_variable   m_changed;
+  bool                      m_stopped;
+};
+
+inline size_t
+ThreadPool::size() const
+{
+  return m_threads.size();
+}
+
+} // namespace ntorrent
+} // namespace ndn
+
+#endif // INCLUDED_UTIL_THREAD_POOL_HPP
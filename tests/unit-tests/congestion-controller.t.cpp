@@ -0,0 +1,134 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+* Copyright (c) 2016 Regents of the University of California.
+*
+* This file is part of the nTorrent codebase.
+*
+* nTorrent is free software: you can redistribute it and/or modify it under the
+* terms of the GNU Lesser General Public License as published by the Free Software
+* Foundation, either version 3 of the License, or (at your option) any later version.
+*
+* nTorrent is distributed in the hope that it will be useful, but WITHOUT ANY
+* WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+* PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+*
+* You should have received copies of the GNU General Public License and GNU Lesser
+* General Public License along with nTorrent, e.g., in COPYING.md file. If not, see
+* <http://www.gnu.org/licenses/>.
+*
+* See AUTHORS for complete list of nTorrent authors and contributors.
+*/
+
+#include "boost-test.hpp"
+#include "congestion-controller.hpp"
+#include "unit-test-time-fixture.hpp"
+
+namespace ndn {
+namespace ntorrent {
+namespace tests {
+
+BOOST_FIXTURE_TEST_SUITE(TestCongestionController, UnitTestTimeFixture)
+
+BOOST_AUTO_TEST_CASE(TestCreate)
+{
+  BOOST_CHECK(nullptr != dynamic_cast<AimdCongestionController*>(
+                           CongestionController::create("aimd").get()));
+  BOOST_CHECK(nullptr != dynamic_cast<CubicCongestionController*>(
+                           CongestionController::create("cubic").get()));
+  BOOST_CHECK_THROW(CongestionController::create("reno"), CongestionController::Error);
+
+  auto controller = CongestionController::create("aimd", 4);
+  BOOST_CHECK_EQUAL(controller->getWindow(), 4);
+}
+
+BOOST_AUTO_TEST_CASE(TestAimd)
+{
+  AimdCongestionController controller(100);
+  const time::milliseconds rtt(10);
+  BOOST_CHECK_EQUAL(controller.getWindow(), CongestionController::INITIAL_WINDOW);
+
+  // slow start: one more Interest per Data packet, up to the maximum window
+  for (int i = 0; i < 200; ++i) {
+    controller.onData(rtt);
+  }
+  BOOST_CHECK_EQUAL(controller.getWindow(), 100);
+  BOOST_CHECK(controller.getSmoothedRtt() == rtt);
+
+  // the losses of one round-trip time halve the window once
+  controller.onLoss();
+  controller.onLoss();
+  BOOST_CHECK_EQUAL(controller.getWindow(), 50);
+  BOOST_CHECK_EQUAL(controller.getSlowStartThreshold(), 50);
+  advanceClocks(rtt);
+  controller.onLoss();
+  BOOST_CHECK_EQUAL(controller.getWindow(), 25);
+
+  // congestion avoidance: one more Interest per round-trip time
+  for (int i = 0; i < 25; ++i) {
+    controller.onData(rtt);
+  }
+  BOOST_CHECK_EQUAL(controller.getWindow(), 25);
+  for (int i = 0; i < 2; ++i) {
+    controller.onData(rtt);
+  }
+  BOOST_CHECK_EQUAL(controller.getWindow(), 26);
+
+  // the window never drops below one Interest
+  for (int i = 0; i < 20; ++i) {
+    advanceClocks(rtt);
+    controller.onLoss();
+  }
+  BOOST_CHECK_EQUAL(controller.getWindow(), 1);
+  BOOST_CHECK_GE(controller.getCongestionWindow(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(TestCubic)
+{
+  CubicCongestionController controller(1000);
+  const time::milliseconds rtt(100);
+  for (int i = 0; i < 90; ++i) {
+    controller.onData(rtt);
+  }
+  BOOST_CHECK_EQUAL(controller.getWindow(), 100);
+
+  controller.onLoss();
+  BOOST_CHECK_EQUAL(controller.getWindow(), 70);
+
+  // the window grows back close to the window of the congestion event...
+  double lastWindow = controller.getCongestionWindow();
+  for (int round = 0; round < 30; ++round) {
+    for (size_t i = controller.getWindow(); i > 0; --i) {
+      controller.onData(rtt);
+    }
+    advanceClocks(rtt);
+    BOOST_CHECK_GE(controller.getCongestionWindow(), lastWindow);
+    lastWindow = controller.getCongestionWindow();
+  }
+  BOOST_CHECK_GT(controller.getWindow(), 90);
+  BOOST_CHECK_LT(controller.getWindow(), 110);
+
+  // ...and then probes for more bandwidth
+  for (int round = 0; round < 100; ++round) {
+    for (size_t i = controller.getWindow(); i > 0; --i) {
+      controller.onData(rtt);
+    }
+    advanceClocks(rtt);
+  }
+  BOOST_CHECK_GT(controller.getWindow(), 150);
+
+  // fast convergence: a second loss before the window grows back lowers the target
+  CubicCongestionController other(1000);
+  for (int i = 0; i < 90; ++i) {
+    other.onData(rtt);
+  }
+  other.onLoss();
+  advanceClocks(rtt);
+  other.onLoss();
+  BOOST_CHECK_EQUAL(other.getWindow(), 49);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+} // namespace tests
+} // namespace ntorrent
+} // namespace ndn
@@ -0,0 +1,113 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+* Copyright (c) 2016 Regents of the University of California.
+*
+* This file is part of the nTorrent codebase.
+*
+* nTorrent is free software: you can redistribute it and/or modify it under the
+* terms of the GNU Lesser General Public License as published by the Free Software
+* Foundation, either version 3 of the License, or (at your option) any later version.
+*
+* nTorrent is distributed in the hope that it will be useful, but WITHOUT ANY
+* WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+* PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+*
+* You should have received copies of the GNU General Public License and GNU Lesser
+* General Public License along with nTorrent, e.g., in COPYING.md file. If not, see
+* <http://www.gnu.org/licenses/>.
+*
+* See AUTHORS for complete list of nTorrent authors and contributors.
+*/
+
+#include "boost-test.hpp"
+#include "data-packet-cache.hpp"
+
+#include <ndn-cxx/data.hpp>
+#include <ndn-cxx/security/key-chain.hpp>
+#include <ndn-cxx/security/signing-helpers.hpp>
+
+namespace ndn {
+namespace ntorrent {
+namespace tests {
+
+static shared_ptr<Data>
+createPacket(const Name& name, size_t contentSize)
+{
+  static security::KeyChain keyChain;
+  std::vector<uint8_t> content(contentSize, 'a');
+  auto d = make_shared<Data>(name);
+  d->setContent(content.data(), content.size());
+  keyChain.sign(*d, signingWithSha256());
+  return d;
+}
+
+BOOST_AUTO_TEST_SUITE(TestDataPacketCache)
+
+BOOST_AUTO_TEST_CASE(TestFindInsert)
+{
+  DataPacketCache cache;
+  auto d1 = createPacket(Name("/test/ucla/1"), 100);
+  auto d2 = createPacket(Name("/test/ucla/2"), 100);
+
+  BOOST_CHECK(nullptr == cache.find(d1->getFullName()));
+  BOOST_CHECK_EQUAL(cache.getMisses(), 1);
+
+  cache.insert(d1->getFullName(), d1);
+  cache.insert(d2->getFullName(), d2);
+  BOOST_CHECK_EQUAL(cache.size(), 2);
+  BOOST_CHECK_EQUAL(cache.bytes(), d1->wireEncode().size() + d2->wireEncode().size());
+
+  BOOST_CHECK(*d1 == *cache.find(d1->getFullName()));
+  BOOST_CHECK(*d2 == *cache.find(d2->getFullName()));
+  BOOST_CHECK_EQUAL(cache.getHits(), 2);
+  BOOST_CHECK_EQUAL(cache.getMisses(), 1);
+
+  BOOST_CHECK(cache.erase(d1->getFullName()));
+  BOOST_CHECK(!cache.erase(d1->getFullName()));
+  BOOST_CHECK(nullptr == cache.find(d1->getFullName()));
+  BOOST_CHECK_EQUAL(cache.size(), 1);
+  BOOST_CHECK_EQUAL(cache.bytes(), d2->wireEncode().size());
+
+  cache.clear();
+  BOOST_CHECK_EQUAL(cache.size(), 0);
+  BOOST_CHECK_EQUAL(cache.bytes(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(TestLruEviction)
+{
+  auto d1 = createPacket(Name("/test/ucla/1"), 100);
+  auto d2 = createPacket(Name("/test/ucla/2"), 100);
+  auto d3 = createPacket(Name("/test/ucla/3"), 100);
+  auto packetSize = d1->wireEncode().size();
+
+  // room for exactly two packets
+  DataPacketCache cache(2 * packetSize);
+  cache.insert(d1->getFullName(), d1);
+  cache.insert(d2->getFullName(), d2);
+
+  // touch d1, so that d2 becomes the least recently used packet
+  BOOST_CHECK(nullptr != cache.find(d1->getFullName()));
+  cache.insert(d3->getFullName(), d3);
+
+  BOOST_CHECK_EQUAL(cache.size(), 2);
+  BOOST_CHECK(nullptr != cache.find(d1->getFullName()));
+  BOOST_CHECK(nullptr == cache.find(d2->getFullName()));
+  BOOST_CHECK(nullptr != cache.find(d3->getFullName()));
+
+  // shrinking the cache evicts the least recently used packets
+  cache.setCapacity(packetSize);
+  BOOST_CHECK_EQUAL(cache.size(), 1);
+  BOOST_CHECK(nullptr != cache.find(d3->getFullName()));
+
+  // packets larger than the capacity are never cached
+  auto big = createPacket(Name("/test/ucla/big"), 1000);
+  cache.insert(big->getFullName(), big);
+  BOOST_CHECK(nullptr == cache.find(big->getFullName()));
+  BOOST_CHECK(nullptr != cache.find(d3->getFullName()));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+} // namespace tests
+} // namespace ntorrent
+} // namespace ndn
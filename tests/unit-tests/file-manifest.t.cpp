@@ -21,6 +21,7 @@
 
 #include "file-manifest.hpp"
 #include "boost-test.hpp"
+#include "util/thread-pool.hpp"
 
 #include <vector>
 
@@ -322,6 +323,84 @@ BOOST_AUTO_TEST_CASE(CheckEncodeDecode)
   }
 }
 
+BOOST_AUTO_TEST_CASE(CheckLazyCatalog)
+{
+  FileManifest m1("/file0/1A2B3C4D",
+                  256,
+                  "/foo/",
+                  {"/foo/0/ABC123",  "/foo/1/DEADBEFF", "/foo/2/CAFEBABE"},
+                  std::make_shared<Name>("/file0/1/5E6F7G8H"));
+  KeyChain keyChain;
+  m1.finalize();
+  keyChain.sign(m1);
+
+  // the names of a decoded catalog can be accessed one at a time
+  FileManifest m2(m1.wireEncode());
+  BOOST_REQUIRE_EQUAL(m2.catalog_size(), 3);
+  for (size_t i = 0; i < m2.catalog_size(); ++i) {
+    BOOST_CHECK_EQUAL(m2.catalog_name(i), m1.catalog()[i]);
+  }
+  // copies share the undecoded catalog
+  FileManifest m3 = m2;
+  BOOST_CHECK_EQUAL(m3, m1);
+  BOOST_CHECK_EQUAL(m3.catalog_name(2), Name("/foo/2/CAFEBABE"));
+  BOOST_CHECK_EQUAL(vector<Name>({"/foo/0/ABC123", "/foo/1/DEADBEFF", "/foo/2/CAFEBABE"}),
+                    m3.catalog());
+  BOOST_CHECK_EQUAL(m3.catalog_size(), 3);
+
+  // modifying a decoded catalog decodes it first
+  m2.push_back("/foo/3/FEEDFACE");
+  BOOST_CHECK_EQUAL(vector<Name>({"/foo/0/ABC123", "/foo/1/DEADBEFF", "/foo/2/CAFEBABE",
+                                  "/foo/3/FEEDFACE"}),
+                    m2.catalog());
+  FileManifest m4(m1.wireEncode());
+  BOOST_CHECK(m4.remove("/foo/1/DEADBEFF"));
+  BOOST_CHECK_EQUAL(vector<Name>({"/foo/0/ABC123", "/foo/2/CAFEBABE"}), m4.catalog());
+  m4.finalize();
+  keyChain.sign(m4);
+  BOOST_CHECK_EQUAL(m4, FileManifest(m4.wireEncode()));
+
+  // the catalog of a generated manifest survives the round trip
+  auto manifests = FileManifest::generate("tests/testdata/foo/bar1.txt",
+                                          "/ndn/multicast/NTORRENT/foo/",
+                                          100,
+                                          100);
+  for (const auto& m : manifests) {
+    FileManifest decoded(m.wireEncode());
+    BOOST_REQUIRE_EQUAL(decoded.catalog_size(), m.catalog_size());
+    for (size_t i = 0; i < decoded.catalog_size(); ++i) {
+      BOOST_CHECK_EQUAL(decoded.catalog_name(i), m.catalog_name(i));
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(CheckConcurrentCatalogDecode)
+{
+  auto manifests = FileManifest::generate("tests/testdata/foo/bar1.txt",
+                                          "/ndn/multicast/NTORRENT/foo/",
+                                          100,
+                                          100);
+  FileManifest decoded(manifests[0].wireEncode());
+  // the copies used by several threads decode the shared catalog once
+  const size_t numTasks = 8;
+  std::vector<const Name*> firstNames(numTasks);
+  std::vector<char> isEqual(numTasks, false);
+  std::vector<ThreadPool::Task> tasks;
+  for (size_t task = 0; task < numTasks; ++task) {
+    tasks.emplace_back([&, task] {
+      FileManifest copy = decoded;
+      firstNames[task] = &copy.catalog_name(0);
+      isEqual[task] = copy.catalog() == manifests[0].catalog();
+    });
+  }
+  ThreadPool pool(4);
+  pool.run(std::move(tasks));
+  for (size_t task = 0; task < numTasks; ++task) {
+    BOOST_CHECK(isEqual[task]);
+    BOOST_CHECK_EQUAL(firstNames[task], &decoded.catalog_name(0));
+  }
+}
+
 BOOST_AUTO_TEST_CASE(CheckGenerateFileManifest)
 {
   const size_t TEST_FILE_LEN = fs::file_size("tests/testdata/foo/bar.txt");
@@ -460,6 +539,72 @@ BOOST_AUTO_TEST_CASE(CheckGenerateFileManifest)
   }
 }
 
+BOOST_AUTO_TEST_CASE(CheckSubManifestIndex)
+{
+  ThreadPool pool(0);
+  // a fanout of at least the number of sub-manifests lists all of them in the first one
+  auto manifests = FileManifest::generate("tests/testdata/foo/bar1.txt",
+                                          "/ndn/multicast/NTORRENT/foo/",
+                                          100,
+                                          100,
+                                          false,
+                                          pool,
+                                          100).first;
+  BOOST_REQUIRE_GT(manifests.size(), 2);
+
+  // the first sub-manifest lists all the others, which are still chained
+  const auto& index = manifests[0].submanifest_index();
+  BOOST_REQUIRE_EQUAL(index.size(), manifests.size() - 1);
+  for (size_t i = 1; i < manifests.size(); ++i) {
+    BOOST_CHECK_EQUAL(index[i - 1], manifests[i].getFullName());
+    BOOST_CHECK(manifests[i].submanifest_index().empty());
+  }
+  BOOST_CHECK_EQUAL(*manifests[0].submanifest_ptr(), manifests[1].getFullName());
+
+  // the index is carried in the meta info, leaving the content as it is without it
+  FileManifest decoded(manifests[0].wireEncode());
+  BOOST_CHECK_EQUAL(decoded, manifests[0]);
+  BOOST_CHECK(decoded.submanifest_index() == index);
+  auto unindexed = FileManifest::generate("tests/testdata/foo/bar1.txt",
+                                          "/ndn/multicast/NTORRENT/foo/",
+                                          100,
+                                          100);
+  BOOST_CHECK(unindexed[0].submanifest_index().empty());
+  BOOST_CHECK(unindexed[0].getContent() == manifests[0].getContent());
+  BOOST_CHECK_EQUAL(unindexed.back().getFullName(), manifests.back().getFullName());
+}
+
+BOOST_AUTO_TEST_CASE(CheckSubManifestIndexTree)
+{
+  ThreadPool pool(0);
+  const size_t fanout = 3;
+  auto manifests = FileManifest::generate("tests/testdata/foo/bar1.txt",
+                                          "/ndn/multicast/NTORRENT/foo/",
+                                          10,
+                                          100,
+                                          false,
+                                          pool,
+                                          fanout).first;
+  BOOST_REQUIRE_GT(manifests.size(), fanout * fanout);
+
+  // each sub-manifest lists its children, and every other sub-manifest is listed exactly once
+  std::vector<size_t> listed(manifests.size(), 0);
+  for (size_t i = 0; i < manifests.size(); ++i) {
+    const auto& index = manifests[i].submanifest_index();
+    BOOST_CHECK_LE(index.size(), fanout);
+    for (size_t j = 0; j < index.size(); ++j) {
+      BOOST_REQUIRE_LT(fanout * i + 1 + j, manifests.size());
+      BOOST_CHECK_EQUAL(index[j], manifests[fanout * i + 1 + j].getFullName());
+      ++listed[fanout * i + 1 + j];
+    }
+    BOOST_CHECK(FileManifest(manifests[i].wireEncode()).submanifest_index() == index);
+  }
+  BOOST_CHECK_EQUAL(listed[0], 0);
+  for (size_t i = 1; i < manifests.size(); ++i) {
+    BOOST_CHECK_EQUAL(listed[i], 1);
+  }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 } // namespace tests
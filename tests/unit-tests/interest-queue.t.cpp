@@ -0,0 +1,172 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+* Copyright (c) 2016 Regents of the University of California.
+*
+* This file is part of the nTorrent codebase.
+*
+* nTorrent is free software: you can redistribute it and/or modify it under the
+* terms of the GNU Lesser General Public License as published by the Free Software
+* Foundation, either version 3 of the License, or (at your option) any later version.
+*
+* nTorrent is distributed in the hope that it will be useful, but WITHOUT ANY
+* WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+* PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+*
+* You should have received copies of the GNU General Public License and GNU Lesser
+* General Public License along with nTorrent, e.g., in COPYING.md file. If not, see
+* <http://www.gnu.org/licenses/>.
+*
+* See AUTHORS for complete list of nTorrent authors and contributors.
+*/
+
+#include "boost-test.hpp"
+#include "interest-queue.hpp"
+
+namespace ndn {
+namespace ntorrent {
+namespace tests {
+
+BOOST_AUTO_TEST_SUITE(TestInterestQueue)
+
+BOOST_AUTO_TEST_CASE(TestPushPop)
+{
+  InterestQueue queue;
+  BOOST_CHECK(queue.empty());
+
+  int nData = 0;
+  int nTimeouts = 0;
+  auto context = queue.createContext([&nData] (const Interest&, const Data&) { ++nData; },
+                                     [&nTimeouts] (const Interest&) { ++nTimeouts; });
+  // more entries than the initial capacity, wrapping around the buffer
+  for (size_t i = 0; i < 10; ++i) {
+    queue.push(context, Name("/test/named").appendNumber(i));
+  }
+  for (size_t i = 0; i < 5; ++i) {
+    BOOST_CHECK_EQUAL(queue.getName(queue.front()), Name("/test/named").appendNumber(i));
+    queue.pop();
+  }
+  for (size_t i = 0; i < 20; ++i) {
+    queue.push(context, 1, i);
+  }
+  queue.releaseContext(context);
+  BOOST_CHECK_EQUAL(queue.size(), 25);
+
+  for (size_t i = 5; i < 10; ++i) {
+    const auto& entry = queue.front();
+    BOOST_CHECK_EQUAL(entry.type, InterestQueue::NAMED_ENTRY);
+    BOOST_CHECK_EQUAL(queue.getName(entry), Name("/test/named").appendNumber(i));
+    queue.pop();
+  }
+  // the callbacks are shared by the entries of the context
+  queue.getDataCallback(queue.front().context)(Interest(), Data());
+  queue.getTimeoutCallback(queue.front().context)(Interest());
+  BOOST_CHECK_EQUAL(nData, 1);
+  BOOST_CHECK_EQUAL(nTimeouts, 1);
+  for (size_t i = 0; i < 20; ++i) {
+    const auto& entry = queue.front();
+    BOOST_CHECK_EQUAL(entry.type, InterestQueue::CATALOG_ENTRY);
+    BOOST_CHECK_EQUAL(entry.index, 1);
+    BOOST_CHECK_EQUAL(entry.packetNum, i);
+    queue.pop();
+  }
+  BOOST_CHECK(queue.empty());
+}
+
+BOOST_AUTO_TEST_CASE(TestContextRelease)
+{
+  InterestQueue queue;
+  auto captured = std::make_shared<int>(0);
+  auto context = queue.createContext([captured] (const Interest&, const Data&) {},
+                                     [captured] (const Interest&) {});
+  queue.push(context, Name("/test/a"));
+  queue.push(context, Name("/test/b"));
+  queue.releaseContext(context);
+  BOOST_CHECK_EQUAL(captured.use_count(), 3);
+
+  // the context lives as long as its entries
+  queue.pop();
+  BOOST_CHECK_EQUAL(captured.use_count(), 3);
+  queue.pop();
+  BOOST_CHECK_EQUAL(captured.use_count(), 1);
+
+  // and is reused once released
+  auto next = queue.createContext(nullptr, nullptr);
+  BOOST_CHECK_EQUAL(next, context);
+}
+
+BOOST_AUTO_TEST_CASE(TestPriorities)
+{
+  InterestQueue queue;
+  auto context = queue.createContext(nullptr, nullptr);
+  // a backlog of data packets is queued before the metadata
+  for (size_t i = 0; i < 100; ++i) {
+    queue.push(context, 0, i);
+  }
+  queue.push(context, Name("/test/manifest/0"), InterestQueue::FILE_MANIFEST_PRIORITY);
+  queue.push(context, Name("/test/manifest/1"), InterestQueue::FILE_MANIFEST_PRIORITY);
+  queue.push(context, Name("/test/torrent-file"), InterestQueue::TORRENT_FILE_PRIORITY);
+  queue.releaseContext(context);
+  BOOST_CHECK_EQUAL(queue.size(), 103);
+  BOOST_CHECK_EQUAL(queue.size(InterestQueue::FILE_MANIFEST_PRIORITY), 2);
+
+  // the metadata goes out first
+  BOOST_CHECK_EQUAL(queue.getName(queue.front()), Name("/test/torrent-file"));
+  queue.pop();
+  BOOST_CHECK_EQUAL(queue.getName(queue.front()), Name("/test/manifest/0"));
+  queue.pop();
+  BOOST_CHECK_EQUAL(queue.getName(queue.front()), Name("/test/manifest/1"));
+  queue.pop();
+  for (size_t i = 0; i < 100; ++i) {
+    BOOST_CHECK_EQUAL(queue.front().packetNum, i);
+    queue.pop();
+  }
+  BOOST_CHECK(queue.empty());
+}
+
+BOOST_AUTO_TEST_CASE(TestWeightedFairness)
+{
+  InterestQueue queue;
+  auto context = queue.createContext(nullptr, nullptr);
+  for (size_t i = 0; i < 1000; ++i) {
+    queue.push(context, 0, i, InterestQueue::FILE_MANIFEST_PRIORITY);
+    queue.push(context, 1, i, InterestQueue::DATA_PRIORITY);
+    queue.push(context, 2, i, InterestQueue::LOW_DATA_PRIORITY);
+  }
+  queue.releaseContext(context);
+
+  // the classes share the pops in proportion to their weights, none of them is starved
+  size_t counts[3] = {0, 0, 0};
+  for (size_t i = 0; i < 110; ++i) {
+    ++counts[queue.front().index];
+    queue.pop();
+  }
+  BOOST_CHECK_EQUAL(counts[0], 80);
+  BOOST_CHECK_EQUAL(counts[1], 20);
+  BOOST_CHECK_EQUAL(counts[2], 10);
+}
+
+BOOST_AUTO_TEST_CASE(TestBitmapPriority)
+{
+  InterestQueue queue;
+  auto context = queue.createContext(nullptr, nullptr);
+  auto peerContext = queue.createContext(nullptr, nullptr, Name("/ucla"));
+  queue.push(peerContext, Name("/test/BITMAP/0"), InterestQueue::BITMAP_PRIORITY);
+  queue.push(context, 0, 0, InterestQueue::LOW_DATA_PRIORITY);
+  queue.releaseContext(context);
+  queue.releaseContext(peerContext);
+
+  // the bitmaps are the lowest priority, and are sent to the peer of their context
+  BOOST_CHECK_EQUAL(queue.front().type, InterestQueue::CATALOG_ENTRY);
+  BOOST_CHECK(queue.getForwardingHint(queue.front().context).empty());
+  queue.pop();
+  BOOST_CHECK_EQUAL(queue.getName(queue.front()), Name("/test/BITMAP/0"));
+  BOOST_CHECK_EQUAL(queue.getForwardingHint(queue.front().context), Name("/ucla"));
+  queue.pop();
+  BOOST_CHECK(queue.empty());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+} // namespace tests
+} // namespace ntorrent
+} // namespace ndn
@@ -0,0 +1,196 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+* Copyright (c) 2016 Regents of the University of California.
+*
+* This file is part of the nTorrent codebase.
+*
+* nTorrent is free software: you can redistribute it and/or modify it under the
+* terms of the GNU Lesser General Public License as published by the Free Software
+* Foundation, either version 3 of the License, or (at your option) any later version.
+*
+* nTorrent is distributed in the hope that it will be useful, but WITHOUT ANY
+* WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+* PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+*
+* You should have received copies of the GNU General Public License and GNU Lesser
+* General Public License along with nTorrent, e.g., in COPYING.md file. If not, see
+* <http://www.gnu.org/licenses/>.
+*
+* See AUTHORS for complete list of nTorrent authors and contributors.
+*/
+
+#include "boost-test.hpp"
+#include "packet-signature-store.hpp"
+
+#include "file-manifest.hpp"
+#include "util/io-util.hpp"
+
+#include <boost/filesystem.hpp>
+#include <boost/filesystem/fstream.hpp>
+
+namespace ndn {
+namespace ntorrent {
+namespace tests {
+
+namespace fs = boost::filesystem;
+
+BOOST_AUTO_TEST_SUITE(TestPacketSignatureStore)
+
+BOOST_AUTO_TEST_CASE(TestInsertFindFlush)
+{
+  const std::string storePath = ".appdata/foo/signatures/";
+  const std::string dataPath = "tests/testdata/";
+  const std::string filePath = "tests/testdata/foo/bar1.txt";
+  const size_t subManifestSize = 16;
+  auto manifestsDataPair = FileManifest::generate(filePath,
+                                                  "/ndn/multicast/NTORRENT/foo/",
+                                                  subManifestSize,
+                                                  1024,
+                                                  true);
+  const auto& manifests = manifestsDataPair.first;
+  const auto& data = manifestsDataPair.second;
+  const auto& manifest = manifests[1];
+
+  {
+    PacketSignatureStore store(storePath, dataPath);
+    BOOST_CHECK(nullptr == store.find(manifest, 0));
+    for (size_t i = 0; i < manifest.catalog().size(); ++i) {
+      store.insert(manifest, i, data[subManifestSize + i]);
+    }
+    BOOST_CHECK(store.flush());
+  }
+  // the signatures are reloaded from disk by a new store
+  PacketSignatureStore store(storePath, dataPath);
+  BOOST_CHECK(nullptr == store.find(manifests[0], 0));
+  BOOST_CHECK(nullptr == store.find(manifest, manifest.catalog().size()));
+  for (size_t i = 0; i < manifest.catalog().size(); ++i) {
+    const auto& packet = data[subManifestSize + i];
+    auto signatureValue = store.find(manifest, i);
+    BOOST_REQUIRE(nullptr != signatureValue);
+    BOOST_CHECK(*signatureValue == packet.getSignature().getValue());
+
+    // a packet rebuilt with the stored signature is identical to the original one
+    auto d = IoUtil::readDataPacket(packet.getFullName(), manifest, subManifestSize, filePath,
+                                    *signatureValue);
+    BOOST_REQUIRE(nullptr != d);
+    BOOST_CHECK_EQUAL(d->getFullName(), packet.getFullName());
+    BOOST_CHECK(*d == packet);
+  }
+  fs::remove_all(".appdata");
+}
+
+BOOST_AUTO_TEST_CASE(TestInsertSignatureValues)
+{
+  const size_t subManifestSize = 16;
+  auto manifestsDataPair = FileManifest::generate("tests/testdata/foo/bar1.txt",
+                                                  "/ndn/multicast/NTORRENT/foo/",
+                                                  subManifestSize,
+                                                  1024,
+                                                  true);
+  const auto& manifest = manifestsDataPair.first[1];
+  const auto& data = manifestsDataPair.second;
+
+  // the signatures of every other packet, collected before inserting them at once
+  PacketSignatureStore::SignatureValues signatures;
+  for (size_t i = 0; i < manifest.catalog().size(); i += 2) {
+    PacketSignatureStore::SignatureValue value;
+    BOOST_REQUIRE(PacketSignatureStore::getSignatureValue(data[subManifestSize + i], value));
+    signatures.emplace_back(i, value);
+  }
+  PacketSignatureStore store(".appdata/foo/signatures/", "tests/testdata/");
+  store.insert(manifest, signatures);
+  for (size_t i = 0; i < manifest.catalog().size(); ++i) {
+    auto signatureValue = store.find(manifest, i);
+    if (0 == i % 2) {
+      BOOST_REQUIRE(nullptr != signatureValue);
+      BOOST_CHECK(*signatureValue == data[subManifestSize + i].getSignature().getValue());
+    }
+    else {
+      BOOST_CHECK(nullptr == signatureValue);
+    }
+  }
+  fs::remove_all(".appdata");
+}
+
+BOOST_AUTO_TEST_CASE(TestTakeWrites)
+{
+  const size_t subManifestSize = 16;
+  auto manifestsDataPair = FileManifest::generate("tests/testdata/foo/bar1.txt",
+                                                  "/ndn/multicast/NTORRENT/foo/",
+                                                  subManifestSize,
+                                                  1024,
+                                                  true);
+  const auto& manifests = manifestsDataPair.first;
+  const auto& data = manifestsDataPair.second;
+
+  PacketSignatureStore store(".appdata/foo/signatures/", "tests/testdata/");
+  BOOST_CHECK(!store.isDirty());
+  BOOST_CHECK(store.takeWrites().empty());
+  store.insert(manifests[0], 0, data[0]);
+  BOOST_CHECK(store.isDirty());
+  BOOST_CHECK(store.flush());
+  BOOST_CHECK(!store.isDirty());
+
+  // the signatures already written of the same file are taken again, as the file changed
+  store.insert(manifests[1], 0, data[subManifestSize]);
+  auto writes = store.takeWrites();
+  BOOST_CHECK(!store.isDirty());
+  BOOST_REQUIRE_EQUAL(writes.size(), 2);
+  for (auto& write : writes) {
+    BOOST_CHECK_EQUAL(write.dataPath, "tests/testdata/" + manifests[0].file_name());
+    // a file that cannot be replaced is reported, to be marked dirty
+    write.path = "/dev/null/signatures";
+  }
+  auto failedManifests = store.write(writes);
+  BOOST_CHECK_EQUAL(failedManifests.size(), 2);
+  for (const auto& manifestName : failedManifests) {
+    store.markDirty(manifestName);
+  }
+  BOOST_CHECK(store.isDirty());
+  BOOST_CHECK(store.flush());
+  fs::remove_all(".appdata");
+}
+
+BOOST_AUTO_TEST_CASE(TestChangedFile)
+{
+  const std::string storePath = ".appdata/foo/signatures/";
+  const std::string dataPath = ".appdata/foo/data/";
+  const std::string filePath = dataPath + "foo/bar1.txt";
+  fs::create_directories(dataPath + "foo");
+  fs::copy_file("tests/testdata/foo/bar1.txt", filePath);
+  const size_t subManifestSize = 16;
+  auto manifestsDataPair = FileManifest::generate(filePath,
+                                                  "/ndn/multicast/NTORRENT/foo/",
+                                                  subManifestSize,
+                                                  1024,
+                                                  true);
+  const auto& manifest = manifestsDataPair.first[1];
+  const auto& data = manifestsDataPair.second;
+  {
+    PacketSignatureStore store(storePath, dataPath);
+    for (size_t i = 0; i < manifest.catalog().size(); ++i) {
+      store.insert(manifest, i, data[subManifestSize + i]);
+    }
+    BOOST_CHECK(store.flush());
+  }
+  {
+    PacketSignatureStore store(storePath, dataPath);
+    BOOST_CHECK(nullptr != store.find(manifest, 0));
+  }
+  // the file is modified on disk, so its stored signatures no longer match its bytes
+  {
+    fs::ofstream os(filePath, fs::ofstream::binary | fs::ofstream::app);
+    os << 'x';
+  }
+  PacketSignatureStore store(storePath, dataPath);
+  for (size_t i = 0; i < manifest.catalog().size(); ++i) {
+    BOOST_CHECK(nullptr == store.find(manifest, i));
+  }
+  fs::remove_all(".appdata");
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+} // namespace tests
+} // namespace ntorrent
+} // namespace ndn
@@ -0,0 +1,166 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+* Copyright (c) 2016 Regents of the University of California.
+*
+* This file is part of the nTorrent codebase.
+*
+* nTorrent is free software: you can redistribute it and/or modify it under the
+* terms of the GNU Lesser General Public License as published by the Free Software
+* Foundation, either version 3 of the License, or (at your option) any later version.
+*
+* nTorrent is distributed in the hope that it will be useful, but WITHOUT ANY
+* WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+* PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+*
+* You should have received copies of the GNU General Public License and GNU Lesser
+* General Public License along with nTorrent, e.g., in COPYING.md file. If not, see
+* <http://www.gnu.org/licenses/>.
+*
+* See AUTHORS for complete list of nTorrent authors and contributors.
+*/
+
+#include "boost-test.hpp"
+#include "piece-availability.hpp"
+
+#include <ndn-cxx/name.hpp>
+
+#include <algorithm>
+#include <set>
+
+namespace ndn {
+namespace ntorrent {
+namespace tests {
+
+static Name
+packetName(const Name& manifestName, size_t packetIndex)
+{
+  // .../<file_name>/<submanifest_num>/<packet_num>/<implicit_digest>
+  return Name(manifestName).appendSequenceNumber(packetIndex).append("digest");
+}
+
+BOOST_AUTO_TEST_SUITE(TestPieceAvailability)
+
+BOOST_AUTO_TEST_CASE(TestUpdate)
+{
+  PieceAvailability availability;
+  Name manifest("/foo/bar.txt/%00");
+  BOOST_CHECK_EQUAL(availability.getAvailability(manifest, 0), 0);
+
+  availability.update(Name("/isp1"), manifest, { true, true, false, false });
+  availability.update(Name("/isp2"), manifest, { true, false, true });
+  BOOST_CHECK_EQUAL(availability.size(), 1);
+  BOOST_CHECK_EQUAL(availability.getAvailability(manifest, 0), 2);
+  BOOST_CHECK_EQUAL(availability.getAvailability(manifest, 1), 1);
+  BOOST_CHECK_EQUAL(availability.getAvailability(manifest, 2), 1);
+  BOOST_CHECK_EQUAL(availability.getAvailability(manifest, 3), 0);
+  BOOST_CHECK_EQUAL(availability.getAvailability(manifest, 4), 0);
+  BOOST_CHECK_EQUAL(availability.getAvailability(Name("/foo/bar.txt/%01"), 0), 0);
+
+  // a new bitmap replaces the old one
+  availability.update(Name("/isp1"), manifest, { false, true, true, true });
+  BOOST_CHECK_EQUAL(availability.getAvailability(manifest, 0), 1);
+  BOOST_CHECK_EQUAL(availability.getAvailability(manifest, 1), 1);
+  BOOST_CHECK_EQUAL(availability.getAvailability(manifest, 2), 2);
+  BOOST_CHECK_EQUAL(availability.getAvailability(manifest, 3), 1);
+
+  // adding a packet the peer is known to have changes nothing
+  availability.addPacket(Name("/isp2"), manifest, 0);
+  availability.addPacket(Name("/isp2"), manifest, 3);
+  availability.addPacket(Name("/isp3"), manifest, 5);
+  BOOST_CHECK_EQUAL(availability.getAvailability(manifest, 0), 1);
+  BOOST_CHECK_EQUAL(availability.getAvailability(manifest, 3), 2);
+  BOOST_CHECK_EQUAL(availability.getAvailability(manifest, 5), 1);
+
+  auto peers = availability.getPeers(manifest, 3);
+  std::sort(peers.begin(), peers.end());
+  BOOST_REQUIRE_EQUAL(peers.size(), 2);
+  BOOST_CHECK_EQUAL(peers[0], Name("/isp1"));
+  BOOST_CHECK_EQUAL(peers[1], Name("/isp2"));
+
+  BOOST_CHECK(availability.erasePeer(Name("/isp1")));
+  BOOST_CHECK(!availability.erasePeer(Name("/isp1")));
+  BOOST_CHECK_EQUAL(availability.getAvailability(manifest, 2), 1);
+  BOOST_CHECK_EQUAL(availability.getAvailability(manifest, 3), 1);
+  BOOST_CHECK_EQUAL(availability.getPeers(manifest, 1).size(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(TestTakeRarest)
+{
+  PieceAvailability availability;
+  Name manifest1("/foo/bar.txt/%00");
+  Name manifest2("/foo/bar.txt/%01");
+  availability.update(Name("/isp1"), manifest1, { true, true, true, true });
+  availability.update(Name("/isp2"), manifest1, { true, true, false, false });
+  availability.update(Name("/isp3"), manifest1, { true, false, false, false });
+  availability.update(Name("/isp1"), manifest2, { true, true });
+
+  auto addAll = [&] {
+    for (size_t i = 0; i < 4; ++i) {
+      availability.addPending(packetName(manifest1, i));
+      availability.addPending(packetName(manifest2, i));
+    }
+  };
+  auto sorted = [] (std::vector<Name> names) {
+    std::sort(names.begin(), names.end());
+    return names;
+  };
+  addAll();
+  BOOST_CHECK_EQUAL(availability.numPending(), 8);
+  BOOST_CHECK(!availability.addPending(packetName(manifest1, 0)));
+  BOOST_CHECK_EQUAL(availability.numPending(), 8);
+
+  auto packets = availability.takeRarest(5);
+  BOOST_REQUIRE_EQUAL(packets.size(), 5);
+  BOOST_CHECK_EQUAL(availability.numPending(), 3);
+  // the packets that a single peer has, in any order
+  auto rarest = sorted(std::vector<Name>(packets.begin(), packets.begin() + 4));
+  auto expected = sorted({ packetName(manifest1, 2), packetName(manifest1, 3),
+                           packetName(manifest2, 0), packetName(manifest2, 1) });
+  BOOST_CHECK_EQUAL_COLLECTIONS(rarest.begin(), rarest.end(), expected.begin(), expected.end());
+  BOOST_CHECK_EQUAL(packets[4], packetName(manifest1, 1));
+
+  // then the packets no peer is known to have
+  packets = availability.takeRarest(10);
+  BOOST_REQUIRE_EQUAL(packets.size(), 3);
+  BOOST_CHECK_EQUAL(packets[0], packetName(manifest1, 0));
+  auto unknown = sorted(std::vector<Name>(packets.begin() + 1, packets.end()));
+  expected = sorted({ packetName(manifest2, 2), packetName(manifest2, 3) });
+  BOOST_CHECK_EQUAL_COLLECTIONS(unknown.begin(), unknown.end(), expected.begin(), expected.end());
+  BOOST_CHECK_EQUAL(availability.numPending(), 0);
+  BOOST_CHECK(availability.takeRarest(1).empty());
+
+  // the pending packets follow the changes of availability
+  addAll();
+  availability.update(Name("/isp4"), manifest2, { true, true, true });
+  packets = sorted(availability.takeRarest(3));
+  expected = sorted({ packetName(manifest1, 2), packetName(manifest1, 3),
+                      packetName(manifest2, 2) });
+  BOOST_CHECK_EQUAL_COLLECTIONS(packets.begin(), packets.end(), expected.begin(), expected.end());
+  availability.erasePeer(Name("/isp1"));
+  packets = sorted(availability.takeRarest(3));
+  expected = sorted({ packetName(manifest1, 1), packetName(manifest2, 0),
+                      packetName(manifest2, 1) });
+  BOOST_CHECK_EQUAL_COLLECTIONS(packets.begin(), packets.end(), expected.begin(), expected.end());
+  packets = availability.takeRarest(3);
+  BOOST_REQUIRE_EQUAL(packets.size(), 2);
+  BOOST_CHECK_EQUAL(packets[0], packetName(manifest1, 0));
+  BOOST_CHECK_EQUAL(packets[1], packetName(manifest2, 3));
+
+  // ties are broken randomly
+  std::set<Name> first;
+  for (int i = 0; i < 100; ++i) {
+    availability.addPending(packetName(manifest1, 1));
+    for (size_t j = 0; j < 3; ++j) {
+      availability.addPending(packetName(manifest2, j));
+    }
+    first.insert(availability.takeRarest(1).front());
+    availability.takeRarest(3);
+  }
+  BOOST_CHECK_EQUAL(first.size(), 4);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+} // namespace tests
+} // namespace ntorrent
+} // namespace ndn
@@ -0,0 +1,194 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+* Copyright (c) 2016 Regents of the University of California.
+*
+* This file is part of the nTorrent codebase.
+*
+* nTorrent is free software: you can redistribute it and/or modify it under the
+* terms of the GNU Lesser General Public License as published by the Free Software
+* Foundation, either version 3 of the License, or (at your option) any later version.
+*
+* nTorrent is distributed in the hope that it will be useful, but WITHOUT ANY
+* WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+* PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+*
+* You should have received copies of the GNU General Public License and GNU Lesser
+* General Public License along with nTorrent, e.g., in COPYING.md file. If not, see
+* <http://www.gnu.org/licenses/>.
+*
+* See AUTHORS for complete list of nTorrent authors and contributors.
+*/
+
+#include "boost-test.hpp"
+#include "resume-journal.hpp"
+
+#include "file-manifest.hpp"
+
+#include <boost/filesystem.hpp>
+#include <boost/filesystem/fstream.hpp>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+
+namespace ndn {
+namespace ntorrent {
+namespace tests {
+
+namespace fs = boost::filesystem;
+
+class ResumeJournalFixture
+{
+public:
+  ResumeJournalFixture()
+    : journalPath(".appdata/foo/journal/")
+    , dataPath(".appdata/foo/data/")
+    , filePath(dataPath + "foo/bar1.txt")
+  {
+    fs::create_directories(fs::path(filePath).parent_path());
+    fs::copy_file("tests/testdata/foo/bar1.txt", filePath);
+    manifests = FileManifest::generate(filePath, "/ndn/multicast/NTORRENT/foo/", 16, 1024,
+                                       false).first;
+    BOOST_REQUIRE_EQUAL(manifests.size(), 3);
+    // we have all the packets of the first sub-manifest and every other packet of the second one
+    states.resize(manifests.size());
+    states[0] = PacketBitmap(manifests[0].catalog_size());
+    states[1] = PacketBitmap(manifests[1].catalog_size());
+    for (size_t i = 0; i < manifests[0].catalog_size(); ++i) {
+      states[0].set(i);
+    }
+    for (size_t i = 0; i < manifests[1].catalog_size(); i += 2) {
+      states[1].set(i);
+    }
+  }
+
+  ~ResumeJournalFixture()
+  {
+    fs::remove_all(".appdata");
+  }
+
+  // Write a journal of the states of the manifests
+  void
+  writeJournal()
+  {
+    ResumeJournal journal(journalPath);
+    BOOST_CHECK(!journal.isDirty());
+    journal.markDirty(manifests[0].file_name());
+    BOOST_CHECK(journal.isDirty());
+    BOOST_CHECK(journal.flush(manifests, states, dataPath));
+    BOOST_CHECK(!journal.isDirty());
+  }
+
+public:
+  std::string               journalPath;
+  std::string               dataPath;
+  std::string               filePath;
+  std::vector<FileManifest> manifests;
+  std::vector<PacketBitmap> states;
+};
+
+BOOST_FIXTURE_TEST_SUITE(TestResumeJournal, ResumeJournalFixture)
+
+BOOST_AUTO_TEST_CASE(TestFlushFind)
+{
+  PacketBitmap state;
+  BOOST_CHECK(!ResumeJournal(journalPath).find(manifests[0], filePath, state));
+
+  writeJournal();
+  // the states are restored by a new journal
+  ResumeJournal journal(journalPath);
+  for (size_t i = 0; i < 2; ++i) {
+    BOOST_REQUIRE(journal.find(manifests[i], filePath, state));
+    BOOST_CHECK(state.toVector() == states[i].toVector());
+  }
+  // nothing is recorded for the sub-manifests without data
+  BOOST_CHECK(!journal.find(manifests[2], filePath, state));
+}
+
+BOOST_AUTO_TEST_CASE(TestChangedFile)
+{
+  writeJournal();
+  {
+    fs::ofstream os(filePath, fs::ofstream::binary | fs::ofstream::app);
+    os << "appended";
+  }
+  // the journal is not trusted once the data file changes
+  PacketBitmap state;
+  BOOST_CHECK(!ResumeJournal(journalPath).find(manifests[0], filePath, state));
+}
+
+BOOST_AUTO_TEST_CASE(TestRewrittenFile)
+{
+  writeJournal();
+  struct stat st;
+  BOOST_REQUIRE_EQUAL(::stat(filePath.c_str(), &st), 0);
+  {
+    fs::fstream os(filePath, fs::fstream::in | fs::fstream::out | fs::fstream::binary);
+    os << "rewritten";
+  }
+  // the file is rewritten in place within the same second, keeping its size
+  struct timespec times[2] = { st.st_atim, st.st_mtim };
+  times[1].tv_nsec = 0 == st.st_mtim.tv_nsec ? 1 : st.st_mtim.tv_nsec - 1;
+  BOOST_REQUIRE_EQUAL(::utimensat(AT_FDCWD, filePath.c_str(), times, 0), 0);
+  BOOST_REQUIRE_EQUAL(fs::file_size(filePath), st.st_size);
+  PacketBitmap state;
+  BOOST_CHECK(!ResumeJournal(journalPath).find(manifests[0], filePath, state));
+}
+
+BOOST_AUTO_TEST_CASE(TestAppendCompact)
+{
+  enum {
+    RECORD_SIZE = 8 + 8 + 8 + 4,
+    RANGE_SIZE  = ResumeJournal::DIGEST_SIZE + 4 + 4
+  };
+  writeJournal();
+  auto journalFile = journalPath + manifests[0].file_name();
+  auto compactedSize = fs::file_size(journalFile);
+
+  // the packets written since the last flush are appended to the journal as ranges
+  ResumeJournal journal(journalPath);
+  PacketBitmap state;
+  BOOST_REQUIRE(journal.find(manifests[1], filePath, state));
+  for (size_t packetNum : { 3, 1, 5 }) {
+    states[1].set(packetNum);
+    journal.addPacket(manifests[1], packetNum);
+  }
+  BOOST_CHECK(journal.isDirty());
+  BOOST_CHECK(journal.flush(manifests, states, dataPath));
+  BOOST_CHECK(!journal.isDirty());
+  BOOST_CHECK_EQUAL(fs::file_size(journalFile), compactedSize + RECORD_SIZE + 3 * RANGE_SIZE);
+  BOOST_REQUIRE(ResumeJournal(journalPath).find(manifests[1], filePath, state));
+  BOOST_CHECK(state.toVector() == states[1].toVector());
+
+  // the journal is compacted into a single record once it holds enough records
+  for (size_t i = 0; i < ResumeJournal::COMPACT_RECORDS; ++i) {
+    journal.addPacket(manifests[0], 0);
+    BOOST_CHECK(journal.flush(manifests, states, dataPath));
+  }
+  ResumeJournal compacted(".appdata/foo/compacted/");
+  compacted.markDirty(manifests[0].file_name());
+  BOOST_CHECK(compacted.flush(manifests, states, dataPath));
+  // the last flush appended a record to the compacted journal
+  BOOST_CHECK_EQUAL(fs::file_size(journalFile),
+                    fs::file_size(".appdata/foo/compacted/" + manifests[0].file_name()) +
+                    RECORD_SIZE + RANGE_SIZE);
+  for (size_t i = 0; i < 2; ++i) {
+    BOOST_REQUIRE(ResumeJournal(journalPath).find(manifests[i], filePath, state));
+    BOOST_CHECK(state.toVector() == states[i].toVector());
+  }
+}
+
+BOOST_AUTO_TEST_CASE(TestCorruptJournal)
+{
+  writeJournal();
+  auto journalFile = journalPath + manifests[0].file_name();
+  fs::resize_file(journalFile, fs::file_size(journalFile) - 1);
+  // a truncated journal is ignored
+  PacketBitmap state;
+  BOOST_CHECK(!ResumeJournal(journalPath).find(manifests[0], filePath, state));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+} // namespace tests
+} // namespace ntorrent
+} // namespace ndn
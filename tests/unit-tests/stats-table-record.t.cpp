@@ -119,6 +119,45 @@ BOOST_AUTO_TEST_CASE(TestCopyConstructor)
   BOOST_CHECK(record1 == record2);
 }
 
+BOOST_AUTO_TEST_CASE(TestRttEstimation)
+{
+  StatsTableRecord record(Name("isp1"));
+  BOOST_CHECK(!record.hasRttSample());
+  BOOST_CHECK(record.getRto() == StatsTableRecord::INITIAL_RTO);
+
+  // the first sample sets SRTT to the sample and RTTVAR to half of it
+  record.addRttSample(time::milliseconds(100));
+  BOOST_CHECK(record.hasRttSample());
+  BOOST_CHECK(record.getSmoothedRtt() == time::milliseconds(100));
+  BOOST_CHECK(record.getRttVariation() == time::milliseconds(50));
+  BOOST_CHECK(record.getRto() == time::milliseconds(300));
+
+  record.addRttSample(time::milliseconds(180));
+  BOOST_CHECK(record.getRttVariation() == time::microseconds(57500));
+  BOOST_CHECK(record.getSmoothedRtt() == time::milliseconds(110));
+  BOOST_CHECK(record.getRto() == time::milliseconds(340));
+
+  // the timeout doubles upon every timeout up to MAX_RTO, until the next sample
+  record.backoffRto();
+  BOOST_CHECK(record.getRto() == time::milliseconds(680));
+  for (int i = 0; i < 20; ++i) {
+    record.backoffRto();
+  }
+  BOOST_CHECK(record.getRto() == StatsTableRecord::MAX_RTO);
+
+  // on a fast and steady link, the timeout converges to MIN_RTO
+  for (int i = 0; i < 100; ++i) {
+    record.addRttSample(time::milliseconds(1));
+  }
+  BOOST_CHECK(record.getRto() == StatsTableRecord::MIN_RTO);
+
+  // the estimates are copied with the record
+  StatsTableRecord copy(record);
+  BOOST_CHECK(copy.getSmoothedRtt() == record.getSmoothedRtt());
+  BOOST_CHECK(copy.getRttVariation() == record.getRttVariation());
+  BOOST_CHECK(copy.getRto() == record.getRto());
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 } // namespace tests
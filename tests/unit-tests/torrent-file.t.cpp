@@ -23,6 +23,7 @@
 
 #include "torrent-file.hpp"
 #include "file-manifest.hpp"
+#include "util/thread-pool.hpp"
 
 #include <ndn-cxx/data.hpp>
 #include <ndn-cxx/signature.hpp>
@@ -458,6 +459,62 @@ BOOST_AUTO_TEST_CASE(TestTorrentFileGenerator)
   }
 }
 
+BOOST_AUTO_TEST_CASE(TestParallelTorrentFileGenerator)
+{
+  // generating with a thread pool produces exactly the same torrent file, manifests and packets
+  // as generating serially
+  const std::string directoryPath = "tests/testdata/foo";
+  ThreadPool pool(4);
+  for (size_t subManifestSize : {1, 7, 128}) {
+    auto serial = TorrentFile::generate(directoryPath, 2, subManifestSize, 1024, true);
+    auto parallel = TorrentFile::generate(directoryPath, 2, subManifestSize, 1024, true, pool);
+
+    BOOST_REQUIRE_EQUAL(serial.first.size(), parallel.first.size());
+    for (size_t i = 0; i < serial.first.size(); ++i) {
+      BOOST_CHECK(serial.first[i].wireEncode() == parallel.first[i].wireEncode());
+    }
+    BOOST_REQUIRE_EQUAL(serial.second.size(), parallel.second.size());
+    for (size_t i = 0; i < serial.second.size(); ++i) {
+      const auto& serialManifests = serial.second[i].first;
+      const auto& parallelManifests = parallel.second[i].first;
+      BOOST_REQUIRE_EQUAL(serialManifests.size(), parallelManifests.size());
+      for (size_t j = 0; j < serialManifests.size(); ++j) {
+        BOOST_CHECK(serialManifests[j].wireEncode() == parallelManifests[j].wireEncode());
+      }
+      BOOST_CHECK(serial.second[i].second == parallel.second[i].second);
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(TestIndexedTorrentFileGenerator)
+{
+  const std::string directoryPath = "tests/testdata/foo";
+  ThreadPool pool(0);
+  // one manifest name per segment, so that there is a segment per file
+  auto indexed = TorrentFile::generate(directoryPath, 1, 1024, 1024, false, pool, 2).first;
+  auto unindexed = TorrentFile::generate(directoryPath, 1, 1024, 1024, false, pool).first;
+  BOOST_REQUIRE_EQUAL(indexed.size(), 3);
+  BOOST_REQUIRE_EQUAL(unindexed.size(), indexed.size());
+
+  // the first segment lists the other two, which list none
+  const auto& index = indexed[0].getSegmentIndex();
+  BOOST_REQUIRE_EQUAL(index.size(), 2);
+  BOOST_CHECK_EQUAL(index[0], indexed[1].getFullName());
+  BOOST_CHECK_EQUAL(index[1], indexed[2].getFullName());
+  BOOST_CHECK(indexed[1].getSegmentIndex().empty());
+  BOOST_CHECK(indexed[2].getSegmentIndex().empty());
+
+  // the index is carried in the meta info, leaving the content as it is without it
+  TorrentFile decoded(indexed[0].wireEncode());
+  BOOST_CHECK(decoded.getSegmentIndex() == index);
+  BOOST_CHECK(decoded.getCatalog() == indexed[0].getCatalog());
+  for (size_t i = 0; i < indexed.size(); ++i) {
+    BOOST_CHECK(indexed[i].getContent() == unindexed[i].getContent());
+    BOOST_CHECK(unindexed[i].getSegmentIndex().empty());
+  }
+  BOOST_CHECK_EQUAL(indexed.back().getFullName(), unindexed.back().getFullName());
+}
+
 } // namespace tests
 
 } // namespace ntorrent
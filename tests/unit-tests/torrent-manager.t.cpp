@@ -26,13 +26,17 @@
 #include "dummy-parser-fixture.hpp"
 #include "torrent-file.hpp"
 #include "unit-test-time-fixture.hpp"
+#include "util/bitmap-codec.hpp"
 #include "util/io-util.hpp"
 
+#include <algorithm>
 #include <set>
+#include <thread>
 
 #include <boost/filesystem.hpp>
 #include <boost/filesystem/fstream.hpp>
 
+#include <ndn-cxx/mgmt/nfd/control-parameters.hpp>
 #include <ndn-cxx/util/dummy-client-face.hpp>
 #include <ndn-cxx/util/io.hpp>
 #include <ndn-cxx/security/signature-sha256-with-rsa.hpp>
@@ -68,10 +72,13 @@ public:
 
   void pushTorrentSegment(const TorrentFile& t) {
     m_torrentSegments.push_back(t);
+    indexTorrentSegment(m_torrentSegments.size() - 1);
   }
 
   void pushFileManifestSegment(const FileManifest& m) {
     m_fileManifests.push_back(m);
+    m_fileStates.push_back(PacketBitmap());
+    indexFileManifest(m_fileManifests.size() - 1);
   }
 
   shared_ptr<Name> findTorrentFileSegmentToDownload() {
@@ -83,19 +90,28 @@ public:
   }
 
   std::vector<bool> fileState(const ndn::Name& manifestName) {
-    return m_fileStates[manifestName];
+    auto manifestIndex = findFileManifest(manifestName.getPrefix(-1));
+    if (m_fileManifests.size() == manifestIndex) {
+      return {};
+    }
+    return m_fileStates[manifestIndex].toVector();
   }
 
   void setFileState(const ndn::Name manifestName,
                     const std::vector<bool>& stateVec) {
-
-    m_fileStates[manifestName] = stateVec;
+    auto manifestIndex = findFileManifest(manifestName.getPrefix(-1));
+    BOOST_REQUIRE(m_fileManifests.size() != manifestIndex);
+    m_fileStates[manifestIndex] = PacketBitmap(stateVec);
   }
 
   bool writeData(const Data& data) {
     return TorrentManager::writeData(data);
   }
 
+  void writeDataAsync(const Data& data, const std::function<void(bool)>& onWritten) {
+    TorrentManager::writeDataAsync(data, onWritten);
+  }
+
   bool writeTorrentSegment(const TorrentFile& segment, const std::string& path) {
     return TorrentManager::writeTorrentSegment(segment, path);
   }
@@ -389,6 +405,181 @@ BOOST_AUTO_TEST_CASE(CheckInitializeMissingManifests)
   }
 }
 
+BOOST_AUTO_TEST_CASE(CheckInitializeFromJournal)
+{
+  // a copy of the data, so that it can be modified
+  std::string dataPath = ".appdata/data/";
+  fs::create_directories(dataPath + "foo");
+  for (const auto& fileName : { "bar.txt", "bar1.txt", "bar2.txt" }) {
+    fs::copy_file(std::string("tests/testdata/foo/") + fileName, dataPath + "foo/" + fileName);
+  }
+  auto temp = TorrentFile::generate(dataPath + "foo", 1024, 16, 1024, false);
+  const auto& torrentSegments = temp.first;
+  vector<FileManifest> manifests;
+  for (const auto& ms : temp.second) {
+    manifests.insert(manifests.end(), ms.first.begin(), ms.first.end());
+  }
+  std::string dirPath = ".appdata/foo/";
+  for (size_t i = 0; i < torrentSegments.size(); ++i) {
+    fs::create_directories(dirPath + "torrent_files/");
+    io::save(torrentSegments[i], dirPath + "torrent_files/" + to_string(i));
+  }
+  for (const auto& m : manifests) {
+    fs::path filename = dirPath + "manifests/" + m.file_name() + "/" +
+                        to_string(m.submanifest_number());
+    fs::create_directories(filename.parent_path());
+    io::save(m, filename.string());
+  }
+  auto torrentFileName = torrentSegments[0].getFullName();
+  {
+    TestTorrentManager manager(torrentFileName, dataPath, face);
+    manager.Initialize();
+  }
+  // the journal of every file is written once its data is hashed
+  for (const auto& m : manifests) {
+    BOOST_CHECK(fs::exists(dirPath + "journal/" + m.file_name()));
+  }
+
+  // overwrite a file, keeping its size and modification time
+  fs::path filePath = dataPath + "foo/bar1.txt";
+  auto fileSize = fs::file_size(filePath);
+  auto modificationTime = fs::last_write_time(filePath);
+  {
+    fs::ofstream os(filePath, fs::ofstream::binary | fs::ofstream::trunc);
+    os << std::string(fileSize, 'x');
+  }
+  fs::last_write_time(filePath, modificationTime);
+
+  // the state is restored from the journal without hashing the data again
+  {
+    TestTorrentManager manager(torrentFileName, dataPath, face);
+    manager.Initialize();
+    for (const auto& m : manager.fileManifests()) {
+      auto fileState = manager.fileState(m.getFullName());
+      BOOST_CHECK_EQUAL(fileState.size(), m.catalog_size());
+      BOOST_CHECK(std::all_of(fileState.begin(), fileState.end(), [] (bool s) { return s; }));
+    }
+  }
+  // the verification finds the packets that do not match the data on disk
+  {
+    TestTorrentManager manager(torrentFileName, dataPath, face);
+    manager.setResumeVerification(true);
+    manager.Initialize();
+    for (const auto& m : manager.fileManifests()) {
+      auto fileState = manager.fileState(m.getFullName());
+      bool isModified = std::string::npos != m.file_name().find("bar1.txt");
+      BOOST_CHECK_EQUAL(fileState.size(), m.catalog_size());
+      BOOST_CHECK(std::all_of(fileState.begin(), fileState.end(),
+                              [isModified] (bool s) { return s != isModified; }));
+    }
+  }
+  fs::remove_all(".appdata");
+}
+
+BOOST_AUTO_TEST_CASE(CheckInitializeHashProgress)
+{
+  auto temp = TorrentFile::generate("tests/testdata/foo", 128, 16, 128, false);
+  const auto& torrentSegments = temp.first;
+  vector<FileManifest> manifests;
+  for (const auto& ms : temp.second) {
+    manifests.insert(manifests.end(), ms.first.begin(), ms.first.end());
+  }
+  std::string dirPath = ".appdata/foo/";
+  for (size_t i = 0; i < torrentSegments.size(); ++i) {
+    fs::create_directories(dirPath + "torrent_files/");
+    io::save(torrentSegments[i], dirPath + "torrent_files/" + to_string(i));
+  }
+  size_t numPackets = 0;
+  for (const auto& m : manifests) {
+    fs::path filename = dirPath + "manifests/" + m.file_name() + "/" +
+                        to_string(m.submanifest_number());
+    fs::create_directories(filename.parent_path());
+    io::save(m, filename.string());
+    numPackets += m.catalog_size();
+  }
+  TestTorrentManager manager(torrentSegments[0].getFullName(), "tests/testdata/", face);
+  manager.setHashThreads(4);
+  std::vector<std::pair<size_t, size_t>> progress;
+  manager.setHashProgressCallback([&progress] (size_t numHashed, size_t numTotal) {
+    progress.emplace_back(numHashed, numTotal);
+  });
+  manager.Initialize();
+
+  // the progress is reported once per sub-manifest, up to all the packets
+  BOOST_REQUIRE_EQUAL(progress.size(), manifests.size());
+  for (size_t i = 0; i < progress.size(); ++i) {
+    BOOST_CHECK_EQUAL(progress[i].second, numPackets);
+    BOOST_CHECK(0 == i || progress[i - 1].first < progress[i].first);
+  }
+  BOOST_CHECK_EQUAL(progress.back().first, numPackets);
+  for (const auto& m : manager.fileManifests()) {
+    auto fileState = manager.fileState(m.getFullName());
+    BOOST_CHECK_EQUAL(fileState.size(), m.catalog_size());
+    BOOST_CHECK(std::all_of(fileState.begin(), fileState.end(), [] (bool s) { return s; }));
+  }
+}
+
+BOOST_AUTO_TEST_CASE(CheckInitializeLazy)
+{
+  auto temp = TorrentFile::generate("tests/testdata/foo", 128, 128, 128, false);
+  const auto& torrentSegments = temp.first;
+  vector<FileManifest> manifests;
+  for (const auto& ms : temp.second) {
+    manifests.insert(manifests.end(), ms.first.begin(), ms.first.end());
+  }
+  std::string dirPath = ".appdata/foo/";
+  for (size_t i = 0; i < torrentSegments.size(); ++i) {
+    fs::create_directories(dirPath + "torrent_files/");
+    io::save(torrentSegments[i], dirPath + "torrent_files/" + to_string(i));
+  }
+  std::set<Name> filePrefixes;
+  for (const auto& m : manifests) {
+    fs::path filename = dirPath + "manifests/" + m.file_name() + "/" +
+                        to_string(m.submanifest_number());
+    fs::create_directories(filename.parent_path());
+    io::save(m, filename.string());
+    filePrefixes.insert(FileManifest::manifestPrefix(m.getFullName()));
+  }
+  TestTorrentManager manager(torrentSegments[0].getFullName(), "tests/testdata/", face);
+  manager.setIoThreads(2);
+  manager.setLazyInitialization(true);
+  manager.Initialize();
+
+  // the files are hashed on the I/O threads
+  auto isComplete = [&manager] {
+    for (const auto& m : manager.fileManifests()) {
+      auto fileState = manager.fileState(m.getFullName());
+      if (fileState.size() != m.catalog_size() ||
+          !std::all_of(fileState.begin(), fileState.end(), [] (bool s) { return s; })) {
+        return false;
+      }
+    }
+    return true;
+  };
+  for (int i = 0; i < 1000 && !isComplete(); ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    advanceClocks(time::milliseconds(1));
+  }
+  BOOST_CHECK(isComplete());
+
+  // the prefixes of the torrent file and of each file are registered once
+  std::vector<Name> registeredPrefixes;
+  for (const auto& interest : face->sentInterests) {
+    if (Name("/localhost/nfd/rib/register").isPrefixOf(interest.getName())) {
+      nfd::ControlParameters parameters(interest.getName().get(4).blockFromValue());
+      registeredPrefixes.push_back(parameters.getName());
+    }
+  }
+  std::set<Name> uniquePrefixes(registeredPrefixes.begin(), registeredPrefixes.end());
+  BOOST_CHECK_EQUAL(registeredPrefixes.size(), uniquePrefixes.size());
+  BOOST_CHECK_EQUAL(uniquePrefixes.size(), filePrefixes.size() + 1);
+  BOOST_CHECK_EQUAL(uniquePrefixes.count(
+                      TorrentFile::torrentFileName(torrentSegments[0].getFullName())), 1);
+  for (const auto& prefix : filePrefixes) {
+    BOOST_CHECK_EQUAL(uniquePrefixes.count(prefix), 1);
+  }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 BOOST_FIXTURE_TEST_SUITE(TestTorrentManagerNetworkingStuff, FaceFixture)
@@ -444,6 +635,76 @@ BOOST_AUTO_TEST_CASE(TestDownloadingTorrentFile)
   fs::remove_all(".appdata");
 }
 
+BOOST_AUTO_TEST_CASE(TestDownloadingIndexedTorrentFile)
+{
+  std::string filePath = ".appdata/foo/";
+  ThreadPool pool(0);
+  // a segment per file, the first one listing the other two
+  auto torrentSegments = TorrentFile::generate("tests/testdata/foo", 1, 1024, 1024, false, pool,
+                                               2).first;
+  BOOST_REQUIRE_EQUAL(torrentSegments.size(), 3);
+
+  TestTorrentManager manager(torrentSegments[0].getFullName(), filePath, face);
+  manager.Initialize();
+
+  advanceClocks(time::milliseconds(1), 10);
+  manager.sendRoutablePrefixResponse();
+  advanceClocks(time::milliseconds(1), 10);
+
+  size_t nInterests = face->sentInterests.size();
+  auto requested = [this, &nInterests] (const Name& name) {
+    return std::count_if(face->sentInterests.begin() + nInterests, face->sentInterests.end(),
+                         [&name] (const Interest& interest) {
+                           return interest.getName() == name;
+                         });
+  };
+  size_t nSegments = 0;
+  auto onSuccess = [&nSegments] (const std::vector<ndn::Name>& vec) {
+    ++nSegments;
+  };
+  std::vector<Name> failedNames;
+  auto onFailed = [&failedNames] (const ndn::Name& name, const std::string& reason) {
+    failedNames.push_back(name);
+  };
+  manager.downloadTorrentFile(filePath + "torrent_files", onSuccess, onFailed);
+  advanceClocks(time::milliseconds(1), 10);
+  BOOST_CHECK_EQUAL(requested(torrentSegments[0].getFullName()), 1);
+
+  // both the other segments are requested at once
+  face->receive(static_cast<const Data&>(torrentSegments[0]));
+  advanceClocks(time::milliseconds(1), 10);
+  BOOST_CHECK_EQUAL(nSegments, 1);
+  BOOST_CHECK_EQUAL(requested(torrentSegments[1].getFullName()), 1);
+  BOOST_CHECK_EQUAL(requested(torrentSegments[2].getFullName()), 1);
+  BOOST_CHECK(!manager.hasAllTorrentSegments());
+
+  face->receive(static_cast<const Data&>(torrentSegments[2]));
+  advanceClocks(time::milliseconds(1), 10);
+  // the last segment does not complete the torrent-file while a segment before it is missing
+  BOOST_CHECK(!manager.hasAllTorrentSegments());
+  BOOST_CHECK_EQUAL(*manager.findTorrentFileSegmentToDownload(), torrentSegments[1].getFullName());
+
+  // only the failed segment is requested again
+  advanceClocks(time::milliseconds(100), 20);
+  BOOST_REQUIRE_EQUAL(failedNames.size(), 1);
+  BOOST_CHECK_EQUAL(failedNames[0], torrentSegments[1].getFullName());
+  nInterests = face->sentInterests.size();
+  manager.retryTorrentFileSegment(failedNames[0], filePath + "torrent_files", onSuccess,
+                                  onFailed);
+  advanceClocks(time::milliseconds(1), 10);
+  BOOST_CHECK_EQUAL(face->sentInterests.size(), nInterests + 1);
+  BOOST_CHECK_EQUAL(requested(torrentSegments[1].getFullName()), 1);
+
+  face->receive(static_cast<const Data&>(torrentSegments[1]));
+  advanceClocks(time::milliseconds(1), 10);
+  BOOST_CHECK_EQUAL(nSegments, 3);
+  BOOST_CHECK(manager.hasAllTorrentSegments());
+  BOOST_CHECK(manager.torrentSegments() == torrentSegments);
+
+  fs::remove_all(filePath);
+  fs::remove_all(".appdata");
+}
+
 BOOST_AUTO_TEST_CASE(TestDownloadingFileManifests)
 {
   vector<FileManifest> manifests;
@@ -522,6 +783,79 @@ BOOST_AUTO_TEST_CASE(TestDownloadingFileManifests)
   fs::remove_all(".appdata");
 }
 
+BOOST_AUTO_TEST_CASE(TestDownloadingIndexedFileManifest)
+{
+  std::string filePath = ".appdata/foo/";
+  ThreadPool pool(0);
+  auto content = TorrentFile::generate("tests/testdata/foo", 1024, 100, 100, false, pool, 100);
+  // a file of more than two segments
+  auto file = std::find_if(content.second.begin(), content.second.end(),
+                           [] (const std::pair<vector<FileManifest>, vector<Data>>& f) {
+                             return f.first.size() > 2;
+                           });
+  BOOST_REQUIRE(content.second.end() != file);
+  const auto& manifests = file->first;
+
+  TestTorrentManager manager(content.first[0].getFullName(), filePath, face);
+  manager.Initialize();
+
+  advanceClocks(time::milliseconds(1), 10);
+  manager.sendRoutablePrefixResponse();
+  advanceClocks(time::milliseconds(1), 10);
+
+  size_t nInterests = face->sentInterests.size();
+  auto requested = [this, &nInterests, &manifests] {
+    std::vector<Name> names;
+    for (size_t i = nInterests; i < face->sentInterests.size(); ++i) {
+      for (const auto& m : manifests) {
+        if (face->sentInterests[i].getName() == m.getFullName()) {
+          names.push_back(m.getFullName());
+        }
+      }
+    }
+    return names;
+  };
+  size_t nSegments = 0;
+  size_t nPackets = 0;
+  manager.download_file_manifest(manifests[0].getFullName(), filePath + "manifests",
+                                 [&nSegments, &nPackets] (const std::vector<ndn::Name>& vec) {
+                                   ++nSegments;
+                                   nPackets += vec.size();
+                                 },
+                                 [](const ndn::Name& name, const std::string& reason) {
+                                   BOOST_FAIL("Unexpected failure");
+                                 });
+  advanceClocks(time::milliseconds(1), 10);
+  BOOST_CHECK_EQUAL(requested().size(), 1);
+
+  // the packets of the first segment are handed out, and all the other segments are requested
+  // at once
+  face->receive(static_cast<const Data&>(manifests[0]));
+  advanceClocks(time::milliseconds(1), 10);
+  BOOST_CHECK_EQUAL(nSegments, 1);
+  BOOST_CHECK_EQUAL(nPackets, manifests[0].catalog().size());
+  auto names = requested();
+  BOOST_REQUIRE_EQUAL(names.size(), manifests.size());
+  for (size_t i = 0; i < manifests.size(); ++i) {
+    BOOST_CHECK_EQUAL(names[i], manifests[i].getFullName());
+  }
+
+  // the segments may arrive in any order, and their pointers are not followed
+  size_t expectedPackets = manifests[0].catalog().size();
+  for (size_t i = manifests.size() - 1; i > 0; --i) {
+    face->receive(static_cast<const Data&>(manifests[i]));
+    advanceClocks(time::milliseconds(1), 10);
+    expectedPackets += manifests[i].catalog().size();
+  }
+  BOOST_CHECK_EQUAL(nSegments, manifests.size());
+  BOOST_CHECK_EQUAL(nPackets, expectedPackets);
+  BOOST_CHECK_EQUAL(requested().size(), manifests.size());
+  BOOST_CHECK_EQUAL(manager.fileManifests().size(), manifests.size());
+
+  fs::remove_all(filePath);
+  fs::remove_all(".appdata");
+}
+
 BOOST_AUTO_TEST_CASE(TestDownloadingDataPackets)
 {
   std::string filePath = ".appdata/foo/";
@@ -568,6 +902,350 @@ BOOST_AUTO_TEST_CASE(TestDownloadingDataPackets)
   fs::remove_all(".appdata");
 }
 
+BOOST_AUTO_TEST_CASE(TestCongestionWindow)
+{
+  std::string filePath = ".appdata/foo/";
+  TestTorrentManager manager("/ndn/multicast/NTORRENT/foo/torrent-file/sha256digest=521110d7a60e317e1f36029a414f0d98318f26553720ed50a26479fe4bf982b7",
+                             filePath, face);
+  manager.setCongestionController(CongestionController::create("aimd", 4));
+
+  manager.Initialize();
+
+  advanceClocks(time::milliseconds(1), 10);
+  manager.sendRoutablePrefixResponse();
+  advanceClocks(time::milliseconds(1), 10);
+  size_t nInterests = face->sentInterests.size();
+
+  // only a window of Interests is sent out, the others wait in the queue
+  size_t nReceived = 0;
+  for (int i = 0; i < 8; ++i) {
+    manager.download_data_packet(Name("/test/ucla").appendNumber(i),
+                                 [&nReceived] (const ndn::Name& name) {
+                                   ++nReceived;
+                                 },
+                                 [](const ndn::Name& name, const std::string& reason) {
+                                   BOOST_FAIL("Unexpected failure");
+                                 });
+  }
+  advanceClocks(time::milliseconds(1), 10);
+  BOOST_CHECK_EQUAL(face->sentInterests.size() - nInterests, 4);
+  BOOST_CHECK(manager.hasPendingInterests());
+
+  // every Data packet received lets the next Interest out
+  for (int i = 0; i < 8; ++i) {
+    auto data = make_shared<Data>(Name("/test/ucla").appendNumber(i));
+    SignatureSha256WithRsa fakeSignature;
+    fakeSignature.setValue(encoding::makeEmptyBlock(tlv::SignatureValue));
+    data->setSignature(fakeSignature);
+    data->wireEncode();
+
+    face->receive(*data);
+    advanceClocks(time::milliseconds(1), 10);
+    BOOST_CHECK_EQUAL(face->sentInterests.size() - nInterests, std::min<size_t>(8, i + 5));
+  }
+  BOOST_CHECK_EQUAL(nReceived, 8);
+  BOOST_CHECK(manager.getCongestionController().getSmoothedRtt() > time::nanoseconds::zero());
+
+  // a timeout shrinks the window
+  manager.download_data_packet(Name("/test/ucla/timeout"),
+                               [](const ndn::Name& name) {
+                                 BOOST_FAIL("Unexpected success");
+                               },
+                               [](const ndn::Name& name, const std::string& reason) {});
+  advanceClocks(time::milliseconds(1), 2100);
+  BOOST_CHECK_EQUAL(manager.getCongestionController().getWindow(), 2);
+
+  fs::remove_all(filePath);
+  fs::remove_all(".appdata");
+}
+
+BOOST_AUTO_TEST_CASE(TestDownloadMissingDataPackets)
+{
+  std::string filePath = ".appdata/foo/";
+  auto content = TorrentFile::generate("tests/testdata/foo", 1024, 1024, 1024, true);
+  // a file of more packets than the window
+  auto file = std::find_if(content.second.begin(), content.second.end(),
+                           [] (const std::pair<vector<FileManifest>, vector<Data>>& f) {
+                             return f.second.size() > 8;
+                           });
+  BOOST_REQUIRE(content.second.end() != file);
+  const auto& manifest = file->first[0];
+  const auto& packets  = file->second;
+
+  TestTorrentManager manager(content.first[0].getFullName(), filePath, face);
+  manager.setCongestionController(CongestionController::create("aimd", 4));
+  manager.Initialize();
+
+  advanceClocks(time::milliseconds(1), 10);
+  manager.sendRoutablePrefixResponse();
+  advanceClocks(time::milliseconds(1), 10);
+  manager.pushFileManifestSegment(manifest);
+  // we already have the packets 1 and 2
+  std::vector<bool> state(manifest.catalog().size(), false);
+  state[1] = state[2] = true;
+  manager.setFileState(manifest.getFullName(), state);
+  BOOST_CHECK(!manager.hasAllDataPackets());
+
+  size_t nInterests = face->sentInterests.size();
+  size_t nReceived = 0;
+  manager.downloadMissingDataPackets([&nReceived] (const ndn::Name& name) {
+                                       ++nReceived;
+                                     },
+                                     [](const ndn::Name& name, const std::string& reason) {
+                                       BOOST_FAIL("Unexpected failure");
+                                     });
+  advanceClocks(time::milliseconds(1), 10);
+  // only a window of Interests is produced, skipping the packets we have
+  BOOST_REQUIRE_EQUAL(face->sentInterests.size() - nInterests, 4);
+  std::vector<size_t> expected = { 0, 3, 4, 5 };
+  for (size_t i = 0; i < expected.size(); ++i) {
+    BOOST_CHECK_EQUAL(face->sentInterests[nInterests + i].getName(),
+                      packets[expected[i]].getFullName());
+  }
+  BOOST_CHECK(manager.hasPendingInterests());
+
+  // every Data packet received lets the next missing packet out
+  for (size_t i = 0; i < packets.size(); ++i) {
+    if (1 == i || 2 == i) {
+      continue;
+    }
+    face->receive(packets[i]);
+    advanceClocks(time::milliseconds(1), 10);
+  }
+  BOOST_CHECK_EQUAL(nReceived, packets.size() - 2);
+  BOOST_CHECK_EQUAL(face->sentInterests.size() - nInterests, packets.size() - 2);
+  BOOST_CHECK(manager.hasAllDataPackets());
+  BOOST_CHECK(!manager.hasPendingInterests());
+
+  fs::remove_all(filePath);
+  fs::remove_all(".appdata");
+}
+
+BOOST_AUTO_TEST_CASE(TestQueuedPacketsOfMovedManifest)
+{
+  std::string filePath = ".appdata/foo/";
+  auto content = TorrentFile::generate("tests/testdata/foo", 1024, 1024, 1024, true);
+  BOOST_REQUIRE_GE(content.second.size(), 2);
+  // the manifest of the first file is received after the packets of the second one are queued
+  size_t firstFile = content.second[0].first[0].file_name() < content.second[1].first[0].file_name()
+                     ? 0 : 1;
+  const auto& first  = content.second[firstFile].first[0];
+  const auto& second = content.second[1 - firstFile].first[0];
+  const auto& packets = content.second[1 - firstFile].second;
+  BOOST_REQUIRE_GT(second.catalog().size(), 1);
+
+  TestTorrentManager manager(content.first[0].getFullName(), filePath, face);
+  manager.setCongestionController(CongestionController::create("aimd", 1));
+  manager.Initialize();
+
+  advanceClocks(time::milliseconds(1), 10);
+  manager.sendRoutablePrefixResponse();
+  advanceClocks(time::milliseconds(1), 10);
+  manager.pushFileManifestSegment(second);
+
+  size_t nInterests = face->sentInterests.size();
+  manager.download_data_packets(second.catalog(),
+                                [] (const ndn::Name& name) {},
+                                [](const ndn::Name& name, const std::string& reason) {
+                                  BOOST_FAIL("Unexpected failure");
+                                });
+  advanceClocks(time::milliseconds(1), 10);
+  BOOST_REQUIRE_EQUAL(face->sentInterests.size() - nInterests, 1);
+
+  // the manifest moves the second one to the next position, the queued packets still refer to it
+  BOOST_CHECK(manager.writeFileManifest(first, filePath + "manifests"));
+  BOOST_CHECK_EQUAL(manager.fileManifests()[1].getFullName(), second.getFullName());
+  for (const auto& packet : packets) {
+    face->receive(packet);
+    advanceClocks(time::milliseconds(1), 10);
+  }
+  BOOST_REQUIRE_EQUAL(face->sentInterests.size() - nInterests, second.catalog().size());
+  for (size_t i = 0; i < second.catalog().size(); ++i) {
+    BOOST_CHECK_EQUAL(face->sentInterests[nInterests + i].getName(), second.catalog()[i]);
+  }
+
+  fs::remove_all(filePath);
+  fs::remove_all(".appdata");
+}
+
+BOOST_AUTO_TEST_CASE(TestInterestLifetime)
+{
+  std::string filePath = ".appdata/foo/";
+  TestTorrentManager manager("/ndn/multicast/NTORRENT/foo/torrent-file/sha256digest=521110d7a60e317e1f36029a414f0d98318f26553720ed50a26479fe4bf982b7",
+                             filePath, face);
+
+  manager.Initialize();
+
+  advanceClocks(time::milliseconds(1), 10);
+  manager.sendRoutablePrefixResponse();
+  advanceClocks(time::milliseconds(1), 10);
+
+  auto receive = [this] (const Name& name) {
+    auto data = make_shared<Data>(name);
+    SignatureSha256WithRsa fakeSignature;
+    fakeSignature.setValue(encoding::makeEmptyBlock(tlv::SignatureValue));
+    data->setSignature(fakeSignature);
+    data->wireEncode();
+    face->receive(*data);
+  };
+  size_t nFailures = 0;
+  auto download = [&manager, &nFailures] (const Name& name) {
+    manager.download_data_packet(name,
+                                 [](const ndn::Name& name) {},
+                                 [&nFailures] (const ndn::Name& name, const std::string& reason) {
+                                   ++nFailures;
+                                 });
+  };
+
+  // without round-trip time samples, the Interests live for the initial timeout
+  download(Name("/test/ucla/0"));
+  advanceClocks(time::milliseconds(1), 50);
+  BOOST_CHECK(face->sentInterests.back().getInterestLifetime() == StatsTableRecord::INITIAL_RTO);
+  receive(Name("/test/ucla/0"));
+
+  // a sample of 50ms gives a timeout of 150ms, raised to the minimum timeout
+  download(Name("/test/ucla/1"));
+  advanceClocks(time::milliseconds(1), 10);
+  BOOST_CHECK(face->sentInterests.back().getInterestLifetime() == StatsTableRecord::MIN_RTO);
+
+  // the timeout doubles when the Interest times out
+  advanceClocks(time::milliseconds(1), 200);
+  BOOST_CHECK_EQUAL(nFailures, 1);
+  download(Name("/test/ucla/1"));
+  advanceClocks(time::milliseconds(1), 10);
+  BOOST_CHECK(face->sentInterests.back().getInterestLifetime() == time::milliseconds(400));
+
+  // the Data of a retransmitted Interest is no sample, so the timeout keeps its backoff
+  receive(Name("/test/ucla/1"));
+  download(Name("/test/ucla/2"));
+  advanceClocks(time::milliseconds(1), 10);
+  BOOST_CHECK(face->sentInterests.back().getInterestLifetime() == time::milliseconds(400));
+  receive(Name("/test/ucla/2"));
+  BOOST_CHECK_EQUAL(nFailures, 1);
+
+  fs::remove_all(filePath);
+  fs::remove_all(".appdata");
+}
+
+BOOST_AUTO_TEST_CASE(TestPieceAvailability)
+{
+  std::string filePath = ".appdata/foo/";
+  auto content = TorrentFile::generate("tests/testdata/foo", 1024, 1024, 1024, true);
+  // a file of more than one packet
+  auto file = std::find_if(content.second.begin(), content.second.end(),
+                           [] (const std::pair<vector<FileManifest>, vector<Data>>& f) {
+                             return f.second.size() > 1;
+                           });
+  BOOST_REQUIRE(content.second.end() != file);
+  const auto& manifest = file->first[0];
+  const auto& packets  = file->second;
+
+  TestTorrentManager manager(content.first[0].getFullName(), filePath, face);
+  manager.Initialize();
+
+  advanceClocks(time::milliseconds(1), 10);
+  manager.sendRoutablePrefixResponse();
+  advanceClocks(time::milliseconds(1), 10);
+  manager.pushFileManifestSegment(manifest);
+
+  // the routable prefix that serves a packet has it
+  manager.download_data_packet(packets[1].getFullName(),
+                               [](const ndn::Name& name) {},
+                               [](const ndn::Name& name, const std::string& reason) {
+                                 BOOST_FAIL("Unexpected failure");
+                               });
+  advanceClocks(time::milliseconds(1), 10);
+  BOOST_REQUIRE(!face->sentInterests.empty());
+  Name prefix = face->sentInterests.back().getForwardingHint().begin()->name;
+  face->receive(packets[1]);
+  advanceClocks(time::milliseconds(1), 10);
+
+  const auto& availability = manager.getPieceAvailability();
+  BOOST_CHECK_EQUAL(availability.getAvailability(manifest.name(), 0), 0);
+  BOOST_CHECK_EQUAL(availability.getAvailability(manifest.name(), 1), 1);
+  auto peers = availability.getPeers(manifest.name(), 1);
+  BOOST_REQUIRE_EQUAL(peers.size(), 1);
+  BOOST_CHECK_EQUAL(peers[0], prefix);
+
+  // the manager advertises the packets it has to the peers
+  size_t nData = face->sentData.size();
+  Name bitmapName = Name("/ndn/multicast/NTORRENT/foo/BITMAP").append(manifest.name());
+  face->receive(Interest(bitmapName));
+  advanceClocks(time::milliseconds(1), 10);
+  BOOST_REQUIRE_EQUAL(face->sentData.size(), nData + 1);
+  const auto& bitmapContent = face->sentData.back().getContent();
+  auto bitmap = BitmapCodec::decode(bitmapContent.value(), bitmapContent.value_size());
+  BOOST_REQUIRE_EQUAL(bitmap.size(), manifest.catalog().size());
+  for (size_t i = 0; i < bitmap.size(); ++i) {
+    BOOST_CHECK_EQUAL(bitmap[i], 1 == i);
+  }
+
+  fs::remove_all(filePath);
+  fs::remove_all(".appdata");
+}
+
+BOOST_AUTO_TEST_CASE(TestRequestBitmaps)
+{
+  std::string filePath = ".appdata/foo/";
+  auto content = TorrentFile::generate("tests/testdata/foo", 1024, 1024, 1024, true);
+  const auto& manifest = content.second[0].first[0];
+
+  TestTorrentManager manager(content.first[0].getFullName(), filePath, face);
+  manager.Initialize();
+
+  advanceClocks(time::milliseconds(1), 10);
+  manager.sendRoutablePrefixResponse();
+  advanceClocks(time::milliseconds(1), 10);
+  manager.pushFileManifestSegment(manifest);
+
+  Name bitmapName = Name("/ndn/multicast/NTORRENT/foo/BITMAP").append(manifest.name());
+  size_t nInterests = face->sentInterests.size();
+  auto countBitmapInterests = [&] {
+    return std::count_if(face->sentInterests.begin() + nInterests, face->sentInterests.end(),
+                         [&] (const Interest& interest) {
+                           return interest.getName() == bitmapName;
+                         });
+  };
+  // each peer is asked once for the bitmap, through the queue
+  manager.requestBitmaps(manifest.name());
+  manager.requestBitmaps(manifest.name());
+  BOOST_CHECK_EQUAL(countBitmapInterests(), 0);
+  manager.download_data_packets({}, [](const ndn::Name& name) {},
+                                [](const ndn::Name& name, const std::string& reason) {});
+  advanceClocks(time::milliseconds(1), 10);
+  BOOST_REQUIRE_EQUAL(countBitmapInterests(), 1);
+  const auto& interest = face->sentInterests.back();
+  BOOST_CHECK_EQUAL(interest.getName(), bitmapName);
+  Name peer = interest.getForwardingHint().begin()->name;
+
+  // the bitmap of the peer updates the piece availability
+  std::vector<bool> bitmap(manifest.catalog().size(), false);
+  bitmap[0] = true;
+  auto encoded = BitmapCodec::encode(bitmap);
+  auto data = make_shared<Data>(bitmapName);
+  data->setContent(encoded.data(), encoded.size());
+  SignatureSha256WithRsa fakeSignature;
+  fakeSignature.setValue(encoding::makeEmptyBlock(tlv::SignatureValue));
+  data->setSignature(fakeSignature);
+  data->wireEncode();
+  face->receive(*data);
+  advanceClocks(time::milliseconds(1), 10);
+  const auto& availability = manager.getPieceAvailability();
+  auto peers = availability.getPeers(manifest.name(), 0);
+  BOOST_REQUIRE_EQUAL(peers.size(), 1);
+  BOOST_CHECK_EQUAL(peers[0], peer);
+
+  // the bitmap received is not requested again until it is stale
+  manager.requestBitmaps(manifest.name());
+  manager.download_data_packets({}, [](const ndn::Name& name) {},
+                                [](const ndn::Name& name, const std::string& reason) {});
+  advanceClocks(time::milliseconds(1), 10);
+  BOOST_CHECK_EQUAL(countBitmapInterests(), 1);
+
+  fs::remove_all(filePath);
+  fs::remove_all(".appdata");
+}
+
 // we already have downloaded the torrent file
 BOOST_AUTO_TEST_CASE(TestFindTorrentFileSegmentToDownload1)
 {
@@ -580,22 +1258,23 @@ BOOST_AUTO_TEST_CASE(TestFindTorrentFileSegmentToDownload1)
   advanceClocks(time::milliseconds(1), 10);
   manager.sendRoutablePrefixResponse();
 
-  TorrentFile t1(Name("/ndn/multicast/NTORRENT/test/torrent-file/sha256digest"),
+  // the segments are named without their implicit digest, and each one points to the next one
+  TorrentFile t1(Name("/ndn/multicast/NTORRENT/test/torrent-file"),
                  Name("/ndn/multicast/NTORRENT/test/torrent-file/1/sha256digest"), Name("/test"),
                  { Name("/manifest1") });
   manager.pushTorrentSegment(t1);
 
-  TorrentFile t2(Name("/ndn/multicast/NTORRENT/test/torrent-file/1/sha256digest"),
+  TorrentFile t2(Name("/ndn/multicast/NTORRENT/test/torrent-file/1"),
                  Name("/ndn/multicast/NTORRENT/test/torrent-file/2/sha256digest"), Name("/test"),
                  { Name("/manifest2"), Name("/manifest3") });
   manager.pushTorrentSegment(t2);
 
-  TorrentFile t3(Name("/ndn/multicast/NTORRENT/test/torrent-file/3/sha256digest"),
-                 Name("/ndn/multicast/NTORRENT/test/torrent-file/4/sha256digest"), Name("/test"),
+  TorrentFile t3(Name("/ndn/multicast/NTORRENT/test/torrent-file/2"),
+                 Name("/ndn/multicast/NTORRENT/test/torrent-file/3/sha256digest"), Name("/test"),
                  { Name("/manifest4"), Name("/manifest5") });
   manager.pushTorrentSegment(t3);
 
-  TorrentFile t4(Name("/ndn/multicast/NTORRENT/test/torrent-file/4/sha256digest"), Name("/test"), {});
+  TorrentFile t4(Name("/ndn/multicast/NTORRENT/test/torrent-file/3"), Name("/test"), {});
   manager.pushTorrentSegment(t4);
 
   BOOST_CHECK(!(manager.findTorrentFileSegmentToDownload()));
@@ -1226,6 +1905,74 @@ BOOST_AUTO_TEST_CASE(CheckWriteDataComplete)
   }
 }
 
+BOOST_AUTO_TEST_CASE(CheckWriteDataAsync)
+{
+  Name initialSegmentName("/ndn/multicast/NTORRENT/foo/torrent-file/sha256digest=5351d424c7893158da35707258635d885725be0aa34321cf2e557afc2b785a76");
+  std::string filePath = "tests/testdata/temp";
+  vector<FileManifest> manifests;
+  std::vector<vector<Data>> fileData;
+  {
+    auto temp = TorrentFile::generate("tests/testdata/foo", 128, 128, 128, true);
+    for (const auto& ms : temp.second) {
+      manifests.insert(manifests.end(), ms.first.begin(), ms.first.end());
+      fileData.push_back(ms.second);
+    }
+  }
+  TestTorrentManager manager(initialSegmentName, filePath, face);
+  manager.Initialize();
+  manager.setIoThreads(4);
+  for (const auto& m : manifests) {
+    manager.pushFileManifestSegment(m);
+  }
+  // write all the packets on the I/O threads
+  size_t numPackets = 0;
+  size_t numWritten = 0;
+  for (const auto& data : fileData) {
+    for (const auto& d : data) {
+      ++numPackets;
+      manager.writeDataAsync(d, [&numWritten] (bool written) {
+        BOOST_CHECK(written);
+        ++numWritten;
+      });
+    }
+  }
+  // the completions are run by the event loop
+  for (int i = 0; i < 1000 && numWritten < numPackets; ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    advanceClocks(time::milliseconds(1));
+  }
+  BOOST_REQUIRE_EQUAL(numWritten, numPackets);
+  for (const auto& m : manifests) {
+    for (auto s : manager.fileState(m.getFullName())) {
+      BOOST_CHECK(s);
+    }
+  }
+  // verify file by file that the data packets are written correctly
+  auto data_it = fileData.begin();
+  for (const auto& m : manifests) {
+    if (0 != m.submanifest_number()) {
+      continue;
+    }
+    fs::ifstream is(filePath + m.file_name(), fs::ifstream::binary | fs::ifstream::in);
+    is >> std::noskipws;
+    std::istream_iterator<uint8_t> start(is), end;
+    std::vector<uint8_t> file_bytes(start, end);
+    std::vector<uint8_t> data_bytes;
+    for (const auto& d : *data_it) {
+      auto content = d.getContent();
+      data_bytes.insert(data_bytes.end(), content.value_begin(), content.value_end());
+    }
+    BOOST_CHECK(data_bytes == file_bytes);
+    ++data_it;
+  }
+  // packets already written are not written again
+  bool rewritten = true;
+  manager.writeDataAsync(fileData[0][0], [&rewritten] (bool written) { rewritten = written; });
+  BOOST_CHECK(!rewritten);
+  fs::remove_all(filePath);
+  fs::remove_all(".appdata");
+}
+
 BOOST_AUTO_TEST_CASE(CheckWriteTorrentComplete)
 {
   const struct {
@@ -1304,10 +2051,38 @@ BOOST_AUTO_TEST_CASE(CheckWriteTorrentComplete)
       BOOST_CHECK(manager.writeTorrentSegment(t, torrentPath));
     }
     BOOST_CHECK(manager.torrentSegments() == torrentSegments);
+    // the segments we have are not added again
+    for (const auto& t : torrentSegmentsRandom) {
+      BOOST_CHECK(!manager.writeTorrentSegment(t, torrentPath));
+    }
+    BOOST_CHECK(manager.torrentSegments() == torrentSegments);
     fs::remove_all(".appdata");
   }
 }
 
+BOOST_AUTO_TEST_CASE(CheckWriteTorrentFailed)
+{
+  auto torrentSegments = TorrentFile::generate("tests/testdata/foo", 1024, 1024, 1024,
+                                               false).first;
+  TestTorrentManager manager(torrentSegments[0].getFullName(), "tests/testdata/temp", face);
+  // a file in place of the directory of the segments makes their writes fail
+  std::string torrentPath = ".appdata/foo/torrent_files/";
+  fs::create_directories(".appdata/foo");
+  {
+    fs::ofstream os(".appdata/foo/torrent_files");
+  }
+  // the segment is accepted, then dropped once it cannot be written, so it is downloaded again
+  BOOST_CHECK(manager.writeTorrentSegment(torrentSegments[0], torrentPath));
+  BOOST_CHECK(manager.torrentSegments().empty());
+  BOOST_CHECK_EQUAL(*manager.findTorrentFileSegmentToDownload(), torrentSegments[0].getFullName());
+
+  // it is kept once the directory can be written
+  fs::remove(".appdata/foo/torrent_files");
+  BOOST_CHECK(manager.writeTorrentSegment(torrentSegments[0], torrentPath));
+  BOOST_CHECK(manager.torrentSegments() == torrentSegments);
+  BOOST_CHECK(fs::exists(torrentPath + "0"));
+}
+
 BOOST_AUTO_TEST_CASE(CheckWriteManifestComplete)
 {
   std::string dirPath = ".appdata/foo/";
@@ -1396,7 +2171,13 @@ BOOST_AUTO_TEST_CASE(CheckWriteManifestComplete)
     for (const auto& m : fileManifestsRandom) {
       BOOST_CHECK(manager.writeFileManifest(m, manifestPath));
     }
+    BOOST_CHECK(manager.fileManifests() == manifests);
     BOOST_CHECK(manager2.fileManifests() == manifests);
+    // the manifests we have are not added again
+    for (const auto& m : fileManifestsRandom) {
+      BOOST_CHECK(!manager.writeFileManifest(m, manifestPath));
+    }
+    BOOST_CHECK(manager.fileManifests() == manifests);
     fs::remove_all(".appdata");
   }
 }
@@ -23,6 +23,7 @@
 #include "update-handler.hpp"
 #include "unit-test-time-fixture.hpp"
 #include "dummy-parser-fixture.hpp"
+#include "util/bitmap-codec.hpp"
 
 #include <ndn-cxx/name.hpp>
 #include <ndn-cxx/util/dummy-client-face.hpp>
@@ -39,7 +40,7 @@ class TestUpdateHandler : public UpdateHandler {
 public:
   TestUpdateHandler(Name torrentName, shared_ptr<KeyChain> keyChain,
                     shared_ptr<StatsTable> statsTable, shared_ptr<Face> face)
-  : UpdateHandler(torrentName, keyChain, statsTable, face)
+  : UpdateHandler(torrentName, make_shared<SigningService>(keyChain), statsTable, face)
   {
   }
 
@@ -251,9 +252,9 @@ BOOST_AUTO_TEST_CASE(TestNeedsUpdate)
   table1->insert(Name("isp2"));
   table1->insert(Name("isp3"));
 
-  shared_ptr<KeyChain> keyChain = make_shared<KeyChain>();
+  auto signingService = make_shared<SigningService>();
 
-  UpdateHandler handler1(Name("linux15.01"), keyChain, table1, face1);
+  UpdateHandler handler1(Name("linux15.01"), signingService, table1, face1);
 
   BOOST_CHECK(handler1.needsUpdate());
 
@@ -270,6 +271,68 @@ BOOST_AUTO_TEST_CASE(TestNeedsUpdate)
   BOOST_CHECK(!handler1.needsUpdate());
 }
 
+BOOST_AUTO_TEST_CASE(TestBitmapExchange)
+{
+  shared_ptr<KeyChain> keyChain = make_shared<KeyChain>();
+  auto signingService = make_shared<SigningService>(keyChain);
+  Name manifestName("/ndn/multicast/NTORRENT/linux15.01/bar.txt/%00");
+  std::vector<bool> bitmap(100, true);
+  bitmap[42] = false;
+
+  shared_ptr<StatsTable> table1 = make_shared<StatsTable>(Name("linux15.01"));
+  UpdateHandler handler1(Name("linux15.01"), signingService, table1, face1);
+  handler1.setBitmapProvider([&] (const Name& name, std::vector<bool>& result) {
+    if (name != manifestName) {
+      return false;
+    }
+    result = bitmap;
+    return true;
+  });
+  advanceClocks(time::milliseconds(1), 10);
+  shared_ptr<Data> d = DummyParser::createDataPacket(Name("/localhop/nfd/rib/routable-prefixes"),
+                                                      { Name("ucla") });
+  keyChain->sign(*d);
+  face1->receive(*d);
+  advanceClocks(time::milliseconds(1), 10);
+
+  shared_ptr<StatsTable> table2 = make_shared<StatsTable>(Name("linux15.01"));
+  UpdateHandler handler2(Name("linux15.01"), signingService, table2, face2);
+
+  // request the bitmap of the sub-manifest from the peer
+  size_t nReceived = 0;
+  handler2.sendBitmapInterest(manifestName, Name("ucla"),
+                              [&] (const Name& peer, const Name& name,
+                                   const std::vector<bool>& received) {
+                                ++nReceived;
+                                BOOST_CHECK_EQUAL(peer, Name("ucla"));
+                                BOOST_CHECK_EQUAL(name, manifestName);
+                                BOOST_CHECK(received == bitmap);
+                              });
+  advanceClocks(time::milliseconds(1), 10);
+  const Interest& interest = face2->sentInterests.back();
+  Name bitmapName = Name("/ndn/multicast/NTORRENT/linux15.01/BITMAP").append(manifestName);
+  BOOST_CHECK_EQUAL(interest.getName(), bitmapName);
+  BOOST_CHECK_EQUAL(interest.getForwardingHint().begin()->name, Name("ucla"));
+
+  // the peer answers with its encoded bitmap
+  face1->receive(interest);
+  advanceClocks(time::milliseconds(1), 10);
+  BOOST_REQUIRE_EQUAL(face1->sentData.size(), 1);
+  const Data& data = face1->sentData.back();
+  BOOST_CHECK_EQUAL(data.getName(), bitmapName);
+  BOOST_CHECK(BitmapCodec::decode(data.getContent().value(),
+                                  data.getContent().value_size()) == bitmap);
+
+  face2->receive(data);
+  advanceClocks(time::milliseconds(1), 10);
+  BOOST_CHECK_EQUAL(nReceived, 1);
+
+  // the peer does not answer for the sub-manifests it does not know
+  face1->receive(Interest(Name("/ndn/multicast/NTORRENT/linux15.01/BITMAP/unknown/%00")));
+  advanceClocks(time::milliseconds(1), 10);
+  BOOST_CHECK_EQUAL(face1->sentData.size(), 1);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 } // namespace tests
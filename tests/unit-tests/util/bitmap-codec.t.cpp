@@ -0,0 +1,116 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+* Copyright (c) 2016 Regents of the University of California.
+*
+* This file is part of the nTorrent codebase.
+*
+* nTorrent is free software: you can redistribute it and/or modify it under the
+* terms of the GNU Lesser General Public License as published by the Free Software
+* Foundation, either version 3 of the License, or (at your option) any later version.
+*
+* nTorrent is distributed in the hope that it will be useful, but WITHOUT ANY
+* WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+* PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+*
+* You should have received copies of the GNU General Public License and GNU Lesser
+* General Public License along with nTorrent, e.g., in COPYING.md file. If not, see
+* <http://www.gnu.org/licenses/>.
+*
+* See AUTHORS for complete list of nTorrent authors and contributors.
+*/
+
+#include "boost-test.hpp"
+#include "util/bitmap-codec.hpp"
+
+#include <random>
+
+namespace ndn {
+namespace ntorrent {
+namespace tests {
+
+BOOST_AUTO_TEST_SUITE(TestBitmapCodec)
+
+static std::vector<bool>
+roundTrip(const std::vector<bool>& bitmap, BitmapCodec::Format format)
+{
+  auto buffer = BitmapCodec::encode(bitmap, format);
+  return BitmapCodec::decode(buffer.data(), buffer.size());
+}
+
+BOOST_AUTO_TEST_CASE(TestRoundTrip)
+{
+  std::mt19937 random(42);
+  std::vector<std::vector<bool>> bitmaps = {
+    {},
+    { true },
+    { false },
+    std::vector<bool>(1000, false),
+    std::vector<bool>(1000, true),
+    std::vector<bool>(1001, true),
+  };
+  std::vector<bool> randomBitmap(777);
+  for (size_t i = 0; i < randomBitmap.size(); ++i) {
+    randomBitmap[i] = random() % 2;
+  }
+  bitmaps.push_back(randomBitmap);
+  std::vector<bool> mostlyComplete(100000, true);
+  mostlyComplete[5] = mostlyComplete[500] = mostlyComplete[99999] = false;
+  bitmaps.push_back(mostlyComplete);
+
+  for (const auto& bitmap : bitmaps) {
+    BOOST_CHECK(roundTrip(bitmap, BitmapCodec::PACKED) == bitmap);
+    BOOST_CHECK(roundTrip(bitmap, BitmapCodec::RUN_LENGTH) == bitmap);
+    auto buffer = BitmapCodec::encode(bitmap);
+    BOOST_CHECK(BitmapCodec::decode(buffer.data(), buffer.size()) == bitmap);
+    // never more than the packed encoding
+    BOOST_CHECK_LE(buffer.size(), BitmapCodec::encode(bitmap, BitmapCodec::PACKED).size());
+  }
+}
+
+BOOST_AUTO_TEST_CASE(TestCompactness)
+{
+  // a nearly complete bitmap is a handful of runs
+  std::vector<bool> bitmap(100000, true);
+  bitmap[5] = bitmap[500] = false;
+  auto buffer = BitmapCodec::encode(bitmap);
+  BOOST_CHECK_EQUAL(buffer[0], BitmapCodec::RUN_LENGTH);
+  BOOST_CHECK_LT(buffer.size(), 16);
+
+  // an alternating bitmap is packed
+  std::vector<bool> alternating(1000);
+  for (size_t i = 0; i < alternating.size(); i += 2) {
+    alternating[i] = true;
+  }
+  buffer = BitmapCodec::encode(alternating);
+  BOOST_CHECK_EQUAL(buffer[0], BitmapCodec::PACKED);
+  BOOST_CHECK_EQUAL(buffer.size(), 1 + 2 + 125);
+}
+
+BOOST_AUTO_TEST_CASE(TestMalformed)
+{
+  std::vector<std::vector<uint8_t>> buffers = {
+    // empty
+    {},
+    // unknown format
+    { 2, 0 },
+    // truncated number of bits
+    { BitmapCodec::PACKED, 0x80 },
+    // packed payload of the wrong size
+    { BitmapCodec::PACKED, 9, 0xff },
+    // runs past the end of the bitmap
+    { BitmapCodec::RUN_LENGTH, 4, 2, 3 },
+    // runs short of the end of the bitmap
+    { BitmapCodec::RUN_LENGTH, 4, 2, 1 },
+    // too many bits
+    { BitmapCodec::RUN_LENGTH, 0xff, 0xff, 0xff, 0xff, 0x0f, 0 },
+  };
+  for (const auto& buffer : buffers) {
+    BOOST_CHECK_THROW(BitmapCodec::decode(buffer.data(), buffer.size()), BitmapCodec::Error);
+  }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+} // namespace tests
+} // namespace ntorrent
+} // namespace ndn
@@ -0,0 +1,166 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+* Copyright (c) 2016 Regents of the University of California.
+*
+* This file is part of the nTorrent codebase.
+*
+* nTorrent is free software: you can redistribute it and/or modify it under the
+* terms of the GNU Lesser General Public License as published by the Free Software
+* Foundation, either version 3 of the License, or (at your option) any later version.
+*
+* nTorrent is distributed in the hope that it will be useful, but WITHOUT ANY
+* WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+* PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+*
+* You should have received copies of the GNU General Public License and GNU Lesser
+* General Public License along with nTorrent, e.g., in COPYING.md file. If not, see
+* <http://www.gnu.org/licenses/>.
+*
+* See AUTHORS for complete list of nTorrent authors and contributors.
+*/
+
+#include "boost-test.hpp"
+#include "util/digest-signer.hpp"
+
+#include <ndn-cxx/encoding/block-helpers.hpp>
+#include <ndn-cxx/security/key-chain.hpp>
+#include <ndn-cxx/security/signing-helpers.hpp>
+
+#include <chrono>
+#include <vector>
+
+namespace ndn {
+namespace ntorrent {
+namespace tests {
+
+BOOST_AUTO_TEST_SUITE(TestDigestSigner)
+
+static std::vector<Data>
+makePackets(size_t numPackets, size_t packetSize, bool varySize = true)
+{
+  std::vector<Data> packets;
+  packets.reserve(numPackets);
+  std::vector<uint8_t> content(packetSize);
+  for (size_t i = 0; i < numPackets; ++i) {
+    Name name("/NTORRENT/foo/bar.txt");
+    name.appendSequenceNumber(i);
+    packets.emplace_back(name);
+    // packets of every size up to packetSize, so that the padding differs between them
+    std::fill(content.begin(), content.end(), static_cast<uint8_t>(i));
+    size_t size = varySize ? i % (packetSize + 1) : packetSize;
+    packets.back().setContent(encoding::makeBinaryBlock(tlv::Content, content.data(), size));
+  }
+  return packets;
+}
+
+static std::vector<Data*>
+pointers(std::vector<Data>& packets)
+{
+  std::vector<Data*> result;
+  for (auto& packet : packets) {
+    result.push_back(&packet);
+  }
+  return result;
+}
+
+BOOST_AUTO_TEST_CASE(TestSameAsKeyChain)
+{
+  security::KeyChain keyChain;
+  auto expected = makePackets(300, 150);
+  for (auto& packet : expected) {
+    keyChain.sign(packet, signingWithSha256());
+  }
+
+  auto packets = makePackets(300, 150);
+  for (size_t i = 0; i < packets.size(); ++i) {
+    auto fullName = DigestSigner::sign(packets[i]);
+    BOOST_CHECK(packets[i].wireEncode() == expected[i].wireEncode());
+    BOOST_CHECK_EQUAL(fullName, expected[i].getFullName());
+  }
+
+  auto batch = makePackets(300, 150);
+  auto fullNames = DigestSigner::sign(pointers(batch));
+  BOOST_REQUIRE_EQUAL(fullNames.size(), batch.size());
+  for (size_t i = 0; i < batch.size(); ++i) {
+    BOOST_CHECK(batch[i].wireEncode() == expected[i].wireEncode());
+    BOOST_CHECK_EQUAL(fullNames[i], expected[i].getFullName());
+  }
+
+  BOOST_CHECK(DigestSigner::sign(std::vector<Data*>()).empty());
+}
+
+BOOST_AUTO_TEST_CASE(TestLargeMetaInfo)
+{
+  // a MetaInfo larger than the room reserved for the headers
+  security::KeyChain keyChain;
+  auto expected = makePackets(1, 100);
+  auto packets = makePackets(1, 100);
+  std::string finalBlock(200, 'x');
+  for (auto* packet : { &expected[0], &packets[0] }) {
+    packet->setFreshnessPeriod(time::seconds(10));
+    packet->setFinalBlockId(name::Component(finalBlock));
+  }
+  keyChain.sign(expected[0], signingWithSha256());
+  auto fullName = DigestSigner::sign(packets[0]);
+  BOOST_CHECK(packets[0].wireEncode() == expected[0].wireEncode());
+  BOOST_CHECK_EQUAL(fullName, expected[0].getFullName());
+}
+
+BOOST_AUTO_TEST_CASE(TestSignAgain)
+{
+  // signing a packet again replaces its signature, as KeyChain::sign does
+  security::KeyChain keyChain;
+  auto packets = makePackets(2, 100);
+  keyChain.sign(packets[0]);
+  auto fullName = DigestSigner::sign(packets[0]);
+  BOOST_CHECK_EQUAL(packets[0].getSignature().getType(), tlv::DigestSha256);
+  BOOST_CHECK_EQUAL(fullName, packets[0].getFullName());
+  packets[1].setName(packets[0].getName());
+  packets[1].setContent(packets[0].getContent());
+  BOOST_CHECK_EQUAL(DigestSigner::sign(packets[1]), fullName);
+}
+
+// a benchmark, run on demand with --run_test=TestDigestSigner/BenchmarkPacketSigning
+BOOST_AUTO_TEST_CASE(BenchmarkPacketSigning, *boost::unit_test::disabled())
+{
+  // sign and name 64K packets of the default size, as when packetizing a file
+  const size_t numPackets = 64 * 1024;
+  const size_t packetSize = 1024;
+  auto report = [&] (const std::string& name, std::chrono::steady_clock::time_point start) {
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    BOOST_TEST_MESSAGE(name << ": " << numPackets / elapsed.count() << " packets/s");
+  };
+
+  auto packets = makePackets(numPackets, packetSize, false);
+  auto start = std::chrono::steady_clock::now();
+  security::KeyChain keyChain;
+  for (auto& packet : packets) {
+    keyChain.sign(packet, signingWithSha256());
+    packet.getFullName();
+  }
+  report("KeyChain::sign and Data::getFullName", start);
+
+  packets = makePackets(numPackets, packetSize, false);
+  start = std::chrono::steady_clock::now();
+  for (auto& packet : packets) {
+    DigestSigner::sign(packet);
+  }
+  report("DigestSigner::sign, one packet at a time", start);
+
+  packets = makePackets(numPackets, packetSize, false);
+  auto unsignedPackets = pointers(packets);
+  start = std::chrono::steady_clock::now();
+  // in batches of the size of the buffer of IoUtil::packetize_file
+  const size_t batchSize = 1024;
+  for (size_t first = 0; first < numPackets; first += batchSize) {
+    DigestSigner::sign(std::vector<Data*>(unsignedPackets.begin() + first,
+                                          unsignedPackets.begin() + first + batchSize));
+  }
+  report("DigestSigner::sign, in batches", start);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+} // namespace tests
+} // namespace ntorrent
+} // namespace ndn
@@ -0,0 +1,146 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+* Copyright (c) 2016 Regents of the University of California.
+*
+* This file is part of the nTorrent codebase.
+*
+* nTorrent is free software: you can redistribute it and/or modify it under the
+* terms of the GNU Lesser General Public License as published by the Free Software
+* Foundation, either version 3 of the License, or (at your option) any later version.
+*
+* nTorrent is distributed in the hope that it will be useful, but WITHOUT ANY
+* WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+* PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+*
+* You should have received copies of the GNU General Public License and GNU Lesser
+* General Public License along with nTorrent, e.g., in COPYING.md file. If not, see
+* <http://www.gnu.org/licenses/>.
+*
+* See AUTHORS for complete list of nTorrent authors and contributors.
+*/
+
+#include "../boost-test.hpp"
+#include "util/file-writer-pool.hpp"
+
+#include <boost/filesystem.hpp>
+#include <boost/filesystem/fstream.hpp>
+
+#include <iterator>
+#include <string>
+#include <vector>
+
+namespace fs = boost::filesystem;
+
+namespace ndn {
+namespace ntorrent {
+namespace tests {
+
+static std::string
+readFile(const std::string& path)
+{
+  fs::ifstream is(path, fs::ifstream::binary);
+  return std::string(std::istreambuf_iterator<char>(is), std::istreambuf_iterator<char>());
+}
+
+static const uint8_t*
+bytes(const std::string& s)
+{
+  return reinterpret_cast<const uint8_t*>(s.data());
+}
+
+BOOST_AUTO_TEST_SUITE(TestFileWriterPool)
+
+BOOST_AUTO_TEST_CASE(TestOutOfOrderWrites)
+{
+  const std::string dirPath = "tests/testdata/temp/";
+  fs::create_directories(dirPath);
+  const std::string filePath = dirPath + "file";
+  {
+    FileWriterPool writers;
+    // write the chunks in reverse order
+    BOOST_CHECK(writers.write(filePath, 8, bytes("89"), 2));
+    BOOST_CHECK(writers.write(filePath, 4, bytes("4567"), 4));
+    BOOST_CHECK(writers.write(filePath, 0, bytes("0123"), 4));
+    BOOST_CHECK_EQUAL(writers.size(), 1);
+    BOOST_CHECK_EQUAL(writers.unsyncedBytes(), 10);
+    // the written data is readable before it is synced
+    BOOST_CHECK_EQUAL(readFile(filePath), "0123456789");
+    BOOST_CHECK(writers.sync());
+    BOOST_CHECK_EQUAL(writers.unsyncedBytes(), 0);
+    // rewriting a range overwrites it in place
+    BOOST_CHECK(writers.write(filePath, 2, bytes("ab"), 2));
+  }
+  BOOST_CHECK_EQUAL(readFile(filePath), "01ab456789");
+  fs::remove_all(dirPath);
+}
+
+BOOST_AUTO_TEST_CASE(TestMaxOpenFiles)
+{
+  const std::string dirPath = "tests/testdata/temp/";
+  fs::create_directories(dirPath);
+  FileWriterPool writers(2);
+  for (int i = 0; i < 5; ++i) {
+    BOOST_CHECK(writers.write(dirPath + std::to_string(i), 0, bytes("x"), 1));
+    BOOST_CHECK_LE(writers.size(), 2);
+  }
+  BOOST_CHECK_EQUAL(writers.size(), 2);
+  // the files closed to make room for others were synced
+  BOOST_CHECK_EQUAL(writers.unsyncedBytes(), 2);
+  // writing to a closed file opens it again
+  BOOST_CHECK(writers.write(dirPath + "0", 1, bytes("y"), 1));
+  BOOST_CHECK_EQUAL(writers.size(), 2);
+  BOOST_CHECK(writers.close(dirPath + "0"));
+  BOOST_CHECK_EQUAL(writers.size(), 1);
+  BOOST_CHECK_EQUAL(readFile(dirPath + "0"), "xy");
+  // files in directories that do not exist cannot be opened
+  BOOST_CHECK(!writers.write(dirPath + "fake/0", 0, bytes("x"), 1));
+  fs::remove_all(dirPath);
+}
+
+BOOST_AUTO_TEST_CASE(TestSyncPolicy)
+{
+  const std::string dirPath = "tests/testdata/temp/";
+  fs::create_directories(dirPath);
+  FileWriterPool writers(FileWriterPool::DEFAULT_MAX_OPEN_FILES, 4, time::seconds(3600));
+  BOOST_CHECK(writers.write(dirPath + "0", 0, bytes("abc"), 3));
+  BOOST_CHECK_EQUAL(writers.unsyncedBytes(), 3);
+  // reaching the number of unsynced bytes syncs all the files
+  BOOST_CHECK(writers.write(dirPath + "1", 0, bytes("de"), 2));
+  BOOST_CHECK_EQUAL(writers.unsyncedBytes(), 0);
+  fs::remove_all(dirPath);
+}
+
+BOOST_AUTO_TEST_CASE(TestSyncFailure)
+{
+  const std::string dirPath = "tests/testdata/temp/";
+  fs::create_directories(dirPath);
+  // /dev/null accepts positional writes, but cannot be synced
+  const std::string nullPath = "/dev/null";
+  FileWriterPool writers(1);
+  BOOST_REQUIRE(writers.write(nullPath, 0, bytes("abc"), 3));
+  std::vector<std::string> failedPaths;
+  BOOST_CHECK(!writers.sync(failedPaths));
+  BOOST_REQUIRE_EQUAL(failedPaths.size(), 1);
+  BOOST_CHECK_EQUAL(failedPaths[0], nullPath);
+  // the writes that failed to sync are kept
+  BOOST_CHECK_EQUAL(writers.unsyncedBytes(), 3);
+
+  // a file closed to make room for another one fails the next sync
+  BOOST_CHECK(writers.write(dirPath + "0", 0, bytes("x"), 1));
+  BOOST_CHECK_EQUAL(writers.size(), 1);
+  BOOST_CHECK_EQUAL(writers.unsyncedBytes(), 1);
+  failedPaths.clear();
+  BOOST_CHECK(!writers.sync(failedPaths));
+  BOOST_REQUIRE_EQUAL(failedPaths.size(), 1);
+  BOOST_CHECK_EQUAL(failedPaths[0], nullPath);
+  // the failure is reported once
+  BOOST_CHECK(writers.sync());
+  BOOST_CHECK_EQUAL(writers.unsyncedBytes(), 0);
+  fs::remove_all(dirPath);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+} // namespace tests
+} // namespace ntorrent
+} // namespace ndn
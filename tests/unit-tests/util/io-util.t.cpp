@@ -22,6 +22,12 @@
 #include "../boost-test.hpp"
 #include "util/io-util.hpp"
 
+#include "file-manifest.hpp"
+#include "util/mapped-file.hpp"
+
+#include <boost/filesystem.hpp>
+#include <boost/filesystem/fstream.hpp>
+
 namespace ndn {
 namespace ntorrent {
 namespace tests {
@@ -52,6 +58,114 @@ BOOST_AUTO_TEST_CASE(TestFindType)
   BOOST_CHECK_EQUAL(IoUtil::findType(n3), 2);
 }
 
+BOOST_AUTO_TEST_CASE(TestPacketizeFile)
+{
+  const std::string filePath = "tests/testdata/foo/bar1.txt";
+  const Name prefix("/ndn/multicast/NTORRENT/foo/bar1.txt/%FE%00");
+  const size_t fileSize = boost::filesystem::file_size(filePath);
+  std::vector<char> fileBytes(fileSize);
+  boost::filesystem::ifstream is(filePath, boost::filesystem::ifstream::binary);
+  is.read(&fileBytes.front(), fileSize);
+
+  struct {
+    size_t d_dataPacketSize;
+    size_t d_subManifestSize;
+  } DATA [] = {
+    {1024        , 1     },
+    {1024        , 10    },
+    {1000        , 7     },
+    {100         , 10000 },
+    {fileSize    , 1     },
+    {2 * fileSize, 1     },
+  };
+  enum { NUM_DATA = sizeof DATA / sizeof *DATA };
+  for (int i = 0; i < NUM_DATA; ++i) {
+    auto dataPacketSize  = DATA[i].d_dataPacketSize;
+    auto subManifestSize = DATA[i].d_subManifestSize;
+    auto subManifestLength = dataPacketSize * subManifestSize;
+    auto numSubManifests = fileSize / subManifestLength + !!(fileSize % subManifestLength);
+
+    size_t offset = 0;
+    for (size_t subManifestNum = 0; subManifestNum < numSubManifests; ++subManifestNum) {
+      Name subManifestName = prefix;
+      subManifestName.appendSequenceNumber(subManifestNum);
+      // the streamed packets are in order, signed and cover the sub-manifest exactly
+      std::vector<Data> streamed;
+      std::vector<Name> fullNames;
+      auto numPackets = IoUtil::packetize_file(filePath,
+                                               subManifestName,
+                                               dataPacketSize,
+                                               subManifestSize,
+                                               subManifestNum,
+                                               [&streamed, &fullNames] (const Data& d,
+                                                                        const Name& fullName) {
+                                                 streamed.push_back(d);
+                                                 fullNames.push_back(fullName);
+                                               });
+      BOOST_CHECK_EQUAL(numPackets, streamed.size());
+      BOOST_CHECK_LE(numPackets, subManifestSize);
+      for (size_t j = 0; j < streamed.size(); ++j) {
+        Name expectedName = subManifestName;
+        expectedName.appendSequenceNumber(j);
+        BOOST_CHECK_EQUAL(streamed[j].getName(), expectedName);
+        BOOST_CHECK_EQUAL(streamed[j].getFullName(), fullNames[j]);
+        const auto& content = streamed[j].getContent();
+        BOOST_REQUIRE_LE(offset + content.value_size(), fileSize);
+        BOOST_CHECK(std::equal(content.value_begin(), content.value_end(),
+                               fileBytes.begin() + offset));
+        offset += content.value_size();
+      }
+      // the in-memory version produces the same packets
+      auto packets = IoUtil::packetize_file(filePath,
+                                            subManifestName,
+                                            dataPacketSize,
+                                            subManifestSize,
+                                            subManifestNum);
+      BOOST_CHECK(packets == streamed);
+    }
+    BOOST_CHECK_EQUAL(offset, fileSize);
+
+    // there are no packets past the end of the file
+    size_t numPackets = IoUtil::packetize_file(filePath,
+                                               prefix,
+                                               dataPacketSize,
+                                               subManifestSize,
+                                               numSubManifests,
+                                               [] (const Data&, const Name&) {
+                                                 BOOST_ERROR("unexpected packet");
+                                               });
+    BOOST_CHECK_EQUAL(numPackets, 0u);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(TestReadDataPacketMapped)
+{
+  const std::string filePath = "tests/testdata/foo/bar1.txt";
+  const size_t subManifestSize = 10;
+  auto manifestsDataPair = FileManifest::generate(filePath,
+                                                  "/ndn/multicast/NTORRENT/foo/",
+                                                  subManifestSize,
+                                                  1024,
+                                                  true);
+  const auto& manifests = manifestsDataPair.first;
+  const auto& data = manifestsDataPair.second;
+  MappedFileRegistry mappedFiles;
+  auto data_it = data.begin();
+  for (const auto& m : manifests) {
+    for (const auto& name : m.catalog()) {
+      // reading from the mapping produces the same packets as reading from a stream
+      auto d1 = IoUtil::readDataPacket(name, m, subManifestSize, filePath);
+      auto d2 = IoUtil::readDataPacket(name, m, subManifestSize, filePath, &mappedFiles);
+      BOOST_REQUIRE(nullptr != d1);
+      BOOST_REQUIRE(nullptr != d2);
+      BOOST_CHECK(*d1 == *data_it);
+      BOOST_CHECK(*d2 == *data_it);
+      ++data_it;
+    }
+  }
+  BOOST_CHECK_EQUAL(mappedFiles.size(), 1);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 } // namespace tests
@@ -0,0 +1,125 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+* Copyright (c) 2016 Regents of the University of California.
+*
+* This file is part of the nTorrent codebase.
+*
+* nTorrent is free software: you can redistribute it and/or modify it under the
+* terms of the GNU Lesser General Public License as published by the Free Software
+* Foundation, either version 3 of the License, or (at your option) any later version.
+*
+* nTorrent is distributed in the hope that it will be useful, but WITHOUT ANY
+* WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+* PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+*
+* You should have received copies of the GNU General Public License and GNU Lesser
+* General Public License along with nTorrent, e.g., in COPYING.md file. If not, see
+* <http://www.gnu.org/licenses/>.
+*
+* See AUTHORS for complete list of nTorrent authors and contributors.
+*/
+
+#include "../boost-test.hpp"
+#include "util/mapped-file.hpp"
+
+#include <boost/filesystem.hpp>
+#include <boost/filesystem/fstream.hpp>
+
+#include <algorithm>
+#include <vector>
+
+namespace fs = boost::filesystem;
+
+namespace ndn {
+namespace ntorrent {
+namespace tests {
+
+BOOST_AUTO_TEST_SUITE(TestMappedFile)
+
+BOOST_AUTO_TEST_CASE(TestOpen)
+{
+  const std::string filePath = "tests/testdata/foo/bar1.txt";
+  auto fileSize = fs::file_size(filePath);
+  std::vector<char> bytes(fileSize);
+  fs::ifstream is(filePath, fs::ifstream::binary);
+  is.read(&bytes.front(), fileSize);
+
+  auto file = MappedFile::open(filePath);
+  BOOST_REQUIRE(nullptr != file);
+  BOOST_CHECK_EQUAL(file->size(), fileSize);
+  BOOST_CHECK(std::equal(bytes.begin(), bytes.end(), file->data()));
+
+  BOOST_CHECK(nullptr == MappedFile::open("tests/testdata/foo/fake.txt"));
+}
+
+BOOST_AUTO_TEST_CASE(TestRegistryRemapsGrownFiles)
+{
+  const std::string dirPath = "tests/testdata/temp/";
+  const std::string filePath = dirPath + "mapped";
+  fs::create_directories(dirPath);
+  {
+    fs::ofstream os(filePath, fs::ofstream::binary);
+    os << "0123456789";
+  }
+  MappedFileRegistry registry;
+  auto file1 = registry.get(filePath, 10);
+  BOOST_REQUIRE(nullptr != file1);
+  BOOST_CHECK_EQUAL(file1->size(), 10);
+  BOOST_CHECK_EQUAL(registry.size(), 1);
+  // the file is mapped once
+  BOOST_CHECK(file1 == registry.get(filePath, 5));
+  // the file has not grown, the existing mapping is returned
+  BOOST_CHECK(file1 == registry.get(filePath, 20));
+  {
+    fs::ofstream os(filePath, fs::ofstream::binary | fs::ofstream::app);
+    os << "abcdefghij";
+  }
+  // the file is not mapped again until it is known to have grown
+  BOOST_CHECK(file1 == registry.get(filePath, 20));
+  registry.markGrown(filePath);
+  BOOST_CHECK(file1 == registry.get(filePath, 10));
+  auto file2 = registry.get(filePath, 20);
+  BOOST_REQUIRE(nullptr != file2);
+  BOOST_CHECK_EQUAL(file2->size(), 20);
+  BOOST_CHECK_EQUAL(std::string(file2->data() + 10, file2->data() + 20), "abcdefghij");
+  // the previous mapping remains valid
+  BOOST_CHECK_EQUAL(std::string(file1->data(), file1->data() + 10), "0123456789");
+  BOOST_CHECK_EQUAL(registry.size(), 1);
+  BOOST_CHECK(file2 == registry.get(filePath, 30));
+
+  registry.erase(filePath);
+  BOOST_CHECK_EQUAL(registry.size(), 0);
+  BOOST_CHECK(nullptr == registry.get(dirPath + "fake", 1));
+  BOOST_CHECK_EQUAL(registry.size(), 0);
+  fs::remove_all(dirPath);
+}
+
+BOOST_AUTO_TEST_CASE(TestCurrentSize)
+{
+  const std::string dirPath = "tests/testdata/temp/";
+  const std::string filePath = dirPath + "mapped";
+  fs::create_directories(dirPath);
+  {
+    fs::ofstream os(filePath, fs::ofstream::binary);
+    os << "0123456789";
+  }
+  auto file = MappedFile::open(filePath);
+  BOOST_REQUIRE(nullptr != file);
+  BOOST_CHECK_EQUAL(file->currentSize(), 10);
+  // a truncated file is not backed past its new end
+  fs::resize_file(filePath, 4);
+  BOOST_CHECK_EQUAL(file->size(), 10);
+  BOOST_CHECK_EQUAL(file->currentSize(), 4);
+  BOOST_CHECK_EQUAL(std::string(file->data(), file->data() + 4), "0123");
+  // a grown file is not backed past the end of the mapping
+  fs::resize_file(filePath, 20);
+  BOOST_CHECK_EQUAL(file->currentSize(), 10);
+  fs::remove_all(dirPath);
+  BOOST_CHECK_EQUAL(file->currentSize(), 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+} // namespace tests
+} // namespace ntorrent
+} // namespace ndn
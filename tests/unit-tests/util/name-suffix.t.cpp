@@ -0,0 +1,54 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+* Copyright (c) 2016 Regents of the University of California.
+*
+* This file is part of the nTorrent codebase.
+*
+* nTorrent is free software: you can redistribute it and/or modify it under the
+* terms of the GNU Lesser General Public License as published by the Free Software
+* Foundation, either version 3 of the License, or (at your option) any later version.
+*
+* nTorrent is distributed in the hope that it will be useful, but WITHOUT ANY
+* WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+* PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+*
+* You should have received copies of the GNU General Public License and GNU Lesser
+* General Public License along with nTorrent, e.g., in COPYING.md file. If not, see
+* <http://www.gnu.org/licenses/>.
+*
+* See AUTHORS for complete list of nTorrent authors and contributors.
+*/
+
+#include "boost-test.hpp"
+#include "util/name-suffix.hpp"
+
+namespace ndn {
+namespace ntorrent {
+namespace tests {
+
+BOOST_AUTO_TEST_SUITE(TestNameSuffix)
+
+BOOST_AUTO_TEST_CASE(TestPrependSuffix)
+{
+  Name packetName("/ndn/multicast/NTORRENT/foo/bar1.txt");
+  packetName.appendSequenceNumber(3).appendSequenceNumber(300);
+  // long enough to need a multi-byte length
+  packetName.append(name::Component(std::string(300, 'a')));
+  for (size_t prefixSize = 0; prefixSize <= packetName.size() + 1; ++prefixSize) {
+    Block expected = packetName.getSubName(prefixSize).wireEncode();
+    BOOST_CHECK_EQUAL(suffixEncodedSize(packetName, prefixSize), expected.size());
+
+    EncodingEstimator estimator;
+    BOOST_CHECK_EQUAL(prependSuffix(estimator, packetName, prefixSize), expected.size());
+
+    EncodingBuffer buffer;
+    BOOST_CHECK_EQUAL(prependSuffix(buffer, packetName, prefixSize), expected.size());
+    BOOST_CHECK(buffer.block() == expected);
+  }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+} // namespace tests
+} // namespace ntorrent
+} // namespace ndn
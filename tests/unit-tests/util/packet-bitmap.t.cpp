@@ -0,0 +1,142 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+* Copyright (c) 2016 Regents of the University of California.
+*
+* This file is part of the nTorrent codebase.
+*
+* nTorrent is free software: you can redistribute it and/or modify it under the
+* terms of the GNU Lesser General Public License as published by the Free Software
+* Foundation, either version 3 of the License, or (at your option) any later version.
+*
+* nTorrent is distributed in the hope that it will be useful, but WITHOUT ANY
+* WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+* PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+*
+* You should have received copies of the GNU General Public License and GNU Lesser
+* General Public License along with nTorrent, e.g., in COPYING.md file. If not, see
+* <http://www.gnu.org/licenses/>.
+*
+* See AUTHORS for complete list of nTorrent authors and contributors.
+*/
+
+#include "boost-test.hpp"
+#include "util/packet-bitmap.hpp"
+
+#include <random>
+
+namespace ndn {
+namespace ntorrent {
+namespace tests {
+
+BOOST_AUTO_TEST_SUITE(TestPacketBitmap)
+
+BOOST_AUTO_TEST_CASE(TestSetAndCount)
+{
+  PacketBitmap bitmap(130);
+  BOOST_CHECK_EQUAL(bitmap.size(), 130);
+  BOOST_CHECK_EQUAL(bitmap.count(), 0);
+  BOOST_CHECK(!bitmap.isComplete());
+
+  BOOST_CHECK(bitmap.set(0));
+  BOOST_CHECK(bitmap.set(64));
+  BOOST_CHECK(bitmap.set(129));
+  // setting twice or out of range does not count
+  BOOST_CHECK(!bitmap.set(64));
+  BOOST_CHECK(!bitmap.set(130));
+  BOOST_CHECK_EQUAL(bitmap.count(), 3);
+
+  BOOST_CHECK(bitmap.test(0));
+  BOOST_CHECK(!bitmap.test(1));
+  BOOST_CHECK(bitmap.test(64));
+  BOOST_CHECK(bitmap.test(129));
+  BOOST_CHECK(!bitmap.test(130));
+
+  for (size_t i = 0; i < bitmap.size(); ++i) {
+    bitmap.set(i);
+  }
+  BOOST_CHECK_EQUAL(bitmap.count(), 130);
+  BOOST_CHECK(bitmap.isComplete());
+
+  BOOST_CHECK(PacketBitmap().isComplete());
+}
+
+BOOST_AUTO_TEST_CASE(TestFindMissing)
+{
+  PacketBitmap bitmap(200);
+  BOOST_CHECK_EQUAL(bitmap.findFirstMissing(), 0);
+  for (size_t i = 0; i < 150; ++i) {
+    bitmap.set(i);
+  }
+  bitmap.set(151);
+  BOOST_CHECK_EQUAL(bitmap.findFirstMissing(), 150);
+  BOOST_CHECK_EQUAL(bitmap.findNextMissing(151), 152);
+  BOOST_CHECK_EQUAL(bitmap.findNextMissing(10), 150);
+
+  // the padding bits of the last word are never reported
+  for (size_t i = 150; i < 200; ++i) {
+    bitmap.set(i);
+  }
+  BOOST_CHECK_EQUAL(bitmap.findFirstMissing(), 200);
+  BOOST_CHECK_EQUAL(bitmap.findNextMissing(0), 200);
+  BOOST_CHECK_EQUAL(bitmap.findNextMissing(300), 200);
+
+  PacketBitmap partial(70);
+  for (size_t i = 0; i < 69; ++i) {
+    partial.set(i);
+  }
+  BOOST_CHECK_EQUAL(partial.findFirstMissing(), 69);
+  BOOST_CHECK_EQUAL(partial.findNextMissing(64), 69);
+}
+
+BOOST_AUTO_TEST_CASE(TestReset)
+{
+  PacketBitmap bitmap(100);
+  for (size_t i = 0; i < bitmap.size(); ++i) {
+    bitmap.set(i);
+  }
+  BOOST_CHECK_EQUAL(bitmap.findFirstMissing(), 100);
+
+  BOOST_CHECK(bitmap.reset(70));
+  BOOST_CHECK(bitmap.reset(5));
+  // resetting twice or out of range does not count
+  BOOST_CHECK(!bitmap.reset(70));
+  BOOST_CHECK(!bitmap.reset(100));
+  BOOST_CHECK_EQUAL(bitmap.count(), 98);
+  BOOST_CHECK(!bitmap.test(5));
+  BOOST_CHECK(!bitmap.isComplete());
+
+  // the packets reset before the first missing one are found again
+  BOOST_CHECK_EQUAL(bitmap.findFirstMissing(), 5);
+  bitmap.set(5);
+  BOOST_CHECK_EQUAL(bitmap.findFirstMissing(), 70);
+}
+
+BOOST_AUTO_TEST_CASE(TestVectorConversion)
+{
+  std::mt19937 random(42);
+  std::vector<bool> expected(1000);
+  size_t count = 0;
+  for (size_t i = 0; i < expected.size(); ++i) {
+    expected[i] = random() % 2;
+    count += expected[i];
+  }
+  PacketBitmap bitmap(expected);
+  BOOST_CHECK_EQUAL(bitmap.count(), count);
+  BOOST_CHECK(bitmap.toVector() == expected);
+
+  // the scan visits exactly the packets that are not set
+  std::vector<size_t> missing;
+  for (size_t i = bitmap.findFirstMissing(); i < bitmap.size(); i = bitmap.findNextMissing(i + 1)) {
+    missing.push_back(i);
+  }
+  BOOST_CHECK_EQUAL(missing.size(), expected.size() - count);
+  for (auto i : missing) {
+    BOOST_CHECK(!expected[i]);
+  }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+} // namespace tests
+} // namespace ntorrent
+} // namespace ndn
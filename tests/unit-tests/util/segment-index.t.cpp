@@ -0,0 +1,112 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+* Copyright (c) 2016 Regents of the University of California.
+*
+* This file is part of the nTorrent codebase.
+*
+* nTorrent is free software: you can redistribute it and/or modify it under the
+* terms of the GNU Lesser General Public License as published by the Free Software
+* Foundation, either version 3 of the License, or (at your option) any later version.
+*
+* nTorrent is distributed in the hope that it will be useful, but WITHOUT ANY
+* WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+* PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+*
+* You should have received copies of the GNU General Public License and GNU Lesser
+* General Public License along with nTorrent, e.g., in COPYING.md file. If not, see
+* <http://www.gnu.org/licenses/>.
+*
+* See AUTHORS for complete list of nTorrent authors and contributors.
+*/
+
+#include "boost-test.hpp"
+#include "util/segment-index.hpp"
+
+#include <ndn-cxx/encoding/block-helpers.hpp>
+#include <ndn-cxx/encoding/encoding-buffer.hpp>
+
+namespace ndn {
+namespace ntorrent {
+namespace tests {
+
+BOOST_AUTO_TEST_SUITE(TestSegmentIndex)
+
+BOOST_AUTO_TEST_CASE(TestChildren)
+{
+  typedef std::pair<size_t, size_t> Range;
+  // no index
+  BOOST_CHECK(SegmentIndex::children(0, 10, 0) == Range(10, 10));
+  // a binary tree of 6 segments
+  BOOST_CHECK(SegmentIndex::children(0, 6, 2) == Range(1, 3));
+  BOOST_CHECK(SegmentIndex::children(1, 6, 2) == Range(3, 5));
+  BOOST_CHECK(SegmentIndex::children(2, 6, 2) == Range(5, 6));
+  BOOST_CHECK(SegmentIndex::children(3, 6, 2) == Range(6, 6));
+  BOOST_CHECK(SegmentIndex::children(5, 6, 2) == Range(6, 6));
+  // a fanout of at least n - 1 lists all the segments in the first one
+  BOOST_CHECK(SegmentIndex::children(0, 6, 5) == Range(1, 6));
+  BOOST_CHECK(SegmentIndex::children(0, 6, 100) == Range(1, 6));
+  BOOST_CHECK(SegmentIndex::children(1, 6, 100) == Range(6, 6));
+  // out of range
+  BOOST_CHECK(SegmentIndex::children(6, 6, 2) == Range(6, 6));
+  BOOST_CHECK(SegmentIndex::children(0, 0, 2) == Range(0, 0));
+
+  // every segment but the first is listed by exactly one segment before it
+  for (size_t fanout : {1, 2, 3, 7}) {
+    const size_t numSegments = 50;
+    std::vector<size_t> listed(numSegments, 0);
+    for (size_t i = 0; i < numSegments; ++i) {
+      auto children = SegmentIndex::children(i, numSegments, fanout);
+      BOOST_CHECK_LE(children.second - children.first, fanout);
+      for (size_t j = children.first; j < children.second; ++j) {
+        BOOST_CHECK_GT(j, i);
+        ++listed[j];
+      }
+    }
+    BOOST_CHECK_EQUAL(listed[0], 0);
+    for (size_t i = 1; i < numSegments; ++i) {
+      BOOST_CHECK_EQUAL(listed[i], 1);
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(TestReadWrite)
+{
+  std::vector<Name> names = { Name("/ndn/multicast/NTORRENT/foo/torrent-file/1"),
+                              Name("/ndn/multicast/NTORRENT/foo/torrent-file/2") };
+  MetaInfo metaInfo;
+  BOOST_CHECK(SegmentIndex::read(metaInfo).empty());
+
+  SegmentIndex::write(metaInfo, names);
+  BOOST_CHECK(SegmentIndex::read(metaInfo) == names);
+  BOOST_CHECK(SegmentIndex::read(MetaInfo(metaInfo.wireEncode())) == names);
+
+  // writing again replaces the index
+  SegmentIndex::write(metaInfo, { names[1] });
+  BOOST_CHECK_EQUAL(metaInfo.getAppMetaInfo().size(), 1);
+  BOOST_CHECK(SegmentIndex::read(metaInfo) == std::vector<Name>{ names[1] });
+
+  // an empty index is removed
+  SegmentIndex::write(metaInfo, {});
+  BOOST_CHECK(metaInfo.getAppMetaInfo().empty());
+  BOOST_CHECK(SegmentIndex::read(metaInfo).empty());
+}
+
+BOOST_AUTO_TEST_CASE(TestUnknownVersion)
+{
+  // an index of a version we do not know is ignored
+  EncodingBuffer buffer;
+  size_t totalLength = Name("/ndn/multicast/NTORRENT/foo/torrent-file/1").wireEncode(buffer);
+  totalLength += prependNonNegativeIntegerBlock(buffer, SegmentIndex::INDEX_VERSION_TYPE,
+                                                SegmentIndex::VERSION + 1);
+  buffer.prependVarNumber(totalLength);
+  buffer.prependVarNumber(SegmentIndex::SEGMENT_INDEX_TYPE);
+  MetaInfo metaInfo;
+  metaInfo.addAppMetaInfo(buffer.block());
+  BOOST_CHECK(SegmentIndex::read(metaInfo).empty());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+} // namespace tests
+} // namespace ntorrent
+} // namespace ndn
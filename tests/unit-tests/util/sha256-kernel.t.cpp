@@ -0,0 +1,168 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+* Copyright (c) 2016 Regents of the University of California.
+*
+* This file is part of the nTorrent codebase.
+*
+* nTorrent is free software: you can redistribute it and/or modify it under the
+* terms of the GNU Lesser General Public License as published by the Free Software
+* Foundation, either version 3 of the License, or (at your option) any later version.
+*
+* nTorrent is distributed in the hope that it will be useful, but WITHOUT ANY
+* WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+* PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+*
+* You should have received copies of the GNU General Public License and GNU Lesser
+* General Public License along with nTorrent, e.g., in COPYING.md file. If not, see
+* <http://www.gnu.org/licenses/>.
+*
+* See AUTHORS for complete list of nTorrent authors and contributors.
+*/
+
+#include "boost-test.hpp"
+#include "util/sha256-kernel.hpp"
+
+#include <ndn-cxx/util/sha256.hpp>
+#include <ndn-cxx/util/string-helper.hpp>
+
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace ndn {
+namespace ntorrent {
+namespace tests {
+
+BOOST_AUTO_TEST_SUITE(TestSha256Kernel)
+
+static std::vector<Sha256Kernel::Implementation>
+supportedImplementations()
+{
+  std::vector<Sha256Kernel::Implementation> implementations;
+  for (auto implementation : { Sha256Kernel::PORTABLE, Sha256Kernel::AVX2, Sha256Kernel::SHA_NI }) {
+    if (Sha256Kernel::isSupported(implementation)) {
+      implementations.push_back(implementation);
+    }
+  }
+  return implementations;
+}
+
+static bool
+matchesReference(const Sha256Kernel::Digest& digest, const uint8_t* data, size_t size)
+{
+  auto reference = util::Sha256::computeDigest(data, size);
+  return std::equal(digest.begin(), digest.end(), reference->begin());
+}
+
+BOOST_AUTO_TEST_CASE(TestKnownDigests)
+{
+  std::vector<std::pair<std::string, std::string>> vectors = {
+    { "", "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855" },
+    { "abc", "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad" },
+    { "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq",
+      "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1" },
+    { std::string(1000000, 'a'),
+      "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0" },
+  };
+  BOOST_CHECK(Sha256Kernel::isSupported(Sha256Kernel::PORTABLE));
+  BOOST_CHECK(Sha256Kernel::isSupported(Sha256Kernel::best()));
+  for (auto implementation : supportedImplementations()) {
+    for (const auto& v : vectors) {
+      auto data = reinterpret_cast<const uint8_t*>(v.first.data());
+      auto digest = Sha256Kernel::compute(data, v.first.size(), implementation);
+      BOOST_CHECK_EQUAL(toHex(digest.data(), digest.size(), false), v.second);
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(TestImplementationsAgree)
+{
+  std::mt19937 random(42);
+  std::vector<uint8_t> bytes(4096);
+  for (auto& b : bytes) {
+    b = static_cast<uint8_t>(random());
+  }
+  // every size around the padding boundaries, then a few multi-block sizes
+  std::vector<size_t> sizes;
+  for (size_t size = 0; size <= 3 * Sha256Kernel::BLOCK_SIZE; ++size) {
+    sizes.push_back(size);
+  }
+  sizes.insert(sizes.end(), { 1000, 1024, 1100, 4095, 4096 });
+  for (auto implementation : supportedImplementations()) {
+    for (auto size : sizes) {
+      BOOST_CHECK_MESSAGE(matchesReference(Sha256Kernel::compute(bytes.data(), size,
+                                                                 implementation),
+                                           bytes.data(), size),
+                          Sha256Kernel::toString(implementation) << " size " << size);
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(TestComputeBatch)
+{
+  std::mt19937 random(7);
+  std::vector<uint8_t> bytes(8192);
+  for (auto& b : bytes) {
+    b = static_cast<uint8_t>(random());
+  }
+  // batches smaller, equal and larger than the number of lanes, of buffers of mixed sizes
+  for (size_t count : { 0, 1, 3, 8, 9, 17 }) {
+    std::vector<const uint8_t*> buffers;
+    std::vector<size_t> sizes;
+    for (size_t i = 0; i < count; ++i) {
+      buffers.push_back(bytes.data() + 13 * i);
+      sizes.push_back((577 * i) % 4000);
+    }
+    for (auto implementation : supportedImplementations()) {
+      std::vector<Sha256Kernel::Digest> digests(count);
+      Sha256Kernel::computeBatch(buffers.data(), sizes.data(), count, digests.data(),
+                                 implementation);
+      for (size_t i = 0; i < count; ++i) {
+        BOOST_CHECK_MESSAGE(matchesReference(digests[i], buffers[i], sizes[i]),
+                            Sha256Kernel::toString(implementation) << " buffer " << i
+                            << " of " << count);
+      }
+    }
+  }
+}
+
+// a benchmark, run on demand with --run_test=TestSha256Kernel/BenchmarkPacketDigests
+BOOST_AUTO_TEST_CASE(BenchmarkPacketDigests, *boost::unit_test::disabled())
+{
+  // the digests of 64 MB of packets of the default size, as when packetizing a file
+  const size_t packetSize = 1024;
+  const size_t numPackets = 64 * 1024;
+  std::vector<uint8_t> bytes(packetSize * numPackets, 0xAB);
+  std::vector<const uint8_t*> buffers(numPackets);
+  std::vector<size_t> sizes(numPackets, packetSize);
+  for (size_t i = 0; i < numPackets; ++i) {
+    buffers[i] = bytes.data() + i * packetSize;
+  }
+  auto report = [&] (const std::string& name, std::chrono::steady_clock::time_point start) {
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    BOOST_TEST_MESSAGE("SHA-256 " << name << ": " << bytes.size() / elapsed.count() / 1e6
+                       << " MB/s");
+  };
+
+  auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < numPackets; ++i) {
+    util::Sha256::computeDigest(buffers[i], sizes[i]);
+  }
+  report("ndn::util::Sha256", start);
+
+  std::vector<Sha256Kernel::Digest> digests(numPackets);
+  for (auto implementation : supportedImplementations()) {
+    start = std::chrono::steady_clock::now();
+    Sha256Kernel::computeBatch(buffers.data(), sizes.data(), numPackets, digests.data(),
+                               implementation);
+    report(Sha256Kernel::toString(implementation), start);
+    BOOST_CHECK(matchesReference(digests.back(), buffers.back(), sizes.back()));
+  }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+} // namespace tests
+} // namespace ntorrent
+} // namespace ndn
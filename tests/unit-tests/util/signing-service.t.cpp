@@ -0,0 +1,114 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+* Copyright (c) 2016 Regents of the University of California.
+*
+* This file is part of the nTorrent codebase.
+*
+* nTorrent is free software: you can redistribute it and/or modify it under the
+* terms of the GNU Lesser General Public License as published by the Free Software
+* Foundation, either version 3 of the License, or (at your option) any later version.
+*
+* nTorrent is distributed in the hope that it will be useful, but WITHOUT ANY
+* WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+* PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+*
+* You should have received copies of the GNU General Public License and GNU Lesser
+* General Public License along with nTorrent, e.g., in COPYING.md file. If not, see
+* <http://www.gnu.org/licenses/>.
+*
+* See AUTHORS for complete list of nTorrent authors and contributors.
+*/
+
+#include "boost-test.hpp"
+#include "util/signing-service.hpp"
+#include "util/thread-pool.hpp"
+
+#include <ndn-cxx/encoding/block-helpers.hpp>
+#include <ndn-cxx/security/signing-helpers.hpp>
+
+#include <vector>
+
+namespace ndn {
+namespace ntorrent {
+namespace tests {
+
+BOOST_AUTO_TEST_SUITE(TestSigningService)
+
+static Data
+makePacket(size_t packetNum)
+{
+  Name name("/NTORRENT/foo/bar.txt");
+  name.appendSequenceNumber(packetNum);
+  Data packet(name);
+  std::vector<uint8_t> content(packetNum % 1024, static_cast<uint8_t>(packetNum));
+  packet.setContent(encoding::makeBinaryBlock(tlv::Content, content.data(), content.size()));
+  return packet;
+}
+
+BOOST_AUTO_TEST_CASE(TestDefault)
+{
+  BOOST_REQUIRE(nullptr != SigningService::getDefault());
+  BOOST_CHECK(SigningService::getDefault() == SigningService::getDefault());
+}
+
+BOOST_AUTO_TEST_CASE(TestSign)
+{
+  auto keyChain = std::make_shared<KeyChain>();
+  SigningService signingService(keyChain);
+
+  // packets signed with a digest are the same as those signed by the KeyChain
+  auto expected = makePacket(42);
+  keyChain->sign(expected, signingWithSha256());
+  auto packet = makePacket(42);
+  BOOST_CHECK_EQUAL(signingService.sign(packet), expected.getFullName());
+  BOOST_CHECK(packet.wireEncode() == expected.wireEncode());
+  packet = makePacket(42);
+  signingService.sign(packet, signingWithSha256());
+  BOOST_CHECK(packet.wireEncode() == expected.wireEncode());
+
+  // packets signed with a key are signed by the KeyChain
+  packet = makePacket(42);
+  signingService.sign(packet, security::SigningInfo());
+  BOOST_CHECK_NE(packet.getSignature().getType(), tlv::DigestSha256);
+}
+
+BOOST_AUTO_TEST_CASE(TestConcurrentSign)
+{
+  // the packets signed concurrently, one at a time or in batches, are all signed correctly
+  SigningService signingService;
+  const size_t numPackets = 400;
+  std::vector<Data> packets;
+  std::vector<Name> fullNames(numPackets);
+  for (size_t i = 0; i < numPackets; ++i) {
+    packets.push_back(makePacket(i));
+  }
+  std::vector<ThreadPool::Task> tasks;
+  for (size_t first = 0; first < numPackets; first += 10) {
+    tasks.emplace_back([&, first] {
+      if (0 == first % 20) {
+        for (size_t i = first; i < first + 10; ++i) {
+          fullNames[i] = signingService.sign(packets[i]);
+        }
+        return;
+      }
+      std::vector<Data*> batch;
+      for (size_t i = first; i < first + 10; ++i) {
+        batch.push_back(&packets[i]);
+      }
+      auto batchNames = signingService.sign(batch);
+      std::copy(batchNames.begin(), batchNames.end(), fullNames.begin() + first);
+    });
+  }
+  ThreadPool pool(4);
+  pool.run(std::move(tasks));
+  for (size_t i = 0; i < numPackets; ++i) {
+    BOOST_CHECK_EQUAL(packets[i].getSignature().getType(), tlv::DigestSha256);
+    BOOST_CHECK_EQUAL(fullNames[i], packets[i].getFullName());
+  }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+} // namespace tests
+} // namespace ntorrent
+} // namespace ndn
@@ -0,0 +1,113 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+* Copyright (c) 2016 Regents of the University of California.
+*
+* This file is part of the nTorrent codebase.
+*
+* nTorrent is free software: you can redistribute it and/or modify it under the
+* terms of the GNU Lesser General Public License as published by the Free Software
+* Foundation, either version 3 of the License, or (at your option) any later version.
+*
+* nTorrent is distributed in the hope that it will be useful, but WITHOUT ANY
+* WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+* PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+*
+* You should have received copies of the GNU General Public License and GNU Lesser
+* General Public License along with nTorrent, e.g., in COPYING.md file. If not, see
+* <http://www.gnu.org/licenses/>.
+*
+* See AUTHORS for complete list of nTorrent authors and contributors.
+*/
+
+#include "../boost-test.hpp"
+#include "util/thread-pool.hpp"
+
+#include <atomic>
+#include <stdexcept>
+
+namespace ndn {
+namespace ntorrent {
+namespace tests {
+
+BOOST_AUTO_TEST_SUITE(TestThreadPool)
+
+BOOST_AUTO_TEST_CASE(TestRun)
+{
+  for (size_t numThreads : {0, 1, 4}) {
+    ThreadPool pool(numThreads);
+    BOOST_CHECK_EQUAL(pool.size(), numThreads);
+    std::vector<int> results(100);
+    std::vector<ThreadPool::Task> tasks;
+    for (size_t i = 0; i < results.size(); ++i) {
+      tasks.emplace_back([&results, i] { results[i] = i * i; });
+    }
+    pool.run(std::move(tasks));
+    for (size_t i = 0; i < results.size(); ++i) {
+      BOOST_CHECK_EQUAL(results[i], i * i);
+    }
+    // running no tasks returns immediately
+    pool.run({});
+  }
+}
+
+BOOST_AUTO_TEST_CASE(TestNestedRun)
+{
+  // tasks may run batches of tasks on the pool running them
+  for (size_t numThreads : {0, 1, 4}) {
+    ThreadPool pool(numThreads);
+    std::atomic<size_t> count(0);
+    std::vector<ThreadPool::Task> tasks;
+    for (size_t i = 0; i < 20; ++i) {
+      tasks.emplace_back([&pool, &count] {
+        std::vector<ThreadPool::Task> subTasks(10, [&count] { ++count; });
+        pool.run(std::move(subTasks));
+      });
+    }
+    pool.run(std::move(tasks));
+    BOOST_CHECK_EQUAL(count, 200u);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(TestException)
+{
+  // the exception of a task is rethrown once all the tasks of the batch have completed
+  for (size_t numThreads : {0, 1, 4}) {
+    ThreadPool pool(numThreads);
+    std::atomic<size_t> count(0);
+    std::vector<ThreadPool::Task> tasks(10, [&count] { ++count; });
+    tasks.emplace_back([] { throw std::runtime_error("task failed"); });
+    tasks.insert(tasks.end(), 10, [&count] { ++count; });
+    BOOST_CHECK_THROW(pool.run(std::move(tasks)), std::runtime_error);
+    BOOST_CHECK_EQUAL(count, 20u);
+    // the pool is still usable
+    pool.run({[&count] { ++count; }});
+    BOOST_CHECK_EQUAL(count, 21u);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(TestPost)
+{
+  for (size_t numThreads : {0, 1, 4}) {
+    std::atomic<size_t> count(0);
+    {
+      ThreadPool pool(numThreads);
+      for (size_t i = 0; i < 100; ++i) {
+        pool.post([&count] { ++count; });
+      }
+      // exceptions of posted tasks do not affect the pool
+      pool.post([] { throw std::runtime_error("task failed"); });
+      if (0 == numThreads) {
+        // posted tasks run right away on a pool without worker threads
+        BOOST_CHECK_EQUAL(count, 100u);
+      }
+    }
+    // the queued tasks are run before the pool is destroyed
+    BOOST_CHECK_EQUAL(count, 100u);
+  }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+} // namespace tests
+} // namespace ntorrent
+} // namespace ndn